@@ -29,6 +29,9 @@
 #define HAVE_SSE3
 #define HAVE_SSE4_1
 
+/* Define if we have AVX2 and FMA CPU extensions */
+#define HAVE_AVX2
+
 /* Define if we have ARM Neon CPU extensions */
 /* #undef HAVE_NEON */
 
@@ -36,8 +36,11 @@
 #include "alSource.h"
 #include "alBuffer.h"
 #include "alAuxEffectSlot.h"
+#include "alEmitter.h"
 #include "alError.h"
 #include "bformatdec.h"
+#include "mixpool.h"
+#include "hrtfbatch.h"
 #include "alu.h"
 
 #include "compat.h"
@@ -106,6 +109,9 @@ static struct BackendInfo BackendList[] = {
 #ifdef HAVE_WAVE
     { "wave", ALCwaveBackendFactory_getFactory, NULL, NULL, NULL, EmptyFuncs },
 #endif
+#ifdef HAVE_SHM
+    { "shm", ALCshmBackendFactory_getFactory, NULL, NULL, NULL, EmptyFuncs },
+#endif
 
     { NULL, NULL, NULL, NULL, NULL, EmptyFuncs }
 };
@@ -290,6 +296,13 @@ static const ALCfunction alcFunctions[] = {
     DECL(alGetSource3i64SOFT),
     DECL(alGetSourcei64vSOFT),
 
+    DECL(alGenEmittersSOFTX),
+    DECL(alDeleteEmittersSOFTX),
+    DECL(alIsEmitterSOFTX),
+
+    DECL(alGetInteger64SOFT),
+    DECL(alGetInteger64vSOFT),
+
     DECL(alBufferSamplesSOFT),
     DECL(alGetBufferSamplesSOFT),
     DECL(alIsBufferFormatSupportedSOFT),
@@ -358,6 +371,19 @@ static const ALCenums enumeration[] = {
     DECL(ALC_HRTF_SPECIFIER_SOFT),
     DECL(ALC_HRTF_ID_SOFT),
 
+    DECL(ALC_PERIOD_SIZE_SOFTX),
+    DECL(ALC_PERIODS_SOFTX),
+    DECL(ALC_UNDERRUNS_SOFTX),
+    DECL(ALC_OUTPUT_DELAY_SOFTX),
+    DECL(ALC_PANNING_CACHE_HITS_SOFTX),
+    DECL(ALC_PANNING_CACHE_MISSES_SOFTX),
+    DECL(ALC_MIXER_THREAD_SCHED_SOFTX),
+    DECL(ALC_MIXER_THREAD_PRIORITY_SOFTX),
+    DECL(ALC_SCHED_OTHER_SOFTX),
+    DECL(ALC_SCHED_RR_SOFTX),
+    DECL(ALC_SCHED_FIFO_SOFTX),
+    DECL(ALC_MIX_STAMPS_SOFTX),
+
     DECL(ALC_NO_ERROR),
     DECL(ALC_INVALID_DEVICE),
     DECL(ALC_INVALID_CONTEXT),
@@ -530,6 +556,17 @@ static const ALCenums enumeration[] = {
 
     DECL(AL_SOURCE_RADIUS),
 
+    DECL(AL_EMITTER_SOFTX),
+
+    DECL(AL_POOLED_ALLOCATIONS_SOFTX),
+    DECL(AL_POOL_BLOCKS_SOFTX),
+    DECL(AL_SYSTEM_ALLOCATIONS_SOFTX),
+
+    DECL(AL_VOICES_VISITED_SOFTX),
+    DECL(AL_VOICES_SKIPPED_SOFTX),
+    DECL(AL_VOICE_UPDATES_SOFTX),
+    DECL(AL_VOICE_UPDATES_CULLED_SOFTX),
+
     DECL(AL_STEREO_ANGLES),
 
     DECL(AL_UNUSED),
@@ -718,7 +755,8 @@ static const ALchar alExtList[] =
     "AL_EXT_source_distance_model AL_EXT_SOURCE_RADIUS AL_EXT_STEREO_ANGLES "
     "AL_LOKI_quadriphonic AL_SOFT_block_alignment AL_SOFT_deferred_updates "
     "AL_SOFT_direct_channels AL_SOFT_gain_clamp_ex AL_SOFT_loop_points "
-    "AL_SOFT_MSADPCM AL_SOFT_source_latency AL_SOFT_source_length";
+    "AL_SOFT_MSADPCM AL_SOFT_source_latency AL_SOFT_source_length "
+    "AL_SOFTX_allocation_stats AL_SOFTX_static_emitters AL_SOFTX_voice_stats";
 
 static ATOMIC(ALCenum) LastNullDeviceError = ATOMIC_INIT_STATIC(ALC_NO_ERROR);
 
@@ -727,8 +765,10 @@ static altss_t LocalContext;
 /* Process-wide current context */
 static ATOMIC(ALCcontext*) GlobalContext = ATOMIC_INIT_STATIC(NULL);
 
-/* Mixing thread piority level */
+/* Mixing thread piority level, scheduling class and allowed CPUs */
 ALint RTPrioLevel;
+ALint RTSchedClass;
+ALuint64 RTCpuMask;
 
 FILE *LogFile;
 #ifdef _DEBUG
@@ -761,7 +801,8 @@ static const ALCchar alcNoDeviceExtList[] =
 static const ALCchar alcExtensionList[] =
     "ALC_ENUMERATE_ALL_EXT ALC_ENUMERATION_EXT ALC_EXT_CAPTURE "
     "ALC_EXT_DEDICATED ALC_EXT_disconnect ALC_EXT_EFX "
-    "ALC_EXT_thread_local_context ALC_SOFTX_device_clock ALC_SOFT_HRTF "
+    "ALC_EXT_thread_local_context ALC_SOFTX_device_clock ALC_SOFTX_mix_stamps "
+    "ALC_SOFTX_panning_cache ALC_SOFTX_periods ALC_SOFTX_thread_sched ALC_SOFT_HRTF "
     "ALC_SOFT_loopback ALC_SOFT_pause_device";
 static const ALCint alcMajorVersion = 1;
 static const ALCint alcMinorVersion = 1;
@@ -877,6 +918,7 @@ static void alc_init(void)
     assert(ret == althrd_success);
 
     ThunkInit();
+    InitSourceSlabs();
 }
 
 static void alc_initconfig(void)
@@ -935,6 +977,9 @@ static void alc_initconfig(void)
 #elif defined(HAVE_SSE)
     capfilter |= CPU_CAP_SSE;
 #endif
+#ifdef HAVE_AVX2
+    capfilter |= CPU_CAP_AVX2;
+#endif
 #ifdef HAVE_NEON
     capfilter |= CPU_CAP_NEON;
 #endif
@@ -967,6 +1012,8 @@ static void alc_initconfig(void)
                     capfilter &= ~CPU_CAP_SSE3;
                 else if(len == 6 && strncasecmp(str, "sse4.1", len) == 0)
                     capfilter &= ~CPU_CAP_SSE4_1;
+                else if(len == 4 && strncasecmp(str, "avx2", len) == 0)
+                    capfilter &= ~CPU_CAP_AVX2;
                 else if(len == 4 && strncasecmp(str, "neon", len) == 0)
                     capfilter &= ~CPU_CAP_NEON;
                 else
@@ -977,12 +1024,26 @@ static void alc_initconfig(void)
     FillCPUCaps(capfilter);
 
 #ifdef _WIN32
-    RTPrioLevel = 1;
+    /* Time-critical, as the mixing threads always got there. */
+    RTPrioLevel = 3;
 #else
     RTPrioLevel = 0;
 #endif
     ConfigValueInt(NULL, NULL, "rt-prio", &RTPrioLevel);
 
+    RTSchedClass = althrd_sched_rr;
+    if(ConfigValueStr(NULL, NULL, "rt-policy", &str))
+    {
+        if(strcasecmp(str, "fifo") == 0)
+            RTSchedClass = althrd_sched_fifo;
+        else if(strcasecmp(str, "rr") != 0)
+            ERR("Invalid rt-policy: %s\n", str);
+    }
+
+    RTCpuMask = 0;
+    if(ConfigValueStr(NULL, NULL, "rt-cpus", &str))
+        RTCpuMask = strtoull(str, NULL, 0);
+
     aluInitMixer();
 
     str = getenv("ALSOFT_TRAP_ERROR");
@@ -1196,6 +1257,7 @@ static void alc_deinit_safe(void)
     FreeHrtfs();
     FreeALConfig();
 
+    DeinitSourceSlabs();
     ThunkExit();
     almtx_destroy(&ListLock);
     altss_delete(LocalContext);
@@ -1618,13 +1680,15 @@ void ALCcontext_ProcessUpdates(ALCcontext *context)
         UpdateListenerProps(context);
         UpdateAllEffectSlotProps(context);
 
-        LockUIntMapRead(&context->SourceMap);
+        LockSourcesRead(context);
         V0(device->Backend,lock)();
-        for(pos = 0;pos < context->SourceMap.size;pos++)
+        for(pos = 0;pos < GetSourceSlotCount(context);pos++)
         {
-            ALsource *Source = context->SourceMap.values[pos];
+            ALsource *Source = GetSourceSlot(context, pos);
             ALenum new_state;
 
+            if(!Source) continue;
+
             if((Source->state == AL_PLAYING || Source->state == AL_PAUSED) &&
                Source->OffsetType != AL_NONE)
             {
@@ -1639,7 +1703,7 @@ void ALCcontext_ProcessUpdates(ALCcontext *context)
                 SetSourceState(Source, context, new_state);
         }
         V0(device->Backend,unlock)();
-        UnlockUIntMapRead(&context->SourceMap);
+        UnlockSourcesRead(context);
 
         UpdateAllSourceProps(context);
 
@@ -1703,6 +1767,8 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
     ALCuint oldFreq;
     FPUCtl oldMode;
     ALCsizei hrtf_id = -1;
+    ALuint mixthreads = 1;
+    ALfloat valf;
     size_t size;
 
     // Check for attributes
@@ -1827,6 +1893,7 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
     else if(attrList && attrList[0])
     {
         ALCuint freq, numMono, numStereo, numSends;
+        ALCuint refresh = 0;
         ALCuint attrIdx = 0;
 
         /* If a context is already running on the device, stop playback so the
@@ -1850,6 +1917,12 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
                 TRACE_ATTR(ALC_FREQUENCY, freq);
             }
 
+            if(attrList[attrIdx] == ALC_REFRESH)
+            {
+                refresh = attrList[attrIdx + 1];
+                TRACE_ATTR(ALC_REFRESH, refresh);
+            }
+
             if(attrList[attrIdx] == ALC_STEREO_SOURCES)
             {
                 numStereo = attrList[attrIdx + 1];
@@ -1895,8 +1968,15 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
 
         UpdateClockBase(device);
 
-        device->UpdateSize = (ALuint64)device->UpdateSize * freq /
-                             device->Frequency;
+        /* A requested refresh rate picks the period size, within the same
+         * limits as the period_size option. The backend may still round it to
+         * what the hardware supports.
+         */
+        if(refresh > 0)
+            device->UpdateSize = clampu(freq / refresh, 64, 8192);
+        else
+            device->UpdateSize = (ALuint64)device->UpdateSize * freq /
+                                 device->Frequency;
         /* SSE and Neon do best with the update size being a multiple of 4 */
         if((CPUCapFlags&(CPU_CAP_SSE|CPU_CAP_NEON)) != 0)
             device->UpdateSize = (device->UpdateSize+3)&~3;
@@ -1916,6 +1996,12 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
     al_free(device->Bs2b);
     device->Bs2b = NULL;
 
+    mixpool_free(device->MixPool);
+    device->MixPool = NULL;
+
+    hrtfbatch_free(device->HrtfBatch);
+    device->HrtfBatch = NULL;
+
     al_free(device->Dry.Buffer);
     device->Dry.Buffer = NULL;
     device->Dry.NumChannels = 0;
@@ -2086,6 +2172,50 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
         device->FOAOut.NumChannels = device->Dry.NumChannels;
     }
 
+    if(ConfigValueUInt(al_string_get_cstr(device->DeviceName), NULL, "mix-threads", &mixthreads) &&
+       mixthreads > 1)
+    {
+        mixthreads = minu(mixthreads, MAX_MIX_THREADS);
+        device->MixPool = mixpool_alloc(mixthreads,
+            (ALsizei)(size / sizeof(device->Dry.Buffer[0])), device->NumAuxSends
+        );
+        if(!device->MixPool)
+            ERR("Failed to start %u mix threads, mixing on one thread\n", mixthreads);
+        else
+            TRACE("Mixing sources on %u threads\n", mixthreads);
+    }
+
+    /* Voices get summed into the batch groups as they're mixed, so this is
+     * only done when mixing on one thread.
+     */
+    if(device->Render_Mode == HrtfRender && !device->MixPool &&
+       GetConfigValueBool(al_string_get_cstr(device->DeviceName), NULL, "hrtf-batch", 1))
+    {
+        device->HrtfBatch = hrtfbatch_alloc(device->Hrtf.Handle);
+        if(!device->HrtfBatch)
+            ERR("Failed to allocate static HRTF batch groups\n");
+    }
+
+    /* The cache outlives resets so its counts keep adding up, but the gains
+     * in it are only good for the output configuration they were made for.
+     */
+    if(device->PanningCache)
+        panningcache_clear(device->PanningCache);
+    else if(GetConfigValueBool(al_string_get_cstr(device->DeviceName), NULL, "panning-cache", 1))
+    {
+        device->PanningCache = panningcache_alloc();
+        if(!device->PanningCache)
+            ERR("Failed to allocate the panning cache\n");
+    }
+
+    device->CullLevel = 0.0f;
+    if(ConfigValueFloat(al_string_get_cstr(device->DeviceName), NULL, "voice-cull-level", &valf) &&
+       valf < 0.0f)
+    {
+        device->CullLevel = powf(10.0f, valf/20.0f);
+        TRACE("Culling voices below %.1fdB\n", valf);
+    }
+
     SetMixerFPUMode(&oldMode);
     if(device->DefaultSlot)
     {
@@ -2128,11 +2258,12 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
         }
         UnlockUIntMapRead(&context->EffectSlotMap);
 
-        LockUIntMapRead(&context->SourceMap);
-        for(pos = 0;pos < context->SourceMap.size;pos++)
+        LockSourcesRead(context);
+        for(pos = 0;pos < GetSourceSlotCount(context);pos++)
         {
-            ALsource *source = context->SourceMap.values[pos];
+            ALsource *source = GetSourceSlot(context, pos);
             ALuint s = device->NumAuxSends;
+            if(!source) continue;
             while(s < MAX_SENDS)
             {
                 if(source->Send[s].Slot)
@@ -2147,7 +2278,12 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
             }
             source->NeedsUpdate = AL_TRUE;
         }
-        UnlockUIntMapRead(&context->SourceMap);
+        UnlockSourcesRead(context);
+
+        /* The mixer is stopped, so nothing can be using emitter parameters
+         * calculated for the old configuration.
+         */
+        context->EmitterParamsGen++;
 
         UpdateListenerProps(context);
         ReadUnlock(&context->PropLock);
@@ -2158,6 +2294,7 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
 
     if(!(device->Flags&DEVICE_PAUSED))
     {
+        ATOMIC_STORE(&device->MixerSched, -1, almemory_order_relaxed);
         if(V0(device->Backend,start)() == ALC_FALSE)
             return ALC_INVALID_DEVICE;
         device->Flags |= DEVICE_RUNNING;
@@ -2226,6 +2363,15 @@ static ALCvoid FreeDevice(ALCdevice *device)
     ambiup_free(device->AmbiUp);
     device->AmbiUp = NULL;
 
+    mixpool_free(device->MixPool);
+    device->MixPool = NULL;
+
+    hrtfbatch_free(device->HrtfBatch);
+    device->HrtfBatch = NULL;
+
+    panningcache_free(device->PanningCache);
+    device->PanningCache = NULL;
+
     AL_STRING_DEINIT(device->DeviceName);
 
     al_free(device->Dry.Buffer);
@@ -2328,7 +2474,14 @@ static ALvoid InitContext(ALCcontext *Context)
     RWLockInit(&Context->PropLock);
     ATOMIC_INIT(&Context->LastError, AL_NO_ERROR);
     InitUIntMap(&Context->SourceMap, Context->Device->SourcesMax);
+    Context->SourceHandles = GetConfigValueBool(al_string_get_cstr(Context->Device->DeviceName),
+                                                NULL, "source-handles", 0);
+    InitHandleTable(&Context->SourceTable, Context->Device->SourcesMax);
+    InitRef(&Context->SourceReaders, 0);
+    Context->RetiredSources = NULL;
     InitUIntMap(&Context->EffectSlotMap, Context->Device->AuxiliaryEffectSlotMax);
+    InitUIntMap(&Context->EmitterMap, ~0);
+    Context->EmitterParamsGen = 0;
 
     //Set globals
     Context->DistanceModel = DefaultDistanceModel;
@@ -2355,13 +2508,12 @@ static void FreeContext(ALCcontext *context)
 
     TRACE("%p\n", context);
 
-    if(context->SourceMap.size > 0)
-    {
-        WARN("(%p) Deleting %d Source%s\n", context, context->SourceMap.size,
-             (context->SourceMap.size==1)?"":"s");
-        ReleaseALSources(context);
-    }
+    if(GetSourceCount(context) > 0)
+        WARN("(%p) Deleting %d Source%s\n", context, GetSourceCount(context),
+             (GetSourceCount(context)==1)?"":"s");
+    ReleaseALSources(context);
     ResetUIntMap(&context->SourceMap);
+    ResetHandleTable(&context->SourceTable);
 
     if(context->EffectSlotMap.size > 0)
     {
@@ -2371,8 +2523,18 @@ static void FreeContext(ALCcontext *context)
     }
     ResetUIntMap(&context->EffectSlotMap);
 
+    if(context->EmitterMap.size > 0)
+    {
+        WARN("(%p) Deleting %d Emitter%s\n", context, context->EmitterMap.size,
+             (context->EmitterMap.size==1)?"":"s");
+        ReleaseALEmitters(context);
+    }
+    ResetUIntMap(&context->EmitterMap);
+
     al_free(context->Voices);
     context->Voices = NULL;
+    al_free(context->VoiceMask);
+    context->VoiceMask = NULL;
     context->VoiceCount = 0;
     context->MaxVoices = 0;
 
@@ -2919,6 +3081,65 @@ static ALCsizei GetIntegerv(ALCdevice *device, ALCenum param, ALCsizei size, ALC
             almtx_unlock(&device->BackendLock);
             return 1;
 
+        case ALC_PERIOD_SIZE_SOFTX:
+        case ALC_PERIODS_SOFTX:
+            if(device->Type == Loopback)
+            {
+                alcSetError(device, ALC_INVALID_DEVICE);
+                return 0;
+            }
+            almtx_lock(&device->BackendLock);
+            values[0] = (param == ALC_PERIOD_SIZE_SOFTX) ? device->UpdateSize :
+                                                           device->NumUpdates;
+            almtx_unlock(&device->BackendLock);
+            return 1;
+
+        case ALC_UNDERRUNS_SOFTX:
+            values[0] = ATOMIC_LOAD(&device->Underruns, almemory_order_relaxed);
+            return 1;
+
+        case ALC_MIXER_THREAD_SCHED_SOFTX:
+        case ALC_MIXER_THREAD_PRIORITY_SOFTX:
+            {
+                ALint sched = ATOMIC_LOAD(&device->MixerSched, almemory_order_acquire);
+                if(sched < 0)
+                    values[0] = -1;
+                else if(param == ALC_MIXER_THREAD_PRIORITY_SOFTX)
+                    values[0] = ATOMIC_LOAD(&device->MixerPriority, almemory_order_relaxed);
+                else
+                    values[0] = (sched == althrd_sched_fifo) ? ALC_SCHED_FIFO_SOFTX :
+                                (sched == althrd_sched_rr) ? ALC_SCHED_RR_SOFTX :
+                                ALC_SCHED_OTHER_SOFTX;
+            }
+            return 1;
+
+        case ALC_PANNING_CACHE_HITS_SOFTX:
+        case ALC_PANNING_CACHE_MISSES_SOFTX:
+            {
+                ALuint hits = 0, misses = 0;
+                if(device->PanningCache)
+                    panningcache_getStats(device->PanningCache, &hits, &misses);
+                values[0] = (ALCint)((param == ALC_PANNING_CACHE_HITS_SOFTX) ? hits : misses);
+            }
+            return 1;
+
+        case ALC_OUTPUT_DELAY_SOFTX:
+            /* Frames between the mixer and the speakers, as the backend last
+             * measured them. */
+            if(device->Type == Loopback)
+            {
+                alcSetError(device, ALC_INVALID_DEVICE);
+                return 0;
+            }
+            {
+                ClockLatency clock;
+                almtx_lock(&device->BackendLock);
+                clock = V0(device->Backend,getClockLatency)();
+                values[0] = (ALCint)(clock.Latency * device->Frequency / DEVICE_CLOCK_RES);
+                almtx_unlock(&device->BackendLock);
+            }
+            return 1;
+
         default:
             alcSetError(device, ALC_INVALID_ENUM);
             return 0;
@@ -3058,6 +3279,39 @@ ALC_API void ALC_APIENTRY alcGetInteger64vSOFT(ALCdevice *device, ALCenum pname,
                 }
                 break;
 
+            case ALC_MIX_STAMPS_SOFTX:
+                if(size < 2)
+                    alcSetError(device, ALC_INVALID_VALUE);
+                else
+                {
+                    ALuint64 count, first, n;
+
+                    count = ATOMIC_LOAD(&device->MixStampCount, almemory_order_acquire);
+                    n = minu64(count, minu64(MAX_MIX_STAMPS, (ALuint64)(size-2)/2));
+                    first = count - n;
+                    for(i = 0;(ALuint64)i < n;i++)
+                    {
+                        const ALuint64 *stamp = device->MixStamps[(first+i)&(MAX_MIX_STAMPS-1)];
+                        values[2 + i*2 + 0] = stamp[0];
+                        values[2 + i*2 + 1] = stamp[1];
+                    }
+
+                    /* The mixer may have overwritten the oldest entries while
+                     * they were copied. Drop those, keeping the slot it could
+                     * be writing now as well. */
+                    count = ATOMIC_LOAD(&device->MixStampCount, almemory_order_acquire);
+                    if(count+1 > first+MAX_MIX_STAMPS)
+                    {
+                        ALuint64 lost = minu64(n, count+1 - (first+MAX_MIX_STAMPS));
+                        memmove(&values[2], &values[2 + lost*2], (size_t)(n-lost)*2*sizeof(values[0]));
+                        first += lost;
+                        n -= lost;
+                    }
+                    values[0] = first;
+                    values[1] = n;
+                }
+                break;
+
             default:
                 ivals = malloc(size * sizeof(ALCint));
                 size = GetIntegerv(device, pname, size, ivals);
@@ -3196,8 +3450,12 @@ ALC_API ALCcontext* ALC_APIENTRY alcCreateContext(ALCdevice *device, const ALCin
         ALContext->VoiceCount = 0;
         ALContext->MaxVoices = 256;
         ALContext->Voices = al_calloc(16, ALContext->MaxVoices * sizeof(ALContext->Voices[0]));
+        ALContext->VoiceMask = al_calloc(16, VOICE_MASK_WORDS(ALContext->MaxVoices) *
+                                             sizeof(ALContext->VoiceMask[0]));
+        ATOMIC_INIT(&ALContext->VoicesVisited, 0);
+        ATOMIC_INIT(&ALContext->VoicesSkipped, 0);
     }
-    if(!ALContext || !ALContext->Voices)
+    if(!ALContext || !ALContext->Voices || !ALContext->VoiceMask)
     {
         almtx_unlock(&device->BackendLock);
 
@@ -3205,6 +3463,8 @@ ALC_API ALCcontext* ALC_APIENTRY alcCreateContext(ALCdevice *device, const ALCin
         {
             al_free(ALContext->Voices);
             ALContext->Voices = NULL;
+            al_free(ALContext->VoiceMask);
+            ALContext->VoiceMask = NULL;
 
             al_free(ALContext);
             ALContext = NULL;
@@ -3221,6 +3481,8 @@ ALC_API ALCcontext* ALC_APIENTRY alcCreateContext(ALCdevice *device, const ALCin
 
         al_free(ALContext->Voices);
         ALContext->Voices = NULL;
+        al_free(ALContext->VoiceMask);
+        ALContext->VoiceMask = NULL;
 
         al_free(ALContext);
         ALContext = NULL;
@@ -3432,6 +3694,9 @@ ALC_API ALCdevice* ALC_APIENTRY alcOpenDevice(const ALCchar *deviceName)
     device->Flags = 0;
     device->Bs2b = NULL;
     device->Uhj_Encoder = NULL;
+    device->MixPool = NULL;
+    device->HrtfBatch = NULL;
+    device->PanningCache = NULL;
     VECTOR_INIT(device->Hrtf.List);
     AL_STRING_INIT(device->Hrtf.Name);
     device->Render_Mode = NormalRender;
@@ -3447,6 +3712,13 @@ ALC_API ALCdevice* ALC_APIENTRY alcOpenDevice(const ALCchar *deviceName)
 
     device->ClockBase = 0;
     device->SamplesDone = 0;
+    ATOMIC_INIT(&device->Underruns, 0);
+    device->CullLevel = 0.0f;
+    ATOMIC_INIT(&device->VoiceUpdates, 0);
+    ATOMIC_INIT(&device->CulledVoiceUpdates, 0);
+    ATOMIC_INIT(&device->MixerSched, -1);
+    ATOMIC_INIT(&device->MixerPriority, 0);
+    ATOMIC_INIT(&device->MixStampCount, 0);
 
     device->SourcesMax = 256;
     device->AuxiliaryEffectSlotMax = 4;
@@ -3921,6 +4193,9 @@ ALC_API ALCdevice* ALC_APIENTRY alcLoopbackOpenDeviceSOFT(const ALCchar *deviceN
     AL_STRING_INIT(device->Hrtf.Name);
     device->Bs2b = NULL;
     device->Uhj_Encoder = NULL;
+    device->MixPool = NULL;
+    device->HrtfBatch = NULL;
+    device->PanningCache = NULL;
     device->Render_Mode = NormalRender;
     AL_STRING_INIT(device->DeviceName);
     device->Dry.Buffer = NULL;
@@ -3934,6 +4209,13 @@ ALC_API ALCdevice* ALC_APIENTRY alcLoopbackOpenDeviceSOFT(const ALCchar *deviceN
 
     device->ClockBase = 0;
     device->SamplesDone = 0;
+    ATOMIC_INIT(&device->Underruns, 0);
+    device->CullLevel = 0.0f;
+    ATOMIC_INIT(&device->VoiceUpdates, 0);
+    ATOMIC_INIT(&device->CulledVoiceUpdates, 0);
+    ATOMIC_INIT(&device->MixerSched, -1);
+    ATOMIC_INIT(&device->MixerPriority, 0);
+    ATOMIC_INIT(&device->MixStampCount, 0);
 
     device->SourcesMax = 256;
     device->AuxiliaryEffectSlotMax = 4;
@@ -4070,6 +4352,7 @@ ALC_API void ALC_APIENTRY alcDeviceResumeSOFT(ALCdevice *device)
             device->Flags &= ~DEVICE_PAUSED;
             if(ATOMIC_LOAD_SEQ(&device->ContextList) != NULL)
             {
+                ATOMIC_STORE(&device->MixerSched, -1, almemory_order_relaxed);
                 if(V0(device->Backend,start)() != ALC_FALSE)
                     device->Flags |= DEVICE_RUNNING;
                 else
@@ -31,11 +31,14 @@
 #include "alBuffer.h"
 #include "alListener.h"
 #include "alAuxEffectSlot.h"
+#include "alEmitter.h"
 #include "alu.h"
 #include "bs2b.h"
 #include "hrtf.h"
+#include "hrtfbatch.h"
 #include "uhjfilter.h"
 #include "bformatdec.h"
+#include "mixpool.h"
 #include "static_assert.h"
 
 #include "mixer_defs.h"
@@ -103,6 +106,10 @@ const aluMatrixf IdentityMatrixf = {{
 
 static inline HrtfDirectMixerFunc SelectHrtfMixer(void)
 {
+#ifdef HAVE_AVX2
+    if((CPUCapFlags&CPU_CAP_AVX2))
+        return MixDirectHrtf_AVX2;
+#endif
 #ifdef HAVE_SSE
     if((CPUCapFlags&CPU_CAP_SSE))
         return MixDirectHrtf_SSE;
@@ -661,6 +668,7 @@ static void CalcNonAttnSourceParams(ALvoice *voice, const struct ALsourceProps *
             }
 
             voice->IsHrtf = AL_TRUE;
+            voice->HrtfGroup = -1;
         }
         else
         {
@@ -775,6 +783,130 @@ static void CalcNonAttnSourceParams(ALvoice *voice, const struct ALsourceProps *
     }
 }
 
+/* A voice starting from a fixed direction is mixed into the batch group for
+ * that direction, and stays there until its direction changes. It then
+ * continues on its own, fading from the group's coefficients.
+ */
+static void UpdateHrtfBatchGroup(ALvoice *voice, struct HrtfBatch *batch, ALuint key)
+{
+    if(!voice->Moving || (voice->HrtfGroup >= 0 && key == voice->HrtfKey))
+        voice->HrtfGroup = hrtfbatch_getGroup(batch, key);
+    else if(voice->HrtfGroup >= 0)
+    {
+        voice->Chan[0].Direct.Hrtf.Current = voice->Chan[0].Direct.Hrtf.Target;
+        voice->HrtfGroup = -1;
+    }
+    voice->HrtfKey = key;
+}
+
+/* The group's coefficients are for unit gain. Keep the scaled ones too, in
+ * case the voice has to continue on its own.
+ */
+static void CalcHrtfBatchTarget(ALvoice *voice, const ALCdevice *Device, ALfloat gain)
+{
+    const HrtfParams *hrtfparams = hrtfbatch_getParams(Device->HrtfBatch, voice->HrtfGroup);
+    ALuint j;
+
+    for(j = 0;j < Device->Hrtf.Handle->irSize;j++)
+    {
+        voice->Chan[0].Direct.Hrtf.Target.Coeffs[j][0] = hrtfparams->Coeffs[j][0] * gain;
+        voice->Chan[0].Direct.Hrtf.Target.Coeffs[j][1] = hrtfparams->Coeffs[j][1] * gain;
+    }
+    voice->Chan[0].Direct.Hrtf.Target.Delay[0] = hrtfparams->Delay[0];
+    voice->Chan[0].Direct.Hrtf.Target.Delay[1] = hrtfparams->Delay[1];
+}
+
+static void StoreEmitterParams(ALemitter *emitter, const ALvoice *voice, const ALCcontext *ALContext, const ALbuffer *ALBuffer)
+{
+    const ALCdevice *Device = ALContext->Device;
+    ALemitterParams *params = &emitter->Params;
+    ALuint i;
+
+    params->Step = voice->Step;
+    params->SincState = voice->SincState;
+    params->IsHrtf = voice->IsHrtf;
+    params->HrtfKey = voice->HrtfKey;
+
+    params->DirectOut.Buffer = voice->DirectOut.Buffer;
+    params->DirectOut.Channels = voice->DirectOut.Channels;
+    params->Direct.FilterType = voice->Chan[0].Direct.FilterType;
+    params->Direct.LowPass = voice->Chan[0].Direct.LowPass;
+    params->Direct.HighPass = voice->Chan[0].Direct.HighPass;
+    if(voice->IsHrtf)
+        params->Direct.Hrtf = voice->Chan[0].Direct.Hrtf.Target;
+    memcpy(params->Direct.Gains, voice->Chan[0].Direct.Gains.Target, sizeof(params->Direct.Gains));
+    for(i = 0;i < Device->NumAuxSends;i++)
+    {
+        params->SendOut[i].Buffer = voice->SendOut[i].Buffer;
+        params->SendOut[i].Channels = voice->SendOut[i].Channels;
+        params->Send[i].FilterType = voice->Chan[0].Send[i].FilterType;
+        params->Send[i].LowPass = voice->Chan[0].Send[i].LowPass;
+        params->Send[i].HighPass = voice->Chan[0].Send[i].HighPass;
+        memcpy(params->Send[i].Gains, voice->Chan[0].Send[i].Gains.Target,
+               sizeof(params->Send[i].Gains));
+    }
+
+    emitter->ParamsProps = voice->Props;
+    emitter->ParamsFrequency = ALBuffer->Frequency;
+    emitter->ParamsGen = ALContext->EmitterParamsGen;
+    emitter->ParamsValid = AL_TRUE;
+}
+
+static ALboolean ApplyEmitterParams(ALvoice *voice, const struct ALsourceProps *props, const ALemitter *emitter, const ALbuffer *ALBuffer, const ALCcontext *ALContext)
+{
+    const ALCdevice *Device = ALContext->Device;
+    const ALemitterParams *params = &emitter->Params;
+    ALuint i;
+
+    /* The parameters only depend on the source properties, the buffer's
+     * sample rate, and the listener, effect slot, and device state covered
+     * by the generation count. A property block that compares equal
+     * byte-for-byte certainly has the same values.
+     */
+    if(!emitter->ParamsValid || emitter->ParamsGen != ALContext->EmitterParamsGen ||
+       emitter->ParamsFrequency != ALBuffer->Frequency ||
+       memcmp(&emitter->ParamsProps, props, offsetof(struct ALsourceProps, next)) != 0)
+        return AL_FALSE;
+
+    voice->Step = params->Step;
+    voice->SincState = params->SincState;
+
+    voice->DirectOut.Buffer = params->DirectOut.Buffer;
+    voice->DirectOut.Channels = params->DirectOut.Channels;
+    voice->Chan[0].Direct.FilterType = params->Direct.FilterType;
+    ALfilterState_copyParams(&voice->Chan[0].Direct.LowPass, &params->Direct.LowPass);
+    ALfilterState_copyParams(&voice->Chan[0].Direct.HighPass, &params->Direct.HighPass);
+    memcpy(voice->Chan[0].Direct.Gains.Target, params->Direct.Gains,
+           sizeof(voice->Chan[0].Direct.Gains.Target));
+    for(i = 0;i < Device->NumAuxSends;i++)
+    {
+        voice->SendOut[i].Buffer = params->SendOut[i].Buffer;
+        voice->SendOut[i].Channels = params->SendOut[i].Channels;
+        voice->Chan[0].Send[i].FilterType = params->Send[i].FilterType;
+        ALfilterState_copyParams(&voice->Chan[0].Send[i].LowPass, &params->Send[i].LowPass);
+        ALfilterState_copyParams(&voice->Chan[0].Send[i].HighPass, &params->Send[i].HighPass);
+        memcpy(voice->Chan[0].Send[i].Gains.Target, params->Send[i].Gains,
+               sizeof(voice->Chan[0].Send[i].Gains.Target));
+    }
+
+    if(params->IsHrtf)
+    {
+        if(!Device->HrtfBatch)
+            voice->HrtfGroup = -1;
+        else
+            UpdateHrtfBatchGroup(voice, Device->HrtfBatch, params->HrtfKey);
+
+        /* The dry gain was stored for the batch group. */
+        if(voice->HrtfGroup >= 0)
+            CalcHrtfBatchTarget(voice, Device, params->Direct.Gains[0]);
+        else
+            voice->Chan[0].Direct.Hrtf.Target = params->Direct.Hrtf;
+    }
+    voice->IsHrtf = params->IsHrtf;
+
+    return AL_TRUE;
+}
+
 static void CalcAttnSourceParams(ALvoice *voice, const struct ALsourceProps *props, const ALbuffer *ALBuffer, const ALCcontext *ALContext)
 {
     const ALCdevice *Device = ALContext->Device;
@@ -805,8 +937,16 @@ static void CalcAttnSourceParams(ALvoice *voice, const struct ALsourceProps *pro
     ALfloat Pitch;
     ALuint Frequency;
     ALint NumSends;
+    ALemitter *Emitter;
     ALint i;
 
+    /* Sources bound to a static emitter reuse the parameters calculated for
+     * the last voice started on it, if nothing changed since.
+     */
+    Emitter = ATOMIC_LOAD(&props->Emitter, almemory_order_relaxed);
+    if(Emitter && ApplyEmitterParams(voice, props, Emitter, ALBuffer, ALContext))
+        return;
+
     DryGainHF = 1.0f;
     DryGainLF = 1.0f;
     for(i = 0;i < MAX_SENDS;i++)
@@ -1149,12 +1289,23 @@ static void CalcAttnSourceParams(ALvoice *voice, const struct ALsourceProps *pro
         else if(Distance > FLT_EPSILON)
             spread = asinf(radius / Distance) * 2.0f;
 
-        /* Get the HRIR coefficients and delays. */
-        GetHrtfCoeffs(Device->Hrtf.Handle, ev, az, spread, DryGain,
-                      voice->Chan[0].Direct.Hrtf.Target.Coeffs,
-                      voice->Chan[0].Direct.Hrtf.Target.Delay);
+        if(!Device->HrtfBatch)
+            voice->HrtfGroup = -1;
+        else
+            UpdateHrtfBatchGroup(voice, Device->HrtfBatch, hrtfbatch_getKey(ev, az, spread));
+
+        /* Get the HRIR coefficients and delays. The gain is what the dry
+         * signal is mixed into a batch group with.
+         */
+        voice->Chan[0].Direct.Gains.Target[0] = (DryGain > 0.0001f) ? DryGain : 0.0f;
+        if(voice->HrtfGroup >= 0)
+            CalcHrtfBatchTarget(voice, Device, voice->Chan[0].Direct.Gains.Target[0]);
+        else
+            GetHrtfCoeffs(Device->Hrtf.Handle, ev, az, spread, DryGain,
+                          voice->Chan[0].Direct.Hrtf.Target.Coeffs,
+                          voice->Chan[0].Direct.Hrtf.Target.Delay);
 
-        CalcDirectionCoeffs(dir, spread, coeffs);
+        CalcCachedPanning(Device, dir, spread, coeffs, 0.0f, NULL);
 
         for(i = 0;i < NumSends;i++)
         {
@@ -1204,14 +1355,11 @@ static void CalcAttnSourceParams(ALvoice *voice, const struct ALsourceProps *pro
             for(i = 2;i < MAX_OUTPUT_CHANNELS;i++)
                 voice->Chan[0].Direct.Gains.Target[i] = 0.0f;
 
-            CalcDirectionCoeffs(dir, spread, coeffs);
+            CalcCachedPanning(Device, dir, spread, coeffs, 0.0f, NULL);
         }
         else
-        {
-            CalcDirectionCoeffs(dir, spread, coeffs);
-            ComputePanningGains(Device->Dry, coeffs, DryGain,
-                                voice->Chan[0].Direct.Gains.Target);
-        }
+            CalcCachedPanning(Device, dir, spread, coeffs, DryGain,
+                              voice->Chan[0].Direct.Gains.Target);
 
         for(i = 0;i < NumSends;i++)
         {
@@ -1271,6 +1419,9 @@ static void CalcAttnSourceParams(ALvoice *voice, const struct ALsourceProps *pro
             WetGainLF[i], lfscale, calc_rcpQ_from_slope(WetGainLF[i], 0.75f)
         );
     }
+
+    if(Emitter)
+        StoreEmitterParams(Emitter, voice, ALContext, ALBuffer);
 }
 
 static void CalcSourceParams(ALvoice *voice, ALCcontext *context, ALboolean force)
@@ -1308,8 +1459,9 @@ static void CalcSourceParams(ALvoice *voice, ALCcontext *context, ALboolean forc
 
 static void UpdateContextSources(ALCcontext *ctx, ALeffectslot *slot)
 {
-    ALvoice *voice, *voice_end;
+    ALvoice *voice;
     ALsource *source;
+    ALsizei i;
 
     IncrementRef(&ctx->UpdateCount);
     if(!ATOMIC_LOAD(&ctx->HoldUpdates, almemory_order_acquire))
@@ -1320,14 +1472,16 @@ static void UpdateContextSources(ALCcontext *ctx, ALeffectslot *slot)
             force |= CalcEffectSlotParams(slot, ctx->Device);
             slot = ATOMIC_LOAD(&slot->next, almemory_order_relaxed);
         }
+        if(force)
+            ctx->EmitterParamsGen++;
 
-        voice = ctx->Voices;
-        voice_end = voice + ctx->VoiceCount;
-        for(;voice != voice_end;++voice)
+        for(i = NextActiveVoice(ctx->VoiceMask, 0, ctx->VoiceCount);i < ctx->VoiceCount;
+            i = NextActiveVoice(ctx->VoiceMask, i+1, ctx->VoiceCount))
         {
-            if(!(source=voice->Source)) continue;
+            voice = &ctx->Voices[i];
+            source = voice->Source;
             if(source->state != AL_PLAYING && source->state != AL_PAUSED)
-                voice->Source = NULL;
+                SetVoiceSource(ctx, voice, NULL);
             else
                 CalcSourceParams(voice, ctx, force);
         }
@@ -1395,14 +1549,30 @@ DECL_TEMPLATE(ALbyte, aluF2B)
 ALvoid aluMixData(ALCdevice *device, ALvoid *buffer, ALsizei size)
 {
     ALuint SamplesToDo;
-    ALvoice *voice, *voice_end;
+    ALuint64 begin, stamps;
+    ALuint updates, culled;
+    ALuint visited;
+    ALvoice *voice;
     ALeffectslot *slot;
     ALsource *source;
     ALCcontext *ctx;
     FPUCtl oldMode;
+    ALsizei v;
     ALuint i, c;
 
     SetMixerFPUMode(&oldMode);
+    begin = ReadTimestamp();
+
+    /* Note what the thread mixing for the device was given, once it starts. */
+    if(ATOMIC_LOAD(&device->MixerSched, almemory_order_relaxed) == -1)
+    {
+        int sched, priority;
+        if(althrd_getsched(althrd_current(), &sched, &priority) != althrd_success)
+            sched = -2;
+        else
+            ATOMIC_STORE(&device->MixerPriority, priority, almemory_order_relaxed);
+        ATOMIC_STORE(&device->MixerSched, sched, almemory_order_release);
+    }
 
     while(size > 0)
     {
@@ -1421,11 +1591,18 @@ ALvoid aluMixData(ALCdevice *device, ALvoid *buffer, ALsizei size)
 
         if((slot=device->DefaultSlot) != NULL)
         {
-            CalcEffectSlotParams(device->DefaultSlot, device);
+            if(CalcEffectSlotParams(device->DefaultSlot, device))
+            {
+                /* Sources send to the default slot of every context. */
+                ctx = ATOMIC_LOAD(&device->ContextList, almemory_order_acquire);
+                for(;ctx;ctx = ctx->next)
+                    ctx->EmitterParamsGen++;
+            }
             for(i = 0;i < slot->NumChannels;i++)
                 memset(slot->WetBuffer[i], 0, SamplesToDo*sizeof(ALfloat));
         }
 
+        updates = culled = 0;
         ctx = ATOMIC_LOAD(&device->ContextList, almemory_order_acquire);
         while(ctx)
         {
@@ -1442,15 +1619,29 @@ ALvoid aluMixData(ALCdevice *device, ALvoid *buffer, ALsizei size)
                 slot = ATOMIC_LOAD(&slot->next, almemory_order_relaxed);
             }
 
-            /* source processing */
-            voice = ctx->Voices;
-            voice_end = voice + ctx->VoiceCount;
-            for(;voice != voice_end;++voice)
+            /* source processing, visiting only the voices in use */
+            visited = 0;
+            for(i = 0;i < (ALuint)VOICE_MASK_WORDS(ctx->VoiceCount);i++)
+                visited += CountSetBits64(ctx->VoiceMask[i]);
+            ATOMIC_ADD(&ctx->VoicesVisited, visited, almemory_order_relaxed);
+            ATOMIC_ADD(&ctx->VoicesSkipped, ctx->VoiceCount-visited, almemory_order_relaxed);
+
+            if(!device->MixPool ||
+               !mixpool_mixVoices(device->MixPool, device, ctx, slotroot, SamplesToDo,
+                                  &updates, &culled))
             {
-                ALboolean IsVoiceInit = (voice->Step > 0);
-                source = voice->Source;
-                if(source && source->state == AL_PLAYING && IsVoiceInit)
-                    MixSource(voice, source, device, SamplesToDo);
+                for(v = NextActiveVoice(ctx->VoiceMask, 0, ctx->VoiceCount);v < ctx->VoiceCount;
+                    v = NextActiveVoice(ctx->VoiceMask, v+1, ctx->VoiceCount))
+                {
+                    voice = &ctx->Voices[v];
+                    source = voice->Source;
+                    if(source->state == AL_PLAYING && voice->Step > 0)
+                    {
+                        updates++;
+                        if(MixSource(voice, source, device, NULL, SamplesToDo))
+                            culled++;
+                    }
+                }
             }
 
             /* effect slot processing */
@@ -1465,6 +1656,16 @@ ALvoid aluMixData(ALCdevice *device, ALvoid *buffer, ALsizei size)
 
             ctx = ctx->next;
         }
+        ATOMIC_ADD(&device->VoiceUpdates, updates, almemory_order_relaxed);
+        ATOMIC_ADD(&device->CulledVoiceUpdates, culled, almemory_order_relaxed);
+
+        if(device->HrtfBatch)
+        {
+            int lidx = GetChannelIdxByName(device->RealOut, FrontLeft);
+            int ridx = GetChannelIdxByName(device->RealOut, FrontRight);
+            assert(lidx != -1 && ridx != -1);
+            hrtfbatch_mix(device->HrtfBatch, device->RealOut.Buffer, lidx, ridx, SamplesToDo);
+        }
 
         if(device->DefaultSlot != NULL)
         {
@@ -1586,6 +1787,11 @@ ALvoid aluMixData(ALCdevice *device, ALvoid *buffer, ALsizei size)
         size -= SamplesToDo;
     }
 
+    stamps = ATOMIC_LOAD(&device->MixStampCount, almemory_order_relaxed);
+    device->MixStamps[stamps&(MAX_MIX_STAMPS-1)][0] = begin;
+    device->MixStamps[stamps&(MAX_MIX_STAMPS-1)][1] = ReadTimestamp();
+    ATOMIC_STORE(&device->MixStampCount, stamps+1, almemory_order_release);
+
     RestoreFPUMode(&oldMode);
 }
 
@@ -1606,7 +1812,7 @@ ALvoid aluHandleDisconnect(ALCdevice *device)
         while(voice != voice_end)
         {
             ALsource *source = voice->Source;
-            voice->Source = NULL;
+            SetVoiceSource(Context, voice, NULL);
 
             if(source && source->state == AL_PLAYING)
             {
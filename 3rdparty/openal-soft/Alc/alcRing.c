@@ -27,6 +27,8 @@
 #include "threads.h"
 #include "almalloc.h"
 #include "compat.h"
+#include "static_assert.h"
+#include "alshm.h"
 
 
 /* NOTE: This lockless ringbuffer implementation is copied from JACK, extended
@@ -67,6 +69,45 @@ ll_ringbuffer_t *ll_ringbuffer_create(size_t sz, size_t elem_sz)
     return rb;
 }
 
+/* The shm backend builds rings in shared memory that other processes read
+ * through the layout in alshm.h. */
+static_assert(offsetof(struct ll_ringbuffer, write_ptr) == offsetof(ALshmRing, write_ptr) &&
+              offsetof(struct ll_ringbuffer, read_ptr) == offsetof(ALshmRing, read_ptr) &&
+              offsetof(struct ll_ringbuffer, size) == offsetof(ALshmRing, size) &&
+              offsetof(struct ll_ringbuffer, size_mask) == offsetof(ALshmRing, size_mask) &&
+              offsetof(struct ll_ringbuffer, elem_size) == offsetof(ALshmRing, elem_size) &&
+              offsetof(struct ll_ringbuffer, buf) == ALSHM_RING_DATA_OFFSET,
+              "ll_ringbuffer does not match the shared memory layout");
+
+/* Return the number of bytes a ringbuffer holding at least `sz' elements of
+ * `elem_sz' bytes takes, or 0 if it's too big. */
+size_t ll_ringbuffer_bytes(size_t sz, size_t elem_sz)
+{
+    ALuint power_of_two;
+
+    power_of_two = NextPowerOf2(sz);
+    if(power_of_two < sz || power_of_two > (SIZE_MAX-sizeof(struct ll_ringbuffer))/elem_sz)
+        return 0;
+    return sizeof(struct ll_ringbuffer) + power_of_two*elem_sz;
+}
+
+/* Create a ringbuffer like ll_ringbuffer_create, in the memory at `mem'. It
+ * must be 16-byte aligned and hold ll_ringbuffer_bytes(sz, elem_sz) bytes.
+ * The caller keeps ownership of the memory; don't pass the result to
+ * ll_ringbuffer_free. */
+ll_ringbuffer_t *ll_ringbuffer_init(void *mem, size_t sz, size_t elem_sz)
+{
+    ll_ringbuffer_t *rb = mem;
+
+    ATOMIC_INIT(&rb->write_ptr, 0);
+    ATOMIC_INIT(&rb->read_ptr, 0);
+    rb->size = NextPowerOf2(sz);
+    rb->size_mask = rb->size - 1;
+    rb->elem_size = elem_sz;
+    rb->mlocked = 0;
+    return rb;
+}
+
 /* Free all data associated with the ringbuffer `rb'. */
 void ll_ringbuffer_free(ll_ringbuffer_t *rb)
 {
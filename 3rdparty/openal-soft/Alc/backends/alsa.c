@@ -23,6 +23,8 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <memory.h>
+#include <errno.h>
+#include <sys/mman.h>
 
 #include "alMain.h"
 #include "alu.h"
@@ -86,6 +88,7 @@ static const ALCchar alsaDevice[] = "ALSA Default";
     MAGIC(snd_pcm_delay);                                                     \
     MAGIC(snd_pcm_state);                                                     \
     MAGIC(snd_pcm_avail_update);                                              \
+    MAGIC(snd_pcm_avail_delay);                                               \
     MAGIC(snd_pcm_areas_silence);                                             \
     MAGIC(snd_pcm_mmap_begin);                                                \
     MAGIC(snd_pcm_mmap_commit);                                               \
@@ -164,6 +167,7 @@ ALSA_FUNCS(MAKE_FUNC);
 #define snd_pcm_delay psnd_pcm_delay
 #define snd_pcm_state psnd_pcm_state
 #define snd_pcm_avail_update psnd_pcm_avail_update
+#define snd_pcm_avail_delay psnd_pcm_avail_delay
 #define snd_pcm_areas_silence psnd_pcm_areas_silence
 #define snd_pcm_mmap_begin psnd_pcm_mmap_begin
 #define snd_pcm_mmap_commit psnd_pcm_mmap_commit
@@ -394,12 +398,25 @@ typedef struct ALCplaybackAlsa {
     ALvoid *buffer;
     ALsizei size;
 
+    /* Mix straight into the mmap'd buffer from a SCHED_FIFO thread, waking up
+     * when the measured delay says a period is free, with the buffers it
+     * touches locked into memory.
+     */
+    ALboolean lowLatency;
+    struct {
+        void *ptr;
+        size_t len;
+    } locked[2];
+    /* Size of the negotiated hardware buffer, which is what gets mapped. */
+    snd_pcm_uframes_t bufferFrames;
+
     volatile int killNow;
     althrd_t thread;
 } ALCplaybackAlsa;
 
 static int ALCplaybackAlsa_mixerProc(void *ptr);
 static int ALCplaybackAlsa_mixerNoMMapProc(void *ptr);
+static int ALCplaybackAlsa_mixerLowLatencyProc(void *ptr);
 
 static void ALCplaybackAlsa_Construct(ALCplaybackAlsa *self, ALCdevice *device);
 static DECLARE_FORWARD(ALCplaybackAlsa, ALCbackend, void, Destruct)
@@ -422,6 +439,37 @@ static void ALCplaybackAlsa_Construct(ALCplaybackAlsa *self, ALCdevice *device)
 {
     ALCbackend_Construct(STATIC_CAST(ALCbackend, self), device);
     SET_VTABLE2(ALCplaybackAlsa, ALCbackend, self);
+
+    self->lowLatency = AL_FALSE;
+    memset(self->locked, 0, sizeof(self->locked));
+}
+
+
+/* Locks `len' bytes at `ptr' into memory, like ll_ringbuffer_mlock, so the
+ * mixer doesn't page fault on them. Failing (e.g. on RLIMIT_MEMLOCK) is not
+ * fatal. */
+static void ALCplaybackAlsa_lockMemory(ALCplaybackAlsa *self, int idx, void *ptr, size_t len)
+{
+    if(mlock(ptr, len) != 0)
+    {
+        WARN("Failed to lock "SZFMT" bytes into memory: %s\n", len, strerror(errno));
+        return;
+    }
+    self->locked[idx].ptr = ptr;
+    self->locked[idx].len = len;
+}
+
+static void ALCplaybackAlsa_unlockMemory(ALCplaybackAlsa *self)
+{
+    size_t i;
+
+    for(i = 0;i < COUNTOF(self->locked);i++)
+    {
+        if(self->locked[i].ptr)
+            munlock(self->locked[i].ptr, self->locked[i].len);
+        self->locked[i].ptr = NULL;
+        self->locked[i].len = 0;
+    }
 }
 
 
@@ -452,6 +500,8 @@ static int ALCplaybackAlsa_mixerProc(void *ptr)
             ALCplaybackAlsa_unlock(self);
             break;
         }
+        if(state == SND_PCM_STATE_XRUN)
+            ATOMIC_ADD(&device->Underruns, 1, almemory_order_relaxed);
 
         avail = snd_pcm_avail_update(self->pcmHandle);
         if(avail < 0)
@@ -517,6 +567,112 @@ static int ALCplaybackAlsa_mixerProc(void *ptr)
     return 0;
 }
 
+static int ALCplaybackAlsa_mixerLowLatencyProc(void *ptr)
+{
+    ALCplaybackAlsa *self = (ALCplaybackAlsa*)ptr;
+    ALCdevice *device = STATIC_CAST(ALCbackend, self)->mDevice;
+    const snd_pcm_channel_area_t *areas = NULL;
+    snd_pcm_uframes_t update_size, num_updates;
+    snd_pcm_sframes_t avail, delay, commitres;
+    snd_pcm_uframes_t offset, frames;
+    char *WritePtr;
+    int err;
+
+    if(althrd_setsched(althrd_current(), althrd_sched_fifo, maxi(RTPrioLevel, 1)) != althrd_success)
+    {
+        WARN("Failed to set SCHED_FIFO for the mixer thread\n");
+        SetRTPriority();
+    }
+    else
+        SetRTAffinity();
+    althrd_setname(althrd_current(), MIXER_THREAD_NAME);
+
+    update_size = device->UpdateSize;
+    num_updates = device->NumUpdates;
+    while(!self->killNow)
+    {
+        int state = verify_state(self->pcmHandle);
+        if(state < 0)
+        {
+            ERR("Invalid state detected: %s\n", snd_strerror(state));
+            ALCplaybackAlsa_lock(self);
+            aluHandleDisconnect(device);
+            ALCplaybackAlsa_unlock(self);
+            break;
+        }
+        if(state == SND_PCM_STATE_XRUN)
+            ATOMIC_ADD(&device->Underruns, 1, almemory_order_relaxed);
+
+        err = snd_pcm_avail_delay(self->pcmHandle, &avail, &delay);
+        if(err < 0)
+        {
+            ERR("available delay failed: %s\n", snd_strerror(err));
+            continue;
+        }
+
+        if((snd_pcm_uframes_t)avail > update_size*(num_updates+1))
+        {
+            WARN("available samples exceeds the buffer size\n");
+            snd_pcm_reset(self->pcmHandle);
+            continue;
+        }
+
+        if((snd_pcm_uframes_t)avail < update_size)
+        {
+            if(state != SND_PCM_STATE_RUNNING)
+            {
+                err = snd_pcm_start(self->pcmHandle);
+                if(err < 0)
+                    ERR("start failed: %s\n", snd_strerror(err));
+                continue;
+            }
+            /* The next period is free once the hardware has played the part
+             * of it that's still queued. Sleep until then instead of waiting
+             * for the period interrupt, which may come late.
+             */
+            al_nssleep((long)((update_size-avail) * 1000000000 / device->Frequency));
+            continue;
+        }
+        avail -= avail%update_size;
+
+        ALCplaybackAlsa_lock(self);
+        while(avail > 0)
+        {
+            frames = avail;
+
+            err = snd_pcm_mmap_begin(self->pcmHandle, &areas, &offset, &frames);
+            if(err < 0)
+            {
+                ERR("mmap begin error: %s\n", snd_strerror(err));
+                break;
+            }
+
+            /* The areas point at the start of the hardware buffer, which may
+             * be larger than the periods we asked for. */
+            if(!self->locked[0].ptr)
+                ALCplaybackAlsa_lockMemory(self, 0, areas->addr,
+                    snd_pcm_frames_to_bytes(self->pcmHandle, self->bufferFrames)
+                );
+
+            WritePtr = (char*)areas->addr + (offset * areas->step / 8);
+            aluMixData(device, WritePtr, frames);
+
+            commitres = snd_pcm_mmap_commit(self->pcmHandle, offset, frames);
+            if(commitres < 0 || (commitres-frames) != 0)
+            {
+                ERR("mmap commit error: %s\n",
+                    snd_strerror(commitres >= 0 ? -EPIPE : commitres));
+                break;
+            }
+
+            avail -= frames;
+        }
+        ALCplaybackAlsa_unlock(self);
+    }
+
+    return 0;
+}
+
 static int ALCplaybackAlsa_mixerNoMMapProc(void *ptr)
 {
     ALCplaybackAlsa *self = (ALCplaybackAlsa*)ptr;
@@ -542,6 +698,8 @@ static int ALCplaybackAlsa_mixerNoMMapProc(void *ptr)
             ALCplaybackAlsa_unlock(self);
             break;
         }
+        if(state == SND_PCM_STATE_XRUN)
+            ATOMIC_ADD(&device->Underruns, 1, almemory_order_relaxed);
 
         avail = snd_pcm_avail_update(self->pcmHandle);
         if(avail < 0)
@@ -590,6 +748,8 @@ static int ALCplaybackAlsa_mixerNoMMapProc(void *ptr)
 #endif
             case -EPIPE:
             case -EINTR:
+                if(ret == -EPIPE)
+                    ATOMIC_ADD(&device->Underruns, 1, almemory_order_relaxed);
                 ret = snd_pcm_recover(self->pcmHandle, ret, 1);
                 if(ret < 0)
                     avail = 0;
@@ -705,6 +865,7 @@ static ALCboolean ALCplaybackAlsa_reset(ALCplaybackAlsa *self)
     }
 
     allowmmap = GetConfigValueBool(al_string_get_cstr(device->DeviceName), "alsa", "mmap", 1);
+    self->lowLatency = GetConfigValueBool(al_string_get_cstr(device->DeviceName), "alsa", "low-latency", 0);
     periods = device->NumUpdates;
     periodLen = (ALuint64)device->UpdateSize * 1000000 / device->Frequency;
     bufferLen = periodLen * periods;
@@ -714,7 +875,12 @@ static ALCboolean ALCplaybackAlsa_reset(ALCplaybackAlsa *self)
 #define CHECK(x) if((funcerr=#x),(err=(x)) < 0) goto error
     CHECK(snd_pcm_hw_params_any(self->pcmHandle, hp));
     /* set interleaved access */
-    if(!allowmmap || snd_pcm_hw_params_set_access(self->pcmHandle, hp, SND_PCM_ACCESS_MMAP_INTERLEAVED) < 0)
+    if(self->lowLatency)
+    {
+        /* Low-latency mode mixes in place; don't fall back to copies. */
+        CHECK(snd_pcm_hw_params_set_access(self->pcmHandle, hp, SND_PCM_ACCESS_MMAP_INTERLEAVED));
+    }
+    else if(!allowmmap || snd_pcm_hw_params_set_access(self->pcmHandle, hp, SND_PCM_ACCESS_MMAP_INTERLEAVED) < 0)
     {
         /* No mmap */
         CHECK(snd_pcm_hw_params_set_access(self->pcmHandle, hp, SND_PCM_ACCESS_RW_INTERLEAVED));
@@ -835,6 +1001,7 @@ static ALCboolean ALCplaybackAlsa_start(ALCplaybackAlsa *self)
     CHECK(snd_pcm_hw_params_current(self->pcmHandle, hp));
     /* retrieve configuration info */
     CHECK(snd_pcm_hw_params_get_access(hp, &access));
+    CHECK(snd_pcm_hw_params_get_buffer_size(hp, &self->bufferFrames));
 #undef CHECK
     snd_pcm_hw_params_free(hp);
     hp = NULL;
@@ -859,11 +1026,28 @@ static ALCboolean ALCplaybackAlsa_start(ALCplaybackAlsa *self)
             return ALC_FALSE;
         }
         thread_func = ALCplaybackAlsa_mixerProc;
+        if(self->lowLatency)
+        {
+            /* The dry buffer is one allocation that the real and first-order
+             * outputs point into, so lock it up to whichever ends last. The
+             * hardware buffer is locked by the mixer once it's mapped.
+             */
+            ALfloat (*end)[BUFFERSIZE] = device->Dry.Buffer + device->Dry.NumChannels;
+            if(device->RealOut.Buffer + device->RealOut.NumChannels > end)
+                end = device->RealOut.Buffer + device->RealOut.NumChannels;
+            if(device->FOAOut.Buffer + device->FOAOut.NumChannels > end)
+                end = device->FOAOut.Buffer + device->FOAOut.NumChannels;
+            ALCplaybackAlsa_lockMemory(self, 1, device->Dry.Buffer,
+                                       (char*)end - (char*)device->Dry.Buffer);
+
+            thread_func = ALCplaybackAlsa_mixerLowLatencyProc;
+        }
     }
     self->killNow = 0;
     if(althrd_create(&self->thread, thread_func, self) != althrd_success)
     {
         ERR("Could not create playback thread\n");
+        ALCplaybackAlsa_unlockMemory(self);
         al_free(self->buffer);
         self->buffer = NULL;
         return ALC_FALSE;
@@ -887,6 +1071,7 @@ static void ALCplaybackAlsa_stop(ALCplaybackAlsa *self)
     self->killNow = 1;
     althrd_join(self->thread, &res);
 
+    ALCplaybackAlsa_unlockMemory(self);
     al_free(self->buffer);
     self->buffer = NULL;
 }
@@ -584,6 +584,7 @@ FORCE_ALIGN static int ALCmmdevPlayback_mixerProc(void *arg)
     ALCdevice *device = STATIC_CAST(ALCbackend, self)->mDevice;
     UINT32 buffer_len, written;
     ALuint update_size, len;
+    ALboolean started = AL_FALSE;
     BYTE *buffer;
     HRESULT hr;
 
@@ -614,6 +615,11 @@ FORCE_ALIGN static int ALCmmdevPlayback_mixerProc(void *arg)
             break;
         }
         self->Padding = written;
+        /* Nothing left queued once playback started means the device ran dry
+         * waiting for us.
+         */
+        if(written == 0 && started)
+            ATOMIC_ADD(&device->Underruns, 1, almemory_order_relaxed);
 
         len = buffer_len - written;
         if(len < update_size)
@@ -634,6 +640,7 @@ FORCE_ALIGN static int ALCmmdevPlayback_mixerProc(void *arg)
             self->Padding = written + len;
             V0(device->Backend,unlock)();
             hr = IAudioRenderClient_ReleaseBuffer(self->render, len, 0);
+            started = AL_TRUE;
         }
         if(FAILED(hr))
         {
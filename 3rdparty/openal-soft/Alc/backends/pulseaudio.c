@@ -414,6 +414,7 @@ static void pulse_close(pa_threaded_mainloop *loop, pa_context *context, pa_stre
         pa_stream_set_state_callback(stream, NULL, NULL);
         pa_stream_set_moved_callback(stream, NULL, NULL);
         pa_stream_set_write_callback(stream, NULL, NULL);
+        pa_stream_set_underflow_callback(stream, NULL, NULL);
         pa_stream_set_buffer_attr_callback(stream, NULL, NULL);
         pa_stream_disconnect(stream);
         pa_stream_unref(stream);
@@ -471,6 +472,7 @@ static void ALCpulsePlayback_bufferAttrCallback(pa_stream *stream, void *pdata);
 static void ALCpulsePlayback_contextStateCallback(pa_context *context, void *pdata);
 static void ALCpulsePlayback_streamStateCallback(pa_stream *stream, void *pdata);
 static void ALCpulsePlayback_streamWriteCallback(pa_stream *p, size_t nbytes, void *userdata);
+static void ALCpulsePlayback_streamUnderflowCallback(pa_stream *stream, void *pdata);
 static void ALCpulsePlayback_sinkInfoCallback(pa_context *context, const pa_sink_info *info, int eol, void *pdata);
 static void ALCpulsePlayback_sinkNameCallback(pa_context *context, const pa_sink_info *info, int eol, void *pdata);
 static void ALCpulsePlayback_streamMovedCallback(pa_stream *stream, void *pdata);
@@ -648,6 +650,12 @@ static void ALCpulsePlayback_streamWriteCallback(pa_stream* UNUSED(p), size_t UN
     pa_threaded_mainloop_signal(self->loop, 0);
 }
 
+static void ALCpulsePlayback_streamUnderflowCallback(pa_stream* UNUSED(stream), void *pdata)
+{
+    ALCpulsePlayback *self = pdata;
+    ATOMIC_ADD(&STATIC_CAST(ALCbackend,self)->mDevice->Underruns, 1, almemory_order_relaxed);
+}
+
 static void ALCpulsePlayback_sinkInfoCallback(pa_context *UNUSED(context), const pa_sink_info *info, int eol, void *pdata)
 {
     static const struct {
@@ -940,6 +948,7 @@ static ALCboolean ALCpulsePlayback_reset(ALCpulsePlayback *self)
         pa_stream_set_state_callback(self->stream, NULL, NULL);
         pa_stream_set_moved_callback(self->stream, NULL, NULL);
         pa_stream_set_write_callback(self->stream, NULL, NULL);
+        pa_stream_set_underflow_callback(self->stream, NULL, NULL);
         pa_stream_set_buffer_attr_callback(self->stream, NULL, NULL);
         pa_stream_disconnect(self->stream);
         pa_stream_unref(self->stream);
@@ -1047,6 +1056,7 @@ static ALCboolean ALCpulsePlayback_reset(ALCpulsePlayback *self)
     pa_stream_set_state_callback(self->stream, ALCpulsePlayback_streamStateCallback, self);
     pa_stream_set_moved_callback(self->stream, ALCpulsePlayback_streamMovedCallback, self);
     pa_stream_set_write_callback(self->stream, ALCpulsePlayback_streamWriteCallback, self);
+    pa_stream_set_underflow_callback(self->stream, ALCpulsePlayback_streamUnderflowCallback, self);
 
     self->spec = *(pa_stream_get_sample_spec(self->stream));
     if(device->Frequency != self->spec.rate)
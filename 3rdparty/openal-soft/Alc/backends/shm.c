@@ -0,0 +1,378 @@
+/**
+ * OpenAL cross platform audio library
+ * Copyright (C) 1999-2007 by authors.
+ * This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ *  License along with this library; if not, write to the
+ *  Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ * Or go to http://www.gnu.org/copyleft/lgpl.html
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "alMain.h"
+#include "alu.h"
+#include "threads.h"
+#include "compat.h"
+#include "alshm.h"
+
+#include "backends/base.h"
+
+
+static const ALCchar shmDevice[] = "Shared Memory Ring";
+
+
+typedef struct ALCshmBackend {
+    DERIVE_FROM_TYPE(ALCbackend);
+
+    al_string mName;
+
+    /* The mapping holds the header followed by the ring, see alshm.h. */
+    ALshmHeader *mHeader;
+    size_t mMapSize;
+    ll_ringbuffer_t *mRing;
+
+    volatile int killNow;
+    althrd_t thread;
+} ALCshmBackend;
+
+static int ALCshmBackend_mixerProc(void *ptr);
+
+static void ALCshmBackend_Construct(ALCshmBackend *self, ALCdevice *device);
+static void ALCshmBackend_Destruct(ALCshmBackend *self);
+static ALCenum ALCshmBackend_open(ALCshmBackend *self, const ALCchar *name);
+static void ALCshmBackend_close(ALCshmBackend *self);
+static ALCboolean ALCshmBackend_reset(ALCshmBackend *self);
+static ALCboolean ALCshmBackend_start(ALCshmBackend *self);
+static void ALCshmBackend_stop(ALCshmBackend *self);
+static DECLARE_FORWARD2(ALCshmBackend, ALCbackend, ALCenum, captureSamples, void*, ALCuint)
+static DECLARE_FORWARD(ALCshmBackend, ALCbackend, ALCuint, availableSamples)
+static ClockLatency ALCshmBackend_getClockLatency(ALCshmBackend *self);
+static DECLARE_FORWARD(ALCshmBackend, ALCbackend, void, lock)
+static DECLARE_FORWARD(ALCshmBackend, ALCbackend, void, unlock)
+DECLARE_DEFAULT_ALLOCATORS(ALCshmBackend)
+
+DEFINE_ALCBACKEND_VTABLE(ALCshmBackend);
+
+
+static void ALCshmBackend_Construct(ALCshmBackend *self, ALCdevice *device)
+{
+    ALCbackend_Construct(STATIC_CAST(ALCbackend, self), device);
+    SET_VTABLE2(ALCshmBackend, ALCbackend, self);
+
+    AL_STRING_INIT(self->mName);
+    self->mHeader = NULL;
+    self->mMapSize = 0;
+    self->mRing = NULL;
+
+    self->killNow = 1;
+}
+
+static void ALCshmBackend_Destruct(ALCshmBackend *self)
+{
+    AL_STRING_DEINIT(self->mName);
+    ALCbackend_Destruct(STATIC_CAST(ALCbackend, self));
+}
+
+
+/* Tells any consumer to let go of the current object, and removes it. */
+static void ALCshmBackend_unmap(ALCshmBackend *self)
+{
+    if(!self->mHeader)
+        return;
+
+    self->mHeader->state = ALSHM_CLOSED;
+    munmap(self->mHeader, self->mMapSize);
+    shm_unlink(al_string_get_cstr(self->mName));
+
+    self->mHeader = NULL;
+    self->mMapSize = 0;
+    self->mRing = NULL;
+}
+
+
+static int ALCshmBackend_mixerProc(void *ptr)
+{
+    ALCshmBackend *self = (ALCshmBackend*)ptr;
+    ALCdevice *device = STATIC_CAST(ALCbackend, self)->mDevice;
+    const ALuint maxQueued = device->UpdateSize * device->NumUpdates;
+    const long restTime = (long)((ALuint64)device->UpdateSize * 1000000000 /
+                                 device->Frequency / 4);
+    ll_ringbuffer_data_t data[2];
+    ALuint queued, todo, len1;
+
+    SetRTPriority();
+    althrd_setname(althrd_current(), MIXER_THREAD_NAME);
+
+    /* The consumer sets the pace: keep the ring topped up to NumUpdates
+     * updates, mixing in place wherever the write vector points.
+     */
+    while(!self->killNow && device->Connected)
+    {
+        queued = (ALuint)ll_ringbuffer_read_space(self->mRing);
+        if(queued+device->UpdateSize > maxQueued)
+        {
+            al_nssleep(restTime);
+            continue;
+        }
+
+        todo = maxQueued - queued;
+        todo -= todo%device->UpdateSize;
+
+        ll_ringbuffer_get_write_vector(self->mRing, data);
+        len1 = minu((ALuint)data[0].len, todo);
+
+        ALCshmBackend_lock(self);
+        aluMixData(device, data[0].buf, len1);
+        if(todo > len1)
+            aluMixData(device, data[1].buf, todo-len1);
+        ll_ringbuffer_write_advance(self->mRing, todo);
+        ALCshmBackend_unlock(self);
+    }
+
+    return 0;
+}
+
+
+static ALCenum ALCshmBackend_open(ALCshmBackend *self, const ALCchar *name)
+{
+    ALCdevice *device;
+    const char *objname;
+
+    objname = GetConfigValue(NULL, "shm", "name", "");
+    if(objname[0] != '/' || strchr(objname+1, '/') != NULL)
+    {
+        ERR("Invalid shared memory object name '%s'\n", objname);
+        return ALC_INVALID_VALUE;
+    }
+
+    if(!name)
+        name = shmDevice;
+    else if(strcmp(name, shmDevice) != 0)
+        return ALC_INVALID_VALUE;
+
+    al_string_copy_cstr(&self->mName, objname);
+
+    device = STATIC_CAST(ALCbackend, self)->mDevice;
+    al_string_copy_cstr(&device->DeviceName, name);
+
+    return ALC_NO_ERROR;
+}
+
+static void ALCshmBackend_close(ALCshmBackend *self)
+{
+    ALCshmBackend_unmap(self);
+}
+
+static ALCboolean ALCshmBackend_reset(ALCshmBackend *self)
+{
+    ALCdevice *device = STATIC_CAST(ALCbackend, self)->mDevice;
+    const char *objname = al_string_get_cstr(self->mName);
+    ALuint frameSize, ringSize;
+    size_t ringBytes;
+    ALshmHeader *header;
+    void *map;
+    int fd;
+
+    /* The ring is sized for the format, so a new one is made each time and
+     * consumers of the old one are sent to reopen it.
+     */
+    ALCshmBackend_unmap(self);
+
+    switch(device->FmtType)
+    {
+        case DevFmtByte:
+            device->FmtType = DevFmtUByte;
+            break;
+        case DevFmtUShort:
+            device->FmtType = DevFmtShort;
+            break;
+        case DevFmtUInt:
+            device->FmtType = DevFmtInt;
+            break;
+        case DevFmtUByte:
+        case DevFmtShort:
+        case DevFmtInt:
+        case DevFmtFloat:
+            break;
+    }
+    frameSize = FrameSizeFromDevFmt(device->FmtChans, device->FmtType);
+
+    /* One more than the queue holds, since a full ring leaves one element
+     * unused. */
+    ringSize = device->UpdateSize*device->NumUpdates + 1;
+    ringBytes = ll_ringbuffer_bytes(ringSize, frameSize);
+    if(ringBytes == 0 || ringBytes > 0xffffffffu-ALSHM_HEADER_SIZE)
+    {
+        ERR("Ring of %u %u-byte frames is too large\n", ringSize, frameSize);
+        return ALC_FALSE;
+    }
+    self->mMapSize = ALSHM_HEADER_SIZE + ringBytes;
+
+    shm_unlink(objname);
+    fd = shm_open(objname, O_RDWR|O_CREAT|O_EXCL, 0600);
+    if(fd < 0)
+    {
+        ERR("Could not create '%s': %s\n", objname, strerror(errno));
+        return ALC_FALSE;
+    }
+    if(ftruncate(fd, (off_t)self->mMapSize) != 0)
+    {
+        ERR("Could not size '%s': %s\n", objname, strerror(errno));
+        close(fd);
+        shm_unlink(objname);
+        return ALC_FALSE;
+    }
+    map = mmap(NULL, self->mMapSize, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED)
+    {
+        ERR("Could not map '%s': %s\n", objname, strerror(errno));
+        shm_unlink(objname);
+        return ALC_FALSE;
+    }
+
+    header = map;
+    header->version = ALSHM_VERSION;
+    header->map_size = (uint32_t)self->mMapSize;
+    header->frequency = device->Frequency;
+    header->channels = ChannelsFromDevFmt(device->FmtChans);
+    header->sample_bits = BytesFromDevFmt(device->FmtType) * 8;
+    header->is_float = (device->FmtType == DevFmtFloat);
+    header->frame_size = frameSize;
+    header->update_size = device->UpdateSize;
+    header->num_updates = device->NumUpdates;
+    header->state = ALSHM_STOPPED;
+    self->mRing = ll_ringbuffer_init(ALSHM_RING(header), ringSize, frameSize);
+
+    ATOMIC_THREAD_FENCE(almemory_order_release);
+    header->magic = ALSHM_MAGIC;
+    self->mHeader = header;
+
+    TRACE("Mapped '%s': %u frames of %u bytes\n", objname,
+          (ALuint)(ringBytes-ALSHM_RING_DATA_OFFSET)/frameSize, frameSize);
+
+    SetDefaultWFXChannelOrder(device);
+
+    return ALC_TRUE;
+}
+
+static ALCboolean ALCshmBackend_start(ALCshmBackend *self)
+{
+    self->mHeader->state = ALSHM_RUNNING;
+
+    self->killNow = 0;
+    if(althrd_create(&self->thread, ALCshmBackend_mixerProc, self) != althrd_success)
+    {
+        self->mHeader->state = ALSHM_STOPPED;
+        return ALC_FALSE;
+    }
+
+    return ALC_TRUE;
+}
+
+static void ALCshmBackend_stop(ALCshmBackend *self)
+{
+    int res;
+
+    if(self->killNow)
+        return;
+
+    self->killNow = 1;
+    althrd_join(self->thread, &res);
+
+    self->mHeader->state = ALSHM_STOPPED;
+}
+
+static ClockLatency ALCshmBackend_getClockLatency(ALCshmBackend *self)
+{
+    ALCdevice *device = STATIC_CAST(ALCbackend, self)->mDevice;
+    ClockLatency ret;
+
+    ALCshmBackend_lock(self);
+    ret.ClockTime = GetDeviceClockTime(device);
+    ret.Latency = 0;
+    if(self->mRing)
+        ret.Latency = ll_ringbuffer_read_space(self->mRing) * DEVICE_CLOCK_RES /
+                      device->Frequency;
+    ALCshmBackend_unlock(self);
+
+    return ret;
+}
+
+
+typedef struct ALCshmBackendFactory {
+    DERIVE_FROM_TYPE(ALCbackendFactory);
+} ALCshmBackendFactory;
+#define ALCSHMBACKENDFACTORY_INITIALIZER { { GET_VTABLE2(ALCshmBackendFactory, ALCbackendFactory) } }
+
+ALCbackendFactory *ALCshmBackendFactory_getFactory(void);
+
+static ALCboolean ALCshmBackendFactory_init(ALCshmBackendFactory *self);
+static DECLARE_FORWARD(ALCshmBackendFactory, ALCbackendFactory, void, deinit)
+static ALCboolean ALCshmBackendFactory_querySupport(ALCshmBackendFactory *self, ALCbackend_Type type);
+static void ALCshmBackendFactory_probe(ALCshmBackendFactory *self, enum DevProbe type);
+static ALCbackend* ALCshmBackendFactory_createBackend(ALCshmBackendFactory *self, ALCdevice *device, ALCbackend_Type type);
+DEFINE_ALCBACKENDFACTORY_VTABLE(ALCshmBackendFactory);
+
+
+ALCbackendFactory *ALCshmBackendFactory_getFactory(void)
+{
+    static ALCshmBackendFactory factory = ALCSHMBACKENDFACTORY_INITIALIZER;
+    return STATIC_CAST(ALCbackendFactory, &factory);
+}
+
+
+static ALCboolean ALCshmBackendFactory_init(ALCshmBackendFactory* UNUSED(self))
+{
+    return ALC_TRUE;
+}
+
+static ALCboolean ALCshmBackendFactory_querySupport(ALCshmBackendFactory* UNUSED(self), ALCbackend_Type type)
+{
+    if(type == ALCbackend_Playback)
+        return !!ConfigValueExists(NULL, "shm", "name");
+    return ALC_FALSE;
+}
+
+static void ALCshmBackendFactory_probe(ALCshmBackendFactory* UNUSED(self), enum DevProbe type)
+{
+    switch(type)
+    {
+        case ALL_DEVICE_PROBE:
+            AppendAllDevicesList(shmDevice);
+            break;
+        case CAPTURE_DEVICE_PROBE:
+            break;
+    }
+}
+
+static ALCbackend* ALCshmBackendFactory_createBackend(ALCshmBackendFactory* UNUSED(self), ALCdevice *device, ALCbackend_Type type)
+{
+    if(type == ALCbackend_Playback)
+    {
+        ALCshmBackend *backend;
+        NEW_OBJ(backend, ALCshmBackend)(device);
+        if(!backend) return NULL;
+        return STATIC_CAST(ALCbackend, backend);
+    }
+
+    return NULL;
+}
@@ -35,6 +35,9 @@
 
 static const ALCchar waveDevice[] = "Wave File Writer";
 
+/* Most bytes mixed ahead of a write to the file. */
+#define WAVE_WRITE_SIZE (1<<20)
+
 static const ALubyte SUBTYPE_PCM[] = {
     0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xaa,
     0x00, 0x38, 0x9b, 0x71
@@ -73,9 +76,15 @@ typedef struct ALCwaveBackend {
     FILE *mFile;
     long mDataStart;
 
+    /* Mixed samples wait here until there's a write's worth of them, or the
+     * mixer has caught up with the clock.
+     */
     ALvoid *mBuffer;
     ALuint mSize;
 
+    /* Mix as fast as possible instead of in real time. */
+    ALboolean mFreewheel;
+
     volatile int killNow;
     althrd_t thread;
 } ALCwaveBackend;
@@ -109,11 +118,73 @@ static void ALCwaveBackend_Construct(ALCwaveBackend *self, ALCdevice *device)
 
     self->mBuffer = NULL;
     self->mSize = 0;
+    self->mFreewheel = AL_FALSE;
 
     self->killNow = 1;
 }
 
 
+/* Swaps the byte order of the samples in place. The samples are handled a
+ * word at a time where possible, which compilers turn into vector shuffles.
+ */
+static void SwapSampleBytes(ALvoid *buffer, ALuint size, ALuint bytesize)
+{
+    ALuint i;
+
+    if(bytesize == 2)
+    {
+        ALuint *words = buffer;
+        ALushort *samples;
+        ALuint len = size / 4;
+        for(i = 0;i < len;i++)
+        {
+            ALuint word = words[i];
+            words[i] = ((word>>8)&0x00ff00ff) | ((word<<8)&0xff00ff00);
+        }
+        samples = (ALushort*)(words + len);
+        if((size&3) != 0)
+            samples[0] = (samples[0]>>8) | (samples[0]<<8);
+    }
+    else if(bytesize == 4)
+    {
+        ALuint *samples = buffer;
+        ALuint len = size / 4;
+        for(i = 0;i < len;i++)
+        {
+            ALuint samp = samples[i];
+            samples[i] = (samp>>24) | ((samp>>8)&0x0000ff00) |
+                         ((samp<<8)&0x00ff0000) | (samp<<24);
+        }
+    }
+}
+
+/* Writes out what's been mixed into the buffer so far. Returns 0 if the file
+ * couldn't be written to.
+ */
+static int ALCwaveBackend_flush(ALCwaveBackend *self, ALuint frames, ALuint frameSize)
+{
+    ALCdevice *device = STATIC_CAST(ALCbackend, self)->mDevice;
+    size_t fs;
+
+    if(frames == 0)
+        return 1;
+
+    if(!IS_LITTLE_ENDIAN)
+        SwapSampleBytes(self->mBuffer, frames*frameSize, BytesFromDevFmt(device->FmtType));
+
+    fs = fwrite(self->mBuffer, frameSize, frames, self->mFile);
+    (void)fs;
+    if(ferror(self->mFile))
+    {
+        ERR("Error writing to file\n");
+        ALCdevice_Lock(device);
+        aluHandleDisconnect(device);
+        ALCdevice_Unlock(device);
+        return 0;
+    }
+    return 1;
+}
+
 static int ALCwaveBackend_mixerProc(void *ptr)
 {
     ALCwaveBackend *self = (ALCwaveBackend*)ptr;
@@ -121,13 +192,14 @@ static int ALCwaveBackend_mixerProc(void *ptr)
     struct timespec now, start;
     ALint64 avail, done;
     ALuint frameSize;
-    size_t fs;
-    const long restTime = (long)((ALuint64)device->UpdateSize * 1000000000 /
-                                 device->Frequency / 2);
+    ALuint buffered;
+    ALuint bufferFrames;
 
     althrd_setname(althrd_current(), MIXER_THREAD_NAME);
 
     frameSize = FrameSizeFromDevFmt(device->FmtChans, device->FmtType);
+    bufferFrames = self->mSize / frameSize;
+    buffered = 0;
 
     done = 0;
     if(altimespec_get(&start, AL_TIME_UTC) != AL_TIME_UTC)
@@ -137,69 +209,57 @@ static int ALCwaveBackend_mixerProc(void *ptr)
     }
     while(!self->killNow && device->Connected)
     {
-        if(altimespec_get(&now, AL_TIME_UTC) != AL_TIME_UTC)
+        if(self->mFreewheel)
+            avail = done + device->UpdateSize;
+        else
         {
-            ERR("Failed to get current time\n");
-            return 1;
+            if(altimespec_get(&now, AL_TIME_UTC) != AL_TIME_UTC)
+            {
+                ERR("Failed to get current time\n");
+                return 1;
+            }
+
+            avail  = (now.tv_sec - start.tv_sec) * device->Frequency;
+            avail += (ALint64)(now.tv_nsec - start.tv_nsec) * device->Frequency / 1000000000;
+            if(avail < done)
+            {
+                /* Oops, time skipped backwards. Reset the number of samples
+                 * done with one update available since we (likely) just came
+                 * back from sleeping. */
+                done = avail - device->UpdateSize;
+            }
         }
 
-        avail  = (now.tv_sec - start.tv_sec) * device->Frequency;
-        avail += (ALint64)(now.tv_nsec - start.tv_nsec) * device->Frequency / 1000000000;
-        if(avail < done)
+        if(avail-done < device->UpdateSize)
         {
-            /* Oops, time skipped backwards. Reset the number of samples done
-             * with one update available since we (likely) just came back from
-             * sleeping. */
-            done = avail - device->UpdateSize;
+            /* Caught up, so get what's been mixed to the file before sleeping
+             * until the next update is due.
+             */
+            if(!ALCwaveBackend_flush(self, buffered, frameSize))
+                break;
+            buffered = 0;
+
+            al_nssleep((unsigned long)((device->UpdateSize - (avail-done)) *
+                                       1000000000 / device->Frequency));
+            continue;
         }
 
-        if(avail-done < device->UpdateSize)
-            al_nssleep(restTime);
-        else while(avail-done >= device->UpdateSize)
+        while(avail-done >= device->UpdateSize)
         {
-            aluMixData(device, self->mBuffer, device->UpdateSize);
+            aluMixData(device, (ALbyte*)self->mBuffer + buffered*frameSize,
+                       device->UpdateSize);
+            buffered += device->UpdateSize;
             done += device->UpdateSize;
 
-            if(!IS_LITTLE_ENDIAN)
+            if(bufferFrames-buffered < device->UpdateSize)
             {
-                ALuint bytesize = BytesFromDevFmt(device->FmtType);
-                ALuint i;
-
-                if(bytesize == 2)
-                {
-                    ALushort *samples = self->mBuffer;
-                    ALuint len = self->mSize / 2;
-                    for(i = 0;i < len;i++)
-                    {
-                        ALushort samp = samples[i];
-                        samples[i] = (samp>>8) | (samp<<8);
-                    }
-                }
-                else if(bytesize == 4)
-                {
-                    ALuint *samples = self->mBuffer;
-                    ALuint len = self->mSize / 4;
-                    for(i = 0;i < len;i++)
-                    {
-                        ALuint samp = samples[i];
-                        samples[i] = (samp>>24) | ((samp>>8)&0x0000ff00) |
-                                     ((samp<<8)&0x00ff0000) | (samp<<24);
-                    }
-                }
-            }
-
-            fs = fwrite(self->mBuffer, frameSize, device->UpdateSize, self->mFile);
-            (void)fs;
-            if(ferror(self->mFile))
-            {
-                ERR("Error writing to file\n");
-                ALCdevice_Lock(device);
-                aluHandleDisconnect(device);
-                ALCdevice_Unlock(device);
-                break;
+                if(!ALCwaveBackend_flush(self, buffered, frameSize))
+                    return 0;
+                buffered = 0;
             }
         }
     }
+    ALCwaveBackend_flush(self, buffered, frameSize);
 
     return 0;
 }
@@ -338,9 +398,13 @@ static ALCboolean ALCwaveBackend_reset(ALCwaveBackend *self)
 static ALCboolean ALCwaveBackend_start(ALCwaveBackend *self)
 {
     ALCdevice *device = STATIC_CAST(ALCbackend, self)->mDevice;
+    ALuint frameSize = FrameSizeFromDevFmt(device->FmtChans, device->FmtType);
+    ALuint updates = maxu(WAVE_WRITE_SIZE / (device->UpdateSize*frameSize), 1);
 
-    self->mSize = device->UpdateSize * FrameSizeFromDevFmt(device->FmtChans, device->FmtType);
-    self->mBuffer = malloc(self->mSize);
+    self->mFreewheel = GetConfigValueBool(NULL, "wave", "freewheel", 0);
+
+    self->mSize = device->UpdateSize * updates * frameSize;
+    self->mBuffer = al_calloc(16, self->mSize);
     if(!self->mBuffer)
     {
         ERR("Buffer malloc failed\n");
@@ -350,7 +414,7 @@ static ALCboolean ALCwaveBackend_start(ALCwaveBackend *self)
     self->killNow = 0;
     if(althrd_create(&self->thread, ALCwaveBackend_mixerProc, self) != althrd_success)
     {
-        free(self->mBuffer);
+        al_free(self->mBuffer);
         self->mBuffer = NULL;
         self->mSize = 0;
         return ALC_FALSE;
@@ -371,8 +435,9 @@ static void ALCwaveBackend_stop(ALCwaveBackend *self)
     self->killNow = 1;
     althrd_join(self->thread, &res);
 
-    free(self->mBuffer);
+    al_free(self->mBuffer);
     self->mBuffer = NULL;
+    self->mSize = 0;
 
     size = ftell(self->mFile);
     if(size > 0)
@@ -205,7 +205,9 @@ static void CALLBACK ALCwinmmPlayback_waveOutProc(HWAVEOUT UNUSED(device), UINT
     if(msg != WOM_DONE)
         return;
 
-    DecrementRef(&self->WaveBuffersCommitted);
+    /* Every buffer played out before the mixer sent one back. */
+    if(DecrementRef(&self->WaveBuffersCommitted) == 0 && !self->killNow)
+        ATOMIC_ADD(&STATIC_CAST(ALCbackend,self)->mDevice->Underruns, 1, almemory_order_relaxed);
     PostThreadMessage(self->thread, msg, 0, param1);
 }
 
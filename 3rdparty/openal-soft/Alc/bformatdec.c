@@ -9,6 +9,10 @@
 #include "threads.h"
 #include "almalloc.h"
 
+#ifdef HAVE_SSE_INTRINSICS_HERE
+#include <xmmintrin.h>
+#endif
+
 
 void bandsplit_init(BandSplitter *splitter, ALfloat freq_mult)
 {
@@ -73,6 +77,124 @@ void bandsplit_process(BandSplitter *splitter, ALfloat *restrict hpout, ALfloat
     splitter->hp_z1 = z1;
 }
 
+static void SplitBands_C(BandSplitter *splitters, ALfloat (*restrict hpout)[BUFFERSIZE],
+                         ALfloat (*restrict lpout)[BUFFERSIZE],
+                         const ALfloat (*restrict input)[BUFFERSIZE], ALuint numchans,
+                         ALuint count)
+{
+    ALuint c;
+    for(c = 0;c < numchans;c++)
+        bandsplit_process(&splitters[c], hpout[c], lpout[c], input[c], count);
+}
+
+#ifdef HAVE_SSE_INTRINSICS_HERE
+/* Runs one sample of four splitters, each in its own lane. The steps are the
+ * same as bandsplit_process, so the results are too.
+ */
+static inline __m128 BandSplit4(const __m128 x, const __m128 lpcoeff, const __m128 hpcoeff,
+                                __m128 *restrict lp_z1, __m128 *restrict lp_z2,
+                                __m128 *restrict hp_z1, __m128 *restrict hpout)
+{
+    __m128 d, y, lp;
+
+    d = _mm_mul_ps(_mm_sub_ps(x, *lp_z1), lpcoeff);
+    y = _mm_add_ps(*lp_z1, d);
+    *lp_z1 = _mm_add_ps(y, d);
+
+    d = _mm_mul_ps(_mm_sub_ps(y, *lp_z2), lpcoeff);
+    lp = _mm_add_ps(*lp_z2, d);
+    *lp_z2 = _mm_add_ps(lp, d);
+
+    d = _mm_sub_ps(x, _mm_mul_ps(hpcoeff, *hp_z1));
+    y = _mm_add_ps(*hp_z1, _mm_mul_ps(hpcoeff, d));
+    *hp_z1 = d;
+
+    *hpout = _mm_sub_ps(y, lp);
+    return lp;
+}
+
+static void SplitBands_SSE(BandSplitter *splitters, ALfloat (*restrict hpout)[BUFFERSIZE],
+                           ALfloat (*restrict lpout)[BUFFERSIZE],
+                           const ALfloat (*restrict input)[BUFFERSIZE], ALuint numchans,
+                           ALuint count)
+{
+    ALuint c = 0;
+
+    /* The filters are recursive, so rather than working on several samples
+     * of one channel, four channels are run side by side. Every four samples
+     * get transposed into the lanes and back out again.
+     */
+    for(;numchans-c > 3;c += 4)
+    {
+        BandSplitter *split = &splitters[c];
+        const __m128 lpcoeff = _mm_setr_ps(
+            split[0].coeff*0.5f + 0.5f, split[1].coeff*0.5f + 0.5f,
+            split[2].coeff*0.5f + 0.5f, split[3].coeff*0.5f + 0.5f
+        );
+        const __m128 hpcoeff = _mm_setr_ps(split[0].coeff, split[1].coeff,
+                                           split[2].coeff, split[3].coeff);
+        __m128 lp_z1 = _mm_setr_ps(split[0].lp_z1, split[1].lp_z1,
+                                   split[2].lp_z1, split[3].lp_z1);
+        __m128 lp_z2 = _mm_setr_ps(split[0].lp_z2, split[1].lp_z2,
+                                   split[2].lp_z2, split[3].lp_z2);
+        __m128 hp_z1 = _mm_setr_ps(split[0].hp_z1, split[1].hp_z1,
+                                   split[2].hp_z1, split[3].hp_z1);
+        alignas(16) ALfloat lanes[4];
+        ALuint i, k;
+
+        for(i = 0;count-i > 3;i += 4)
+        {
+            __m128 x0 = _mm_loadu_ps(&input[c+0][i]);
+            __m128 x1 = _mm_loadu_ps(&input[c+1][i]);
+            __m128 x2 = _mm_loadu_ps(&input[c+2][i]);
+            __m128 x3 = _mm_loadu_ps(&input[c+3][i]);
+            __m128 hp0, hp1, hp2, hp3;
+            __m128 lp0, lp1, lp2, lp3;
+
+            _MM_TRANSPOSE4_PS(x0, x1, x2, x3);
+            lp0 = BandSplit4(x0, lpcoeff, hpcoeff, &lp_z1, &lp_z2, &hp_z1, &hp0);
+            lp1 = BandSplit4(x1, lpcoeff, hpcoeff, &lp_z1, &lp_z2, &hp_z1, &hp1);
+            lp2 = BandSplit4(x2, lpcoeff, hpcoeff, &lp_z1, &lp_z2, &hp_z1, &hp2);
+            lp3 = BandSplit4(x3, lpcoeff, hpcoeff, &lp_z1, &lp_z2, &hp_z1, &hp3);
+            _MM_TRANSPOSE4_PS(lp0, lp1, lp2, lp3);
+            _MM_TRANSPOSE4_PS(hp0, hp1, hp2, hp3);
+
+            _mm_storeu_ps(&lpout[c+0][i], lp0);
+            _mm_storeu_ps(&lpout[c+1][i], lp1);
+            _mm_storeu_ps(&lpout[c+2][i], lp2);
+            _mm_storeu_ps(&lpout[c+3][i], lp3);
+            _mm_storeu_ps(&hpout[c+0][i], hp0);
+            _mm_storeu_ps(&hpout[c+1][i], hp1);
+            _mm_storeu_ps(&hpout[c+2][i], hp2);
+            _mm_storeu_ps(&hpout[c+3][i], hp3);
+        }
+        for(;i < count;i++)
+        {
+            const __m128 x = _mm_setr_ps(input[c+0][i], input[c+1][i],
+                                         input[c+2][i], input[c+3][i]);
+            __m128 hp, lp;
+
+            lp = BandSplit4(x, lpcoeff, hpcoeff, &lp_z1, &lp_z2, &hp_z1, &hp);
+            _mm_store_ps(lanes, lp);
+            for(k = 0;k < 4;k++)
+                lpout[c+k][i] = lanes[k];
+            _mm_store_ps(lanes, hp);
+            for(k = 0;k < 4;k++)
+                hpout[c+k][i] = lanes[k];
+        }
+
+        _mm_store_ps(lanes, lp_z1);
+        for(k = 0;k < 4;k++) split[k].lp_z1 = lanes[k];
+        _mm_store_ps(lanes, lp_z2);
+        for(k = 0;k < 4;k++) split[k].lp_z2 = lanes[k];
+        _mm_store_ps(lanes, hp_z1);
+        for(k = 0;k < 4;k++) split[k].hp_z1 = lanes[k];
+    }
+    for(;c < numchans;c++)
+        bandsplit_process(&splitters[c], hpout[c], lpout[c], input[c], count);
+}
+#endif
+
 
 static const ALfloat UnitScale[MAX_AMBI_COEFFS] = {
     1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
@@ -161,7 +283,27 @@ static const ALfloat Ambi3DDecoder[8][FB_Max][MAX_AMBI_COEFFS] = {
 static ALfloat Ambi3DEncoderT[8][MAX_AMBI_COEFFS];
 
 
+/* Splits each of the input channels into the matching rows of the high and
+ * low frequency outputs, with the matching splitter.
+ */
+typedef void (*SplitBandsFunc)(BandSplitter *splitters, ALfloat (*restrict hpout)[BUFFERSIZE],
+                               ALfloat (*restrict lpout)[BUFFERSIZE],
+                               const ALfloat (*restrict input)[BUFFERSIZE], ALuint numchans,
+                               ALuint count);
+
+static void SplitBands_C(BandSplitter *splitters, ALfloat (*restrict hpout)[BUFFERSIZE],
+                         ALfloat (*restrict lpout)[BUFFERSIZE],
+                         const ALfloat (*restrict input)[BUFFERSIZE], ALuint numchans,
+                         ALuint count);
+#ifdef HAVE_SSE_INTRINSICS_HERE
+static void SplitBands_SSE(BandSplitter *splitters, ALfloat (*restrict hpout)[BUFFERSIZE],
+                           ALfloat (*restrict lpout)[BUFFERSIZE],
+                           const ALfloat (*restrict input)[BUFFERSIZE], ALuint numchans,
+                           ALuint count);
+#endif
+
 static RowMixerFunc MixMatrixRow = MixRow_C;
+static SplitBandsFunc SplitBands = SplitBands_C;
 
 
 static alonce_flag bformatdec_inited = AL_ONCE_FLAG_INIT;
@@ -171,6 +313,10 @@ static void init_bformatdec(void)
     ALuint i, j;
 
     MixMatrixRow = SelectRowMixer();
+#ifdef HAVE_SSE_INTRINSICS_HERE
+    if((CPUCapFlags&CPU_CAP_SSE))
+        SplitBands = SplitBands_SSE;
+#endif
 
     for(i = 0;i < COUNTOF(Ambi3DPoints);i++)
         CalcDirectionCoeffs(Ambi3DPoints[i], 0.0f, Ambi3DEncoderT[i]);
@@ -197,15 +343,17 @@ typedef ALfloat ALfloatMAX_AMBI_COEFFS[MAX_AMBI_COEFFS];
 static void GenUpsamplerGains(const ALfloat (*restrict EncoderT)[MAX_AMBI_COEFFS],
                               const ALfloat (*restrict Decoder)[FB_Max][MAX_AMBI_COEFFS],
                               ALsizei InChannels,
-                              ALfloat (*restrict OutGains)[MAX_OUTPUT_CHANNELS][FB_Max],
+                              ALfloat (*restrict OutGains)[FB_Max][4],
                               ALsizei OutChannels)
 {
     ALsizei i, j, k;
 
     /* Combine the matrices that do the in->virt and virt->out conversions so
-     * we get a single in->out conversion. NOTE: the Encoder matrix and output
-     * are transposed, so the input channels line up with the rows and the
-     * output channels line up with the columns.
+     * we get a single in->out conversion. NOTE: the Encoder matrix is
+     * transposed, so the input channels line up with the rows and the output
+     * channels line up with the columns. The output gains are stored by output
+     * channel, with the high frequency gains for the four first-order inputs
+     * followed by the low frequency ones, the order the split bands are mixed.
      */
     for(i = 0;i < 4;i++)
     {
@@ -217,8 +365,8 @@ static void GenUpsamplerGains(const ALfloat (*restrict EncoderT)[MAX_AMBI_COEFFS
                 hfgain += Decoder[k][FB_HighFreq][i]*EncoderT[k][j];
                 lfgain += Decoder[k][FB_LowFreq][i]*EncoderT[k][j];
             }
-            OutGains[i][j][FB_HighFreq] = hfgain;
-            OutGains[i][j][FB_LowFreq] = lfgain;
+            OutGains[j][FB_HighFreq][i] = hfgain;
+            OutGains[j][FB_LowFreq][i] = lfgain;
         }
     }
 }
@@ -230,6 +378,10 @@ static void GenUpsamplerGains(const ALfloat (*restrict EncoderT)[MAX_AMBI_COEFFS
 typedef struct BFormatDec {
     ALboolean Enabled[MAX_OUTPUT_CHANNELS];
 
+    /* With dual-band decoding, the low frequency coefficients of each output
+     * are packed right after the NumChannels high frequency ones once reset,
+     * so the two bands can be mixed in one go (see bformatdec_reset).
+     */
     union {
         alignas(16) ALfloat Dual[MAX_OUTPUT_CHANNELS][FB_Max][MAX_AMBI_COEFFS];
         alignas(16) ALfloat Single[MAX_OUTPUT_CHANNELS][MAX_AMBI_COEFFS];
@@ -237,6 +389,7 @@ typedef struct BFormatDec {
 
     BandSplitter XOver[MAX_AMBI_COEFFS];
 
+    /* Holds at least 8 rows, for the up-sampler's split bands. */
     ALfloat (*Samples)[BUFFERSIZE];
     /* These two alias into Samples */
     ALfloat (*SamplesHF)[BUFFERSIZE];
@@ -252,7 +405,7 @@ typedef struct BFormatDec {
     struct {
         BandSplitter XOver[4];
 
-        ALfloat Gains[4][MAX_OUTPUT_CHANNELS][FB_Max];
+        alignas(16) ALfloat Gains[MAX_OUTPUT_CHANNELS][FB_Max][4];
     } UpSampler;
 
     ALuint NumChannels;
@@ -313,7 +466,7 @@ void bformatdec_reset(BFormatDec *dec, const AmbDecConf *conf, ALuint chancount,
     dec->SamplesLF = NULL;
 
     dec->NumChannels = chancount;
-    dec->Samples = al_calloc(16, dec->NumChannels*2 * sizeof(dec->Samples[0]));
+    dec->Samples = al_calloc(16, maxu(dec->NumChannels, 4)*2 * sizeof(dec->Samples[0]));
     dec->SamplesHF = dec->Samples;
     dec->SamplesLF = dec->SamplesHF + dec->NumChannels;
 
@@ -488,6 +641,17 @@ void bformatdec_reset(BFormatDec *dec, const AmbDecConf *conf, ALuint chancount,
                 }
             }
         }
+
+        /* Move the low frequency coefficients up against the high frequency
+         * ones, the same way SamplesLF follows SamplesHF. Only the first
+         * NumChannels*2 values of each output are used from here on.
+         */
+        for(i = 0;i < MAX_OUTPUT_CHANNELS;i++)
+        {
+            ALfloat *coeffs = &dec->Matrix.Dual[i][0][0];
+            memmove(coeffs + dec->NumChannels, coeffs + MAX_AMBI_COEFFS,
+                    dec->NumChannels*sizeof(ALfloat));
+        }
     }
 }
 
@@ -498,22 +662,20 @@ void bformatdec_process(struct BFormatDec *dec, ALfloat (*restrict OutBuffer)[BU
 
     if(dec->DualBand)
     {
-        for(i = 0;i < dec->NumChannels;i++)
-            bandsplit_process(&dec->XOver[i], dec->SamplesHF[i], dec->SamplesLF[i],
-                              InSamples[i], SamplesToDo);
+        SplitBands(dec->XOver, dec->SamplesHF, dec->SamplesLF, InSamples, dec->NumChannels,
+                   SamplesToDo);
 
         for(chan = 0;chan < OutChannels;chan++)
         {
             if(!dec->Enabled[chan])
                 continue;
 
+            /* SamplesLF follows SamplesHF, and the coefficients are packed to
+             * match, so both bands mix as one set of channels.
+             */
             memset(dec->ChannelMix, 0, SamplesToDo*sizeof(ALfloat));
             MixMatrixRow(dec->ChannelMix, dec->Matrix.Dual[chan][FB_HighFreq],
-                SAFE_CONST(ALfloatBUFFERSIZE*,dec->SamplesHF), dec->NumChannels, 0,
-                SamplesToDo
-            );
-            MixMatrixRow(dec->ChannelMix, dec->Matrix.Dual[chan][FB_LowFreq],
-                SAFE_CONST(ALfloatBUFFERSIZE*,dec->SamplesLF), dec->NumChannels, 0,
+                SAFE_CONST(ALfloatBUFFERSIZE*,dec->SamplesHF), dec->NumChannels*2, 0,
                 SamplesToDo
             );
 
@@ -594,20 +756,28 @@ void bformatdec_upSample(struct BFormatDec *dec, ALfloat (*restrict OutBuffer)[B
      * channel to the output, without the need for storing the virtual channel
      * array.
      */
-    for(i = 0;i < InChannels;i++)
-    {
-        /* First, split the first-order components into low and high frequency
-         * bands.
-         */
-        bandsplit_process(&dec->UpSampler.XOver[i],
-            dec->Samples[FB_HighFreq], dec->Samples[FB_LowFreq],
-            InSamples[i], SamplesToDo
-        );
 
-        /* Now write each band to the output. */
+    /* First, split the first-order components into low and high frequency
+     * bands, with the high frequency bands in the first four rows of Samples
+     * and the low frequency bands in the next four.
+     */
+    SplitBands(dec->UpSampler.XOver, dec->Samples, dec->Samples+4, InSamples, InChannels,
+               SamplesToDo);
+
+    /* Now write both bands of each to the output. */
+    if(InChannels == 4)
+    {
         for(j = 0;j < dec->NumChannels;j++)
-            MixMatrixRow(OutBuffer[j], dec->UpSampler.Gains[i][j],
-                SAFE_CONST(ALfloatBUFFERSIZE*,dec->Samples), FB_Max, 0,
+            MixMatrixRow(OutBuffer[j], dec->UpSampler.Gains[j][FB_HighFreq],
+                SAFE_CONST(ALfloatBUFFERSIZE*,dec->Samples), 4*FB_Max, 0,
+                SamplesToDo
+            );
+    }
+    else for(j = 0;j < dec->NumChannels;j++)
+    {
+        for(i = 0;i < FB_Max;i++)
+            MixMatrixRow(OutBuffer[j], dec->UpSampler.Gains[j][i],
+                SAFE_CONST(ALfloatBUFFERSIZE*,&dec->Samples[i*4]), InChannels, 0,
                 SamplesToDo
             );
     }
@@ -615,11 +785,12 @@ void bformatdec_upSample(struct BFormatDec *dec, ALfloat (*restrict OutBuffer)[B
 
 
 typedef struct AmbiUpsampler {
-    alignas(16) ALfloat Samples[FB_Max][BUFFERSIZE];
+    /* The high frequency band of each input, then the low frequency band. */
+    alignas(16) ALfloat Samples[FB_Max*4][BUFFERSIZE];
 
     BandSplitter XOver[4];
 
-    ALfloat Gains[4][MAX_OUTPUT_CHANNELS][FB_Max];
+    alignas(16) ALfloat Gains[MAX_OUTPUT_CHANNELS][FB_Max][4];
 } AmbiUpsampler;
 
 AmbiUpsampler *ambiup_alloc()
@@ -654,19 +825,14 @@ void ambiup_reset(struct AmbiUpsampler *ambiup, const ALCdevice *device)
 
 void ambiup_process(struct AmbiUpsampler *ambiup, ALfloat (*restrict OutBuffer)[BUFFERSIZE], ALuint OutChannels, const ALfloat (*restrict InSamples)[BUFFERSIZE], ALuint SamplesToDo)
 {
-    ALuint i, j;
+    ALuint j;
 
-    for(i = 0;i < 4;i++)
-    {
-        bandsplit_process(&ambiup->XOver[i],
-            ambiup->Samples[FB_HighFreq], ambiup->Samples[FB_LowFreq],
-            InSamples[i], SamplesToDo
-        );
+    SplitBands(ambiup->XOver, ambiup->Samples, ambiup->Samples+4, InSamples, 4,
+               SamplesToDo);
 
-        for(j = 0;j < OutChannels;j++)
-            MixMatrixRow(OutBuffer[j], ambiup->Gains[i][j],
-                SAFE_CONST(ALfloatBUFFERSIZE*,ambiup->Samples), FB_Max, 0,
-                SamplesToDo
-            );
-    }
+    for(j = 0;j < OutChannels;j++)
+        MixMatrixRow(OutBuffer[j], ambiup->Gains[j][FB_HighFreq],
+            SAFE_CONST(ALfloatBUFFERSIZE*,ambiup->Samples), 4*FB_Max, 0,
+            SamplesToDo
+        );
 }
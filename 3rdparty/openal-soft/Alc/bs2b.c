@@ -29,6 +29,10 @@
 #include "bs2b.h"
 #include "alu.h"
 
+#ifdef HAVE_SSE_INTRINSICS_HERE
+#include <xmmintrin.h>
+#endif
+
 
 /* Set up all data. */
 static void init(struct bs2b *bs2b)
@@ -129,12 +133,69 @@ void bs2b_clear(struct bs2b *bs2b)
     memset(&bs2b->last_sample, 0, sizeof(bs2b->last_sample));
 } /* bs2b_clear */
 
+#ifdef HAVE_SSE_INTRINSICS_HERE
+/* Runs the four filters together, with the left lowpass, left highboost,
+ * right lowpass and right highboost in the four lanes. The lowpass lanes get
+ * a zero gain for the previous input, which leaves their results as they are
+ * in the scalar version.
+ */
+static void bs2b_cross_feed_SSE(struct bs2b *bs2b, float *restrict Left, float *restrict Right, unsigned int SamplesToDo)
+{
+    const __m128 a0 = _mm_setr_ps(bs2b->a0_lo, bs2b->a0_hi, bs2b->a0_lo, bs2b->a0_hi);
+    const __m128 a1 = _mm_setr_ps(0.0f, bs2b->a1_hi, 0.0f, bs2b->a1_hi);
+    const __m128 b1 = _mm_setr_ps(bs2b->b1_lo, bs2b->b1_hi, bs2b->b1_lo, bs2b->b1_hi);
+    __m128 last_in = _mm_setr_ps(bs2b->last_sample[0].asis, bs2b->last_sample[0].asis,
+                                 bs2b->last_sample[1].asis, bs2b->last_sample[1].asis);
+    __m128 last_out = _mm_setr_ps(bs2b->last_sample[0].lo, bs2b->last_sample[0].hi,
+                                  bs2b->last_sample[1].lo, bs2b->last_sample[1].hi);
+    alignas(16) float lanes[4];
+    unsigned int i;
+
+    for(i = 0;i < SamplesToDo;i++)
+    {
+        const __m128 in = _mm_setr_ps(Left[i], Left[i], Right[i], Right[i]);
+        __m128 mix;
+
+        last_out = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(a0, in), _mm_mul_ps(a1, last_in)),
+            _mm_mul_ps(b1, last_out)
+        );
+        last_in = in;
+
+        /* Crossfeed: each side's highboost plus the other side's lowpass, in
+         * the second and fourth lanes.
+         */
+        mix = _mm_add_ps(last_out, _mm_shuffle_ps(last_out, last_out, _MM_SHUFFLE(0, 0, 2, 2)));
+        _mm_store_ps(lanes, mix);
+        Left[i] = lanes[1];
+        Right[i] = lanes[3];
+    }
+
+    _mm_store_ps(lanes, last_in);
+    bs2b->last_sample[0].asis = lanes[0];
+    bs2b->last_sample[1].asis = lanes[2];
+    _mm_store_ps(lanes, last_out);
+    bs2b->last_sample[0].lo = lanes[0];
+    bs2b->last_sample[0].hi = lanes[1];
+    bs2b->last_sample[1].lo = lanes[2];
+    bs2b->last_sample[1].hi = lanes[3];
+}
+#endif
+
 void bs2b_cross_feed(struct bs2b *bs2b, float *restrict Left, float *restrict Right, unsigned int SamplesToDo)
 {
     float lsamples[128][2];
     float rsamples[128][2];
     unsigned int base;
 
+#ifdef HAVE_SSE_INTRINSICS_HERE
+    if((CPUCapFlags&CPU_CAP_SSE))
+    {
+        bs2b_cross_feed_SSE(bs2b, Left, Right, SamplesToDo);
+        return;
+    }
+#endif
+
     for(base = 0;base < SamplesToDo;)
     {
         unsigned int todo = minu(128, SamplesToDo-base);
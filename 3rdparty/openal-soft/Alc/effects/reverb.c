@@ -32,20 +32,43 @@
 #include "alError.h"
 #include "mixer_defs.h"
 
+#ifdef HAVE_SSE_INTRINSICS_HERE
+#include <xmmintrin.h>
+#endif
+
 
 /* This is the maximum number of samples processed for each inner loop
  * iteration. */
 #define MAX_UPDATE_SAMPLES  256
 
 
+struct ALreverbState;
+typedef ALvoid (*ReverbLinesFunc)(struct ALreverbState *State, ALuint todo, ALfloat (*restrict out)[MAX_UPDATE_SAMPLES]);
+
+static ALvoid EarlyReflection_C(struct ALreverbState *State, ALuint todo, ALfloat (*restrict out)[MAX_UPDATE_SAMPLES]);
+static ALvoid LateReverb_C(struct ALreverbState *State, ALuint todo, ALfloat (*restrict out)[MAX_UPDATE_SAMPLES]);
+#ifdef HAVE_SSE_INTRINSICS_HERE
+static ALvoid EarlyReflection_SSE(struct ALreverbState *State, ALuint todo, ALfloat (*restrict out)[MAX_UPDATE_SAMPLES]);
+static ALvoid LateReverb_SSE(struct ALreverbState *State, ALuint todo, ALfloat (*restrict out)[MAX_UPDATE_SAMPLES]);
+#endif
+
 static MixerFunc MixSamples = Mix_C;
 static RowMixerFunc MixRowSamples = MixRow_C;
+static ReverbLinesFunc EarlyReflection = EarlyReflection_C;
+static ReverbLinesFunc LateReverb = LateReverb_C;
 
 static alonce_flag mixfunc_inited = AL_ONCE_FLAG_INIT;
 static void init_mixfunc(void)
 {
     MixSamples = SelectMixer();
     MixRowSamples = SelectRowMixer();
+#ifdef HAVE_SSE_INTRINSICS_HERE
+    if((CPUCapFlags&CPU_CAP_SSE))
+    {
+        EarlyReflection = EarlyReflection_SSE;
+        LateReverb = LateReverb_SSE;
+    }
+#endif
 }
 
 
@@ -97,9 +120,11 @@ typedef struct ALreverbState {
     ALuint    LateDelayTap[4];
 
     struct {
-        // Early reflections are done with 4 delay lines.
-        ALfloat   Coeff[4];
-        DelayLine Delay[4];
+        /* Early reflections are done with 4 delay lines, interleaved like the
+         * main delay line so the four can be processed together.
+         */
+        alignas(16) ALfloat Coeff[4];
+        DelayLine Delay;
         ALuint    Offset[4];
 
         // The gain for each output channel based on 3D panning.
@@ -121,23 +146,19 @@ typedef struct ALreverbState {
         // Mixing matrix coefficient.
         ALfloat   MixCoeff;
 
-        // Late reverb has 4 parallel all-pass filters.
-        struct {
-            ALfloat   Coeff;
-            DelayLine Delay;
-            ALuint    Offset;
-        } Ap[4];
+        // Late reverb has 4 parallel all-pass filters, with interleaved lines.
+        alignas(16) ALfloat ApCoeff[4];
+        DelayLine ApDelay;
+        ALuint    ApOffset[4];
 
-        // In addition to 4 cyclical delay lines.
-        ALfloat   Coeff[4];
-        DelayLine Delay[4];
+        // In addition to 4 cyclical delay lines, also interleaved.
+        alignas(16) ALfloat Coeff[4];
+        DelayLine Delay;
         ALuint    Offset[4];
 
         // The cyclical delay lines are 1-pole low-pass filtered.
-        struct {
-            ALfloat Sample;
-            ALfloat Coeff;
-        } Lp[4];
+        alignas(16) ALfloat LpCoeff[4];
+        alignas(16) ALfloat LpSample[4];
 
         // The gain for each output channel based on 3D panning.
         ALfloat CurrentGain[4][MAX_OUTPUT_CHANNELS];
@@ -222,11 +243,11 @@ static void ALreverbState_Construct(ALreverbState *state)
     for(index = 0;index < 4;index++)
         state->LateDelayTap[index] = 0;
 
+    state->Early.Delay.Mask = 0;
+    state->Early.Delay.Line = NULL;
     for(index = 0;index < 4;index++)
     {
         state->Early.Coeff[index] = 0.0f;
-        state->Early.Delay[index].Mask = 0;
-        state->Early.Delay[index].Line = NULL;
         state->Early.Offset[index] = 0;
     }
 
@@ -234,20 +255,20 @@ static void ALreverbState_Construct(ALreverbState *state)
     state->Late.DensityGain = 0.0f;
     state->Late.ApFeedCoeff = 0.0f;
     state->Late.MixCoeff = 0.0f;
+    state->Late.ApDelay.Mask = 0;
+    state->Late.ApDelay.Line = NULL;
+    state->Late.Delay.Mask = 0;
+    state->Late.Delay.Line = NULL;
     for(index = 0;index < 4;index++)
     {
-        state->Late.Ap[index].Coeff = 0.0f;
-        state->Late.Ap[index].Delay.Mask = 0;
-        state->Late.Ap[index].Delay.Line = NULL;
-        state->Late.Ap[index].Offset = 0;
+        state->Late.ApCoeff[index] = 0.0f;
+        state->Late.ApOffset[index] = 0;
 
         state->Late.Coeff[index] = 0.0f;
-        state->Late.Delay[index].Mask = 0;
-        state->Late.Delay[index].Line = NULL;
         state->Late.Offset[index] = 0;
 
-        state->Late.Lp[index].Sample = 0.0f;
-        state->Late.Lp[index].Coeff = 0.0f;
+        state->Late.LpSample[index] = 0.0f;
+        state->Late.LpCoeff[index] = 0.0f;
     }
 
     for(l = 0;l < 4;l++)
@@ -432,23 +453,20 @@ static ALboolean AllocLines(ALuint frequency, ALreverbState *State)
     totalSamples += CalcLineLength(length*4, totalSamples, frequency,
                                    MAX_UPDATE_SAMPLES*4, &State->Delay);
 
-    // The early reflection lines.
-    for(index = 0;index < 4;index++)
-        totalSamples += CalcLineLength(EARLY_LINE_LENGTH[index], totalSamples,
-                                       frequency, 0, &State->Early.Delay[index]);
+    /* The early reflection lines. The four are interleaved in one line, long
+     * enough for the longest of them.
+     */
+    totalSamples += CalcLineLength(EARLY_LINE_LENGTH[3]*4, totalSamples,
+                                   frequency, 0, &State->Early.Delay);
 
     // The late delay lines are calculated from the lowest reverb density.
-    for(index = 0;index < 4;index++)
-    {
-        length = LATE_LINE_LENGTH[index] * (1.0f + LATE_LINE_MULTIPLIER);
-        totalSamples += CalcLineLength(length, totalSamples, frequency, 0,
-                                       &State->Late.Delay[index]);
-    }
+    length = LATE_LINE_LENGTH[3] * (1.0f + LATE_LINE_MULTIPLIER);
+    totalSamples += CalcLineLength(length*4, totalSamples, frequency, 0,
+                                   &State->Late.Delay);
 
     // The late all-pass lines.
-    for(index = 0;index < 4;index++)
-        totalSamples += CalcLineLength(ALLPASS_LINE_LENGTH[index], totalSamples,
-                                       frequency, 0, &State->Late.Ap[index].Delay);
+    totalSamples += CalcLineLength(ALLPASS_LINE_LENGTH[3]*4, totalSamples,
+                                   frequency, 0, &State->Late.ApDelay);
 
     // The echo all-pass and delay lines.
     for(index = 0;index < 4;index++)
@@ -474,15 +492,13 @@ static ALboolean AllocLines(ALuint frequency, ALreverbState *State)
 
     // Update all delays to reflect the new sample buffer.
     RealizeLineOffset(State->SampleBuffer, &State->Delay);
+    RealizeLineOffset(State->SampleBuffer, &State->Early.Delay);
+    RealizeLineOffset(State->SampleBuffer, &State->Late.ApDelay);
+    RealizeLineOffset(State->SampleBuffer, &State->Late.Delay);
     for(index = 0;index < 4;index++)
     {
         RealizeLineOffset(State->SampleBuffer, &State->Mod.Delay[index]);
 
-        RealizeLineOffset(State->SampleBuffer, &State->Early.Delay[index]);
-
-        RealizeLineOffset(State->SampleBuffer, &State->Late.Ap[index].Delay);
-        RealizeLineOffset(State->SampleBuffer, &State->Late.Delay[index]);
-
         RealizeLineOffset(State->SampleBuffer, &State->Echo.Delay[index].Ap);
         RealizeLineOffset(State->SampleBuffer, &State->Echo.Delay[index].Feedback);
     }
@@ -514,7 +530,7 @@ static ALboolean ALreverbState_deviceUpdate(ALreverbState *State, ALCdevice *Dev
     for(index = 0;index < 4;index++)
     {
         State->Early.Offset[index] = fastf2u(EARLY_LINE_LENGTH[index] * frequency);
-        State->Late.Ap[index].Offset = fastf2u(ALLPASS_LINE_LENGTH[index] * frequency);
+        State->Late.ApOffset[index] = fastf2u(ALLPASS_LINE_LENGTH[index] * frequency);
     }
 
     // The echo all-pass filter line length is static, so its offset only
@@ -745,7 +761,7 @@ static ALvoid UpdateLateLines(ALfloat xMix, ALfloat density, ALfloat decayTime,
     for(index = 0;index < 4;index++)
     {
         // Calculate the gain (coefficient) for each all-pass line.
-        State->Late.Ap[index].Coeff = CalcDecayCoeff(
+        State->Late.ApCoeff[index] = CalcDecayCoeff(
             ALLPASS_LINE_LENGTH[index], decayTime
         );
 
@@ -760,7 +776,7 @@ static ALvoid UpdateLateLines(ALfloat xMix, ALfloat density, ALfloat decayTime,
         State->Late.Coeff[index] = CalcDecayCoeff(length, decayTime);
 
         // Calculate the damping coefficient for each low-pass filter.
-        State->Late.Lp[index].Coeff = CalcDampingCoeff(
+        State->Late.LpCoeff[index] = CalcDampingCoeff(
             hfRatio, length, decayTime, State->Late.Coeff[index], cw
         );
 
@@ -1090,7 +1106,7 @@ static void EAXModulation(DelayLine *ModDelay, ALuint offset, const ALfloat *res
 /* Given some input samples from the main delay line, this function produces
  * four-channel outputs for the early reflections.
  */
-static ALvoid EarlyReflection(ALreverbState *State, ALuint todo, ALfloat (*restrict out)[MAX_UPDATE_SAMPLES])
+static ALvoid EarlyReflection_C(ALreverbState *State, ALuint todo, ALfloat (*restrict out)[MAX_UPDATE_SAMPLES])
 {
     ALfloat d[4], v, f[4];
     ALuint i;
@@ -1125,10 +1141,10 @@ static ALvoid EarlyReflection(ALreverbState *State, ALuint todo, ALfloat (*restr
         d[3] = v - f[3];
 
         /* Feed the early delay lines, and load the delayed results. */
-        d[0] = DelayLineInOut(&State->Early.Delay[0], offset, State->Early.Offset[0], d[0]);
-        d[1] = DelayLineInOut(&State->Early.Delay[1], offset, State->Early.Offset[1], d[1]);
-        d[2] = DelayLineInOut(&State->Early.Delay[2], offset, State->Early.Offset[2], d[2]);
-        d[3] = DelayLineInOut(&State->Early.Delay[3], offset, State->Early.Offset[3], d[3]);
+        d[0] = DelayLineInOut(&State->Early.Delay, offset*4 + 0, State->Early.Offset[0]*4, d[0]);
+        d[1] = DelayLineInOut(&State->Early.Delay, offset*4 + 1, State->Early.Offset[1]*4, d[1]);
+        d[2] = DelayLineInOut(&State->Early.Delay, offset*4 + 2, State->Early.Offset[2]*4, d[2]);
+        d[3] = DelayLineInOut(&State->Early.Delay, offset*4 + 3, State->Early.Offset[3]*4, d[3]);
 
         /* Output the initial reflection taps and the results of the delayed
          * and decayed junction for all four channels.
@@ -1158,23 +1174,23 @@ static inline ALfloat AllpassInOut(DelayLine *Delay, ALuint outOffset, ALuint in
 // All-pass input/output routine for late reverb.
 static inline ALfloat LateAllPassInOut(ALreverbState *State, ALuint offset, ALuint index, ALfloat in)
 {
-    return AllpassInOut(&State->Late.Ap[index].Delay,
-                        offset - State->Late.Ap[index].Offset,
-                        offset, in, State->Late.ApFeedCoeff,
-                        State->Late.Ap[index].Coeff);
+    return AllpassInOut(&State->Late.ApDelay,
+                        (offset - State->Late.ApOffset[index])*4 + index,
+                        offset*4 + index, in, State->Late.ApFeedCoeff,
+                        State->Late.ApCoeff[index]);
 }
 
 // Low-pass filter input/output routine for late reverb.
 static inline ALfloat LateLowPassInOut(ALreverbState *State, ALuint index, ALfloat in)
 {
-    in = lerp(in, State->Late.Lp[index].Sample, State->Late.Lp[index].Coeff);
-    State->Late.Lp[index].Sample = in;
+    in = lerp(in, State->Late.LpSample[index], State->Late.LpCoeff[index]);
+    State->Late.LpSample[index] = in;
     return in;
 }
 
 // Given four decorrelated input samples, this function produces four-channel
 // output for the late reverb.
-static ALvoid LateReverb(ALreverbState *State, ALuint todo, ALfloat (*restrict out)[MAX_UPDATE_SAMPLES])
+static ALvoid LateReverb_C(ALreverbState *State, ALuint todo, ALfloat (*restrict out)[MAX_UPDATE_SAMPLES])
 {
     ALfloat d[4], f[4];
     ALuint offset;
@@ -1184,7 +1200,7 @@ static ALvoid LateReverb(ALreverbState *State, ALuint todo, ALfloat (*restrict o
     for(base = 0;base < todo;)
     {
         ALfloat tmp[MAX_UPDATE_SAMPLES/4][4];
-        ALuint tmp_todo = minu(todo, MAX_UPDATE_SAMPLES/4);
+        ALuint tmp_todo = minu(todo-base, MAX_UPDATE_SAMPLES/4);
 
         for(i = 0;i < tmp_todo;i++)
         {
@@ -1197,10 +1213,10 @@ static ALvoid LateReverb(ALreverbState *State, ALuint todo, ALfloat (*restrict o
             /* Add the decayed results of the cyclical delay lines, then pass
              * the results through the low-pass filters.
              */
-            f[0] += DelayLineOut(&State->Late.Delay[0], offset-State->Late.Offset[0]) * State->Late.Coeff[0];
-            f[1] += DelayLineOut(&State->Late.Delay[1], offset-State->Late.Offset[1]) * State->Late.Coeff[1];
-            f[2] += DelayLineOut(&State->Late.Delay[2], offset-State->Late.Offset[2]) * State->Late.Coeff[2];
-            f[3] += DelayLineOut(&State->Late.Delay[3], offset-State->Late.Offset[3]) * State->Late.Coeff[3];
+            f[0] += DelayLineOut(&State->Late.Delay, (offset-State->Late.Offset[0])*4 + 0) * State->Late.Coeff[0];
+            f[1] += DelayLineOut(&State->Late.Delay, (offset-State->Late.Offset[1])*4 + 1) * State->Late.Coeff[1];
+            f[2] += DelayLineOut(&State->Late.Delay, (offset-State->Late.Offset[2])*4 + 2) * State->Late.Coeff[2];
+            f[3] += DelayLineOut(&State->Late.Delay, (offset-State->Late.Offset[3])*4 + 3) * State->Late.Coeff[3];
 
             /* This is where the feed-back cycles from line 0 to 3 to 1 to 2
              * and back to 0.
@@ -1253,10 +1269,10 @@ static ALvoid LateReverb(ALreverbState *State, ALuint todo, ALfloat (*restrict o
             f[3] = d[3] + (State->Late.MixCoeff * (-d[0] + -d[1] + -d[2]       ));
 
             /* Re-feed the cyclical delay lines. */
-            DelayLineIn(&State->Late.Delay[0], offset, f[0]);
-            DelayLineIn(&State->Late.Delay[1], offset, f[1]);
-            DelayLineIn(&State->Late.Delay[2], offset, f[2]);
-            DelayLineIn(&State->Late.Delay[3], offset, f[3]);
+            DelayLineIn(&State->Late.Delay, offset*4 + 0, f[0]);
+            DelayLineIn(&State->Late.Delay, offset*4 + 1, f[1]);
+            DelayLineIn(&State->Late.Delay, offset*4 + 2, f[2]);
+            DelayLineIn(&State->Late.Delay, offset*4 + 3, f[3]);
             offset++;
 
             /* Output the results of the matrix for all four channels,
@@ -1279,6 +1295,155 @@ static ALvoid LateReverb(ALreverbState *State, ALuint todo, ALfloat (*restrict o
     }
 }
 
+#ifdef HAVE_SSE_INTRINSICS_HERE
+/* The SSE versions of the above, with the four lines in the lanes of one
+ * vector. The lines' samples are read with a different delay each, so they're
+ * gathered one at a time, but they're all written with a single store. The
+ * operations are done in the same order as the scalar versions, so the output
+ * is the same.
+ */
+#define DELAY_LINE_GATHER(_d, _o0, _o1, _o2, _o3)                             \
+    _mm_setr_ps(DelayLineOut((_d), (_o0)*4 + 0), DelayLineOut((_d), (_o1)*4 + 1), \
+                DelayLineOut((_d), (_o2)*4 + 2), DelayLineOut((_d), (_o3)*4 + 3))
+
+static inline void DelayLineStore(DelayLine *Delay, ALuint offset, __m128 in)
+{
+    _mm_storeu_ps(&Delay->Line[(offset*4)&Delay->Mask], in);
+}
+
+static ALvoid EarlyReflection_SSE(ALreverbState *State, ALuint todo, ALfloat (*restrict out)[MAX_UPDATE_SAMPLES])
+{
+    const ALuint *restrict tap = State->EarlyDelayTap;
+    const ALuint *restrict lineOffset = State->Early.Offset;
+    const __m128 coeff = _mm_load_ps(State->Early.Coeff);
+    const __m128 half = _mm_set1_ps(0.5f);
+    ALuint offset;
+    ALuint base, i;
+
+    offset = State->Offset;
+    for(base = 0;base < todo;)
+    {
+        alignas(16) ALfloat tmp[MAX_UPDATE_SAMPLES/4][4];
+        ALuint tmp_todo = minu(todo-base, MAX_UPDATE_SAMPLES/4);
+
+        for(i = 0;i < tmp_todo;i++)
+        {
+            __m128 f, d, v;
+
+            f = DELAY_LINE_GATHER(&State->Delay, offset-tap[0], offset-tap[1],
+                                  offset-tap[2], offset-tap[3]);
+
+            /* Sum the lanes from first to last, as the scalar path does. */
+            v = _mm_add_ss(f, _mm_shuffle_ps(f, f, _MM_SHUFFLE(1, 1, 1, 1)));
+            v = _mm_add_ss(v, _mm_shuffle_ps(f, f, _MM_SHUFFLE(2, 2, 2, 2)));
+            v = _mm_add_ss(v, _mm_shuffle_ps(f, f, _MM_SHUFFLE(3, 3, 3, 3)));
+            v = _mm_mul_ss(v, half);
+            v = _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0));
+            d = _mm_sub_ps(v, f);
+
+            DelayLineStore(&State->Early.Delay, offset, d);
+            d = DELAY_LINE_GATHER(&State->Early.Delay, offset-lineOffset[0],
+                                  offset-lineOffset[1], offset-lineOffset[2],
+                                  offset-lineOffset[3]);
+            offset++;
+
+            _mm_store_ps(tmp[i], _mm_add_ps(f, _mm_mul_ps(d, coeff)));
+        }
+
+        for(i = 0;i < tmp_todo;i++) out[0][base+i] = tmp[i][0];
+        for(i = 0;i < tmp_todo;i++) out[1][base+i] = tmp[i][1];
+        for(i = 0;i < tmp_todo;i++) out[2][base+i] = tmp[i][2];
+        for(i = 0;i < tmp_todo;i++) out[3][base+i] = tmp[i][3];
+
+        base += tmp_todo;
+    }
+}
+
+static ALvoid LateReverb_SSE(ALreverbState *State, ALuint todo, ALfloat (*restrict out)[MAX_UPDATE_SAMPLES])
+{
+    const ALuint *restrict tap = State->LateDelayTap;
+    const ALuint *restrict lineOffset = State->Late.Offset;
+    const ALuint *restrict apOffset = State->Late.ApOffset;
+    const __m128 densityGain = _mm_set1_ps(State->Late.DensityGain);
+    const __m128 coeff = _mm_load_ps(State->Late.Coeff);
+    const __m128 lpCoeff = _mm_load_ps(State->Late.LpCoeff);
+    const __m128 apFeedCoeff = _mm_set1_ps(State->Late.ApFeedCoeff);
+    const __m128 apCoeff = _mm_load_ps(State->Late.ApCoeff);
+    const __m128 mixCoeff = _mm_set1_ps(State->Late.MixCoeff);
+    const __m128 gain = _mm_set1_ps(State->Late.Gain);
+    /* Signs for the off-diagonal terms of the mixing matrix, in the order the
+     * scalar path adds them.
+     */
+    const __m128 sign0 = _mm_setr_ps(0.0f, -0.0f, 0.0f, -0.0f);
+    const __m128 sign1 = _mm_setr_ps(-0.0f, 0.0f, -0.0f, -0.0f);
+    const __m128 sign2 = _mm_setr_ps(0.0f, 0.0f, 0.0f, -0.0f);
+    __m128 lpSample = _mm_load_ps(State->Late.LpSample);
+    ALuint offset;
+    ALuint base, i;
+
+    offset = State->Offset;
+    for(base = 0;base < todo;)
+    {
+        alignas(16) ALfloat tmp[MAX_UPDATE_SAMPLES/4][4];
+        ALuint tmp_todo = minu(todo-base, MAX_UPDATE_SAMPLES/4);
+
+        for(i = 0;i < tmp_todo;i++)
+        {
+            __m128 f, d, ap, feed, mix;
+
+            f = DELAY_LINE_GATHER(&State->Delay, offset-tap[0], offset-tap[1],
+                                  offset-tap[2], offset-tap[3]);
+            f = _mm_mul_ps(f, densityGain);
+            d = DELAY_LINE_GATHER(&State->Late.Delay, offset-lineOffset[0],
+                                  offset-lineOffset[1], offset-lineOffset[2],
+                                  offset-lineOffset[3]);
+            f = _mm_add_ps(f, _mm_mul_ps(d, coeff));
+
+            /* Low-pass each line with its own filter, then cycle the lines
+             * (2, 3, 1, 0) into the all-passes.
+             */
+            lpSample = _mm_add_ps(f, _mm_mul_ps(_mm_sub_ps(lpSample, f), lpCoeff));
+            d = _mm_shuffle_ps(lpSample, lpSample, _MM_SHUFFLE(0, 1, 3, 2));
+
+            ap = DELAY_LINE_GATHER(&State->Late.ApDelay, offset-apOffset[0],
+                                   offset-apOffset[1], offset-apOffset[2],
+                                   offset-apOffset[3]);
+            feed = _mm_mul_ps(apFeedCoeff, d);
+            DelayLineStore(&State->Late.ApDelay, offset,
+                _mm_add_ps(_mm_mul_ps(apFeedCoeff, _mm_sub_ps(ap, feed)), d)
+            );
+            d = _mm_sub_ps(_mm_mul_ps(apCoeff, ap), feed);
+
+            /* The mixing matrix, as three shuffles of the lines with their
+             * signs applied.
+             */
+            mix = _mm_add_ps(
+                _mm_xor_ps(_mm_shuffle_ps(d, d, _MM_SHUFFLE(0, 0, 0, 1)), sign0),
+                _mm_xor_ps(_mm_shuffle_ps(d, d, _MM_SHUFFLE(1, 1, 2, 2)), sign1)
+            );
+            mix = _mm_add_ps(mix,
+                _mm_xor_ps(_mm_shuffle_ps(d, d, _MM_SHUFFLE(2, 3, 3, 3)), sign2)
+            );
+            f = _mm_add_ps(d, _mm_mul_ps(mixCoeff, mix));
+
+            DelayLineStore(&State->Late.Delay, offset, f);
+            offset++;
+
+            _mm_store_ps(tmp[i], _mm_mul_ps(gain, f));
+        }
+
+        for(i = 0;i < tmp_todo;i++) out[0][base+i] = tmp[i][0];
+        for(i = 0;i < tmp_todo;i++) out[1][base+i] = tmp[i][1];
+        for(i = 0;i < tmp_todo;i++) out[2][base+i] = tmp[i][2];
+        for(i = 0;i < tmp_todo;i++) out[3][base+i] = tmp[i][3];
+
+        base += tmp_todo;
+    }
+    _mm_store_ps(State->Late.LpSample, lpSample);
+}
+#undef DELAY_LINE_GATHER
+#endif
+
 // Given an input sample, this function mixes echo into the four-channel late
 // reverb.
 static ALvoid EAXEcho(ALreverbState *State, ALuint todo, ALfloat (*restrict late)[MAX_UPDATE_SAMPLES])
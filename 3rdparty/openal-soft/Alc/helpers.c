@@ -114,10 +114,29 @@ DEFINE_PROPERTYKEY(PKEY_AudioEndpoint_GUID, 0x1da5d803, 0xd492, 0x4edd, 0x8c, 0x
 extern inline ALuint NextPowerOf2(ALuint value);
 extern inline ALint fastf2i(ALfloat f);
 extern inline ALuint fastf2u(ALfloat f);
+extern inline int CountTrailingZeros64(ALuint64 value);
+extern inline int CountSetBits64(ALuint64 value);
 
 
 ALuint CPUCapFlags = 0;
 
+#if defined(HAVE_GCC_GET_CPUID) && (defined(__i386__) || defined(__x86_64__) || \
+                                    defined(_M_IX86) || defined(_M_X64))
+/* Reads XCR0 with XGETBV. Only valid when CPUID reports OSXSAVE. */
+static inline ALuint get_xcr0(void)
+{
+    unsigned int eax, edx;
+    __asm__ __volatile__(".byte 0x0f, 0x01, 0xd0" : "=a"(eax), "=d"(edx) : "c"(0));
+    return eax;
+}
+#elif defined(HAVE_CPUID_INTRINSIC) && (defined(__i386__) || defined(__x86_64__) || \
+                                        defined(_M_IX86) || defined(_M_X64))
+static inline ALuint get_xcr0(void)
+{
+    return (ALuint)_xgetbv(0);
+}
+#endif
+
 
 void FillCPUCaps(ALuint capfilter)
 {
@@ -167,6 +186,18 @@ void FillCPUCaps(ALuint capfilter)
                     }
                 }
             }
+
+            /* AVX2 also needs FMA, and the OS has to save the YMM registers
+             * (OSXSAVE set, and XCR0 enabling the SSE and AVX states).
+             */
+            if((caps&CPU_CAP_SSE4_1) && maxfunc >= 7 &&
+               (cpuinf[0].regs[2]&(1<<12)) && (cpuinf[0].regs[2]&(1<<27)) &&
+               (cpuinf[0].regs[2]&(1<<28)) && (get_xcr0()&0x6) == 0x6)
+            {
+                __cpuid_count(7, 0, cpuinf[0].regs[0], cpuinf[0].regs[1], cpuinf[0].regs[2], cpuinf[0].regs[3]);
+                if((cpuinf[0].regs[1]&(1<<5)))
+                    caps |= CPU_CAP_AVX2;
+            }
         }
     }
 #elif defined(HAVE_CPUID_INTRINSIC) && (defined(__i386__) || defined(__x86_64__) || \
@@ -215,6 +246,15 @@ void FillCPUCaps(ALuint capfilter)
                     }
                 }
             }
+
+            if((caps&CPU_CAP_SSE4_1) && maxfunc >= 7 &&
+               (cpuinf[0].regs[2]&(1<<12)) && (cpuinf[0].regs[2]&(1<<27)) &&
+               (cpuinf[0].regs[2]&(1<<28)) && (get_xcr0()&0x6) == 0x6)
+            {
+                __cpuidex(cpuinf[0].regs, 7, 0);
+                if((cpuinf[0].regs[1]&(1<<5)))
+                    caps |= CPU_CAP_AVX2;
+            }
         }
     }
 #else
@@ -267,11 +307,12 @@ void FillCPUCaps(ALuint capfilter)
     }
 #endif
 
-    TRACE("Extensions:%s%s%s%s%s%s\n",
+    TRACE("Extensions:%s%s%s%s%s%s%s\n",
         ((capfilter&CPU_CAP_SSE)    ? ((caps&CPU_CAP_SSE)    ? " +SSE"    : " -SSE")    : ""),
         ((capfilter&CPU_CAP_SSE2)   ? ((caps&CPU_CAP_SSE2)   ? " +SSE2"   : " -SSE2")   : ""),
         ((capfilter&CPU_CAP_SSE3)   ? ((caps&CPU_CAP_SSE3)   ? " +SSE3"   : " -SSE3")   : ""),
         ((capfilter&CPU_CAP_SSE4_1) ? ((caps&CPU_CAP_SSE4_1) ? " +SSE4.1" : " -SSE4.1") : ""),
+        ((capfilter&CPU_CAP_AVX2)   ? ((caps&CPU_CAP_AVX2)   ? " +AVX2"   : " -AVX2")   : ""),
         ((capfilter&CPU_CAP_NEON)   ? ((caps&CPU_CAP_NEON)   ? " +Neon"   : " -Neon")   : ""),
         ((!capfilter) ? " -none-" : "")
     );
@@ -954,26 +995,39 @@ void UnmapFileMem(const struct FileMapping *mapping)
 
 void SetRTPriority(void)
 {
-    ALboolean failed = AL_FALSE;
+    /* The level counts up from the class' lowest real-time priority. */
+    if(RTPrioLevel > 0 && althrd_setsched(althrd_current(), RTSchedClass, RTPrioLevel) != althrd_success)
+        ERR("Failed to set priority level for thread\n");
+    SetRTAffinity();
+}
 
-#ifdef _WIN32
-    if(RTPrioLevel > 0)
-        failed = !SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
-#elif defined(HAVE_PTHREAD_SETSCHEDPARAM) && !defined(__OpenBSD__)
-    if(RTPrioLevel > 0)
-    {
-        struct sched_param param;
-        /* Use the minimum real-time priority possible for now (on Linux this
-         * should be 1 for SCHED_RR) */
-        param.sched_priority = sched_get_priority_min(SCHED_RR);
-        failed = !!pthread_setschedparam(pthread_self(), SCHED_RR, &param);
-    }
+void SetRTAffinity(void)
+{
+    if(RTCpuMask != 0 && althrd_setaffinity(althrd_current(), RTCpuMask) != althrd_success)
+        ERR("Failed to set CPU affinity for thread\n");
+}
+
+/* Reads the processor's time-stamp counter where there is one, otherwise a
+ * monotonic clock in nanoseconds. These are what profilers in the app read as
+ * well, so the mixer's timestamps can be laid next to theirs.
+ */
+ALuint64 ReadTimestamp(void)
+{
+#if defined(HAVE_INTRIN_H) && (defined(_M_IX86) || defined(_M_X64))
+    return __rdtsc();
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+    return __builtin_ia32_rdtsc();
+#elif defined(_WIN32)
+    LARGE_INTEGER count, freq;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&freq);
+    return (ALuint64)(count.QuadPart/freq.QuadPart)*DEVICE_CLOCK_RES +
+           (ALuint64)(count.QuadPart%freq.QuadPart)*DEVICE_CLOCK_RES/freq.QuadPart;
 #else
-    /* Real-time priority not available */
-    failed = (RTPrioLevel>0);
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ALuint64)ts.tv_sec*DEVICE_CLOCK_RES + ts.tv_nsec;
 #endif
-    if(failed)
-        ERR("Failed to set priority level for thread\n");
 }
 
 
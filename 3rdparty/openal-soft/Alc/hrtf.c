@@ -48,6 +48,13 @@
 
 static const ALchar magicMarker00[8] = "MinPHR00";
 static const ALchar magicMarker01[8] = "MinPHR01";
+static const ALchar magicMarkerM1[8] = "MinPHRM1";
+
+/* The precompiled format's header, after the marker, is this many 32-bit
+ * fields, padded out to the section alignment.
+ */
+#define MAPPED_HEADER_FIELDS    (9)
+#define MAPPED_ALIGNMENT        (64)
 
 /* First value for pass-through coefficients (remaining are 0), used for omni-
  * directional sounds. */
@@ -679,6 +686,137 @@ static struct Hrtf *LoadHrtf01(const ALubyte *data, size_t datalen, const_al_str
     return Hrtf;
 }
 
+static ALuint ReadLE32(const ALubyte *data)
+{
+    return data[0] | (data[1]<<8) | (data[2]<<16) | ((ALuint)data[3]<<24);
+}
+
+/* Loads the precompiled format, which holds the tables exactly as they're
+ * used. Rather than copying them, the HRTF points into the given data, which
+ * must stay valid (and mapped) for as long as the HRTF exists. The data is
+ * validated, but the coefficients aren't touched, so the pages holding them
+ * are only read in when used, and are shared with other processes using the
+ * same file.
+ */
+static struct Hrtf *LoadHrtfM1(const ALubyte *data, size_t datalen, const_al_string filename)
+{
+    const ALubyte maxDelay = HRTF_HISTORY_LENGTH-1;
+    struct Hrtf *Hrtf = NULL;
+    ALuint rate, irSize, evCount, irCount;
+    ALuint offsets[4], fileSize;
+    const ALubyte *azCount;
+    const ALushort *evOffset;
+    const ALubyte *delays;
+    ALuint count, i;
+    size_t total;
+
+    if(!IS_LITTLE_ENDIAN)
+    {
+        ERR("Precompiled HRTF %s requires a little-endian system\n", al_string_get_cstr(filename));
+        return NULL;
+    }
+    if(datalen < sizeof(magicMarkerM1) + MAPPED_HEADER_FIELDS*4)
+    {
+        ERR("Unexpected end of %s data (req %d, rem "SZFMT")\n",
+            al_string_get_cstr(filename), (int)(sizeof(magicMarkerM1) + MAPPED_HEADER_FIELDS*4),
+            datalen);
+        return NULL;
+    }
+
+    rate = ReadLE32(data + 8);
+    irSize = ReadLE32(data + 12);
+    evCount = ReadLE32(data + 16);
+    irCount = ReadLE32(data + 20);
+    for(i = 0;i < 4;i++)
+        offsets[i] = ReadLE32(data + 24 + i*4);
+    fileSize = ReadLE32(data + 40);
+
+    if(irSize < MIN_IR_SIZE || irSize > MAX_IR_SIZE || (irSize%MOD_IR_SIZE))
+    {
+        ERR("Unsupported HRIR size: irSize=%d (%d to %d by %d)\n",
+            irSize, MIN_IR_SIZE, MAX_IR_SIZE, MOD_IR_SIZE);
+        return NULL;
+    }
+    if(evCount < MIN_EV_COUNT || evCount > MAX_EV_COUNT)
+    {
+        ERR("Unsupported elevation count: evCount=%d (%d to %d)\n",
+            evCount, MIN_EV_COUNT, MAX_EV_COUNT);
+        return NULL;
+    }
+    if(fileSize != datalen)
+    {
+        ERR("Size mismatch in %s (expected %u, got "SZFMT")\n",
+            al_string_get_cstr(filename), fileSize, datalen);
+        return NULL;
+    }
+    if((offsets[0]%MAPPED_ALIGNMENT) || offsets[0] > datalen || datalen-offsets[0] < evCount ||
+       (offsets[1]%MAPPED_ALIGNMENT) || offsets[1] > datalen || datalen-offsets[1] < evCount*2 ||
+       (offsets[2]%MAPPED_ALIGNMENT) || offsets[2] > datalen ||
+       (datalen-offsets[2])/2/irSize < irCount ||
+       (offsets[3]%MAPPED_ALIGNMENT) || offsets[3] > datalen || datalen-offsets[3] < irCount)
+    {
+        ERR("Invalid table offsets in %s\n", al_string_get_cstr(filename));
+        return NULL;
+    }
+
+    azCount = data + offsets[0];
+    evOffset = (const ALushort*)(data + offsets[1]);
+    delays = data + offsets[3];
+
+    count = 0;
+    for(i = 0;i < evCount;i++)
+    {
+        if(azCount[i] < MIN_AZ_COUNT || azCount[i] > MAX_AZ_COUNT)
+        {
+            ERR("Unsupported azimuth count: azCount[%d]=%d (%d to %d)\n",
+                i, azCount[i], MIN_AZ_COUNT, MAX_AZ_COUNT);
+            return NULL;
+        }
+        if(evOffset[i] != count)
+        {
+            ERR("Invalid evOffset[%d]: %d (%d)\n", i, evOffset[i], count);
+            return NULL;
+        }
+        count += azCount[i];
+    }
+    if(count != irCount)
+    {
+        ERR("HRIR count mismatch in %s (expected %u, got %u)\n",
+            al_string_get_cstr(filename), count, irCount);
+        return NULL;
+    }
+    for(i = 0;i < irCount;i++)
+    {
+        if(delays[i] > maxDelay)
+        {
+            ERR("Invalid delays[%d]: %d (%d)\n", i, delays[i], maxDelay);
+            return NULL;
+        }
+    }
+
+    total = sizeof(struct Hrtf) + al_string_length(filename)+1;
+    Hrtf = al_calloc(16, total);
+    if(Hrtf == NULL)
+    {
+        ERR("Out of memory.\n");
+        return NULL;
+    }
+
+    Hrtf->sampleRate = rate;
+    Hrtf->irSize = irSize;
+    Hrtf->evCount = evCount;
+    Hrtf->azCount = azCount;
+    Hrtf->evOffset = evOffset;
+    Hrtf->coeffs = (const ALshort*)(data + offsets[2]);
+    Hrtf->delays = delays;
+    Hrtf->filename = (char*)(Hrtf+1);
+    Hrtf->fmap = NULL;
+    Hrtf->next = NULL;
+    memcpy((void*)Hrtf->filename, al_string_get_cstr(filename), al_string_length(filename)+1);
+
+    return Hrtf;
+}
+
 static void AddFileEntry(vector_HrtfEntry *list, al_string *filename)
 {
     HrtfEntry entry = { AL_STRING_INIT_STATIC(), NULL };
@@ -719,6 +857,27 @@ static void AddFileEntry(vector_HrtfEntry *list, al_string *filename)
 
     if(fmap.len < sizeof(magicMarker01))
         ERR("%s data is too short ("SZFMT" bytes)\n", al_string_get_cstr(*filename), fmap.len);
+    else if(memcmp(fmap.ptr, magicMarkerM1, sizeof(magicMarkerM1)) == 0)
+    {
+        TRACE("Detected precompiled data set format\n");
+        hrtf = LoadHrtfM1((const ALubyte*)fmap.ptr, fmap.len, *filename);
+        if(hrtf)
+        {
+            /* Keep the file mapped, the tables are used in place. */
+            struct FileMapping *keep = al_calloc(16, sizeof(*keep));
+            if(!keep)
+            {
+                al_free(hrtf);
+                hrtf = NULL;
+            }
+            else
+            {
+                *keep = fmap;
+                hrtf->fmap = keep;
+                fmap.ptr = NULL;
+            }
+        }
+    }
     else if(memcmp(fmap.ptr, magicMarker01, sizeof(magicMarker01)) == 0)
     {
         TRACE("Detected data set format v1\n");
@@ -735,7 +894,8 @@ static void AddFileEntry(vector_HrtfEntry *list, al_string *filename)
     }
     else
         ERR("Invalid header in %s: \"%.8s\"\n", al_string_get_cstr(*filename), (const char*)fmap.ptr);
-    UnmapFileMem(&fmap);
+    if(fmap.ptr)
+        UnmapFileMem(&fmap);
 
     if(!hrtf)
     {
@@ -823,7 +983,12 @@ static void AddBuiltInEntry(vector_HrtfEntry *list, const ALubyte *data, size_t
         goto done;
     }
 
-    if(memcmp(data, magicMarker01, sizeof(magicMarker01)) == 0)
+    if(memcmp(data, magicMarkerM1, sizeof(magicMarkerM1)) == 0)
+    {
+        TRACE("Detected precompiled data set format\n");
+        hrtf = LoadHrtfM1(data, datalen, *filename);
+    }
+    else if(memcmp(data, magicMarker01, sizeof(magicMarker01)) == 0)
     {
         TRACE("Detected data set format v1\n");
         hrtf = LoadHrtf01(data+sizeof(magicMarker01),
@@ -1087,6 +1252,11 @@ void FreeHrtfs(void)
     while(Hrtf != NULL)
     {
         struct Hrtf *next = Hrtf->next;
+        if(Hrtf->fmap)
+        {
+            UnmapFileMem(Hrtf->fmap);
+            al_free((void*)Hrtf->fmap);
+        }
         al_free(Hrtf);
         Hrtf = next;
     }
@@ -7,6 +7,8 @@
 #include "alstring.h"
 
 
+struct FileMapping;
+
 struct Hrtf {
     ALuint sampleRate;
     ALuint irSize;
@@ -18,6 +20,9 @@ struct Hrtf {
     const ALubyte *delays;
 
     const char *filename;
+    /* Set when the tables above point into a mapped, precompiled file, which
+     * stays mapped until the HRTF is freed. */
+    const struct FileMapping *fmap;
     struct Hrtf *next;
 };
 
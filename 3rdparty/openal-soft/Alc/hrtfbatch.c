@@ -0,0 +1,221 @@
+/**
+ * OpenAL cross platform audio library
+ * Copyright (C) 1999-2007 by authors.
+ * This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ *  License along with this library; if not, write to the
+ *  Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ * Or go to http://www.gnu.org/copyleft/lgpl.html
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "hrtfbatch.h"
+#include "alMain.h"
+#include "alu.h"
+#include "hrtf.h"
+#include "mixer_defs.h"
+
+#include "almalloc.h"
+
+
+/* Directions are quantized to half a degree, well below the resolution of the
+ * measured HRIRs, so a source keeps the coefficients it would get unbatched
+ * except right at the boundary between two measurements.
+ */
+#define ANGLE_STEPS_PER_RADIAN (360.0f/F_PI)
+#define AZ_STEPS (720)
+
+#define INVALID_KEY (~0u)
+
+
+typedef struct HrtfBatchGroup {
+    alignas(16) ALfloat Input[BUFFERSIZE];
+    HrtfState State;
+    HrtfParams Params;
+
+    ALuint Key;
+    ALuint Offset;
+
+    /* Set when a voice mixed into the input this update. */
+    ALboolean Fed;
+    /* Samples left until the group's output decays to silence. The group may
+     * be handed over to another key once this reaches 0.
+     */
+    ALuint Tail;
+} HrtfBatchGroup;
+
+struct HrtfBatch {
+    const struct Hrtf *Hrtf;
+    ALuint TailLength;
+
+    HrtfBatchGroup Groups[MAX_HRTF_BATCH_GROUPS];
+};
+
+
+static inline HrtfMixerFunc SelectHrtfMixer(void)
+{
+#ifdef HAVE_AVX2
+    if((CPUCapFlags&CPU_CAP_AVX2))
+        return MixHrtf_AVX2;
+#endif
+#ifdef HAVE_SSE
+    if((CPUCapFlags&CPU_CAP_SSE))
+        return MixHrtf_SSE;
+#endif
+#ifdef HAVE_NEON
+    if((CPUCapFlags&CPU_CAP_NEON))
+        return MixHrtf_Neon;
+#endif
+
+    return MixHrtf_C;
+}
+
+
+struct HrtfBatch *hrtfbatch_alloc(const struct Hrtf *hrtf)
+{
+    struct HrtfBatch *batch;
+    ALsizei i;
+
+    batch = al_calloc(16, sizeof(*batch));
+    if(!batch) return NULL;
+
+    batch->Hrtf = hrtf;
+    /* The longest HRIR delay fits in the history, so the output is silent
+     * once that many samples plus the IR length passed without input.
+     */
+    batch->TailLength = HRTF_HISTORY_LENGTH + hrtf->irSize;
+    for(i = 0;i < MAX_HRTF_BATCH_GROUPS;i++)
+        batch->Groups[i].Key = INVALID_KEY;
+
+    return batch;
+}
+
+void hrtfbatch_free(struct HrtfBatch *batch)
+{
+    al_free(batch);
+}
+
+
+ALuint hrtfbatch_getKey(ALfloat elevation, ALfloat azimuth, ALfloat spread)
+{
+    ALuint ev, az, sp;
+
+    ev = fastf2u(clampf(elevation + F_PI_2, 0.0f, F_PI) * ANGLE_STEPS_PER_RADIAN + 0.5f);
+    az = fastf2u(clampf(azimuth + F_PI, 0.0f, F_TAU) * ANGLE_STEPS_PER_RADIAN + 0.5f) % AZ_STEPS;
+    sp = fastf2u(clampf(spread, 0.0f, F_TAU) * ANGLE_STEPS_PER_RADIAN + 0.5f);
+
+    return ev | (az<<9) | (sp<<19);
+}
+
+static void CalcGroupParams(const struct Hrtf *hrtf, ALuint key, HrtfParams *params)
+{
+    ALfloat ev = (ALfloat)( key      & 0x1ff) / ANGLE_STEPS_PER_RADIAN - F_PI_2;
+    ALfloat az = (ALfloat)((key>>9)  & 0x3ff) / ANGLE_STEPS_PER_RADIAN - F_PI;
+    ALfloat sp = (ALfloat)((key>>19) & 0x3ff) / ANGLE_STEPS_PER_RADIAN;
+
+    GetHrtfCoeffs(hrtf, ev, az, sp, 1.0f, params->Coeffs, params->Delay);
+}
+
+ALint hrtfbatch_getGroup(struct HrtfBatch *batch, ALuint key)
+{
+    ALint idle = -1;
+    ALuint idx;
+    ALsizei i;
+
+    /* Open addressing with linear probing. Groups are never emptied, only
+     * handed over to a new key in place, so a probe sequence ends at the
+     * first group that never had a key.
+     */
+    idx = (key * 2654435761u) % MAX_HRTF_BATCH_GROUPS;
+    for(i = 0;i < MAX_HRTF_BATCH_GROUPS;i++)
+    {
+        HrtfBatchGroup *group = &batch->Groups[idx];
+        if(group->Key == key)
+        {
+            /* Hold on to the group until the voice gets mixed. */
+            group->Tail = batch->TailLength;
+            return (ALint)idx;
+        }
+        if(group->Key == INVALID_KEY)
+        {
+            if(idle < 0) idle = (ALint)idx;
+            break;
+        }
+        if(idle < 0 && group->Tail == 0 && !group->Fed)
+            idle = (ALint)idx;
+        idx = (idx+1) % MAX_HRTF_BATCH_GROUPS;
+    }
+    if(idle < 0)
+        return -1;
+
+    {
+        HrtfBatchGroup *group = &batch->Groups[idle];
+        memset(&group->State, 0, sizeof(group->State));
+        group->Key = key;
+        group->Offset = 0;
+        group->Tail = batch->TailLength;
+        CalcGroupParams(batch->Hrtf, key, &group->Params);
+    }
+    return idle;
+}
+
+const HrtfParams *hrtfbatch_getParams(const struct HrtfBatch *batch, ALint group)
+{
+    return &batch->Groups[group].Params;
+}
+
+ALfloat (*hrtfbatch_getInput(struct HrtfBatch *batch, ALint group, ALuint key))[BUFFERSIZE]
+{
+    HrtfBatchGroup *grp = &batch->Groups[group];
+    if(grp->Key != key)
+        return NULL;
+    grp->Fed = AL_TRUE;
+    return &grp->Input;
+}
+
+
+void hrtfbatch_mix(struct HrtfBatch *batch, ALfloat (*OutBuffer)[BUFFERSIZE], ALuint lidx, ALuint ridx, ALuint SamplesToDo)
+{
+    HrtfMixerFunc MixHrtfSamples = SelectHrtfMixer();
+    const ALuint IrSize = batch->Hrtf->irSize;
+    MixHrtfParams hrtfparams;
+    ALsizei i;
+
+    for(i = 0;i < MAX_HRTF_BATCH_GROUPS;i++)
+    {
+        HrtfBatchGroup *group = &batch->Groups[i];
+
+        if(group->Fed)
+            group->Tail = batch->TailLength;
+        else if(group->Tail == 0)
+            continue;
+        else
+            group->Tail -= minu(group->Tail, SamplesToDo);
+
+        /* The coefficients never change, so there's nothing to step. */
+        hrtfparams.Target = &group->Params;
+        hrtfparams.Current = &group->Params;
+        MixHrtfSamples(OutBuffer, lidx, ridx, group->Input, 0, group->Offset, 0,
+                       IrSize, &hrtfparams, &group->State, SamplesToDo);
+        group->Offset += SamplesToDo;
+
+        if(group->Fed)
+        {
+            memset(group->Input, 0, SamplesToDo*sizeof(ALfloat));
+            group->Fed = AL_FALSE;
+        }
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef HRTFBATCH_H
+#define HRTFBATCH_H
+
+#include "alMain.h"
+
+struct Hrtf;
+struct HrtfBatch;
+
+/* Number of distinct directions that can be convolved as a batch at once. */
+#define MAX_HRTF_BATCH_GROUPS 128
+
+/* Allocates the batch groups for static HRTF sources. Each group holds the
+ * unit-gain coefficients for one quantized direction, computed once, and the
+ * convolution state shared by every voice playing from that direction.
+ */
+struct HrtfBatch *hrtfbatch_alloc(const struct Hrtf *hrtf);
+void hrtfbatch_free(struct HrtfBatch *batch);
+
+/* Quantizes a direction (and spread) into the key identifying its group. */
+ALuint hrtfbatch_getKey(ALfloat elevation, ALfloat azimuth, ALfloat spread);
+
+/* Returns the group for the given key, claiming an idle one and computing its
+ * coefficients if there is none yet. Returns -1 if all groups are busy.
+ */
+ALint hrtfbatch_getGroup(struct HrtfBatch *batch, ALuint key);
+const HrtfParams *hrtfbatch_getParams(const struct HrtfBatch *batch, ALint group);
+
+/* Returns the input buffer of the group, for a voice to mix its dry signal
+ * into, or NULL if the group was since handed over to another key.
+ */
+ALfloat (*hrtfbatch_getInput(struct HrtfBatch *batch, ALint group, ALuint key))[BUFFERSIZE];
+
+/* Convolves the input of every active group and adds it to the left and right
+ * output channels, then clears the inputs for the next update.
+ */
+void hrtfbatch_mix(struct HrtfBatch *batch, ALfloat (*OutBuffer)[BUFFERSIZE], ALuint lidx, ALuint ridx, ALuint SamplesToDo);
+
+#endif /* HRTFBATCH_H */
@@ -36,6 +36,7 @@
 #include "alu.h"
 
 #include "mixer_defs.h"
+#include "hrtfbatch.h"
 
 
 static_assert((INT_MAX>>FRACTIONBITS)/MAX_PITCH > BUFFERSIZE,
@@ -67,6 +68,10 @@ static ResamplerFunc ResampleSamples = Resample_point32_C;
 
 MixerFunc SelectMixer(void)
 {
+#ifdef HAVE_AVX2
+    if((CPUCapFlags&CPU_CAP_AVX2))
+        return Mix_AVX2;
+#endif
 #ifdef HAVE_SSE
     if((CPUCapFlags&CPU_CAP_SSE))
         return Mix_SSE;
@@ -81,6 +86,10 @@ MixerFunc SelectMixer(void)
 
 RowMixerFunc SelectRowMixer(void)
 {
+#ifdef HAVE_AVX2
+    if((CPUCapFlags&CPU_CAP_AVX2))
+        return MixRow_AVX2;
+#endif
 #ifdef HAVE_SSE
     if((CPUCapFlags&CPU_CAP_SSE))
         return MixRow_SSE;
@@ -94,6 +103,10 @@ RowMixerFunc SelectRowMixer(void)
 
 static inline HrtfMixerFunc SelectHrtfMixer(void)
 {
+#ifdef HAVE_AVX2
+    if((CPUCapFlags&CPU_CAP_AVX2))
+        return MixHrtf_AVX2;
+#endif
 #ifdef HAVE_SSE
     if((CPUCapFlags&CPU_CAP_SSE))
         return MixHrtf_SSE;
@@ -113,6 +126,10 @@ static inline ResamplerFunc SelectResampler(enum Resampler resampler)
         case PointResampler:
             return Resample_point32_C;
         case LinearResampler:
+#ifdef HAVE_AVX2
+            if((CPUCapFlags&CPU_CAP_AVX2))
+                return Resample_lerp32_AVX2;
+#endif
 #ifdef HAVE_SSE4_1
             if((CPUCapFlags&CPU_CAP_SSE4_1))
                 return Resample_lerp32_SSE41;
@@ -123,6 +140,10 @@ static inline ResamplerFunc SelectResampler(enum Resampler resampler)
 #endif
             return Resample_lerp32_C;
         case FIR4Resampler:
+#ifdef HAVE_AVX2
+            if((CPUCapFlags&CPU_CAP_AVX2))
+                return Resample_fir4_32_AVX2;
+#endif
 #ifdef HAVE_SSE4_1
             if((CPUCapFlags&CPU_CAP_SSE4_1))
                 return Resample_fir4_32_SSE41;
@@ -143,6 +164,10 @@ static inline ResamplerFunc SelectResampler(enum Resampler resampler)
 #endif
             return Resample_fir8_32_C;
         case BSincResampler:
+#ifdef HAVE_AVX2
+            if((CPUCapFlags&CPU_CAP_AVX2))
+                return Resample_bsinc32_AVX2;
+#endif
 #ifdef HAVE_SSE
             if((CPUCapFlags&CPU_CAP_SSE))
                 return Resample_bsinc32_SSE;
@@ -381,8 +406,116 @@ static const ALfloat *DoFilters(ALfilterState *lpfilter, ALfilterState *hpfilter
 }
 
 
-ALvoid MixSource(ALvoice *voice, ALsource *Source, ALCdevice *Device, ALuint SamplesToDo)
+/* Allowance over the gains for how far resampling and filtering can take a
+ * signal above its stored peak.
+ */
+#define CULL_HEADROOM 2.0f
+
+/* Returns the most any input sample can be scaled by on its way to an output
+ * over this update, whether the gains are fading or not.
+ */
+static ALfloat GetVoiceGainBound(const ALvoice *voice, const ALCdevice *Device,
+                                 ALuint NumChannels, ALuint IrSize)
 {
+    ALfloat bound = 0.0f;
+    ALuint chan, send, i;
+
+    for(chan = 0;chan < NumChannels;chan++)
+    {
+        const DirectParams *parms = &voice->Chan[chan].Direct;
+
+        if(!voice->IsHrtf)
+        {
+            for(i = 0;i < voice->DirectOut.Channels;i++)
+                bound = maxf(bound, maxf(fabsf(parms->Gains.Current[i]),
+                                         fabsf(parms->Gains.Target[i])));
+        }
+        else
+        {
+            ALfloat sums[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+            for(i = 0;i < IrSize;i++)
+            {
+                sums[0] += fabsf(parms->Hrtf.Current.Coeffs[i][0]);
+                sums[1] += fabsf(parms->Hrtf.Current.Coeffs[i][1]);
+                sums[2] += fabsf(parms->Hrtf.Target.Coeffs[i][0]);
+                sums[3] += fabsf(parms->Hrtf.Target.Coeffs[i][1]);
+            }
+            bound = maxf(bound, maxf(maxf(sums[0], sums[1]), maxf(sums[2], sums[3])));
+
+            if(voice->HrtfGroup >= 0)
+            {
+                /* The group's coefficients are for unit gain. */
+                const HrtfParams *group = hrtfbatch_getParams(Device->HrtfBatch,
+                                                              voice->HrtfGroup);
+                ALfloat gain = maxf(fabsf(parms->Gains.Current[0]),
+                                    fabsf(parms->Gains.Target[0]));
+
+                sums[0] = sums[1] = 0.0f;
+                for(i = 0;i < IrSize;i++)
+                {
+                    sums[0] += fabsf(group->Coeffs[i][0]);
+                    sums[1] += fabsf(group->Coeffs[i][1]);
+                }
+                bound = maxf(bound, maxf(sums[0], sums[1]) * gain);
+            }
+        }
+
+        for(send = 0;send < Device->NumAuxSends;send++)
+        {
+            const SendParams *sparms = &voice->Chan[chan].Send[send];
+
+            if(!voice->SendOut[send].Buffer)
+                continue;
+            for(i = 0;i < voice->SendOut[send].Channels;i++)
+                bound = maxf(bound, maxf(fabsf(sparms->Gains.Current[i]),
+                                         fabsf(sparms->Gains.Target[i])));
+        }
+    }
+
+    return bound * CULL_HEADROOM;
+}
+
+/* Skips an update of a voice whose input is inaudible, leaving it as if it
+ * had mixed silence: gains and coefficients land on their targets, and the
+ * filter and HRTF histories are cleared.
+ */
+static void SkipVoiceUpdate(ALvoice *voice, const ALCdevice *Device, ALuint NumChannels,
+                            ALuint SamplesToDo)
+{
+    ALuint chan, send;
+
+    for(chan = 0;chan < NumChannels;chan++)
+    {
+        DirectParams *parms = &voice->Chan[chan].Direct;
+
+        memcpy(parms->Gains.Current, parms->Gains.Target, sizeof(parms->Gains.Current));
+        if(voice->IsHrtf)
+        {
+            parms->Hrtf.Current = parms->Hrtf.Target;
+            memset(&parms->Hrtf.State, 0, sizeof(parms->Hrtf.State));
+        }
+        ALfilterState_clear(&parms->LowPass);
+        ALfilterState_clear(&parms->HighPass);
+
+        for(send = 0;send < Device->NumAuxSends;send++)
+        {
+            SendParams *sparms = &voice->Chan[chan].Send[send];
+
+            memcpy(sparms->Gains.Current, sparms->Gains.Target, sizeof(sparms->Gains.Current));
+            ALfilterState_clear(&sparms->LowPass);
+            ALfilterState_clear(&sparms->HighPass);
+        }
+
+        memset(voice->PrevSamples[chan], 0, sizeof(voice->PrevSamples[chan]));
+    }
+    voice->Offset += SamplesToDo;
+}
+
+ALboolean MixSource(ALvoice *voice, ALsource *Source, ALCdevice *Device, const MixBuffers *Buffers, ALuint SamplesToDo)
+{
+    ALfloat (*DirectOut)[BUFFERSIZE];
+    ALfloat *SrcBuffer, *ResampleBuffer, *FilterBuffer;
     ResamplerFunc Resample;
     ALbufferlistitem *BufferListItem;
     ALuint DataPosInt, DataPosFrac;
@@ -395,6 +528,7 @@ ALvoid MixSource(ALvoice *voice, ALsource *Source, ALCdevice *Device, ALuint Sam
     ALint64 DataSize64;
     ALuint Counter;
     ALuint IrSize;
+    ALboolean Culled;
     ALuint chan, send, j;
 
     /* Get source info */
@@ -409,9 +543,89 @@ ALvoid MixSource(ALvoice *voice, ALsource *Source, ALCdevice *Device, ALuint Sam
 
     IrSize = (Device->Hrtf.Handle ? Device->Hrtf.Handle->irSize : 0);
 
+    if(Buffers)
+    {
+        SrcBuffer      = Buffers->SourceData;
+        ResampleBuffer = Buffers->ResampledData;
+        FilterBuffer   = Buffers->FilteredData;
+        DirectOut      = Buffers->DirectOut;
+    }
+    else
+    {
+        SrcBuffer      = Device->SourceData;
+        ResampleBuffer = Device->ResampledData;
+        FilterBuffer   = Device->FilteredData;
+        DirectOut      = voice->DirectOut.Buffer;
+    }
+
     Resample = ((increment == FRACTIONONE && DataPosFrac == 0) ?
                 Resample_copy32_C : ResampleSamples);
 
+    /* A static source playing through to its end can be checked against its
+     * buffer's envelope. The window starts far enough back to cover what the
+     * filters and HRTF may still be holding from earlier updates.
+     */
+    Culled = AL_FALSE;
+    if(Device->CullLevel > 0.0f && Source->SourceType == AL_STATIC && !Looping &&
+       BufferListItem->buffer && BufferListItem->buffer->EnvelopeBlocks > 0)
+    {
+        const ALbuffer *ALBuffer = BufferListItem->buffer;
+        ALsizei blocks = ALBuffer->EnvelopeBlocks;
+        ALuint lookback, start;
+        ALuint64 end;
+        ALfloat bound, peak;
+        ALsizei i;
+
+        lookback  = (ALuint)(((ALuint64)(BUFFERSIZE+HRIR_LENGTH)*increment) >> FRACTIONBITS);
+        lookback += MAX_PRE_SAMPLES;
+        start = (DataPosInt > lookback) ? DataPosInt-lookback : 0;
+        end   = DataPosInt + MAX_POST_SAMPLES +
+                (((ALuint64)SamplesToDo*increment + DataPosFrac) >> FRACTIONBITS);
+
+        bound = GetVoiceGainBound(voice, Device, NumChannels, IrSize);
+        if(ALBuffer->Envelope[blocks + start/BUFFER_ENVELOPE_BLOCK]*bound < Device->CullLevel)
+        {
+            /* Nothing left to hear; finish now. */
+            SkipVoiceUpdate(voice, Device, NumChannels, SamplesToDo);
+            State = AL_STOPPED;
+            BufferListItem = NULL;
+            DataPosInt = 0;
+            DataPosFrac = 0;
+            Culled = AL_TRUE;
+        }
+        else
+        {
+            ALsizei last = (ALsizei)mini64(end/BUFFER_ENVELOPE_BLOCK, blocks-1);
+
+            peak = 0.0f;
+            for(i = start/BUFFER_ENVELOPE_BLOCK;i <= last;i++)
+                peak = maxf(peak, ALBuffer->Envelope[i]);
+            if(peak*bound < Device->CullLevel)
+            {
+                ALuint64 pos;
+
+                SkipVoiceUpdate(voice, Device, NumChannels, SamplesToDo);
+                pos  = (ALuint64)SamplesToDo*increment + DataPosFrac;
+                pos += (ALuint64)DataPosInt << FRACTIONBITS;
+                if(pos >= ((ALuint64)ALBuffer->SampleLen << FRACTIONBITS))
+                {
+                    State = AL_STOPPED;
+                    BufferListItem = NULL;
+                    DataPosInt = 0;
+                    DataPosFrac = 0;
+                }
+                else
+                {
+                    DataPosInt  = (ALuint)(pos >> FRACTIONBITS);
+                    DataPosFrac = (ALuint)(pos & FRACTIONMASK);
+                }
+                Culled = AL_TRUE;
+            }
+        }
+    }
+    if(Culled)
+        goto voice_done;
+
     Counter = voice->Moving ? SamplesToDo : 0;
     OutPos = 0;
     do {
@@ -443,7 +657,7 @@ ALvoid MixSource(ALvoice *voice, ALsource *Source, ALCdevice *Device, ALuint Sam
         for(chan = 0;chan < NumChannels;chan++)
         {
             const ALfloat *ResampledData;
-            ALfloat *SrcData = Device->SourceData;
+            ALfloat *SrcData = SrcBuffer;
             ALuint SrcDataSize;
 
             /* Load the previous samples into the source data first. */
@@ -550,14 +764,14 @@ ALvoid MixSource(ALvoice *voice, ALsource *Source, ALCdevice *Device, ALuint Sam
             /* Now resample, then filter and mix to the appropriate outputs. */
             ResampledData = Resample(&voice->SincState,
                 &SrcData[MAX_PRE_SAMPLES], DataPosFrac, increment,
-                Device->ResampledData, DstBufferSize
+                ResampleBuffer, DstBufferSize
             );
             {
                 DirectParams *parms = &voice->Chan[chan].Direct;
                 const ALfloat *samples;
 
                 samples = DoFilters(
-                    &parms->LowPass, &parms->HighPass, Device->FilteredData,
+                    &parms->LowPass, &parms->HighPass, FilterBuffer,
                     ResampledData, DstBufferSize, parms->FilterType
                 );
                 if(!voice->IsHrtf)
@@ -565,16 +779,50 @@ ALvoid MixSource(ALvoice *voice, ALsource *Source, ALCdevice *Device, ALuint Sam
                     if(!Counter)
                         memcpy(parms->Gains.Current, parms->Gains.Target,
                                sizeof(parms->Gains.Current));
-                    MixSamples(samples, voice->DirectOut.Channels, voice->DirectOut.Buffer,
+                    MixSamples(samples, voice->DirectOut.Channels, DirectOut,
                         parms->Gains.Current, parms->Gains.Target, Counter, OutPos, DstBufferSize
                     );
                 }
                 else
                 {
                     MixHrtfParams hrtfparams;
+                    ALuint HrtfCounter = Counter;
                     int lidx, ridx;
 
-                    if(!Counter)
+                    if(voice->HrtfGroup >= 0)
+                    {
+                        ALfloat (*GroupIn)[BUFFERSIZE] = hrtfbatch_getInput(
+                            Device->HrtfBatch, voice->HrtfGroup, voice->HrtfKey
+                        );
+                        if(GroupIn)
+                        {
+                            /* The group convolves the sum of its voices once,
+                             * so only the gain is applied here.
+                             */
+                            if(!Counter)
+                                parms->Gains.Current[0] = parms->Gains.Target[0];
+                            MixSamples(samples, 1, GroupIn, parms->Gains.Current,
+                                parms->Gains.Target, Counter, OutPos, DstBufferSize
+                            );
+                            goto hrtf_done;
+                        }
+
+                        /* The group was handed over to another direction
+                         * while the voice was paused. Continue on its own.
+                         */
+                        voice->HrtfGroup = -1;
+                        HrtfCounter = 0;
+                    }
+
+                    /* Nothing to step when the coefficients didn't change. */
+                    if(HrtfCounter &&
+                       parms->Hrtf.Target.Delay[0] == parms->Hrtf.Current.Delay[0] &&
+                       parms->Hrtf.Target.Delay[1] == parms->Hrtf.Current.Delay[1] &&
+                       memcmp(parms->Hrtf.Target.Coeffs, parms->Hrtf.Current.Coeffs,
+                              IrSize*sizeof(parms->Hrtf.Target.Coeffs[0])) == 0)
+                        HrtfCounter = 0;
+
+                    if(!HrtfCounter)
                     {
                         parms->Hrtf.Current = parms->Hrtf.Target;
                         for(j = 0;j < HRIR_LENGTH;j++)
@@ -587,7 +835,7 @@ ALvoid MixSource(ALvoice *voice, ALsource *Source, ALCdevice *Device, ALuint Sam
                     }
                     else
                     {
-                        ALfloat delta = 1.0f / (ALfloat)Counter;
+                        ALfloat delta = 1.0f / (ALfloat)HrtfCounter;
                         ALfloat coeffdiff;
                         ALint delaydiff;
                         for(j = 0;j < IrSize;j++)
@@ -609,29 +857,32 @@ ALvoid MixSource(ALvoice *voice, ALsource *Source, ALCdevice *Device, ALuint Sam
                     ridx = GetChannelIdxByName(Device->RealOut, FrontRight);
                     assert(lidx != -1 && ridx != -1);
 
-                    MixHrtfSamples(voice->DirectOut.Buffer, lidx, ridx, samples, Counter,
+                    MixHrtfSamples(DirectOut, lidx, ridx, samples, HrtfCounter,
                                    voice->Offset, OutPos, IrSize, &hrtfparams,
                                    &parms->Hrtf.State, DstBufferSize);
                 }
             }
+        hrtf_done:
 
             for(send = 0;send < Device->NumAuxSends;send++)
             {
                 SendParams *parms = &voice->Chan[chan].Send[send];
+                ALfloat (*SendOut)[BUFFERSIZE];
                 const ALfloat *samples;
 
-                if(!voice->SendOut[send].Buffer)
+                SendOut = Buffers ? Buffers->SendOut[send] : voice->SendOut[send].Buffer;
+                if(!SendOut)
                     continue;
 
                 samples = DoFilters(
-                    &parms->LowPass, &parms->HighPass, Device->FilteredData,
+                    &parms->LowPass, &parms->HighPass, FilterBuffer,
                     ResampledData, DstBufferSize, parms->FilterType
                 );
 
                 if(!Counter)
                     memcpy(parms->Gains.Current, parms->Gains.Target,
                            sizeof(parms->Gains.Current));
-                MixSamples(samples, voice->SendOut[send].Channels, voice->SendOut[send].Buffer,
+                MixSamples(samples, voice->SendOut[send].Channels, SendOut,
                     parms->Gains.Current, parms->Gains.Target, Counter, OutPos, DstBufferSize
                 );
             }
@@ -690,6 +941,7 @@ ALvoid MixSource(ALvoice *voice, ALsource *Source, ALCdevice *Device, ALuint Sam
         }
     } while(State == AL_PLAYING && OutPos < SamplesToDo);
 
+voice_done:
     voice->Moving = AL_TRUE;
 
     /* Update source info */
@@ -697,4 +949,6 @@ ALvoid MixSource(ALvoice *voice, ALsource *Source, ALCdevice *Device, ALuint Sam
     ATOMIC_STORE(&Source->current_buffer,    BufferListItem, almemory_order_relaxed);
     ATOMIC_STORE(&Source->position,          DataPosInt, almemory_order_relaxed);
     ATOMIC_STORE(&Source->position_fraction, DataPosFrac, almemory_order_release);
+
+    return Culled;
 }
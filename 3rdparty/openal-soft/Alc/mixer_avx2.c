@@ -0,0 +1,403 @@
+/**
+ * OpenAL cross platform audio library
+ * Copyright (C) 1999-2007 by authors.
+ * This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ *  License along with this library; if not, write to the
+ *  Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ * Or go to http://www.gnu.org/copyleft/lgpl.html
+ */
+
+#include "config.h"
+
+#include <immintrin.h>
+
+#include "AL/al.h"
+#include "AL/alc.h"
+#include "alMain.h"
+#include "alu.h"
+
+#include "alSource.h"
+#include "alAuxEffectSlot.h"
+#include "mixer_defs.h"
+
+
+/* All loads and stores here are unaligned, since the buffers are only
+ * guaranteed 16-byte alignment. Results differ from the SSE paths in the last
+ * bits, as FMA skips the intermediate rounding of the product.
+ */
+
+const ALfloat *Resample_lerp32_AVX2(const BsincState* UNUSED(state), const ALfloat *restrict src,
+                                    ALuint frac, ALuint increment, ALfloat *restrict dst,
+                                    ALuint numsamples)
+{
+    const __m256i increment8 = _mm256_set1_epi32(increment*8);
+    const __m256 fracOne8 = _mm256_set1_ps(1.0f/FRACTIONONE);
+    const __m256i fracMask8 = _mm256_set1_epi32(FRACTIONMASK);
+    ALuint pos_[8], frac_[8];
+    __m256i frac8, pos8;
+    ALuint pos;
+    ALuint i;
+
+    InitiatePositionArrays(frac, increment, frac_, pos_, 8);
+
+    frac8 = _mm256_loadu_si256((const __m256i*)frac_);
+    pos8 = _mm256_loadu_si256((const __m256i*)pos_);
+
+    for(i = 0;numsamples-i > 7;i += 8)
+    {
+        const __m256 val1 = _mm256_i32gather_ps(src, pos8, 4);
+        const __m256 val2 = _mm256_i32gather_ps(src+1, pos8, 4);
+
+        /* val1 + (val2-val1)*mu */
+        const __m256 mu = _mm256_mul_ps(_mm256_cvtepi32_ps(frac8), fracOne8);
+        const __m256 out = _mm256_fmadd_ps(mu, _mm256_sub_ps(val2, val1), val1);
+
+        _mm256_storeu_ps(&dst[i], out);
+
+        frac8 = _mm256_add_epi32(frac8, increment8);
+        pos8 = _mm256_add_epi32(pos8, _mm256_srli_epi32(frac8, FRACTIONBITS));
+        frac8 = _mm256_and_si256(frac8, fracMask8);
+    }
+
+    /* NOTE: These eight elements represent the position *after* the last
+     * eight samples, so the lowest element is the next position to resample.
+     */
+    pos = _mm_cvtsi128_si32(_mm256_castsi256_si128(pos8));
+    frac = _mm_cvtsi128_si32(_mm256_castsi256_si128(frac8));
+
+    for(;i < numsamples;i++)
+    {
+        dst[i] = lerp(src[pos], src[pos+1], frac * (1.0f/FRACTIONONE));
+
+        frac += increment;
+        pos  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+    return dst;
+}
+
+const ALfloat *Resample_fir4_32_AVX2(const BsincState* UNUSED(state), const ALfloat *restrict src,
+                                     ALuint frac, ALuint increment, ALfloat *restrict dst,
+                                     ALuint numsamples)
+{
+    const __m256i increment8 = _mm256_set1_epi32(increment*8);
+    const __m256i fracMask8 = _mm256_set1_epi32(FRACTIONMASK);
+    const ALfloat *coeffs = ResampleCoeffs.FIR4[0];
+    ALuint pos_[8], frac_[8];
+    __m256i frac8, pos8;
+    ALuint pos;
+    ALuint i;
+
+    InitiatePositionArrays(frac, increment, frac_, pos_, 8);
+
+    frac8 = _mm256_loadu_si256((const __m256i*)frac_);
+    pos8 = _mm256_loadu_si256((const __m256i*)pos_);
+
+    --src;
+    for(i = 0;numsamples-i > 7;i += 8)
+    {
+        /* Gather each of the four taps for eight samples at a time. */
+        const __m256i k8 = _mm256_slli_epi32(frac8, 2);
+        __m256 out;
+
+        out = _mm256_mul_ps(_mm256_i32gather_ps(coeffs, k8, 4),
+                            _mm256_i32gather_ps(src, pos8, 4));
+        out = _mm256_fmadd_ps(_mm256_i32gather_ps(coeffs+1, k8, 4),
+                              _mm256_i32gather_ps(src+1, pos8, 4), out);
+        out = _mm256_fmadd_ps(_mm256_i32gather_ps(coeffs+2, k8, 4),
+                              _mm256_i32gather_ps(src+2, pos8, 4), out);
+        out = _mm256_fmadd_ps(_mm256_i32gather_ps(coeffs+3, k8, 4),
+                              _mm256_i32gather_ps(src+3, pos8, 4), out);
+
+        _mm256_storeu_ps(&dst[i], out);
+
+        frac8 = _mm256_add_epi32(frac8, increment8);
+        pos8 = _mm256_add_epi32(pos8, _mm256_srli_epi32(frac8, FRACTIONBITS));
+        frac8 = _mm256_and_si256(frac8, fracMask8);
+    }
+
+    pos = _mm_cvtsi128_si32(_mm256_castsi256_si128(pos8));
+    frac = _mm_cvtsi128_si32(_mm256_castsi256_si128(frac8));
+
+    for(;i < numsamples;i++)
+    {
+        dst[i] = resample_fir4(src[pos], src[pos+1], src[pos+2], src[pos+3], frac);
+
+        frac += increment;
+        pos  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+    return dst;
+}
+
+const ALfloat *Resample_bsinc32_AVX2(const BsincState *state, const ALfloat *restrict src,
+                                     ALuint frac, ALuint increment, ALfloat *restrict dst,
+                                     ALuint dstlen)
+{
+    const __m256 sf8 = _mm256_set1_ps(state->sf);
+    const ALuint m = state->m;
+    const ALint l = state->l;
+    const ALfloat *fil, *scd, *phd, *spd;
+    ALuint pi, j_f, i;
+    ALfloat pf;
+    ALint j_s;
+    __m256 r8;
+    __m128 r4;
+
+    for(i = 0;i < dstlen;i++)
+    {
+        // Calculate the phase index and factor.
+#define FRAC_PHASE_BITDIFF (FRACTIONBITS-BSINC_PHASE_BITS)
+        pi = frac >> FRAC_PHASE_BITDIFF;
+        pf = (frac & ((1<<FRAC_PHASE_BITDIFF)-1)) * (1.0f/(1<<FRAC_PHASE_BITDIFF));
+#undef FRAC_PHASE_BITDIFF
+
+        fil = state->coeffs[pi].filter;
+        scd = state->coeffs[pi].scDelta;
+        phd = state->coeffs[pi].phDelta;
+        spd = state->coeffs[pi].spDelta;
+
+        // Apply the scale and phase interpolated filter.
+        r8 = _mm256_setzero_ps();
+        {
+            const __m256 pf8 = _mm256_set1_ps(pf);
+            for(j_f = 0,j_s = l;m-j_f > 7;j_f+=8,j_s+=8)
+            {
+                const __m256 f8 = _mm256_fmadd_ps(
+                    pf8,
+                    _mm256_fmadd_ps(sf8, _mm256_loadu_ps(&spd[j_f]), _mm256_loadu_ps(&phd[j_f])),
+                    _mm256_fmadd_ps(sf8, _mm256_loadu_ps(&scd[j_f]), _mm256_loadu_ps(&fil[j_f]))
+                );
+                r8 = _mm256_fmadd_ps(f8, _mm256_loadu_ps(&src[j_s]), r8);
+            }
+        }
+        r4 = _mm_add_ps(_mm256_castps256_ps128(r8), _mm256_extractf128_ps(r8, 1));
+        /* The coefficient count is a multiple of 4, so there's at most one
+         * set of 4 left.
+         */
+        if(j_f < m)
+        {
+            const __m128 sf4 = _mm256_castps256_ps128(sf8);
+            const __m128 pf4 = _mm_set1_ps(pf);
+            const __m128 f4 = _mm_fmadd_ps(
+                pf4,
+                _mm_fmadd_ps(sf4, _mm_load_ps(&spd[j_f]), _mm_load_ps(&phd[j_f])),
+                _mm_fmadd_ps(sf4, _mm_load_ps(&scd[j_f]), _mm_load_ps(&fil[j_f]))
+            );
+            r4 = _mm_fmadd_ps(f4, _mm_loadu_ps(&src[j_s]), r4);
+        }
+        r4 = _mm_add_ps(r4, _mm_shuffle_ps(r4, r4, _MM_SHUFFLE(0, 1, 2, 3)));
+        r4 = _mm_add_ps(r4, _mm_movehl_ps(r4, r4));
+        dst[i] = _mm_cvtss_f32(r4);
+
+        frac += increment;
+        src  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+    return dst;
+}
+
+
+/* The HRIR is applied four taps (eight floats) at a time, over each run of
+ * history values that doesn't wrap around the end of the ring.
+ */
+static inline void ApplyCoeffsStep(ALuint Offset, ALfloat (*restrict Values)[2],
+                                   const ALuint IrSize,
+                                   ALfloat (*restrict Coeffs)[2],
+                                   const ALfloat (*restrict CoeffStep)[2],
+                                   ALfloat left, ALfloat right)
+{
+    const __m256 lrlr = _mm256_setr_ps(left, right, left, right, left, right, left, right);
+    ALuint i = 0;
+
+    while(i < IrSize)
+    {
+        const ALuint o = (Offset+i)&HRIR_MASK;
+        const ALuint todo = minu(IrSize-i, HRIR_LENGTH-o);
+        ALuint j = 0;
+
+        for(;todo-j > 3;j += 4)
+        {
+            __m256 coeffs = _mm256_loadu_ps(&Coeffs[i+j][0]);
+            __m256 vals = _mm256_loadu_ps(&Values[o+j][0]);
+
+            vals = _mm256_fmadd_ps(lrlr, coeffs, vals);
+            coeffs = _mm256_add_ps(coeffs, _mm256_loadu_ps(&CoeffStep[i+j][0]));
+            _mm256_storeu_ps(&Values[o+j][0], vals);
+            _mm256_storeu_ps(&Coeffs[i+j][0], coeffs);
+        }
+        for(;j < todo;j++)
+        {
+            Values[o+j][0] += Coeffs[i+j][0] * left;
+            Values[o+j][1] += Coeffs[i+j][1] * right;
+            Coeffs[i+j][0] += CoeffStep[i+j][0];
+            Coeffs[i+j][1] += CoeffStep[i+j][1];
+        }
+        i += todo;
+    }
+}
+
+static inline void ApplyCoeffs(ALuint Offset, ALfloat (*restrict Values)[2],
+                               const ALuint IrSize,
+                               ALfloat (*restrict Coeffs)[2],
+                               ALfloat left, ALfloat right)
+{
+    const __m256 lrlr = _mm256_setr_ps(left, right, left, right, left, right, left, right);
+    ALuint i = 0;
+
+    while(i < IrSize)
+    {
+        const ALuint o = (Offset+i)&HRIR_MASK;
+        const ALuint todo = minu(IrSize-i, HRIR_LENGTH-o);
+        ALuint j = 0;
+
+        for(;todo-j > 3;j += 4)
+        {
+            __m256 vals = _mm256_loadu_ps(&Values[o+j][0]);
+            vals = _mm256_fmadd_ps(lrlr, _mm256_loadu_ps(&Coeffs[i+j][0]), vals);
+            _mm256_storeu_ps(&Values[o+j][0], vals);
+        }
+        for(;j < todo;j++)
+        {
+            Values[o+j][0] += Coeffs[i+j][0] * left;
+            Values[o+j][1] += Coeffs[i+j][1] * right;
+        }
+        i += todo;
+    }
+}
+
+#define MixHrtf MixHrtf_AVX2
+#define MixDirectHrtf MixDirectHrtf_AVX2
+#include "mixer_inc.c"
+#undef MixHrtf
+
+
+void Mix_AVX2(const ALfloat *data, ALuint OutChans, ALfloat (*restrict OutBuffer)[BUFFERSIZE],
+              ALfloat *CurrentGains, const ALfloat *TargetGains, ALuint Counter, ALuint OutPos,
+              ALuint BufferSize)
+{
+    const __m256 ramp8 = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    ALfloat gain, delta, step;
+    __m256 gain8;
+    ALuint c;
+
+    delta = (Counter > 0) ? 1.0f/(ALfloat)Counter : 0.0f;
+
+    for(c = 0;c < OutChans;c++)
+    {
+        ALuint pos = 0;
+        gain = CurrentGains[c];
+        step = (TargetGains[c] - gain) * delta;
+        if(fabsf(step) > FLT_EPSILON)
+        {
+            ALuint minsize = minu(BufferSize, Counter);
+            /* Mix with applying gain steps in multiples of 8. */
+            if(minsize-pos > 7)
+            {
+                const __m256 step8 = _mm256_set1_ps(step * 8.0f);
+                gain8 = _mm256_fmadd_ps(_mm256_set1_ps(step), ramp8, _mm256_set1_ps(gain));
+                do {
+                    const __m256 val8 = _mm256_loadu_ps(&data[pos]);
+                    __m256 dry8 = _mm256_loadu_ps(&OutBuffer[c][OutPos+pos]);
+                    dry8 = _mm256_fmadd_ps(val8, gain8, dry8);
+                    gain8 = _mm256_add_ps(gain8, step8);
+                    _mm256_storeu_ps(&OutBuffer[c][OutPos+pos], dry8);
+                    pos += 8;
+                } while(minsize-pos > 7);
+                /* NOTE: gain8 now represents the next eight gains after the
+                 * last eight mixed samples, so the lowest element represents
+                 * the next gain to apply.
+                 */
+                gain = _mm_cvtss_f32(_mm256_castps256_ps128(gain8));
+            }
+            /* Mix with applying left over gain steps that aren't multiples of 8. */
+            for(;pos < minsize;pos++)
+            {
+                OutBuffer[c][OutPos+pos] += data[pos]*gain;
+                gain += step;
+            }
+            if(pos == Counter)
+                gain = TargetGains[c];
+            CurrentGains[c] = gain;
+        }
+
+        if(!(fabsf(gain) > GAIN_SILENCE_THRESHOLD))
+            continue;
+        gain8 = _mm256_set1_ps(gain);
+        for(;BufferSize-pos > 7;pos += 8)
+        {
+            const __m256 val8 = _mm256_loadu_ps(&data[pos]);
+            __m256 dry8 = _mm256_loadu_ps(&OutBuffer[c][OutPos+pos]);
+            dry8 = _mm256_fmadd_ps(val8, gain8, dry8);
+            _mm256_storeu_ps(&OutBuffer[c][OutPos+pos], dry8);
+        }
+        for(;pos < BufferSize;pos++)
+            OutBuffer[c][OutPos+pos] += data[pos]*gain;
+    }
+}
+
+void MixRow_AVX2(ALfloat *OutBuffer, const ALfloat *Gains, const ALfloat (*restrict data)[BUFFERSIZE], ALuint InChans, ALuint InPos, ALuint BufferSize)
+{
+    const ALfloat *rows[MAX_ROW_CHANS];
+    __m256 gains[MAX_ROW_CHANS];
+    ALuint c = 0;
+
+    /* As with the SSE version, keep the output in registers across the input
+     * channels. */
+    while(c < InChans)
+    {
+        ALuint count = 0;
+        ALuint pos = 0;
+        ALuint i;
+
+        for(;c < InChans && count < MAX_ROW_CHANS;c++)
+        {
+            ALfloat gain = Gains[c];
+            if(!(fabsf(gain) > GAIN_SILENCE_THRESHOLD))
+                continue;
+            rows[count] = &data[c][InPos];
+            gains[count] = _mm256_set1_ps(gain);
+            count++;
+        }
+        if(count == 0)
+            break;
+
+        for(;BufferSize-pos > 15;pos += 16)
+        {
+            __m256 dry8a = _mm256_loadu_ps(&OutBuffer[pos]);
+            __m256 dry8b = _mm256_loadu_ps(&OutBuffer[pos+8]);
+            for(i = 0;i < count;i++)
+            {
+                dry8a = _mm256_fmadd_ps(_mm256_loadu_ps(&rows[i][pos]), gains[i], dry8a);
+                dry8b = _mm256_fmadd_ps(_mm256_loadu_ps(&rows[i][pos+8]), gains[i], dry8b);
+            }
+            _mm256_storeu_ps(&OutBuffer[pos], dry8a);
+            _mm256_storeu_ps(&OutBuffer[pos+8], dry8b);
+        }
+        for(;BufferSize-pos > 7;pos += 8)
+        {
+            __m256 dry8 = _mm256_loadu_ps(&OutBuffer[pos]);
+            for(i = 0;i < count;i++)
+                dry8 = _mm256_fmadd_ps(_mm256_loadu_ps(&rows[i][pos]), gains[i], dry8);
+            _mm256_storeu_ps(&OutBuffer[pos], dry8);
+        }
+        for(;pos < BufferSize;pos++)
+        {
+            ALfloat dry = OutBuffer[pos];
+            for(i = 0;i < count;i++)
+                dry += rows[i][pos] * _mm256_cvtss_f32(gains[i]);
+            OutBuffer[pos] = dry;
+        }
+    }
+}
@@ -11,6 +11,11 @@ struct MixGains;
 struct MixHrtfParams;
 struct HrtfState;
 
+/* The most input channels the vectorized row mixers add into the output in one
+ * pass. Enough for both bands of a third-order decoder.
+ */
+#define MAX_ROW_CHANS (MAX_AMBI_COEFFS*2)
+
 /* C resamplers */
 const ALfloat *Resample_copy32_C(const BsincState *state, const ALfloat *restrict src, ALuint frac, ALuint increment, ALfloat *restrict dst, ALuint dstlen);
 const ALfloat *Resample_point32_C(const BsincState *state, const ALfloat *restrict src, ALuint frac, ALuint increment, ALfloat *restrict dst, ALuint dstlen);
@@ -91,6 +96,32 @@ const ALfloat *Resample_fir8_32_SSE41(const BsincState *state, const ALfloat *re
                                       ALuint frac, ALuint increment, ALfloat *restrict dst,
                                       ALuint numsamples);
 
+/* AVX2/FMA mixers */
+void MixHrtf_AVX2(ALfloat (*restrict OutBuffer)[BUFFERSIZE], ALuint lidx, ALuint ridx,
+                  const ALfloat *data, ALuint Counter, ALuint Offset, ALuint OutPos,
+                  const ALuint IrSize, const struct MixHrtfParams *hrtfparams,
+                  struct HrtfState *hrtfstate, ALuint BufferSize);
+void MixDirectHrtf_AVX2(ALfloat (*restrict OutBuffer)[BUFFERSIZE], ALuint lidx, ALuint ridx,
+                        const ALfloat *data, ALuint Offset, const ALuint IrSize,
+                        ALfloat (*restrict Coeffs)[2], ALfloat (*restrict Values)[2],
+                        ALuint BufferSize);
+void Mix_AVX2(const ALfloat *data, ALuint OutChans, ALfloat (*restrict OutBuffer)[BUFFERSIZE],
+              ALfloat *CurrentGains, const ALfloat *TargetGains, ALuint Counter, ALuint OutPos,
+              ALuint BufferSize);
+void MixRow_AVX2(ALfloat *OutBuffer, const ALfloat *Gains,
+                 const ALfloat (*restrict data)[BUFFERSIZE], ALuint InChans,
+                 ALuint InPos, ALuint BufferSize);
+
+/* AVX2/FMA resamplers */
+const ALfloat *Resample_lerp32_AVX2(const BsincState *state, const ALfloat *restrict src,
+                                    ALuint frac, ALuint increment, ALfloat *restrict dst,
+                                    ALuint numsamples);
+const ALfloat *Resample_fir4_32_AVX2(const BsincState *state, const ALfloat *restrict src,
+                                     ALuint frac, ALuint increment, ALfloat *restrict dst,
+                                     ALuint numsamples);
+const ALfloat *Resample_bsinc32_AVX2(const BsincState *state, const ALfloat *restrict src, ALuint frac,
+                                     ALuint increment, ALfloat *restrict dst, ALuint dstlen);
+
 /* Neon mixers */
 void MixHrtf_Neon(ALfloat (*restrict OutBuffer)[BUFFERSIZE], ALuint lidx, ALuint ridx,
                   const ALfloat *data, ALuint Counter, ALuint Offset, ALuint OutPos,
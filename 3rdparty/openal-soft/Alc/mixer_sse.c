@@ -268,25 +268,58 @@ void Mix_SSE(const ALfloat *data, ALuint OutChans, ALfloat (*restrict OutBuffer)
 
 void MixRow_SSE(ALfloat *OutBuffer, const ALfloat *Gains, const ALfloat (*restrict data)[BUFFERSIZE], ALuint InChans, ALuint InPos, ALuint BufferSize)
 {
-    __m128 gain4;
-    ALuint c;
+    const ALfloat *rows[MAX_ROW_CHANS];
+    __m128 gains[MAX_ROW_CHANS];
+    ALuint c = 0;
 
-    for(c = 0;c < InChans;c++)
+    /* Accumulate as many input channels as will fit into the output samples
+     * while they're in registers, rather than loading and storing the output
+     * once for each input channel. The sums are still made in channel order,
+     * so this gives the same results as one channel at a time.
+     */
+    while(c < InChans)
     {
+        ALuint count = 0;
         ALuint pos = 0;
-        ALfloat gain = Gains[c];
-        if(!(fabsf(gain) > GAIN_SILENCE_THRESHOLD))
-            continue;
+        ALuint i;
 
-        gain4 = _mm_set1_ps(gain);
+        for(;c < InChans && count < MAX_ROW_CHANS;c++)
+        {
+            ALfloat gain = Gains[c];
+            if(!(fabsf(gain) > GAIN_SILENCE_THRESHOLD))
+                continue;
+            rows[count] = &data[c][InPos];
+            gains[count] = _mm_set1_ps(gain);
+            count++;
+        }
+        if(count == 0)
+            break;
+
+        for(;BufferSize-pos > 7;pos += 8)
+        {
+            __m128 dry4a = _mm_load_ps(&OutBuffer[pos]);
+            __m128 dry4b = _mm_load_ps(&OutBuffer[pos+4]);
+            for(i = 0;i < count;i++)
+            {
+                dry4a = _mm_add_ps(dry4a, _mm_mul_ps(_mm_load_ps(&rows[i][pos]), gains[i]));
+                dry4b = _mm_add_ps(dry4b, _mm_mul_ps(_mm_load_ps(&rows[i][pos+4]), gains[i]));
+            }
+            _mm_store_ps(&OutBuffer[pos], dry4a);
+            _mm_store_ps(&OutBuffer[pos+4], dry4b);
+        }
         for(;BufferSize-pos > 3;pos += 4)
         {
-            const __m128 val4 = _mm_load_ps(&data[c][InPos+pos]);
             __m128 dry4 = _mm_load_ps(&OutBuffer[pos]);
-            dry4 = _mm_add_ps(dry4, _mm_mul_ps(val4, gain4));
+            for(i = 0;i < count;i++)
+                dry4 = _mm_add_ps(dry4, _mm_mul_ps(_mm_load_ps(&rows[i][pos]), gains[i]));
             _mm_store_ps(&OutBuffer[pos], dry4);
         }
         for(;pos < BufferSize;pos++)
-            OutBuffer[pos] += data[c][InPos+pos]*gain;
+        {
+            ALfloat dry = OutBuffer[pos];
+            for(i = 0;i < count;i++)
+                dry += rows[i][pos] * _mm_cvtss_f32(gains[i]);
+            OutBuffer[pos] = dry;
+        }
     }
 }
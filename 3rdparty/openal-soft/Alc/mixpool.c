@@ -0,0 +1,404 @@
+/**
+ * OpenAL cross platform audio library
+ * Copyright (C) 1999-2007 by authors.
+ * This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ *  License along with this library; if not, write to the
+ *  Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ * Or go to http://www.gnu.org/copyleft/lgpl.html
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "mixpool.h"
+#include "alMain.h"
+#include "alSource.h"
+#include "alAuxEffectSlot.h"
+#include "alu.h"
+
+#include "threads.h"
+#include "almalloc.h"
+
+
+/* The voices are split into a fixed number of chunks per thread, each chunk
+ * mixing into its own accumulation buffers. A thread first takes the chunks
+ * of its own queue, then steals the ones left in the others'. The chunks are
+ * summed in order afterward, so which thread ends up mixing a chunk makes no
+ * difference to the output.
+ */
+#define CHUNKS_PER_THREAD 4
+
+/* Maximum number of effect slots the voices may send to, including the
+ * device's default slot.
+ */
+#define MAX_MIX_SLOTS 4
+
+/* Must be less than 15 characters (16 including terminating null) for
+ * compatibility with pthread_setname_np limitations. */
+#define MIXPOOL_THREAD_NAME "alsoft-mixpool"
+
+
+typedef struct MixChunk {
+    ALboolean Mixed;
+    /* Voices this chunk updated, and how many of those were culled. */
+    ALuint Updates;
+    ALuint Culled;
+
+    ALfloat (*DryBuffer)[BUFFERSIZE];
+    ALfloat (*WetBuffer)[BUFFERSIZE];
+} MixChunk;
+
+typedef struct MixThread {
+    struct MixPool *Pool;
+    ALsizei Index;
+    althrd_t Thread;
+
+    /* Number of chunks taken from this thread's queue, by itself or others.
+     * Goes past CHUNKS_PER_THREAD once the queue is empty.
+     */
+    ATOMIC(ALuint) ChunksTaken;
+
+    alignas(16) ALfloat SourceData[BUFFERSIZE];
+    alignas(16) ALfloat ResampledData[BUFFERSIZE];
+    alignas(16) ALfloat FilteredData[BUFFERSIZE];
+} MixThread;
+
+struct MixPool {
+    ALsizei NumThreads;
+    ALsizei NumChunks;
+    ALsizei NumChannels;
+    ALsizei MaxSlots;
+
+    almtx_t Lock;
+    alcnd_t Cond;
+    ALuint Generation;
+    ATOMIC(ALenum) KillNow;
+
+    /* Number of worker threads still mixing the current generation. */
+    ATOMIC(ALuint) Pending;
+
+    /* The current job. Set by the mixer thread before it starts a new
+     * generation, and only read by the workers.
+     */
+    ALCdevice *Device;
+    ALvoice *Voices;
+    const ALuint64 *VoiceMask;
+    ALsizei VoiceCount;
+    ALuint SamplesToDo;
+    ALsizei NumSlots;
+    ALeffectslot *Slots[MAX_MIX_SLOTS];
+
+    ALfloat (*ChunkBuffers)[BUFFERSIZE];
+    MixChunk Chunks[MAX_MIX_THREADS*CHUNKS_PER_THREAD];
+
+    /* Thread 0 is the device's mixer thread. */
+    MixThread Threads[];
+};
+
+
+static inline ALboolean IsVoicePlaying(const ALvoice *voice)
+{
+    const ALsource *source = voice->Source;
+    return (source && source->state == AL_PLAYING && voice->Step > 0);
+}
+
+static ALsizei FindSlot(const struct MixPool *pool, ALfloat (*buffer)[BUFFERSIZE])
+{
+    ALsizei i;
+    for(i = 0;i < pool->NumSlots;i++)
+    {
+        if(pool->Slots[i]->WetBuffer == buffer)
+            return i;
+    }
+    return -1;
+}
+
+static void MixVoiceChunk(struct MixPool *pool, MixThread *thread, ALsizei chunkidx)
+{
+    MixChunk *chunk = &pool->Chunks[chunkidx];
+    ALCdevice *device = pool->Device;
+    ALuint SamplesToDo = pool->SamplesToDo;
+    ALsizei per_chunk, begin, end;
+    MixBuffers buffers;
+    ALuint updates = 0;
+    ALuint culled = 0;
+    ALsizei i, s, c;
+
+    per_chunk = (pool->VoiceCount + pool->NumChunks-1) / pool->NumChunks;
+    begin = mini(chunkidx*per_chunk, pool->VoiceCount);
+    end = mini(begin+per_chunk, pool->VoiceCount);
+
+    buffers.SourceData = thread->SourceData;
+    buffers.ResampledData = thread->ResampledData;
+    buffers.FilteredData = thread->FilteredData;
+
+    for(i = NextActiveVoice(pool->VoiceMask, begin, end);i < end;
+        i = NextActiveVoice(pool->VoiceMask, i+1, end))
+    {
+        ALvoice *voice = &pool->Voices[i];
+
+        if(!IsVoicePlaying(voice))
+            continue;
+
+        if(!chunk->Mixed)
+        {
+            for(c = 0;c < pool->NumChannels;c++)
+                memset(chunk->DryBuffer[c], 0, SamplesToDo*sizeof(ALfloat));
+            for(c = 0;c < pool->NumSlots*MAX_EFFECT_CHANNELS;c++)
+                memset(chunk->WetBuffer[c], 0, SamplesToDo*sizeof(ALfloat));
+            chunk->Mixed = AL_TRUE;
+        }
+
+        /* Redirect the voice's outputs to the same channels of this chunk's
+         * buffers.
+         */
+        buffers.DirectOut = chunk->DryBuffer + (voice->DirectOut.Buffer - device->Dry.Buffer);
+        for(s = 0;s < (ALsizei)device->NumAuxSends;s++)
+        {
+            ALsizei slotidx = -1;
+            if(voice->SendOut[s].Buffer)
+                slotidx = FindSlot(pool, voice->SendOut[s].Buffer);
+            buffers.SendOut[s] = (slotidx < 0) ? NULL :
+                                 (chunk->WetBuffer + slotidx*MAX_EFFECT_CHANNELS);
+        }
+
+        updates++;
+        if(MixSource(voice, voice->Source, device, &buffers, SamplesToDo))
+            culled++;
+    }
+
+    chunk->Updates = updates;
+    chunk->Culled = culled;
+}
+
+static void MixChunks(struct MixPool *pool, ALsizei index)
+{
+    MixThread *self = &pool->Threads[index];
+    ALsizei i;
+
+    for(i = 0;i < pool->NumThreads;i++)
+    {
+        MixThread *owner = &pool->Threads[(index+i) % pool->NumThreads];
+        ALuint taken;
+
+        while((taken=ATOMIC_ADD(&owner->ChunksTaken, 1, almemory_order_relaxed)) < CHUNKS_PER_THREAD)
+            MixVoiceChunk(pool, self, owner->Index*CHUNKS_PER_THREAD + taken);
+    }
+}
+
+static int MixPoolProc(void *arg)
+{
+    MixThread *self = arg;
+    struct MixPool *pool = self->Pool;
+    ALuint generation = 0;
+    FPUCtl oldMode;
+
+    SetRTPriority();
+    althrd_setname(althrd_current(), MIXPOOL_THREAD_NAME);
+    SetMixerFPUMode(&oldMode);
+
+    almtx_lock(&pool->Lock);
+    while(1)
+    {
+        while(pool->Generation == generation && !ATOMIC_LOAD(&pool->KillNow, almemory_order_acquire))
+            alcnd_wait(&pool->Cond, &pool->Lock);
+        if(ATOMIC_LOAD(&pool->KillNow, almemory_order_acquire))
+            break;
+        generation = pool->Generation;
+        almtx_unlock(&pool->Lock);
+
+        MixChunks(pool, self->Index);
+        ATOMIC_SUB(&pool->Pending, 1, almemory_order_acq_rel);
+
+        almtx_lock(&pool->Lock);
+    }
+    almtx_unlock(&pool->Lock);
+
+    RestoreFPUMode(&oldMode);
+    return 0;
+}
+
+
+struct MixPool *mixpool_alloc(ALsizei numthreads, ALsizei numchans, ALsizei numsends)
+{
+    struct MixPool *pool;
+    ALsizei chunkchans;
+    ALsizei i;
+
+    numthreads = clampi(numthreads, 2, MAX_MIX_THREADS);
+
+    pool = al_calloc(16, sizeof(*pool) + numthreads*sizeof(pool->Threads[0]));
+    if(!pool) return NULL;
+
+    pool->NumThreads = numthreads;
+    pool->NumChunks = numthreads * CHUNKS_PER_THREAD;
+    pool->NumChannels = numchans;
+    pool->MaxSlots = numsends ? MAX_MIX_SLOTS : 0;
+
+    chunkchans = pool->NumChannels + pool->MaxSlots*MAX_EFFECT_CHANNELS;
+    pool->ChunkBuffers = al_calloc(16, pool->NumChunks*chunkchans*sizeof(pool->ChunkBuffers[0]));
+    if(!pool->ChunkBuffers)
+    {
+        al_free(pool);
+        return NULL;
+    }
+    for(i = 0;i < pool->NumChunks;i++)
+    {
+        pool->Chunks[i].Mixed = AL_FALSE;
+        pool->Chunks[i].DryBuffer = pool->ChunkBuffers + i*chunkchans;
+        pool->Chunks[i].WetBuffer = pool->Chunks[i].DryBuffer + pool->NumChannels;
+    }
+
+    almtx_init(&pool->Lock, almtx_plain);
+    alcnd_init(&pool->Cond);
+    pool->Generation = 0;
+    ATOMIC_INIT(&pool->KillNow, AL_FALSE);
+    ATOMIC_INIT(&pool->Pending, 0);
+
+    for(i = 0;i < numthreads;i++)
+    {
+        pool->Threads[i].Pool = pool;
+        pool->Threads[i].Index = i;
+        ATOMIC_INIT(&pool->Threads[i].ChunksTaken, CHUNKS_PER_THREAD);
+    }
+    for(i = 1;i < numthreads;i++)
+    {
+        if(althrd_create(&pool->Threads[i].Thread, MixPoolProc, &pool->Threads[i]) != althrd_success)
+        {
+            ERR("Failed to start mix thread %d\n", i);
+            pool->NumThreads = i;
+            mixpool_free(pool);
+            return NULL;
+        }
+    }
+
+    return pool;
+}
+
+void mixpool_free(struct MixPool *pool)
+{
+    ALsizei i;
+
+    if(!pool)
+        return;
+
+    almtx_lock(&pool->Lock);
+    ATOMIC_STORE(&pool->KillNow, AL_TRUE, almemory_order_release);
+    alcnd_broadcast(&pool->Cond);
+    almtx_unlock(&pool->Lock);
+
+    for(i = 1;i < pool->NumThreads;i++)
+    {
+        int res;
+        althrd_join(pool->Threads[i].Thread, &res);
+    }
+
+    alcnd_destroy(&pool->Cond);
+    almtx_destroy(&pool->Lock);
+
+    al_free(pool->ChunkBuffers);
+    pool->ChunkBuffers = NULL;
+
+    al_free(pool);
+}
+
+
+ALboolean mixpool_mixVoices(struct MixPool *pool, ALCdevice *device, ALCcontext *ctx, ALeffectslot *slotroot, ALuint SamplesToDo, ALuint *updates, ALuint *culled)
+{
+    ALeffectslot *slot;
+    ALsizei i, s, c;
+
+    /* Gather the slots the voices can send to, and make sure they fit. */
+    pool->NumSlots = 0;
+    if(device->DefaultSlot)
+    {
+        if(pool->NumSlots == pool->MaxSlots)
+            return AL_FALSE;
+        pool->Slots[pool->NumSlots++] = device->DefaultSlot;
+    }
+    for(slot = slotroot;slot;slot = ATOMIC_LOAD(&slot->next, almemory_order_relaxed))
+    {
+        if(pool->NumSlots == pool->MaxSlots)
+            return AL_FALSE;
+        pool->Slots[pool->NumSlots++] = slot;
+    }
+
+    for(i = NextActiveVoice(ctx->VoiceMask, 0, ctx->VoiceCount);i < ctx->VoiceCount;
+        i = NextActiveVoice(ctx->VoiceMask, i+1, ctx->VoiceCount))
+    {
+        const ALvoice *voice = &ctx->Voices[i];
+        if(!IsVoicePlaying(voice))
+            continue;
+        for(s = 0;s < (ALsizei)device->NumAuxSends;s++)
+        {
+            if(voice->SendOut[s].Buffer && FindSlot(pool, voice->SendOut[s].Buffer) < 0)
+                return AL_FALSE;
+        }
+    }
+
+    pool->Device = device;
+    pool->Voices = ctx->Voices;
+    pool->VoiceMask = ctx->VoiceMask;
+    pool->VoiceCount = ctx->VoiceCount;
+    pool->SamplesToDo = SamplesToDo;
+    for(i = 0;i < pool->NumChunks;i++)
+        pool->Chunks[i].Mixed = AL_FALSE;
+    for(i = 0;i < pool->NumThreads;i++)
+        ATOMIC_STORE(&pool->Threads[i].ChunksTaken, 0, almemory_order_relaxed);
+    ATOMIC_STORE(&pool->Pending, pool->NumThreads-1, almemory_order_relaxed);
+
+    almtx_lock(&pool->Lock);
+    pool->Generation++;
+    alcnd_broadcast(&pool->Cond);
+    almtx_unlock(&pool->Lock);
+
+    MixChunks(pool, 0);
+
+    /* The workers only have a chunk or two left at this point, so there isn't
+     * much to gain from sleeping.
+     */
+    while(ATOMIC_LOAD(&pool->Pending, almemory_order_acquire) > 0)
+        althrd_yield();
+
+    /* Sum the chunks in order. */
+    for(i = 0;i < pool->NumChunks;i++)
+    {
+        const MixChunk *chunk = &pool->Chunks[i];
+        ALuint j;
+
+        if(!chunk->Mixed)
+            continue;
+        *updates += chunk->Updates;
+        *culled += chunk->Culled;
+
+        for(c = 0;c < pool->NumChannels;c++)
+        {
+            for(j = 0;j < SamplesToDo;j++)
+                device->Dry.Buffer[c][j] += chunk->DryBuffer[c][j];
+        }
+        for(s = 0;s < pool->NumSlots;s++)
+        {
+            ALeffectslot *dst = pool->Slots[s];
+            for(c = 0;c < (ALsizei)dst->NumChannels;c++)
+            {
+                const ALfloat *src = chunk->WetBuffer[s*MAX_EFFECT_CHANNELS + c];
+                for(j = 0;j < SamplesToDo;j++)
+                    dst->WetBuffer[c][j] += src[j];
+            }
+        }
+    }
+
+    return AL_TRUE;
+}
@@ -0,0 +1,29 @@
+#ifndef MIXPOOL_H
+#define MIXPOOL_H
+
+#include "alMain.h"
+
+struct ALeffectslot;
+struct MixPool;
+
+#define MAX_MIX_THREADS 16
+
+/* Allocates a pool of numthreads-1 worker threads which, together with the
+ * mixer thread, mix a context's voices in parallel. numchans is the number of
+ * channels allocated for the device's mix buffers (dry, first-order and real
+ * output), and numsends the device's number of auxiliary sends. Everything is
+ * allocated up front, so mixing does not allocate.
+ */
+struct MixPool *mixpool_alloc(ALsizei numthreads, ALsizei numchans, ALsizei numsends);
+void mixpool_free(struct MixPool *pool);
+
+/* Mixes all of the context's playing voices into the device's mix buffers and
+ * the wet buffers of the given effect slots, like calling MixSource on each
+ * voice in turn. The result is reproducible for a given thread count. Adds the
+ * number of voices updated, and of those culled, to updates and culled. Returns
+ * AL_FALSE without mixing anything if the voices can't be mixed in parallel,
+ * e.g. when they send to more effect slots than the pool has room for.
+ */
+ALboolean mixpool_mixVoices(struct MixPool *pool, ALCdevice *device, ALCcontext *ctx, struct ALeffectslot *slotroot, ALuint SamplesToDo, ALuint *updates, ALuint *culled);
+
+#endif /* MIXPOOL_H */
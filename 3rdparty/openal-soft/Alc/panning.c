@@ -21,6 +21,7 @@
 #include "config.h"
 
 #include <math.h>
+#include <float.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
@@ -35,6 +36,8 @@
 #include "uhjfilter.h"
 #include "bs2b.h"
 
+#include "almalloc.h"
+
 
 extern inline void CalcXYZCoeffs(ALfloat x, ALfloat y, ALfloat z, ALfloat spread, ALfloat coeffs[MAX_AMBI_COEFFS]);
 
@@ -209,6 +212,173 @@ void CalcAngleCoeffs(ALfloat azimuth, ALfloat elevation, ALfloat spread, ALfloat
 }
 
 
+/* Directions are quantized to 1/2048th of a unit along each axis, about 0.03
+ * degrees, and the spread to 1/1024th of a turn. That's finer than anything
+ * the panning can resolve, so the cached coefficients for a quantized
+ * direction can stand in for the exact ones.
+ */
+#define PANNING_DIR_STEPS       (2048.0f)
+#define PANNING_SPREAD_STEPS    (1024.0f/F_TAU)
+
+#define PANNING_CACHE_SIZE      (256)
+#define PANNING_CACHE_PROBES    (8)
+
+#define INVALID_PANNING_KEY     (~(ALuint64)0)
+
+typedef struct PanningCacheEntry {
+    ALuint64 Key;
+    ALboolean HasGains;
+
+    ALfloat Coeffs[MAX_AMBI_COEFFS];
+    /* Dry output gains for a gain of 1. */
+    ALfloat Gains[MAX_OUTPUT_CHANNELS];
+} PanningCacheEntry;
+
+struct PanningCache {
+    ATOMIC(ALuint) Hits;
+    ATOMIC(ALuint) Misses;
+
+    PanningCacheEntry Entries[PANNING_CACHE_SIZE];
+};
+
+
+struct PanningCache *panningcache_alloc(void)
+{
+    struct PanningCache *cache;
+
+    cache = al_calloc(16, sizeof(*cache));
+    if(!cache) return NULL;
+
+    ATOMIC_INIT(&cache->Hits, 0);
+    ATOMIC_INIT(&cache->Misses, 0);
+    panningcache_clear(cache);
+
+    return cache;
+}
+
+void panningcache_free(struct PanningCache *cache)
+{
+    al_free(cache);
+}
+
+void panningcache_clear(struct PanningCache *cache)
+{
+    ALsizei i;
+    for(i = 0;i < PANNING_CACHE_SIZE;i++)
+    {
+        cache->Entries[i].Key = INVALID_PANNING_KEY;
+        cache->Entries[i].HasGains = AL_FALSE;
+    }
+}
+
+void panningcache_getStats(struct PanningCache *cache, ALuint *hits, ALuint *misses)
+{
+    *hits = ATOMIC_LOAD(&cache->Hits, almemory_order_relaxed);
+    *misses = ATOMIC_LOAD(&cache->Misses, almemory_order_relaxed);
+}
+
+
+static inline ALuint QuantizeDirAxis(ALfloat val)
+{
+    return fastf2u((clampf(val, -1.0f, 1.0f) + 1.0f)*PANNING_DIR_STEPS + 0.5f);
+}
+
+static inline ALfloat DequantizeDirAxis(ALuint64 val)
+{
+    return (ALfloat)(ALuint)(val&0x1fff)/PANNING_DIR_STEPS - 1.0f;
+}
+
+static ALuint64 GetPanningKey(const ALfloat dir[3], ALfloat spread)
+{
+    ALuint64 sp;
+
+    sp = fastf2u(clampf(spread, 0.0f, F_TAU)*PANNING_SPREAD_STEPS + 0.5f);
+    return (ALuint64)QuantizeDirAxis(dir[0]) | ((ALuint64)QuantizeDirAxis(dir[1])<<13) |
+           ((ALuint64)QuantizeDirAxis(dir[2])<<26) | (sp<<39);
+}
+
+static void CalcEntryCoeffs(PanningCacheEntry *entry)
+{
+    ALfloat dir[3], len;
+
+    dir[0] = DequantizeDirAxis(entry->Key);
+    dir[1] = DequantizeDirAxis(entry->Key>>13);
+    dir[2] = DequantizeDirAxis(entry->Key>>26);
+    len = sqrtf(dir[0]*dir[0] + dir[1]*dir[1] + dir[2]*dir[2]);
+    if(len > FLT_EPSILON)
+    {
+        dir[0] /= len;
+        dir[1] /= len;
+        dir[2] /= len;
+    }
+
+    CalcDirectionCoeffs(dir, (ALfloat)(ALuint)(entry->Key>>39) / PANNING_SPREAD_STEPS,
+                        entry->Coeffs);
+}
+
+void CalcCachedPanning(const ALCdevice *device, const ALfloat dir[3], ALfloat spread, ALfloat coeffs[MAX_AMBI_COEFFS], ALfloat ingain, ALfloat gains[MAX_OUTPUT_CHANNELS])
+{
+    struct PanningCache *cache = device->PanningCache;
+    PanningCacheEntry *entry = NULL;
+    ALuint64 key;
+    ALuint idx;
+    ALsizei i;
+
+    if(!cache)
+    {
+        CalcDirectionCoeffs(dir, spread, coeffs);
+        if(gains)
+            ComputePanningGains(device->Dry, coeffs, ingain, gains);
+        return;
+    }
+
+    /* Open addressing with a short linear probe. When every slot probed holds
+     * another key, the first one is simply recalculated for this key; nothing
+     * holds on to an entry past this call.
+     */
+    key = GetPanningKey(dir, spread);
+    idx = (ALuint)((key * U64(0x9e3779b97f4a7c15)) >> 56) % PANNING_CACHE_SIZE;
+    for(i = 0;i < PANNING_CACHE_PROBES;i++)
+    {
+        PanningCacheEntry *cur = &cache->Entries[(idx+i) % PANNING_CACHE_SIZE];
+        if(cur->Key == key)
+        {
+            entry = cur;
+            break;
+        }
+        if(cur->Key == INVALID_PANNING_KEY)
+            break;
+    }
+    if(entry)
+        ATOMIC_ADD(&cache->Hits, 1, almemory_order_relaxed);
+    else
+    {
+        entry = &cache->Entries[(idx+i) % PANNING_CACHE_SIZE];
+        if(i == PANNING_CACHE_PROBES)
+            entry = &cache->Entries[idx];
+        entry->Key = key;
+        entry->HasGains = AL_FALSE;
+        CalcEntryCoeffs(entry);
+        ATOMIC_ADD(&cache->Misses, 1, almemory_order_relaxed);
+    }
+
+    memcpy(coeffs, entry->Coeffs, sizeof(entry->Coeffs));
+    if(gains)
+    {
+        if(!entry->HasGains)
+        {
+            ComputePanningGains(device->Dry, entry->Coeffs, 1.0f, entry->Gains);
+            entry->HasGains = AL_TRUE;
+        }
+        /* The gains scale linearly with the input gain, and the unit gains
+         * are exact, so this matches panning the coefficients directly.
+         */
+        for(i = 0;i < MAX_OUTPUT_CHANNELS;i++)
+            gains[i] = entry->Gains[i] * ingain;
+    }
+}
+
+
 void ComputeAmbientGainsMC(const ChannelConfig *chancoeffs, ALuint numchans, ALfloat ingain, ALfloat gains[MAX_OUTPUT_CHANNELS])
 {
     ALuint i;
@@ -4,6 +4,10 @@
 #include "alu.h"
 #include "uhjfilter.h"
 
+#ifdef HAVE_SSE_INTRINSICS_HERE
+#include <xmmintrin.h>
+#endif
+
 /* This is the maximum number of samples processed for each inner loop
  * iteration. */
 #define MAX_UPDATE_SAMPLES  128
@@ -62,12 +66,119 @@ static void allpass_process(AllPassState *state, ALfloat *restrict dst, const AL
  * know which is the intended result.
  */
 
+#ifdef HAVE_SSE_INTRINSICS_HERE
+/* Runs the three filter chains side by side, one in each of the first three
+ * lanes: Filter1 on Y, Filter2 on the W and X mix for D, and Filter1 on the W
+ * and X mix for S. Each sample goes through all four sections of the chains
+ * before the next one, so the sections' state stays in registers. The steps
+ * are the same as allpass_process, so the results are too.
+ */
+static void EncodeUhj2_SSE(Uhj2Encoder *enc, ALfloat *restrict LeftOut, ALfloat *restrict RightOut, ALfloat (*restrict InSamples)[BUFFERSIZE], ALuint SamplesToDo)
+{
+    const __m128 wgain = _mm_setr_ps(0.0f, -0.3420201f, 0.9396926f, 0.0f);
+    const __m128 xgain = _mm_setr_ps(0.0f,  0.5098604f, 0.1855740f, 0.0f);
+    const __m128 ygain = _mm_setr_ps(0.6554516f, 0.0f, 0.0f, 0.0f);
+    alignas(16) ALfloat out[MAX_UPDATE_SAMPLES][4];
+    __m128 aa[4], x0[4], x1[4], y0[4], y1[4];
+    ALfloat lastY, lastWX;
+    ALuint base, i, k;
+
+    for(k = 0;k < 4;k++)
+    {
+        aa[k] = _mm_setr_ps(Filter1Coeff[k]*Filter1Coeff[k], Filter2Coeff[k]*Filter2Coeff[k],
+                            Filter1Coeff[k]*Filter1Coeff[k], 0.0f);
+        x0[k] = _mm_setr_ps(enc->Filter1_Y[k].x[0], enc->Filter2_WX[k].x[0],
+                            enc->Filter1_WX[k].x[0], 0.0f);
+        x1[k] = _mm_setr_ps(enc->Filter1_Y[k].x[1], enc->Filter2_WX[k].x[1],
+                            enc->Filter1_WX[k].x[1], 0.0f);
+        y0[k] = _mm_setr_ps(enc->Filter1_Y[k].y[0], enc->Filter2_WX[k].y[0],
+                            enc->Filter1_WX[k].y[0], 0.0f);
+        y1[k] = _mm_setr_ps(enc->Filter1_Y[k].y[1], enc->Filter2_WX[k].y[1],
+                            enc->Filter1_WX[k].y[1], 0.0f);
+    }
+    /* The Filter1 chains need a 1 sample delay for the final output. */
+    lastY = enc->Filter1_Y[3].y[0];
+    lastWX = enc->Filter1_WX[3].y[0];
+
+    for(base = 0;base < SamplesToDo;)
+    {
+        ALuint todo = minu(SamplesToDo - base, MAX_UPDATE_SAMPLES);
+
+        for(i = 0;i < todo;i++)
+        {
+            __m128 val = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(wgain, _mm_set1_ps(InSamples[0][base+i])),
+                           _mm_mul_ps(xgain, _mm_set1_ps(InSamples[1][base+i]))),
+                _mm_mul_ps(ygain, _mm_set1_ps(InSamples[2][base+i]))
+            );
+            for(k = 0;k < 4;k++)
+            {
+                const __m128 res = _mm_sub_ps(
+                    _mm_mul_ps(aa[k], _mm_add_ps(val, y1[k])), x1[k]
+                );
+                x1[k] = x0[k];
+                x0[k] = val;
+                y1[k] = y0[k];
+                y0[k] = res;
+                val = res;
+            }
+            _mm_store_ps(out[i], val);
+        }
+
+        for(i = 0;i < todo;i++)
+        {
+            const ALfloat D = lastY + out[i][1];
+            const ALfloat S = lastWX;
+            lastY = out[i][0];
+            lastWX = out[i][2];
+
+            /* Left = (S + D)/2.0 */
+            *(LeftOut++) += (S + D) * 0.5f;
+            /* Right = (S - D)/2.0 */
+            *(RightOut++) += (S - D) * 0.5f;
+        }
+
+        base += todo;
+    }
+
+    for(k = 0;k < 4;k++)
+    {
+        alignas(16) ALfloat lanes[4][4];
+
+        _mm_store_ps(lanes[0], x0[k]);
+        _mm_store_ps(lanes[1], x1[k]);
+        _mm_store_ps(lanes[2], y0[k]);
+        _mm_store_ps(lanes[3], y1[k]);
+        enc->Filter1_Y[k].x[0] = lanes[0][0];
+        enc->Filter1_Y[k].x[1] = lanes[1][0];
+        enc->Filter1_Y[k].y[0] = lanes[2][0];
+        enc->Filter1_Y[k].y[1] = lanes[3][0];
+        enc->Filter2_WX[k].x[0] = lanes[0][1];
+        enc->Filter2_WX[k].x[1] = lanes[1][1];
+        enc->Filter2_WX[k].y[0] = lanes[2][1];
+        enc->Filter2_WX[k].y[1] = lanes[3][1];
+        enc->Filter1_WX[k].x[0] = lanes[0][2];
+        enc->Filter1_WX[k].x[1] = lanes[1][2];
+        enc->Filter1_WX[k].y[0] = lanes[2][2];
+        enc->Filter1_WX[k].y[1] = lanes[3][2];
+    }
+}
+#endif
+
 void EncodeUhj2(Uhj2Encoder *enc, ALfloat *restrict LeftOut, ALfloat *restrict RightOut, ALfloat (*restrict InSamples)[BUFFERSIZE], ALuint SamplesToDo)
 {
     ALfloat D[MAX_UPDATE_SAMPLES], S[MAX_UPDATE_SAMPLES];
     ALfloat temp[2][MAX_UPDATE_SAMPLES];
     ALuint base, i;
 
+#ifdef HAVE_SSE_INTRINSICS_HERE
+    if((CPUCapFlags&CPU_CAP_SSE))
+    {
+        EncodeUhj2_SSE(enc, LeftOut, RightOut, InSamples, SamplesToDo);
+        return;
+    }
+#endif
+
     for(base = 0;base < SamplesToDo;)
     {
         ALuint todo = minu(SamplesToDo - base, MAX_UPDATE_SAMPLES);
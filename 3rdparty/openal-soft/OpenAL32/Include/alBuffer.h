@@ -71,9 +71,19 @@ inline ALuint FrameSizeFromFmt(enum FmtChannels chans, enum FmtType type)
 }
 
 
+/* Number of sample frames summarized by each entry of a buffer's envelope. */
+#define BUFFER_ENVELOPE_BLOCK 64
+
 typedef struct ALbuffer {
     ALvoid  *data;
 
+    /* Peak absolute sample value over every BUFFER_ENVELOPE_BLOCK frames,
+     * across channels, followed by the peak from each block to the end of
+     * the buffer. Lets the mixer tell when a stretch of it is inaudible.
+     */
+    ALfloat *Envelope;
+    ALsizei  EnvelopeBlocks;
+
     ALsizei  Frequency;
     ALenum   Format;
     ALsizei  SampleLen;
@@ -0,0 +1,87 @@
+#ifndef _AL_EMITTER_H_
+#define _AL_EMITTER_H_
+
+#include "alMain.h"
+#include "alSource.h"
+#include "alu.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Mixing parameters calculated for a mono voice playing from an emitter. Only
+ * the filter coefficients are kept, the filter history belongs to the voice.
+ */
+typedef struct ALemitterParams {
+    ALint Step;
+    BsincState SincState;
+
+    ALboolean IsHrtf;
+    ALuint HrtfKey;
+
+    struct {
+        ALfloat (*Buffer)[BUFFERSIZE];
+        ALuint Channels;
+    } DirectOut;
+    struct {
+        ALfloat (*Buffer)[BUFFERSIZE];
+        ALuint Channels;
+    } SendOut[MAX_SENDS];
+
+    struct {
+        enum ActiveFilters FilterType;
+        ALfilterState LowPass;
+        ALfilterState HighPass;
+        HrtfParams Hrtf;
+        ALfloat Gains[MAX_OUTPUT_CHANNELS];
+    } Direct;
+    struct {
+        enum ActiveFilters FilterType;
+        ALfilterState LowPass;
+        ALfilterState HighPass;
+        ALfloat Gains[MAX_OUTPUT_CHANNELS];
+    } Send[MAX_SENDS];
+} ALemitterParams;
+
+typedef struct ALemitter {
+    /* Fixed position a source takes when bound to the emitter. */
+    ALfloat Position[3];
+
+    RefCount ref;
+
+    /* The parameters calculated for the last voice started on the emitter,
+     * and what they were calculated from. They're only accessed by the mixer,
+     * and are valid as long as the context's EmitterParamsGen doesn't change
+     * (i.e. the listener, effect slots, and device stay the same).
+     */
+    ALboolean ParamsValid;
+    ALuint ParamsGen;
+    ALsizei ParamsFrequency;
+    struct ALsourceProps ParamsProps;
+    ALemitterParams Params;
+
+    /* Self ID */
+    ALuint id;
+} ALemitter;
+
+inline void LockEmittersRead(ALCcontext *context)
+{ LockUIntMapRead(&context->EmitterMap); }
+inline void UnlockEmittersRead(ALCcontext *context)
+{ UnlockUIntMapRead(&context->EmitterMap); }
+inline void LockEmittersWrite(ALCcontext *context)
+{ LockUIntMapWrite(&context->EmitterMap); }
+inline void UnlockEmittersWrite(ALCcontext *context)
+{ UnlockUIntMapWrite(&context->EmitterMap); }
+
+inline struct ALemitter *LookupEmitter(ALCcontext *context, ALuint id)
+{ return (struct ALemitter*)LookupUIntMapKeyNoLock(&context->EmitterMap, id); }
+inline struct ALemitter *RemoveEmitter(ALCcontext *context, ALuint id)
+{ return (struct ALemitter*)RemoveUIntMapKeyNoLock(&context->EmitterMap, id); }
+
+ALvoid ReleaseALEmitters(ALCcontext *Context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -16,6 +16,10 @@
 #include <fenv.h>
 #endif
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 #include "AL/al.h"
 #include "AL/alc.h"
 #include "AL/alext.h"
@@ -34,6 +38,7 @@
 #include "align.h"
 #include "atomic.h"
 #include "uintmap.h"
+#include "handletable.h"
 #include "vector.h"
 #include "alstring.h"
 #include "almalloc.h"
@@ -41,19 +46,6 @@
 
 #include "hrtf.h"
 
-#ifndef ALC_SOFT_device_clock
-#define ALC_SOFT_device_clock 1
-typedef int64_t ALCint64SOFT;
-typedef uint64_t ALCuint64SOFT;
-#define ALC_DEVICE_CLOCK_SOFT                    0x1600
-#define ALC_DEVICE_LATENCY_SOFT                  0x1601
-#define ALC_DEVICE_CLOCK_LATENCY_SOFT            0x1602
-typedef void (ALC_APIENTRY*LPALCGETINTEGER64VSOFT)(ALCdevice *device, ALCenum pname, ALsizei size, ALCint64SOFT *values);
-#ifdef AL_ALEXT_PROTOTYPES
-ALC_API void ALC_APIENTRY alcGetInteger64vSOFT(ALCdevice *device, ALCenum pname, ALsizei size, ALCint64SOFT *values);
-#endif
-#endif
-
 #ifndef AL_SOFT_buffer_samples2
 #define AL_SOFT_buffer_samples2 1
 /* Channel configurations */
@@ -380,6 +372,45 @@ inline ALint fastf2i(ALfloat f)
 inline ALuint fastf2u(ALfloat f)
 { return fastf2i(f); }
 
+/* Number of trailing zero bits. The value must not be 0. */
+inline int CountTrailingZeros64(ALuint64 value)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(value);
+#elif defined(_MSC_VER) && defined(_WIN64)
+    unsigned long idx;
+    _BitScanForward64(&idx, value);
+    return (int)idx;
+#elif defined(_MSC_VER)
+    unsigned long idx;
+    if(_BitScanForward(&idx, (unsigned long)value))
+        return (int)idx;
+    _BitScanForward(&idx, (unsigned long)(value>>32));
+    return (int)idx + 32;
+#else
+    int count = 0;
+    while(!(value&1))
+    {
+        value >>= 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+/* Number of set bits. */
+inline int CountSetBits64(ALuint64 value)
+{
+#if defined(__GNUC__)
+    return __builtin_popcountll(value);
+#else
+    value = value - ((value>>1) & U64(0x5555555555555555));
+    value = (value&U64(0x3333333333333333)) + ((value>>2)&U64(0x3333333333333333));
+    value = (value + (value>>4)) & U64(0x0f0f0f0f0f0f0f0f);
+    return (int)((value * U64(0x0101010101010101)) >> 56);
+#endif
+}
+
 
 enum DevProbe {
     ALL_DEVICE_PROBE,
@@ -595,6 +626,9 @@ typedef struct HrtfParams {
  */
 #define BUFFERSIZE (2048u)
 
+/* Number of mixer updates whose timestamps are kept. Must be a power of 2. */
+#define MAX_MIX_STAMPS  256
+
 struct ALCdevice_struct
 {
     RefCount ref;
@@ -661,6 +695,15 @@ struct ALCdevice_struct
     /* First-order ambisonic upsampler for higher-order output */
     struct AmbiUpsampler *AmbiUp;
 
+    /* Worker threads mixing sources alongside the mixer thread */
+    struct MixPool *MixPool;
+
+    /* Shared convolution for HRTF sources that play from a fixed direction */
+    struct HrtfBatch *HrtfBatch;
+
+    /* Ambisonic coefficients and dry gains for recently panned directions */
+    struct PanningCache *PanningCache;
+
     /* Rendering mode. */
     enum RenderMode Render_Mode;
 
@@ -670,6 +713,34 @@ struct ALCdevice_struct
     ALuint64 ClockBase;
     ALuint SamplesDone;
 
+    /* Number of times the backend ran out of mixed samples to play. Counted
+     * by the backends that can tell, and never reset while the device is
+     * open.
+     */
+    ATOMIC(ALuint) Underruns;
+
+    /* Level below which a static source's output is considered inaudible and
+     * its mixing skipped, or 0 to mix everything. Along with the number of
+     * source updates the mixer made and how many of them were culled.
+     */
+    ALfloat CullLevel;
+    ATOMIC(ALuint64) VoiceUpdates;
+    ATOMIC(ALuint64) CulledVoiceUpdates;
+
+    /* Scheduling class and priority the mixing thread ended up with, as
+     * althrd_getsched reports them. The class is -1 until the first update
+     * after the device (re)starts, and -2 if it couldn't be read.
+     */
+    ATOMIC(ALint) MixerSched;
+    ATOMIC(ALint) MixerPriority;
+
+    /* ReadTimestamp readings taken at the start and end of each aluMixData
+     * call, for ALC_SOFTX_mix_stamps. Update n is kept in entry
+     * n&(MAX_MIX_STAMPS-1) until MixStampCount goes past n+MAX_MIX_STAMPS.
+     */
+    ALuint64 MixStamps[MAX_MIX_STAMPS][2];
+    ATOMIC(ALuint64) MixStampCount;
+
     /* Temp storage used for each source when mixing. */
     alignas(16) ALfloat SourceData[BUFFERSIZE];
     alignas(16) ALfloat ResampledData[BUFFERSIZE];
@@ -764,6 +835,17 @@ struct ALCcontext_struct {
 
     UIntMap SourceMap;
     UIntMap EffectSlotMap;
+    UIntMap EmitterMap;
+
+    /* With source-handles enabled, sources are kept in a generational handle
+     * table instead of the source map, and looked up without locking. Calls
+     * on sources are then only counted, and deleted sources are retired until
+     * no call is in progress.
+     */
+    ALboolean SourceHandles;
+    HandleTable SourceTable;
+    RefCount SourceReaders;
+    struct ALsource *RetiredSources;
 
     ATOMIC(ALenum) LastError;
 
@@ -786,9 +868,22 @@ struct ALCcontext_struct {
     ALfloat GainBoost;
 
     struct ALvoice *Voices;
+    /* One bit per voice that has a source, for the mixer to go straight to. */
+    ALuint64 *VoiceMask;
     ALsizei VoiceCount;
     ALsizei MaxVoices;
 
+    /* Voice slots the mixer visited and skipped over, summed over every
+     * update.
+     */
+    ATOMIC(ALuint64) VoicesVisited;
+    ATOMIC(ALuint64) VoicesSkipped;
+
+    /* Incremented by the mixer whenever the listener, effect slots, or device
+     * change, invalidating the parameters cached by emitters.
+     */
+    ALuint EmitterParamsGen;
+
     ATOMIC(struct ALeffectslot*) ActiveAuxSlotList;
 
     ALCdevice  *Device;
@@ -848,6 +943,8 @@ typedef struct ll_ringbuffer_data {
 } ll_ringbuffer_data_t;
 ll_ringbuffer_t *ll_ringbuffer_create(size_t sz, size_t elem_sz);
 void ll_ringbuffer_free(ll_ringbuffer_t *rb);
+size_t ll_ringbuffer_bytes(size_t sz, size_t elem_sz);
+ll_ringbuffer_t *ll_ringbuffer_init(void *mem, size_t sz, size_t elem_sz);
 void ll_ringbuffer_get_read_vector(const ll_ringbuffer_t *rb, ll_ringbuffer_data_t *vec);
 void ll_ringbuffer_get_write_vector(const ll_ringbuffer_t *rb, ll_ringbuffer_data_t *vec);
 size_t ll_ringbuffer_read(ll_ringbuffer_t *rb, char *dest, size_t cnt);
@@ -872,6 +969,9 @@ int ConfigValueFloat(const char *devName, const char *blockName, const char *key
 int ConfigValueBool(const char *devName, const char *blockName, const char *keyName, int *ret);
 
 void SetRTPriority(void);
+void SetRTAffinity(void);
+
+ALuint64 ReadTimestamp(void);
 
 void SetDefaultChannelOrder(ALCdevice *device);
 void SetDefaultWFXChannelOrder(ALCdevice *device);
@@ -937,6 +1037,8 @@ extern enum LogLevel LogLevel;
 
 
 extern ALint RTPrioLevel;
+extern ALint RTSchedClass;
+extern ALuint64 RTCpuMask;
 
 
 extern ALuint CPUCapFlags;
@@ -946,6 +1048,7 @@ enum {
     CPU_CAP_SSE3   = 1<<2,
     CPU_CAP_SSE4_1 = 1<<3,
     CPU_CAP_NEON   = 1<<4,
+    CPU_CAP_AVX2   = 1<<5,
 };
 
 void FillCPUCaps(ALuint capfilter);
@@ -14,6 +14,7 @@ extern "C" {
 struct ALbuffer;
 struct ALsource;
 struct ALsourceProps;
+struct ALemitter;
 
 
 typedef struct ALbufferlistitem {
@@ -54,6 +55,9 @@ struct ALsourceProps {
 
     ATOMIC(ALfloat) Radius;
 
+    /** Static emitter the source is bound to, if any. */
+    ATOMIC(struct ALemitter*) Emitter;
+
     /** Direct filter and auxiliary send info. */
     struct {
         ATOMIC(ALfloat) Gain;
@@ -88,6 +92,12 @@ typedef struct ALvoice {
 
     ALboolean IsHrtf;
 
+    /* Static HRTF batch group the dry signal is mixed into, or -1 when the
+     * voice is convolved on its own, and the direction key it was given for.
+     */
+    ALint HrtfGroup;
+    ALuint HrtfKey;
+
     ALuint Offset; /* Number of output samples mixed since starting. */
 
     alignas(16) ALfloat PrevSamples[MAX_INPUT_CHANNELS][MAX_PRE_SAMPLES];
@@ -110,6 +120,48 @@ typedef struct ALvoice {
     } Chan[MAX_INPUT_CHANNELS];
 } ALvoice;
 
+/* Gives the voice to the source, or takes it back, keeping the context's
+ * mask of voices in use up to date. The context must be locked.
+ */
+inline void SetVoiceSource(ALCcontext *context, ALvoice *voice, struct ALsource *source)
+{
+    ALsizei idx = (ALsizei)(voice - context->Voices);
+    voice->Source = source;
+    if(source)
+        context->VoiceMask[idx>>6] |= U64(1)<<(idx&63);
+    else
+        context->VoiceMask[idx>>6] &= ~(U64(1)<<(idx&63));
+}
+
+/* Returns the index of the first voice in use from idx on, or end if there
+ * are none before it.
+ */
+inline ALsizei NextActiveVoice(const ALuint64 *mask, ALsizei idx, ALsizei end)
+{
+    while(idx < end)
+    {
+        ALuint64 bits = mask[idx>>6] >> (idx&63);
+        if(bits)
+            return mini(idx + CountTrailingZeros64(bits), end);
+        idx = (idx|63) + 1;
+    }
+    return end;
+}
+
+#define VOICE_MASK_WORDS(n) (((n)+63) / 64)
+
+/* Scratch and output buffers for MixSource to use in place of the device's
+ * and the voice's own. Lets multiple voices be mixed concurrently.
+ */
+typedef struct MixBuffers {
+    ALfloat *SourceData;
+    ALfloat *ResampledData;
+    ALfloat *FilteredData;
+
+    ALfloat (*DirectOut)[BUFFERSIZE];
+    ALfloat (*SendOut[MAX_SENDS])[BUFFERSIZE];
+} MixBuffers;
+
 
 typedef struct ALsource {
     /** Source properties. */
@@ -147,6 +199,9 @@ typedef struct ALsource {
 
     ALfloat Radius;
 
+    /** Static emitter the source is bound to, if any. */
+    struct ALemitter *Emitter;
+
     /** Direct filter and auxiliary send info. */
     struct {
         ALfloat Gain;
@@ -204,21 +259,74 @@ typedef struct ALsource {
 
     /** Self ID */
     ALuint id;
+
+    /* Next source waiting to be freed, once deleted. */
+    struct ALsource *NextRetired;
 } ALsource;
 
 inline void LockSourcesRead(ALCcontext *context)
-{ LockUIntMapRead(&context->SourceMap); }
+{
+    if(context->SourceHandles)
+        IncrementRef(&context->SourceReaders);
+    else
+        LockUIntMapRead(&context->SourceMap);
+}
 inline void UnlockSourcesRead(ALCcontext *context)
-{ UnlockUIntMapRead(&context->SourceMap); }
+{
+    if(context->SourceHandles)
+        DecrementRef(&context->SourceReaders);
+    else
+        UnlockUIntMapRead(&context->SourceMap);
+}
 inline void LockSourcesWrite(ALCcontext *context)
-{ LockUIntMapWrite(&context->SourceMap); }
+{
+    if(context->SourceHandles)
+        LockHandleTableWrite(&context->SourceTable);
+    else
+        LockUIntMapWrite(&context->SourceMap);
+}
 inline void UnlockSourcesWrite(ALCcontext *context)
-{ UnlockUIntMapWrite(&context->SourceMap); }
+{
+    if(context->SourceHandles)
+        UnlockHandleTableWrite(&context->SourceTable);
+    else
+        UnlockUIntMapWrite(&context->SourceMap);
+}
 
 inline struct ALsource *LookupSource(ALCcontext *context, ALuint id)
-{ return (struct ALsource*)LookupUIntMapKeyNoLock(&context->SourceMap, id); }
+{
+    if(context->SourceHandles)
+        return (struct ALsource*)LookupHandleTableKey(&context->SourceTable, id);
+    return (struct ALsource*)LookupUIntMapKeyNoLock(&context->SourceMap, id);
+}
 inline struct ALsource *RemoveSource(ALCcontext *context, ALuint id)
-{ return (struct ALsource*)RemoveUIntMapKeyNoLock(&context->SourceMap, id); }
+{
+    if(context->SourceHandles)
+        return (struct ALsource*)RemoveHandleTableKeyNoLock(&context->SourceTable, id);
+    return (struct ALsource*)RemoveUIntMapKeyNoLock(&context->SourceMap, id);
+}
+
+/* For iterating over the context's sources, with the sources locked for
+ * reading. Slots may be empty (NULL) when using the handle table.
+ */
+inline ALsizei GetSourceSlotCount(ALCcontext *context)
+{
+    if(context->SourceHandles)
+        return GetHandleTableCapacity(&context->SourceTable);
+    return context->SourceMap.size;
+}
+inline struct ALsource *GetSourceSlot(ALCcontext *context, ALsizei pos)
+{
+    if(context->SourceHandles)
+        return (struct ALsource*)GetHandleTableSlotValue(&context->SourceTable, pos);
+    return (struct ALsource*)context->SourceMap.values[pos];
+}
+inline ALsizei GetSourceCount(ALCcontext *context)
+{
+    if(context->SourceHandles)
+        return context->SourceTable.size;
+    return context->SourceMap.size;
+}
 
 void UpdateAllSourceProps(ALCcontext *context);
 ALvoid SetSourceState(ALsource *Source, ALCcontext *Context, ALenum state);
@@ -226,6 +334,10 @@ ALboolean ApplyOffset(ALsource *Source);
 
 ALvoid ReleaseALSources(ALCcontext *Context);
 
+void InitSourceSlabs(void);
+void DeinitSourceSlabs(void);
+void GetSourceSlabStats(size_t *allocs, size_t *blocks);
+
 #ifdef __cplusplus
 }
 #endif
@@ -28,6 +28,15 @@
 /* Maximum number of buffer samples after the current pos needed for resampling. */
 #define MAX_POST_SAMPLES 12
 
+/* Defined when SSE intrinsics can be used by code built without any extra
+ * switches, i.e. when the compiler targets SSE anyway (as it always does for
+ * x86-64). The mixer_sse*.c files get their own switch and don't need this.
+ */
+#if defined(HAVE_SSE) && (defined(__SSE__) || defined(_M_X64) || \
+                          (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+#define HAVE_SSE_INTRINSICS_HERE
+#endif
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -36,6 +45,7 @@ extern "C" {
 struct ALsource;
 struct ALsourceProps;
 struct ALvoice;
+struct MixBuffers;
 struct ALeffectslot;
 struct ALbuffer;
 
@@ -301,6 +311,24 @@ inline void CalcXYZCoeffs(ALfloat x, ALfloat y, ALfloat z, ALfloat spread, ALflo
  */
 void CalcAngleCoeffs(ALfloat azimuth, ALfloat elevation, ALfloat spread, ALfloat coeffs[MAX_AMBI_COEFFS]);
 
+/**
+ * CalcCachedPanning
+ *
+ * Calculates the ambisonic coefficients for a direction like
+ * CalcDirectionCoeffs, and the dry panning gains for it like
+ * ComputePanningGains if gains is not NULL. Results are kept in the device's
+ * panning cache, keyed by the direction and spread quantized, so sources that
+ * repeatedly play from the same place skip the calculations.
+ */
+void CalcCachedPanning(const ALCdevice *device, const ALfloat dir[3], ALfloat spread, ALfloat coeffs[MAX_AMBI_COEFFS], ALfloat ingain, ALfloat gains[MAX_OUTPUT_CHANNELS]);
+
+struct PanningCache *panningcache_alloc(void);
+void panningcache_free(struct PanningCache *cache);
+/* Forgets every entry, for when the device's output configuration changes. */
+void panningcache_clear(struct PanningCache *cache);
+/* Lookups that were and weren't in the cache, since it was allocated. */
+void panningcache_getStats(struct PanningCache *cache, ALuint *hits, ALuint *misses);
+
 /**
  * ComputeAmbientGains
  *
@@ -347,7 +375,10 @@ void ComputeFirstOrderGainsMC(const ChannelConfig *chancoeffs, ALuint numchans,
 void ComputeFirstOrderGainsBF(const BFChannelConfig *chanmap, ALuint numchans, const ALfloat mtx[4], ALfloat ingain, ALfloat gains[MAX_OUTPUT_CHANNELS]);
 
 
-ALvoid MixSource(struct ALvoice *voice, struct ALsource *source, ALCdevice *Device, ALuint SamplesToDo);
+/* Buffers may be NULL, to mix with the device's scratch buffers into the
+ * voice's outputs. Returns AL_TRUE if the update was culled instead of mixed.
+ */
+ALboolean MixSource(struct ALvoice *voice, struct ALsource *source, ALCdevice *Device, const struct MixBuffers *Buffers, ALuint SamplesToDo);
 
 ALvoid aluMixData(ALCdevice *device, ALvoid *buffer, ALsizei size);
 /* Caller must lock the device. */
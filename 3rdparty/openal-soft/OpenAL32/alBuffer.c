@@ -50,6 +50,7 @@ static ALboolean IsValidChannels(ALenum channels);
 static ALboolean DecomposeUserFormat(ALenum format, enum UserFmtChannels *chans, enum UserFmtType *type);
 static ALboolean DecomposeFormat(ALenum format, enum FmtChannels *chans, enum FmtType *type);
 static ALboolean SanitizeAlignment(enum UserFmtType type, ALsizei *align);
+static void UpdateEnvelope(ALbuffer *ALBuf);
 
 
 AL_API ALvoid AL_APIENTRY alGenBuffers(ALsizei n, ALuint *buffers)
@@ -360,6 +361,7 @@ AL_API ALvoid AL_APIENTRY alBufferSubDataSOFT(ALuint buffer, ALenum format, cons
 
     ConvertData((char*)albuf->data+offset, (enum UserFmtType)albuf->FmtType,
                 data, srctype, channels, length, align);
+    UpdateEnvelope(albuf);
     WriteUnlock(&albuf->lock);
 
 done:
@@ -454,6 +456,7 @@ AL_API void AL_APIENTRY alBufferSubSamplesSOFT(ALuint buffer,
     offset *= FrameSizeFromFmt(albuf->FmtChannels, albuf->FmtType);
     ConvertData((char*)albuf->data+offset, (enum UserFmtType)albuf->FmtType,
                 data, type, ChannelsFromFmt(albuf->FmtChannels), samples, align);
+    UpdateEnvelope(albuf);
     WriteUnlock(&albuf->lock);
 
 done:
@@ -1069,10 +1072,79 @@ ALenum LoadData(ALbuffer *ALBuf, ALuint freq, ALenum NewFormat, ALsizei frames,
     ALBuf->LoopStart = 0;
     ALBuf->LoopEnd = ALBuf->SampleLen;
 
+    /* The envelope is only an aid to the mixer; without it, the buffer is
+     * simply always mixed.
+     */
+    if(ALBuf->EnvelopeBlocks != (frames+BUFFER_ENVELOPE_BLOCK-1) / BUFFER_ENVELOPE_BLOCK)
+    {
+        al_free(ALBuf->Envelope);
+        ALBuf->EnvelopeBlocks = (frames+BUFFER_ENVELOPE_BLOCK-1) / BUFFER_ENVELOPE_BLOCK;
+        ALBuf->Envelope = al_calloc(16, ALBuf->EnvelopeBlocks*2 * sizeof(ALfloat));
+        if(!ALBuf->Envelope)
+            ALBuf->EnvelopeBlocks = 0;
+    }
+    UpdateEnvelope(ALBuf);
+
     WriteUnlock(&ALBuf->lock);
     return AL_NO_ERROR;
 }
 
+#define DECL_TEMPLATE(T, scale)                                               \
+static ALfloat GetPeak_##T(const T *data, ALsizei count)                      \
+{                                                                             \
+    ALfloat peak = 0.0f;                                                      \
+    ALsizei i;                                                                \
+    for(i = 0;i < count;i++)                                                  \
+        peak = maxf(peak, fabsf((ALfloat)data[i]));                           \
+    return peak * (scale);                                                    \
+}
+
+DECL_TEMPLATE(ALbyte, 1.0f/128.0f)
+DECL_TEMPLATE(ALshort, 1.0f/32768.0f)
+DECL_TEMPLATE(ALfloat, 1.0f)
+
+#undef DECL_TEMPLATE
+
+/* Recalculates the envelope from the stored samples. */
+static void UpdateEnvelope(ALbuffer *ALBuf)
+{
+    ALsizei channels = ChannelsFromFmt(ALBuf->FmtChannels);
+    ALsizei blocks = ALBuf->EnvelopeBlocks;
+    ALfloat peak;
+    ALsizei i;
+
+    for(i = 0;i < blocks;i++)
+    {
+        ALsizei start = i * BUFFER_ENVELOPE_BLOCK;
+        ALsizei count = mini(BUFFER_ENVELOPE_BLOCK, ALBuf->SampleLen-start) * channels;
+
+        start *= channels;
+        switch(ALBuf->FmtType)
+        {
+            case FmtByte:
+                peak = GetPeak_ALbyte((const ALbyte*)ALBuf->data + start, count);
+                break;
+            case FmtShort:
+                peak = GetPeak_ALshort((const ALshort*)ALBuf->data + start, count);
+                break;
+            case FmtFloat:
+                peak = GetPeak_ALfloat((const ALfloat*)ALBuf->data + start, count);
+                break;
+            default:
+                peak = 1.0f;
+                break;
+        }
+        ALBuf->Envelope[i] = peak;
+    }
+
+    peak = 0.0f;
+    for(i = blocks-1;i >= 0;i--)
+    {
+        peak = maxf(peak, ALBuf->Envelope[i]);
+        ALBuf->Envelope[blocks + i] = peak;
+    }
+}
+
 
 ALuint BytesFromUserFmt(enum UserFmtType type)
 {
@@ -1387,6 +1459,7 @@ void DeleteBuffer(ALCdevice *device, ALbuffer *buffer)
     FreeThunkEntry(buffer->id);
 
     al_free(buffer->data);
+    al_free(buffer->Envelope);
 
     memset(buffer, 0, sizeof(*buffer));
     al_free(buffer);
@@ -1407,6 +1480,7 @@ ALvoid ReleaseALBuffers(ALCdevice *device)
         device->BufferMap.values[i] = NULL;
 
         al_free(temp->data);
+        al_free(temp->Envelope);
 
         FreeThunkEntry(temp->id);
         memset(temp, 0, sizeof(ALbuffer));
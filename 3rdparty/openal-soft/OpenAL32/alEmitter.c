@@ -0,0 +1,180 @@
+/**
+ * OpenAL cross platform audio library
+ * Copyright (C) 1999-2007 by authors.
+ * This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ *  License along with this library; if not, write to the
+ *  Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ * Or go to http://www.gnu.org/copyleft/lgpl.html
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "AL/al.h"
+#include "AL/alc.h"
+#include "alMain.h"
+#include "alEmitter.h"
+#include "alSource.h"
+#include "alThunk.h"
+#include "alError.h"
+
+#include "almalloc.h"
+
+
+extern inline void LockEmittersRead(ALCcontext *context);
+extern inline void UnlockEmittersRead(ALCcontext *context);
+extern inline void LockEmittersWrite(ALCcontext *context);
+extern inline void UnlockEmittersWrite(ALCcontext *context);
+extern inline struct ALemitter *LookupEmitter(ALCcontext *context, ALuint id);
+extern inline struct ALemitter *RemoveEmitter(ALCcontext *context, ALuint id);
+
+
+AL_API ALvoid AL_APIENTRY alGenEmittersSOFTX(ALsizei n, const ALfloat *positions, ALuint *emitters)
+{
+    ALCcontext *context;
+    ALsizei cur = 0;
+    ALenum err;
+
+    context = GetContextRef();
+    if(!context) return;
+
+    if(!(n >= 0))
+        SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
+    if(n > 0 && !(positions && emitters))
+        SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
+    for(cur = 0;cur < n;cur++)
+    {
+        if(!(isfinite(positions[cur*3+0]) && isfinite(positions[cur*3+1]) &&
+             isfinite(positions[cur*3+2])))
+            SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
+    }
+
+    for(cur = 0;cur < n;cur++)
+    {
+        ALemitter *emitter = al_calloc(16, sizeof(ALemitter));
+        if(!emitter)
+        {
+            alDeleteEmittersSOFTX(cur, emitters);
+            SET_ERROR_AND_GOTO(context, AL_OUT_OF_MEMORY, done);
+        }
+        emitter->Position[0] = positions[cur*3+0];
+        emitter->Position[1] = positions[cur*3+1];
+        emitter->Position[2] = positions[cur*3+2];
+        InitRef(&emitter->ref, 0);
+        emitter->ParamsValid = AL_FALSE;
+
+        err = NewThunkEntry(&emitter->id);
+        if(err == AL_NO_ERROR)
+            err = InsertUIntMapEntry(&context->EmitterMap, emitter->id, emitter);
+        if(err != AL_NO_ERROR)
+        {
+            FreeThunkEntry(emitter->id);
+            memset(emitter, 0, sizeof(ALemitter));
+            al_free(emitter);
+
+            alDeleteEmittersSOFTX(cur, emitters);
+            SET_ERROR_AND_GOTO(context, err, done);
+        }
+
+        emitters[cur] = emitter->id;
+    }
+
+done:
+    ALCcontext_DecRef(context);
+}
+
+AL_API ALvoid AL_APIENTRY alDeleteEmittersSOFTX(ALsizei n, const ALuint *emitters)
+{
+    ALCcontext *context;
+    ALemitter *emitter;
+    ALsizei i;
+
+    context = GetContextRef();
+    if(!context) return;
+
+    LockEmittersWrite(context);
+    if(!(n >= 0))
+        SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
+    for(i = 0;i < n;i++)
+    {
+        if(emitters[i] && (emitter=LookupEmitter(context, emitters[i])) == NULL)
+            SET_ERROR_AND_GOTO(context, AL_INVALID_NAME, done);
+        if(emitters[i] && ReadRef(&emitter->ref) != 0)
+            SET_ERROR_AND_GOTO(context, AL_INVALID_OPERATION, done);
+    }
+
+    // All emitters are valid
+    for(i = 0;i < n;i++)
+    {
+        ALvoice *voice, *voice_end;
+
+        if((emitter=RemoveEmitter(context, emitters[i])) == NULL)
+            continue;
+        FreeThunkEntry(emitter->id);
+
+        /* No source is bound to the emitter anymore, but a voice may not have
+         * picked up the unbinding yet.
+         */
+        LockContext(context);
+        voice = context->Voices;
+        voice_end = voice + context->VoiceCount;
+        for(;voice != voice_end;++voice)
+        {
+            if(ATOMIC_LOAD(&voice->Props.Emitter, almemory_order_relaxed) == emitter)
+                ATOMIC_STORE(&voice->Props.Emitter, NULL, almemory_order_relaxed);
+        }
+        UnlockContext(context);
+
+        memset(emitter, 0, sizeof(*emitter));
+        al_free(emitter);
+    }
+
+done:
+    UnlockEmittersWrite(context);
+    ALCcontext_DecRef(context);
+}
+
+AL_API ALboolean AL_APIENTRY alIsEmitterSOFTX(ALuint emitter)
+{
+    ALCcontext *context;
+    ALboolean  ret;
+
+    context = GetContextRef();
+    if(!context) return AL_FALSE;
+
+    LockEmittersRead(context);
+    ret = (LookupEmitter(context, emitter) ? AL_TRUE : AL_FALSE);
+    UnlockEmittersRead(context);
+
+    ALCcontext_DecRef(context);
+
+    return ret;
+}
+
+
+ALvoid ReleaseALEmitters(ALCcontext *Context)
+{
+    ALsizei pos;
+    for(pos = 0;pos < Context->EmitterMap.size;pos++)
+    {
+        ALemitter *temp = Context->EmitterMap.values[pos];
+        Context->EmitterMap.values[pos] = NULL;
+
+        FreeThunkEntry(temp->id);
+        memset(temp, 0, sizeof(ALemitter));
+        al_free(temp);
+    }
+}
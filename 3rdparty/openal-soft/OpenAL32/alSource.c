@@ -33,6 +33,7 @@
 #include "alBuffer.h"
 #include "alThunk.h"
 #include "alAuxEffectSlot.h"
+#include "alEmitter.h"
 
 #include "backends/base.h"
 
@@ -46,10 +47,24 @@ extern inline void LockSourcesWrite(ALCcontext *context);
 extern inline void UnlockSourcesWrite(ALCcontext *context);
 extern inline struct ALsource *LookupSource(ALCcontext *context, ALuint id);
 extern inline struct ALsource *RemoveSource(ALCcontext *context, ALuint id);
+extern inline ALsizei GetSourceSlotCount(ALCcontext *context);
+extern inline struct ALsource *GetSourceSlot(ALCcontext *context, ALsizei pos);
+extern inline ALsizei GetSourceCount(ALCcontext *context);
+extern inline void SetVoiceSource(ALCcontext *context, ALvoice *voice, struct ALsource *source);
+extern inline ALsizei NextActiveVoice(const ALuint64 *mask, ALsizei idx, ALsizei end);
+
+/* Sources, their property containers, and buffer queue items are allocated
+ * and freed as sounds come and go, so they're kept in pools.
+ */
+static al_slab SourceSlab;
+static al_slab SourcePropsSlab;
+static al_slab BufferListSlab;
 
 static void InitSourceParams(ALsource *Source);
 static void DeinitSource(ALsource *source);
+static void ReleaseSourceQueue(ALsource *source);
 static void UpdateSourceProps(ALsource *source, ALuint num_sends);
+static void ReclaimSources(ALCcontext *context);
 static ALint64 GetSourceSampleOffset(ALsource *Source, ALCdevice *device, ALuint64 *clocktime);
 static ALdouble GetSourceSecOffset(ALsource *Source, ALCdevice *device, ALuint64 *clocktime);
 static ALdouble GetSourceOffset(ALsource *Source, ALenum name, ALCdevice *device);
@@ -115,6 +130,9 @@ typedef enum SourceProp {
 
     /* AL_EXT_BFORMAT */
     srcOrientation = AL_ORIENTATION,
+
+    /* AL_SOFTX_static_emitters */
+    srcEmitterSOFTX = AL_EMITTER_SOFTX,
 } SourceProp;
 
 static ALboolean SetSourcefv(ALsource *Source, ALCcontext *Context, SourceProp prop, const ALfloat *values);
@@ -127,13 +145,12 @@ static ALboolean GetSourcei64v(ALsource *Source, ALCcontext *Context, SourceProp
 
 static inline ALvoice *GetSourceVoice(const ALsource *source, const ALCcontext *context)
 {
-    ALvoice *voice = context->Voices;
-    ALvoice *voice_end = voice + context->VoiceCount;
-    while(voice != voice_end)
+    ALsizei i;
+    for(i = NextActiveVoice(context->VoiceMask, 0, context->VoiceCount);i < context->VoiceCount;
+        i = NextActiveVoice(context->VoiceMask, i+1, context->VoiceCount))
     {
-        if(voice->Source == source)
-            return voice;
-        ++voice;
+        if(context->Voices[i].Source == source)
+            return &context->Voices[i];
     }
     return NULL;
 }
@@ -201,6 +218,7 @@ static ALint FloatValsByProp(ALenum prop)
         case AL_BUFFER:
         case AL_DIRECT_FILTER:
         case AL_AUXILIARY_SEND_FILTER:
+        case AL_EMITTER_SOFTX:
             break; /* i/i64 only */
         case AL_SAMPLE_OFFSET_LATENCY_SOFT:
             break; /* i64 only */
@@ -262,6 +280,7 @@ static ALint DoubleValsByProp(ALenum prop)
         case AL_BUFFER:
         case AL_DIRECT_FILTER:
         case AL_AUXILIARY_SEND_FILTER:
+        case AL_EMITTER_SOFTX:
             break; /* i/i64 only */
         case AL_SAMPLE_OFFSET_LATENCY_SOFT:
             break; /* i64 only */
@@ -305,6 +324,7 @@ static ALint IntValsByProp(ALenum prop)
         case AL_BUFFERS_PROCESSED:
         case AL_SOURCE_TYPE:
         case AL_DIRECT_FILTER:
+        case AL_EMITTER_SOFTX:
         case AL_BYTE_LENGTH_SOFT:
         case AL_SAMPLE_LENGTH_SOFT:
         case AL_SEC_LENGTH_SOFT:
@@ -365,6 +385,7 @@ static ALint Int64ValsByProp(ALenum prop)
         case AL_BUFFERS_PROCESSED:
         case AL_SOURCE_TYPE:
         case AL_DIRECT_FILTER:
+        case AL_EMITTER_SOFTX:
         case AL_BYTE_LENGTH_SOFT:
         case AL_SAMPLE_LENGTH_SOFT:
         case AL_SEC_LENGTH_SOFT:
@@ -562,6 +583,10 @@ static ALboolean SetSourcefv(ALsource *Source, ALCcontext *Context, SourceProp p
             Source->Position[0] = values[0];
             Source->Position[1] = values[1];
             Source->Position[2] = values[2];
+            /* An explicit position overrides a bound emitter. */
+            if(Source->Emitter)
+                DecrementRef(&Source->Emitter->ref);
+            Source->Emitter = NULL;
             DO_UPDATEPROPS();
             return AL_TRUE;
 
@@ -617,6 +642,7 @@ static ALboolean SetSourcefv(ALsource *Source, ALCcontext *Context, SourceProp p
         case AL_BUFFER:
         case AL_DIRECT_FILTER:
         case AL_AUXILIARY_SEND_FILTER:
+        case AL_EMITTER_SOFTX:
         case AL_SAMPLE_OFFSET_LATENCY_SOFT:
             break;
     }
@@ -631,6 +657,7 @@ static ALboolean SetSourceiv(ALsource *Source, ALCcontext *Context, SourceProp p
     ALbuffer  *buffer = NULL;
     ALfilter  *filter = NULL;
     ALeffectslot *slot = NULL;
+    ALemitter *emitter = NULL;
     ALbufferlistitem *oldlist;
     ALbufferlistitem *newlist;
     ALfloat fvals[6];
@@ -681,7 +708,7 @@ static ALboolean SetSourceiv(ALsource *Source, ALCcontext *Context, SourceProp p
             if(buffer != NULL)
             {
                 /* Add the selected buffer to a one-item queue */
-                newlist = malloc(sizeof(ALbufferlistitem));
+                newlist = al_slab_alloc(&BufferListSlab);
                 newlist->buffer = buffer;
                 newlist->next = NULL;
                 IncrementRef(&buffer->ref);
@@ -713,7 +740,7 @@ static ALboolean SetSourceiv(ALsource *Source, ALCcontext *Context, SourceProp p
 
                 if(temp->buffer)
                     DecrementRef(&temp->buffer->ref);
-                free(temp);
+                al_slab_free(&BufferListSlab, temp);
             }
             return AL_TRUE;
 
@@ -797,6 +824,28 @@ static ALboolean SetSourceiv(ALsource *Source, ALCcontext *Context, SourceProp p
             DO_UPDATEPROPS();
             return AL_TRUE;
 
+        case AL_EMITTER_SOFTX:
+            LockEmittersRead(Context);
+            if(!(*values == 0 || (emitter=LookupEmitter(Context, *values)) != NULL))
+            {
+                UnlockEmittersRead(Context);
+                SET_ERROR_AND_RETURN_VALUE(Context, AL_INVALID_VALUE, AL_FALSE);
+            }
+
+            if(emitter)
+            {
+                IncrementRef(&emitter->ref);
+                Source->Position[0] = emitter->Position[0];
+                Source->Position[1] = emitter->Position[1];
+                Source->Position[2] = emitter->Position[2];
+            }
+            if(Source->Emitter)
+                DecrementRef(&Source->Emitter->ref);
+            Source->Emitter = emitter;
+            UnlockEmittersRead(Context);
+            DO_UPDATEPROPS();
+            return AL_TRUE;
+
         case AL_DISTANCE_MODEL:
             CHECKVAL(*values == AL_NONE ||
                      *values == AL_INVERSE_DISTANCE ||
@@ -956,6 +1005,7 @@ static ALboolean SetSourcei64v(ALsource *Source, ALCcontext *Context, SourceProp
         /* 1x uint */
         case AL_BUFFER:
         case AL_DIRECT_FILTER:
+        case AL_EMITTER_SOFTX:
             CHECKVAL(*values <= UINT_MAX && *values >= 0);
 
             ivals[0] = (ALuint)*values;
@@ -1193,6 +1243,7 @@ static ALboolean GetSourcedv(ALsource *Source, ALCcontext *Context, SourceProp p
         case AL_BUFFER:
         case AL_DIRECT_FILTER:
         case AL_AUXILIARY_SEND_FILTER:
+        case AL_EMITTER_SOFTX:
         case AL_SAMPLE_OFFSET_LATENCY_SOFT:
             break;
     }
@@ -1343,6 +1394,10 @@ static ALboolean GetSourceiv(ALsource *Source, ALCcontext *Context, SourceProp p
             *values = Source->DirectChannels;
             return AL_TRUE;
 
+        case AL_EMITTER_SOFTX:
+            *values = Source->Emitter ? Source->Emitter->id : 0;
+            return AL_TRUE;
+
         case AL_DISTANCE_MODEL:
             *values = Source->DistanceModel;
             return AL_TRUE;
@@ -1512,6 +1567,7 @@ static ALboolean GetSourcei64v(ALsource *Source, ALCcontext *Context, SourceProp
         /* 1x uint */
         case AL_BUFFER:
         case AL_DIRECT_FILTER:
+        case AL_EMITTER_SOFTX:
             if((err=GetSourceiv(Source, Context, prop, ivals)) != AL_FALSE)
                 *values = (ALuint)ivals[0];
             return err;
@@ -1550,7 +1606,7 @@ AL_API ALvoid AL_APIENTRY alGenSources(ALsizei n, ALuint *sources)
         SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
     for(cur = 0;cur < n;cur++)
     {
-        ALsource *source = al_calloc(16, sizeof(ALsource));
+        ALsource *source = al_slab_alloc(&SourceSlab);
         if(!source)
         {
             alDeleteSources(cur, sources);
@@ -1558,14 +1614,21 @@ AL_API ALvoid AL_APIENTRY alGenSources(ALsizei n, ALuint *sources)
         }
         InitSourceParams(source);
 
-        err = NewThunkEntry(&source->id);
-        if(err == AL_NO_ERROR)
-            err = InsertUIntMapEntry(&context->SourceMap, source->id, source);
+        if(context->SourceHandles)
+            err = InsertHandleTableEntry(&context->SourceTable, source, &source->id);
+        else
+        {
+            err = NewThunkEntry(&source->id);
+            if(err == AL_NO_ERROR)
+            {
+                err = InsertUIntMapEntry(&context->SourceMap, source->id, source);
+                if(err != AL_NO_ERROR)
+                    FreeThunkEntry(source->id);
+            }
+        }
         if(err != AL_NO_ERROR)
         {
-            FreeThunkEntry(source->id);
-            memset(source, 0, sizeof(ALsource));
-            al_free(source);
+            al_slab_free(&SourceSlab, source);
 
             alDeleteSources(cur, sources);
             SET_ERROR_AND_GOTO(context, err, done);
@@ -1602,20 +1665,32 @@ AL_API ALvoid AL_APIENTRY alDeleteSources(ALsizei n, const ALuint *sources)
     {
         ALvoice *voice;
 
+        /* Removed and detached together, so the state calls (which look
+         * sources up again with the context locked) either see both or
+         * neither.
+         */
+        LockContext(context);
         if((Source=RemoveSource(context, sources[i])) == NULL)
+        {
+            UnlockContext(context);
             continue;
-        FreeThunkEntry(Source->id);
-
-        LockContext(context);
+        }
         voice = GetSourceVoice(Source, context);
-        if(voice) voice->Source = NULL;
+        if(voice) SetVoiceSource(context, voice, NULL);
         UnlockContext(context);
 
-        DeinitSource(Source);
+        if(!context->SourceHandles)
+            FreeThunkEntry(Source->id);
+
+        /* The buffers are let go of now, so they can be deleted right after,
+         * even if the source itself has to wait for readers to finish.
+         */
+        ReleaseSourceQueue(Source);
 
-        memset(Source, 0, sizeof(*Source));
-        al_free(Source);
+        Source->NextRetired = context->RetiredSources;
+        context->RetiredSources = Source;
     }
+    ReclaimSources(context);
 
 done:
     UnlockSourcesWrite(context);
@@ -2307,21 +2382,31 @@ AL_API ALvoid AL_APIENTRY alSourcePlayv(ALsizei n, const ALuint *sources)
     while(n > context->MaxVoices-context->VoiceCount)
     {
         ALvoice *temp = NULL;
+        ALuint64 *tempmask = NULL;
         ALsizei newcount;
 
         newcount = context->MaxVoices << 1;
         if(newcount > 0)
+        {
             temp = al_malloc(16, newcount * sizeof(context->Voices[0]));
-        if(!temp)
+            tempmask = al_calloc(16, VOICE_MASK_WORDS(newcount) * sizeof(tempmask[0]));
+        }
+        if(!temp || !tempmask)
         {
+            al_free(temp);
+            al_free(tempmask);
             UnlockContext(context);
             SET_ERROR_AND_GOTO(context, AL_OUT_OF_MEMORY, done);
         }
         memcpy(temp, context->Voices, context->MaxVoices * sizeof(temp[0]));
         memset(&temp[context->MaxVoices], 0, (newcount-context->MaxVoices) * sizeof(temp[0]));
+        memcpy(tempmask, context->VoiceMask,
+               VOICE_MASK_WORDS(context->MaxVoices) * sizeof(tempmask[0]));
 
         al_free(context->Voices);
         context->Voices = temp;
+        al_free(context->VoiceMask);
+        context->VoiceMask = tempmask;
         context->MaxVoices = newcount;
     }
 
@@ -2329,7 +2414,9 @@ AL_API ALvoid AL_APIENTRY alSourcePlayv(ALsizei n, const ALuint *sources)
     {
         for(i = 0;i < n;i++)
         {
-            source = LookupSource(context, sources[i]);
+            /* Deleted since the check above. */
+            if((source=LookupSource(context, sources[i])) == NULL)
+                continue;
             source->new_state = AL_PLAYING;
         }
     }
@@ -2337,7 +2424,8 @@ AL_API ALvoid AL_APIENTRY alSourcePlayv(ALsizei n, const ALuint *sources)
     {
         for(i = 0;i < n;i++)
         {
-            source = LookupSource(context, sources[i]);
+            if((source=LookupSource(context, sources[i])) == NULL)
+                continue;
             SetSourceState(source, context, AL_PLAYING);
         }
     }
@@ -2375,7 +2463,9 @@ AL_API ALvoid AL_APIENTRY alSourcePausev(ALsizei n, const ALuint *sources)
     {
         for(i = 0;i < n;i++)
         {
-            source = LookupSource(context, sources[i]);
+            /* Deleted since the check above. */
+            if((source=LookupSource(context, sources[i])) == NULL)
+                continue;
             source->new_state = AL_PAUSED;
         }
     }
@@ -2383,7 +2473,8 @@ AL_API ALvoid AL_APIENTRY alSourcePausev(ALsizei n, const ALuint *sources)
     {
         for(i = 0;i < n;i++)
         {
-            source = LookupSource(context, sources[i]);
+            if((source=LookupSource(context, sources[i])) == NULL)
+                continue;
             SetSourceState(source, context, AL_PAUSED);
         }
     }
@@ -2419,7 +2510,9 @@ AL_API ALvoid AL_APIENTRY alSourceStopv(ALsizei n, const ALuint *sources)
     LockContext(context);
     for(i = 0;i < n;i++)
     {
-        source = LookupSource(context, sources[i]);
+        /* Deleted since the check above. */
+        if((source=LookupSource(context, sources[i])) == NULL)
+            continue;
         source->new_state = AL_NONE;
         SetSourceState(source, context, AL_STOPPED);
     }
@@ -2455,7 +2548,9 @@ AL_API ALvoid AL_APIENTRY alSourceRewindv(ALsizei n, const ALuint *sources)
     LockContext(context);
     for(i = 0;i < n;i++)
     {
-        source = LookupSource(context, sources[i]);
+        /* Deleted since the check above. */
+        if((source=LookupSource(context, sources[i])) == NULL)
+            continue;
         source->new_state = AL_NONE;
         SetSourceState(source, context, AL_INITIAL);
     }
@@ -2525,12 +2620,12 @@ AL_API ALvoid AL_APIENTRY alSourceQueueBuffers(ALuint src, ALsizei nb, const ALu
 
         if(!BufferListStart)
         {
-            BufferListStart = malloc(sizeof(ALbufferlistitem));
+            BufferListStart = al_slab_alloc(&BufferListSlab);
             BufferList = BufferListStart;
         }
         else
         {
-            BufferList->next = malloc(sizeof(ALbufferlistitem));
+            BufferList->next = al_slab_alloc(&BufferListSlab);
             BufferList = BufferList->next;
         }
         BufferList->buffer = buffer;
@@ -2568,7 +2663,7 @@ AL_API ALvoid AL_APIENTRY alSourceQueueBuffers(ALuint src, ALsizei nb, const ALu
                     DecrementRef(&buffer->ref);
                     ReadUnlock(&buffer->lock);
                 }
-                free(BufferListStart);
+                al_slab_free(&BufferListSlab, BufferListStart);
                 BufferListStart = next;
             }
             UnlockBuffersRead(device);
@@ -2692,7 +2787,7 @@ AL_API ALvoid AL_APIENTRY alSourceUnqueueBuffers(ALuint src, ALsizei nb, ALuint
             DecrementRef(&buffer->ref);
         }
 
-        free(OldHead);
+        al_slab_free(&BufferListSlab, OldHead);
         OldHead = next;
     }
 
@@ -2748,6 +2843,8 @@ static void InitSourceParams(ALsource *Source)
 
     Source->Radius = 0.0f;
 
+    Source->Emitter = NULL;
+
     Source->DistanceModel = DefaultDistanceModel;
 
     Source->Direct.Gain = 1.0f;
@@ -2786,20 +2883,19 @@ static void InitSourceParams(ALsource *Source)
 
 static void DeinitSource(ALsource *source)
 {
-    ALbufferlistitem *BufferList;
     struct ALsourceProps *props;
     size_t count = 0;
     size_t i;
 
     props = ATOMIC_LOAD_SEQ(&source->Update);
-    if(props) al_free(props);
+    if(props) al_slab_free(&SourcePropsSlab, props);
 
     props = ATOMIC_LOAD(&source->FreeList, almemory_order_relaxed);
     while(props)
     {
         struct ALsourceProps *next;
         next = ATOMIC_LOAD(&props->next, almemory_order_relaxed);
-        al_free(props);
+        al_slab_free(&SourcePropsSlab, props);
         props = next;
         ++count;
     }
@@ -2809,22 +2905,38 @@ static void DeinitSource(ALsource *source)
     if(count > 3)
         WARN("Freed "SZFMT" Source property objects\n", count);
 
+    ReleaseSourceQueue(source);
+
+    for(i = 0;i < MAX_SENDS;++i)
+    {
+        if(source->Send[i].Slot)
+            DecrementRef(&source->Send[i].Slot->ref);
+        source->Send[i].Slot = NULL;
+    }
+
+    if(source->Emitter)
+        DecrementRef(&source->Emitter->ref);
+    source->Emitter = NULL;
+}
+
+/* Drops the source's buffer queue and the references it holds. */
+static void ReleaseSourceQueue(ALsource *source)
+{
+    ALbufferlistitem *BufferList;
+
+    WriteLock(&source->queue_lock);
     BufferList = ATOMIC_EXCHANGE_SEQ(ALbufferlistitem*, &source->queue, NULL);
+    ATOMIC_STORE_SEQ(&source->current_buffer, NULL);
+    WriteUnlock(&source->queue_lock);
+
     while(BufferList != NULL)
     {
         ALbufferlistitem *next = BufferList->next;
         if(BufferList->buffer != NULL)
             DecrementRef(&BufferList->buffer->ref);
-        free(BufferList);
+        al_slab_free(&BufferListSlab, BufferList);
         BufferList = next;
     }
-
-    for(i = 0;i < MAX_SENDS;++i)
-    {
-        if(source->Send[i].Slot)
-            DecrementRef(&source->Send[i].Slot->ref);
-        source->Send[i].Slot = NULL;
-    }
 }
 
 static void UpdateSourceProps(ALsource *source, ALuint num_sends)
@@ -2835,7 +2947,7 @@ static void UpdateSourceProps(ALsource *source, ALuint num_sends)
     /* Get an unused property container, or allocate a new one as needed. */
     props = ATOMIC_LOAD(&source->FreeList, almemory_order_acquire);
     if(!props)
-        props = al_calloc(16, sizeof(*props));
+        props = al_slab_alloc(&SourcePropsSlab);
     else
     {
         struct ALsourceProps *next;
@@ -2873,6 +2985,7 @@ static void UpdateSourceProps(ALsource *source, ALuint num_sends)
     ATOMIC_STORE(&props->HeadRelative, source->HeadRelative, almemory_order_relaxed);
     ATOMIC_STORE(&props->DistanceModel, source->DistanceModel, almemory_order_relaxed);
     ATOMIC_STORE(&props->DirectChannels, source->DirectChannels, almemory_order_relaxed);
+    ATOMIC_STORE(&props->Emitter, source->Emitter, almemory_order_relaxed);
 
     ATOMIC_STORE(&props->DryGainHFAuto, source->DryGainHFAuto, almemory_order_relaxed);
     ATOMIC_STORE(&props->WetGainAuto, source->WetGainAuto, almemory_order_relaxed);
@@ -2922,12 +3035,13 @@ void UpdateAllSourceProps(ALCcontext *context)
     ALuint num_sends = context->Device->NumAuxSends;
     ALsizei pos;
 
-    for(pos = 0;pos < context->VoiceCount;pos++)
+    for(pos = NextActiveVoice(context->VoiceMask, 0, context->VoiceCount);
+        pos < context->VoiceCount;
+        pos = NextActiveVoice(context->VoiceMask, pos+1, context->VoiceCount))
     {
         ALvoice *voice = &context->Voices[pos];
         ALsource *source = voice->Source;
-        if(source != NULL && (source->state == AL_PLAYING ||
-                              source->state == AL_PAUSED) &&
+        if((source->state == AL_PLAYING || source->state == AL_PAUSED) &&
            source->NeedsUpdate)
         {
             source->NeedsUpdate = AL_FALSE;
@@ -3000,15 +3114,12 @@ ALvoid SetSourceState(ALsource *Source, ALCcontext *Context, ALenum state)
                 if(Context->Voices[i].Source == NULL)
                 {
                     voice = &Context->Voices[i];
-                    voice->Source = Source;
                     break;
                 }
             }
             if(voice == NULL)
-            {
                 voice = &Context->Voices[Context->VoiceCount++];
-                voice->Source = Source;
-            }
+            SetVoiceSource(Context, voice, Source);
             discontinuity = AL_TRUE;
         }
 
@@ -3024,6 +3135,7 @@ ALvoid SetSourceState(ALsource *Source, ALCcontext *Context, ALenum state)
         }
 
         voice->Moving = AL_FALSE;
+        voice->HrtfGroup = -1;
         for(i = 0;i < MAX_INPUT_CHANNELS;i++)
         {
             ALsizei j;
@@ -3399,22 +3511,79 @@ static ALboolean GetSampleOffset(ALsource *Source, ALuint *offset, ALuint *frac)
 }
 
 
+void InitSourceSlabs(void)
+{
+    al_slab_init(&SourceSlab, sizeof(ALsource), 16);
+    al_slab_init(&SourcePropsSlab, sizeof(struct ALsourceProps), 32);
+    al_slab_init(&BufferListSlab, sizeof(ALbufferlistitem), 64);
+}
+
+void DeinitSourceSlabs(void)
+{
+    al_slab_deinit(&BufferListSlab);
+    al_slab_deinit(&SourcePropsSlab);
+    al_slab_deinit(&SourceSlab);
+}
+
+/* Returns the number of objects the source pools handed out, and the number
+ * of blocks they allocated to do so.
+ */
+void GetSourceSlabStats(size_t *allocs, size_t *blocks)
+{
+    *allocs = ATOMIC_LOAD(&SourceSlab.AllocCount, almemory_order_relaxed) +
+              ATOMIC_LOAD(&SourcePropsSlab.AllocCount, almemory_order_relaxed) +
+              ATOMIC_LOAD(&BufferListSlab.AllocCount, almemory_order_relaxed);
+    *blocks = ATOMIC_LOAD(&SourceSlab.BlockCount, almemory_order_relaxed) +
+              ATOMIC_LOAD(&SourcePropsSlab.BlockCount, almemory_order_relaxed) +
+              ATOMIC_LOAD(&BufferListSlab.BlockCount, almemory_order_relaxed);
+}
+
+/* ReclaimSources
+ *
+ * Frees the deleted sources, unless a call on a source is in progress. With
+ * lock-free lookups, that call may have found one of them just before it was
+ * removed. They're otherwise freed on a later deletion. Must be called with
+ * the sources locked for writing.
+ */
+static void ReclaimSources(ALCcontext *context)
+{
+    ALsource *source;
+
+    if(ReadRef(&context->SourceReaders) != 0)
+        return;
+
+    source = context->RetiredSources;
+    context->RetiredSources = NULL;
+    while(source)
+    {
+        ALsource *next = source->NextRetired;
+
+        DeinitSource(source);
+        al_slab_free(&SourceSlab, source);
+        source = next;
+    }
+}
+
 /* ReleaseALSources
  *
- * Destroys all sources in the source map.
+ * Destroys all sources in the source map, and the deleted ones not yet freed.
  */
 ALvoid ReleaseALSources(ALCcontext *Context)
 {
     ALsizei pos;
-    for(pos = 0;pos < Context->SourceMap.size;pos++)
+    for(pos = 0;pos < GetSourceSlotCount(Context);pos++)
     {
-        ALsource *temp = Context->SourceMap.values[pos];
-        Context->SourceMap.values[pos] = NULL;
+        ALsource *temp = GetSourceSlot(Context, pos);
+        if(!temp) continue;
 
-        DeinitSource(temp);
+        if(!Context->SourceHandles)
+        {
+            Context->SourceMap.values[pos] = NULL;
+            FreeThunkEntry(temp->id);
+        }
 
-        FreeThunkEntry(temp->id);
-        memset(temp, 0, sizeof(*temp));
-        al_free(temp);
+        DeinitSource(temp);
+        al_slab_free(&SourceSlab, temp);
     }
+    ReclaimSources(Context);
 }
@@ -33,6 +33,7 @@
 #include "alAuxEffectSlot.h"
 
 #include "backends/base.h"
+#include "almalloc.h"
 
 
 static const ALchar alVendor[] = "OpenAL Community";
@@ -47,6 +48,19 @@ static const ALchar alErrInvalidValue[] = "Invalid Value";
 static const ALchar alErrInvalidOp[] = "Invalid Operation";
 static const ALchar alErrOutOfMemory[] = "Out of Memory";
 
+/* The allocation counters are process-wide, not per context. */
+static ALint64SOFT GetAllocationStat(ALenum pname)
+{
+    size_t allocs, blocks;
+
+    if(pname == AL_SYSTEM_ALLOCATIONS_SOFTX)
+        return (ALint64SOFT)al_malloc_count();
+    GetSourceSlabStats(&allocs, &blocks);
+    if(pname == AL_POOL_BLOCKS_SOFTX)
+        return (ALint64SOFT)blocks;
+    return (ALint64SOFT)allocs;
+}
+
 AL_API ALvoid AL_APIENTRY alEnable(ALenum capability)
 {
     ALCcontext *context;
@@ -296,6 +310,29 @@ AL_API ALint AL_APIENTRY alGetInteger(ALenum pname)
         value = (ALint)(GAIN_MIX_MAX/context->GainBoost);
         break;
 
+    case AL_POOLED_ALLOCATIONS_SOFTX:
+    case AL_POOL_BLOCKS_SOFTX:
+    case AL_SYSTEM_ALLOCATIONS_SOFTX:
+        value = (ALint)GetAllocationStat(pname);
+        break;
+
+    case AL_VOICES_VISITED_SOFTX:
+        value = (ALint)ATOMIC_LOAD(&context->VoicesVisited, almemory_order_relaxed);
+        break;
+
+    case AL_VOICES_SKIPPED_SOFTX:
+        value = (ALint)ATOMIC_LOAD(&context->VoicesSkipped, almemory_order_relaxed);
+        break;
+
+    /* Counted over every context on the device. */
+    case AL_VOICE_UPDATES_SOFTX:
+        value = (ALint)ATOMIC_LOAD(&context->Device->VoiceUpdates, almemory_order_relaxed);
+        break;
+
+    case AL_VOICE_UPDATES_CULLED_SOFTX:
+        value = (ALint)ATOMIC_LOAD(&context->Device->CulledVoiceUpdates, almemory_order_relaxed);
+        break;
+
     default:
         SET_ERROR_AND_GOTO(context, AL_INVALID_ENUM, done);
     }
@@ -341,6 +378,29 @@ AL_API ALint64SOFT AL_APIENTRY alGetInteger64SOFT(ALenum pname)
         value = (ALint64SOFT)(GAIN_MIX_MAX/context->GainBoost);
         break;
 
+    case AL_POOLED_ALLOCATIONS_SOFTX:
+    case AL_POOL_BLOCKS_SOFTX:
+    case AL_SYSTEM_ALLOCATIONS_SOFTX:
+        value = GetAllocationStat(pname);
+        break;
+
+    case AL_VOICES_VISITED_SOFTX:
+        value = ATOMIC_LOAD(&context->VoicesVisited, almemory_order_relaxed);
+        break;
+
+    case AL_VOICES_SKIPPED_SOFTX:
+        value = ATOMIC_LOAD(&context->VoicesSkipped, almemory_order_relaxed);
+        break;
+
+    /* Counted over every context on the device. */
+    case AL_VOICE_UPDATES_SOFTX:
+        value = ATOMIC_LOAD(&context->Device->VoiceUpdates, almemory_order_relaxed);
+        break;
+
+    case AL_VOICE_UPDATES_CULLED_SOFTX:
+        value = ATOMIC_LOAD(&context->Device->CulledVoiceUpdates, almemory_order_relaxed);
+        break;
+
     default:
         SET_ERROR_AND_GOTO(context, AL_INVALID_ENUM, done);
     }
@@ -467,6 +527,13 @@ AL_API ALvoid AL_APIENTRY alGetIntegerv(ALenum pname, ALint *values)
             case AL_SPEED_OF_SOUND:
             case AL_DEFERRED_UPDATES_SOFT:
             case AL_GAIN_LIMIT_SOFT:
+            case AL_POOLED_ALLOCATIONS_SOFTX:
+            case AL_POOL_BLOCKS_SOFTX:
+            case AL_SYSTEM_ALLOCATIONS_SOFTX:
+            case AL_VOICES_VISITED_SOFTX:
+            case AL_VOICES_SKIPPED_SOFTX:
+            case AL_VOICE_UPDATES_SOFTX:
+            case AL_VOICE_UPDATES_CULLED_SOFTX:
                 values[0] = alGetInteger(pname);
                 return;
         }
@@ -499,6 +566,13 @@ AL_API void AL_APIENTRY alGetInteger64vSOFT(ALenum pname, ALint64SOFT *values)
             case AL_SPEED_OF_SOUND:
             case AL_DEFERRED_UPDATES_SOFT:
             case AL_GAIN_LIMIT_SOFT:
+            case AL_POOLED_ALLOCATIONS_SOFTX:
+            case AL_POOL_BLOCKS_SOFTX:
+            case AL_SYSTEM_ALLOCATIONS_SOFTX:
+            case AL_VOICES_VISITED_SOFTX:
+            case AL_VOICES_SKIPPED_SOFTX:
+            case AL_VOICE_UPDATES_SOFTX:
+            case AL_VOICE_UPDATES_CULLED_SOFTX:
                 values[0] = alGetInteger64SOFT(pname);
                 return;
         }
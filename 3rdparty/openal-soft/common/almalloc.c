@@ -12,8 +12,14 @@
 #include <windows.h>
 #endif
 
+#include "threads.h"
+
+
+static ATOMIC(size_t) MallocCount = ATOMIC_INIT_STATIC(0);
+
 void *al_malloc(size_t alignment, size_t size)
 {
+    ATOMIC_ADD(&MallocCount, 1, almemory_order_relaxed);
 #if defined(HAVE_ALIGNED_ALLOC)
     size = (size+(alignment-1))&~(alignment-1);
     return aligned_alloc(alignment, size);
@@ -60,3 +66,92 @@ void al_free(void *ptr)
     }
 #endif
 }
+
+size_t al_malloc_count(void)
+{
+    return ATOMIC_LOAD(&MallocCount, almemory_order_relaxed);
+}
+
+
+/* Same as the spinlock for RWLock. Only held for a few pointer swaps, or a
+ * block allocation. */
+#define LOCK(l) do {                                                          \
+    while(ATOMIC_FLAG_TEST_AND_SET(&(l), almemory_order_acq_rel) == true)     \
+        althrd_yield();                                                       \
+} while(0)
+#define UNLOCK(l) ATOMIC_FLAG_CLEAR(&(l), almemory_order_release)
+
+void al_slab_init(al_slab *slab, size_t size, size_t count)
+{
+    /* Objects hold the freelist link while free. */
+    if(size < sizeof(void*))
+        size = sizeof(void*);
+    slab->ObjSize = (size+(AL_SLAB_ALIGN-1)) & ~(size_t)(AL_SLAB_ALIGN-1);
+    slab->ObjCount = (count > 0) ? count : 1;
+
+    slab->FreeList = NULL;
+    slab->Blocks = NULL;
+    ATOMIC_FLAG_CLEAR(&slab->Lock, almemory_order_relaxed);
+
+    ATOMIC_INIT(&slab->AllocCount, 0);
+    ATOMIC_INIT(&slab->BlockCount, 0);
+}
+
+void al_slab_deinit(al_slab *slab)
+{
+    void *block = slab->Blocks;
+    while(block)
+    {
+        void *next = *(void**)block;
+        al_free(block);
+        block = next;
+    }
+    slab->Blocks = NULL;
+    slab->FreeList = NULL;
+}
+
+void *al_slab_alloc(al_slab *slab)
+{
+    void *ret;
+
+    LOCK(slab->Lock);
+    if(!slab->FreeList)
+    {
+        /* The start of the block holds the block link, objects follow. */
+        char *block = al_malloc(AL_SLAB_ALIGN, AL_SLAB_ALIGN + slab->ObjSize*slab->ObjCount);
+        size_t i;
+
+        if(!block)
+        {
+            UNLOCK(slab->Lock);
+            return NULL;
+        }
+        *(void**)block = slab->Blocks;
+        slab->Blocks = block;
+
+        for(i = 0;i < slab->ObjCount;i++)
+        {
+            void *obj = block + AL_SLAB_ALIGN + slab->ObjSize*i;
+            *(void**)obj = slab->FreeList;
+            slab->FreeList = obj;
+        }
+        ATOMIC_ADD(&slab->BlockCount, 1, almemory_order_relaxed);
+    }
+    ret = slab->FreeList;
+    slab->FreeList = *(void**)ret;
+    UNLOCK(slab->Lock);
+
+    ATOMIC_ADD(&slab->AllocCount, 1, almemory_order_relaxed);
+    memset(ret, 0, slab->ObjSize);
+    return ret;
+}
+
+void al_slab_free(al_slab *slab, void *ptr)
+{
+    if(!ptr) return;
+
+    LOCK(slab->Lock);
+    *(void**)ptr = slab->FreeList;
+    slab->FreeList = ptr;
+    UNLOCK(slab->Lock);
+}
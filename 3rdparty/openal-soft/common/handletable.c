@@ -0,0 +1,150 @@
+#include "config.h"
+
+#include "handletable.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "almalloc.h"
+
+
+extern inline ALvoid *LookupHandleTableKey(HandleTable *table, ALuint handle);
+extern inline ALvoid *GetHandleTableSlotValue(HandleTable *table, ALsizei pos);
+extern inline ALsizei GetHandleTableCapacity(HandleTable *table);
+extern inline void LockHandleTableWrite(HandleTable *table);
+extern inline void UnlockHandleTableWrite(HandleTable *table);
+
+
+static inline HandleTableSlot *GetSlot(HandleTable *table, ALuint idx)
+{
+    HandleTableSlot *chunk = ATOMIC_LOAD(&table->chunks[idx>>HANDLETABLE_CHUNK_BITS],
+                                         almemory_order_relaxed);
+    return &chunk[idx&(HANDLETABLE_CHUNK_SIZE-1)];
+}
+
+void InitHandleTable(HandleTable *table, ALsizei limit)
+{
+    ALsizei i;
+    for(i = 0;i < HANDLETABLE_MAX_CHUNKS;i++)
+        ATOMIC_INIT(&table->chunks[i], NULL);
+    ATOMIC_INIT(&table->capacity, 0);
+    table->size = 0;
+    table->limit = (limit > 0 && limit <= (ALsizei)HANDLETABLE_INDEX_MASK) ?
+                   limit : (ALsizei)HANDLETABLE_INDEX_MASK;
+    table->free_head = 0;
+    table->free_tail = 0;
+    RWLockInit(&table->lock);
+}
+
+void ResetHandleTable(HandleTable *table)
+{
+    ALsizei i;
+
+    WriteLock(&table->lock);
+    for(i = 0;i < HANDLETABLE_MAX_CHUNKS;i++)
+    {
+        HandleTableSlot *chunk = ATOMIC_EXCHANGE(HandleTableSlot*, &table->chunks[i], NULL,
+                                                 almemory_order_relaxed);
+        al_free(chunk);
+    }
+    ATOMIC_STORE(&table->capacity, 0, almemory_order_release);
+    table->size = 0;
+    table->free_head = 0;
+    table->free_tail = 0;
+    WriteUnlock(&table->lock);
+}
+
+ALenum InsertHandleTableEntry(HandleTable *table, ALvoid *value, ALuint *handle)
+{
+    HandleTableSlot *slot;
+    ALuint idx;
+
+    WriteLock(&table->lock);
+    if(table->size == table->limit)
+    {
+        WriteUnlock(&table->lock);
+        return AL_OUT_OF_MEMORY;
+    }
+
+    if(table->free_head == 0)
+    {
+        ALsizei capacity = ATOMIC_LOAD(&table->capacity, almemory_order_relaxed);
+        /* The last index of the last chunk would overflow into the
+         * generation, so it's never handed out.
+         */
+        ALsizei count = (ALsizei)HANDLETABLE_INDEX_MASK - capacity;
+        HandleTableSlot *chunk;
+        ALsizei i;
+
+        if(count > HANDLETABLE_CHUNK_SIZE)
+            count = HANDLETABLE_CHUNK_SIZE;
+        /* Every slot is in use, so add another chunk. Its slots are set up
+         * before the capacity is raised to cover them.
+         */
+        chunk = al_calloc(16, HANDLETABLE_CHUNK_SIZE*sizeof(HandleTableSlot));
+        if(!chunk)
+        {
+            WriteUnlock(&table->lock);
+            return AL_OUT_OF_MEMORY;
+        }
+        for(i = 0;i < HANDLETABLE_CHUNK_SIZE;i++)
+        {
+            ATOMIC_INIT(&chunk[i].handle, 0);
+            ATOMIC_INIT(&chunk[i].value, NULL);
+            chunk[i].gen = 1;
+            chunk[i].next_free = (i < count-1) ? capacity+i+2 : 0;
+        }
+        ATOMIC_STORE(&table->chunks[capacity>>HANDLETABLE_CHUNK_BITS], chunk,
+                     almemory_order_release);
+        ATOMIC_STORE(&table->capacity, capacity+HANDLETABLE_CHUNK_SIZE,
+                     almemory_order_release);
+
+        table->free_head = capacity + 1;
+        table->free_tail = capacity + count;
+    }
+
+    idx = table->free_head - 1;
+    slot = GetSlot(table, idx);
+    table->free_head = slot->next_free;
+    if(table->free_head == 0)
+        table->free_tail = 0;
+
+    *handle = (slot->gen<<HANDLETABLE_INDEX_BITS) | (idx+1);
+    ATOMIC_STORE(&slot->value, value, almemory_order_relaxed);
+    ATOMIC_STORE_SEQ(&slot->handle, *handle);
+    table->size++;
+    WriteUnlock(&table->lock);
+
+    return AL_NO_ERROR;
+}
+
+ALvoid *RemoveHandleTableKeyNoLock(HandleTable *table, ALuint handle)
+{
+    ALuint idx = (handle&HANDLETABLE_INDEX_MASK) - 1;
+    HandleTableSlot *slot;
+    ALvoid *value;
+
+    if(idx >= (ALuint)ATOMIC_LOAD(&table->capacity, almemory_order_relaxed))
+        return NULL;
+    slot = GetSlot(table, idx);
+    if(ATOMIC_LOAD(&slot->handle, almemory_order_relaxed) != handle)
+        return NULL;
+
+    /* Invalidate the handle before anything else, so lookups that haven't
+     * seen it yet fail.
+     */
+    ATOMIC_STORE_SEQ(&slot->handle, 0);
+    value = ATOMIC_EXCHANGE(ALvoid*, &slot->value, NULL, almemory_order_relaxed);
+
+    if(++slot->gen > HANDLETABLE_GEN_MASK)
+        slot->gen = 1;
+    slot->next_free = 0;
+    if(table->free_tail == 0)
+        table->free_head = idx + 1;
+    else
+        GetSlot(table, table->free_tail-1)->next_free = idx + 1;
+    table->free_tail = idx + 1;
+    table->size--;
+
+    return value;
+}
@@ -20,6 +20,11 @@
 
 #include "config.h"
 
+/* pthread_setaffinity_np is a GNU extension. */
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #include "threads.h"
 
 #include <stdlib.h>
@@ -175,6 +180,73 @@ int althrd_join(althrd_t thr, int *res)
     return althrd_success;
 }
 
+/* Windows has no real-time classes as such; both of them map the level to a
+ * thread priority: 1 is above normal, 2 highest, and 3 or more time-critical.
+ */
+int althrd_setsched(althrd_t thr, int sched, int priority)
+{
+    HANDLE hdl;
+    int prio;
+
+    if(althrd_equal(thr, althrd_current()))
+        hdl = GetCurrentThread();
+    else if((hdl=LookupUIntMapKey(&ThrdIdHandle, thr)) == NULL)
+        return althrd_error;
+
+    if(sched == althrd_sched_other || priority < 1)
+        prio = THREAD_PRIORITY_NORMAL;
+    else if(priority == 1)
+        prio = THREAD_PRIORITY_ABOVE_NORMAL;
+    else if(priority == 2)
+        prio = THREAD_PRIORITY_HIGHEST;
+    else
+        prio = THREAD_PRIORITY_TIME_CRITICAL;
+
+    if(!SetThreadPriority(hdl, prio))
+        return althrd_error;
+    return althrd_success;
+}
+
+/* Reports the priorities althrd_setsched gives back as the level it takes,
+ * in the round-robin class. Anything lower is the normal class at 0. */
+int althrd_getsched(althrd_t thr, int *sched, int *priority)
+{
+    HANDLE hdl;
+    int prio;
+
+    if(althrd_equal(thr, althrd_current()))
+        hdl = GetCurrentThread();
+    else if((hdl=LookupUIntMapKey(&ThrdIdHandle, thr)) == NULL)
+        return althrd_error;
+
+    if((prio=GetThreadPriority(hdl)) == THREAD_PRIORITY_ERROR_RETURN)
+        return althrd_error;
+    if(prio >= THREAD_PRIORITY_TIME_CRITICAL)
+        *priority = 3;
+    else if(prio >= THREAD_PRIORITY_HIGHEST)
+        *priority = 2;
+    else if(prio >= THREAD_PRIORITY_ABOVE_NORMAL)
+        *priority = 1;
+    else
+        *priority = 0;
+    *sched = (*priority > 0) ? althrd_sched_rr : althrd_sched_other;
+    return althrd_success;
+}
+
+int althrd_setaffinity(althrd_t thr, unsigned long long cpumask)
+{
+    HANDLE hdl;
+
+    if(althrd_equal(thr, althrd_current()))
+        hdl = GetCurrentThread();
+    else if((hdl=LookupUIntMapKey(&ThrdIdHandle, thr)) == NULL)
+        return althrd_error;
+
+    if(SetThreadAffinityMask(hdl, (DWORD_PTR)cpumask) == 0)
+        return althrd_error;
+    return althrd_success;
+}
+
 int althrd_sleep(const struct timespec *ts, struct timespec* UNUSED(rem))
 {
     DWORD msec;
@@ -512,6 +584,97 @@ void althrd_setname(althrd_t thr, const char *name)
 }
 
 
+/* `priority' counts up from 1, the lowest real-time priority, and is clamped
+ * to what the class allows. */
+int althrd_setsched(althrd_t thr, int sched, int priority)
+{
+#if defined(HAVE_PTHREAD_SETSCHEDPARAM) && !defined(__OpenBSD__)
+    struct sched_param param;
+    int policy;
+
+    switch(sched)
+    {
+        case althrd_sched_rr: policy = SCHED_RR; break;
+        case althrd_sched_fifo: policy = SCHED_FIFO; break;
+        default: policy = SCHED_OTHER; break;
+    }
+
+    param.sched_priority = 0;
+    if(policy != SCHED_OTHER)
+    {
+        int minprio = sched_get_priority_min(policy);
+        int maxprio = sched_get_priority_max(policy);
+        param.sched_priority = minprio + ((priority > 1) ? priority-1 : 0);
+        if(param.sched_priority > maxprio)
+            param.sched_priority = maxprio;
+    }
+
+    if(pthread_setschedparam(thr, policy, &param) != 0)
+        return althrd_error;
+    return althrd_success;
+#else
+    (void)thr;
+    (void)sched;
+    (void)priority;
+    return althrd_error;
+#endif
+}
+
+/* Reports the priority the same way althrd_setsched takes it, counting up
+ * from 1 for the real-time classes, and 0 otherwise. */
+int althrd_getsched(althrd_t thr, int *sched, int *priority)
+{
+#if defined(HAVE_PTHREAD_SETSCHEDPARAM) && !defined(__OpenBSD__)
+    struct sched_param param;
+    int policy;
+
+    if(pthread_getschedparam(thr, &policy, &param) != 0)
+        return althrd_error;
+
+    if(policy == SCHED_FIFO || policy == SCHED_RR)
+    {
+        *sched = (policy == SCHED_FIFO) ? althrd_sched_fifo : althrd_sched_rr;
+        *priority = param.sched_priority - sched_get_priority_min(policy) + 1;
+    }
+    else
+    {
+        *sched = althrd_sched_other;
+        *priority = 0;
+    }
+    return althrd_success;
+#else
+    (void)thr;
+    (void)sched;
+    (void)priority;
+    return althrd_error;
+#endif
+}
+
+/* Bit n of `cpumask' allows the thread on CPU n. */
+int althrd_setaffinity(althrd_t thr, unsigned long long cpumask)
+{
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+    cpu_set_t set;
+    int i;
+
+    CPU_ZERO(&set);
+    for(i = 0;i < 64;i++)
+    {
+        if((cpumask>>i)&1)
+            CPU_SET(i, &set);
+    }
+
+    if(pthread_setaffinity_np(thr, sizeof(set), &set) != 0)
+        return althrd_error;
+    return althrd_success;
+#else
+    (void)thr;
+    (void)cpumask;
+    return althrd_error;
+#endif
+}
+
+
 typedef struct thread_cntr {
     althrd_start_t func;
     void *arg;
@@ -0,0 +1,534 @@
+/*
+ * OpenAL Ambisonic Decoder Benchmark
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* This file contains a benchmark of the high-quality ambisonic decoder, for a
+ * first-order decoder over a quad layout and a third-order one over 7.1,
+ * rendered through the loopback device at 48kHz. The decoder files are
+ * written out along with the config, with uneven speaker distances so the
+ * distance compensation delays are used as well.
+ *
+ * The input is a looping click, once as a mono source panned into the full
+ * order and once as a first-order B-Format source, which the third-order
+ * decoder up-samples. Each block's time is mostly the band splitting and the
+ * decoding matrix.
+ *
+ * As with alverbbench, the program runs itself once for every CPU extension
+ * path, and the outputs of the vectorized paths are checked against the
+ * scalar one.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "AL/al.h"
+#include "AL/alc.h"
+#include "AL/alext.h"
+
+
+#define FREQUENCY       48000
+#define BLOCK_SIZE      1024
+#define WARMUP_BLOCKS   16
+#define MEASURED_BLOCKS 256
+#define CLICK_LENGTH    (FREQUENCY/20)
+#define MAX_CHANNELS    8
+
+/* The largest difference allowed between the output of a vectorized path and
+ * the scalar one, relative to the peak of the output. The paths pick
+ * different mixers for the sources too, which round differently.
+ */
+#define TOLERANCE       1e-5
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static LPALCLOOPBACKOPENDEVICESOFT alcLoopbackOpenDeviceSOFT;
+static LPALCRENDERSAMPLESSOFT alcRenderSamplesSOFT;
+
+static const struct {
+    const char *name;
+    const char *disabled_exts;
+} Paths[] = {
+    { "c",   "all" },
+    { "sse", "" },
+};
+
+typedef struct Speaker {
+    const char *name;
+    float distance;
+    float azimuth;
+} Speaker;
+
+static const Speaker QuadSpeakers[] = {
+    { "LF", 1.0f,   45.0f },
+    { "RF", 1.2f,  -45.0f },
+    { "LB", 1.4f,  135.0f },
+    { "RB", 1.1f, -135.0f },
+};
+static const Speaker Surround71Speakers[] = {
+    { "LF", 1.0f,   30.0f },
+    { "RF", 1.2f,  -30.0f },
+    { "CE", 1.1f,    0.0f },
+    { "LS", 1.4f,   90.0f },
+    { "RS", 1.3f,  -90.0f },
+    { "LB", 1.6f,  150.0f },
+    { "RB", 1.5f, -150.0f },
+};
+
+static const struct {
+    int order;
+    /* The config option holding the decoder for the layout. */
+    const char *layout;
+    ALCenum channels;
+    ALCint numchans;
+    const char *chan_mask;
+    ALsizei numcoeffs;
+    const Speaker *speakers;
+    ALsizei numspeakers;
+} Orders[] = {
+    { 1, "quad", ALC_QUAD_SOFT, 4, "f", 4, QuadSpeakers, 4 },
+    { 3, "surround71", ALC_7POINT1_SOFT, 8, "ffff", 16, Surround71Speakers, 7 },
+};
+
+
+static double get_nanoseconds(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart * 1000000000.0 / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec*1000000000.0 + (double)ts.tv_nsec;
+#endif
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double da = *(const double*)a;
+    double db = *(const double*)b;
+    return (da > db) - (da < db);
+}
+
+/* Writes an AmbDec file for the given order. The matrix only needs to be
+ * dense and stable, not a good decode, so each speaker gets a gain for every
+ * coefficient from its direction.
+ */
+static int WriteDecoder(const char *fname, size_t idx)
+{
+    FILE *f;
+    ALsizei i, k;
+
+    f = fopen(fname, "w");
+    if(!f)
+    {
+        fprintf(stderr, "Failed to write %s\n", fname);
+        return 1;
+    }
+
+    fprintf(f, "/description alambibench_order%d\n", Orders[idx].order);
+    fprintf(f, "/version 3\n");
+    fprintf(f, "/dec/chan_mask %s\n", Orders[idx].chan_mask);
+    fprintf(f, "/dec/freq_bands 2\n");
+    fprintf(f, "/dec/speakers %d\n", Orders[idx].numspeakers);
+    fprintf(f, "/dec/coeff_scale n3d\n");
+    fprintf(f, "/opt/input_scale n3d\n");
+    fprintf(f, "/opt/nfeff_comp input\n");
+    fprintf(f, "/opt/delay_comp on\n");
+    fprintf(f, "/opt/level_comp on\n");
+    fprintf(f, "/opt/xover_freq 400.000000\n");
+    fprintf(f, "/opt/xover_ratio 0.000000\n");
+
+    fprintf(f, "/speakers/{\n");
+    for(i = 0;i < Orders[idx].numspeakers;i++)
+        fprintf(f, "add_spkr %s %f %f 0.000000\n", Orders[idx].speakers[i].name,
+                Orders[idx].speakers[i].distance, Orders[idx].speakers[i].azimuth);
+    fprintf(f, "/}\n");
+
+    for(k = 0;k < 2;k++)
+    {
+        ALsizei c;
+
+        fprintf(f, "/%s/{\n", k ? "hfmatrix" : "lfmatrix");
+        fprintf(f, "order_gain 1.000000 1.000000 1.000000 1.000000\n");
+        for(i = 0;i < Orders[idx].numspeakers;i++)
+        {
+            double azi = Orders[idx].speakers[i].azimuth * M_PI / 180.0;
+
+            fprintf(f, "add_row");
+            for(c = 0;c < Orders[idx].numcoeffs;c++)
+                fprintf(f, " %f", 0.25 * cos(azi*(c+1) + c) / (1.0 + c*0.25) * (k ? 1.0 : 0.8));
+            fprintf(f, "\n");
+        }
+        fprintf(f, "/}\n");
+    }
+    fprintf(f, "/end\n");
+
+    fclose(f);
+    return 0;
+}
+
+/* Creates a short decaying noise burst that resembles a keystroke, either as
+ * mono or encoded to first-order B-Format from the front left.
+ */
+static ALuint CreateClick(ALboolean bformat)
+{
+    static ALshort data[CLICK_LENGTH*4];
+    ALuint seed = 22222;
+    ALuint buffer;
+    ALsizei i;
+
+    for(i = 0;i < CLICK_LENGTH;i++)
+    {
+        float noise, s;
+        seed = seed*96314165 + 907633515;
+        noise = (float)((ALint)seed) / 2147483648.0f;
+        s = noise * 32767.0f * expf(-(float)i / (CLICK_LENGTH/6));
+        if(!bformat)
+            data[i] = (ALshort)s;
+        else
+        {
+            /* FuMa W, X, Y, Z. */
+            data[i*4 + 0] = (ALshort)(s * 0.707107f);
+            data[i*4 + 1] = (ALshort)(s * 0.707107f);
+            data[i*4 + 2] = (ALshort)(s * 0.5f);
+            data[i*4 + 3] = (ALshort)(s * 0.2f);
+        }
+    }
+
+    buffer = 0;
+    alGenBuffers(1, &buffer);
+    if(!bformat)
+        alBufferData(buffer, AL_FORMAT_MONO16, data, CLICK_LENGTH*sizeof(ALshort), FREQUENCY);
+    else
+        alBufferData(buffer, AL_FORMAT_BFORMAT3D_16, data, CLICK_LENGTH*4*sizeof(ALshort),
+                     FREQUENCY);
+    return buffer;
+}
+
+/* FNV-1a over the bits of the rendered samples, to compare output between
+ * runs.
+ */
+static unsigned int HashSamples(unsigned int hash, const float *samples, size_t count)
+{
+    const unsigned char *bytes = (const unsigned char*)samples;
+    size_t i;
+
+    for(i = 0;i < count*sizeof(float);i++)
+    {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int RunCase(const char *path, size_t idx)
+{
+    ALCint attrs[] = {
+        ALC_FORMAT_CHANNELS_SOFT, 0,
+        ALC_FORMAT_TYPE_SOFT, ALC_FLOAT_SOFT,
+        ALC_FREQUENCY, FREQUENCY,
+        0
+    };
+    static float output[BLOCK_SIZE*MAX_CHANNELS];
+    static double timings[MEASURED_BLOCKS];
+    const ALCint numchans = Orders[idx].numchans;
+    ALCdevice *device;
+    ALCcontext *context;
+    ALuint buffers[2], sources[2];
+    unsigned int hash = 2166136261u;
+    double block_ns;
+    char dumpname[64];
+    FILE *dump;
+    ALsizei b;
+
+    device = alcLoopbackOpenDeviceSOFT(NULL);
+    if(!device)
+    {
+        fprintf(stderr, "Failed to open loopback device\n");
+        return 1;
+    }
+
+    attrs[1] = Orders[idx].channels;
+    context = alcCreateContext(device, attrs);
+    if(!context || alcMakeContextCurrent(context) == ALC_FALSE)
+    {
+        fprintf(stderr, "Failed to set up loopback context\n");
+        if(context)
+            alcDestroyContext(context);
+        alcCloseDevice(device);
+        return 1;
+    }
+    if(!alIsExtensionPresent("AL_EXT_BFORMAT"))
+    {
+        fprintf(stderr, "Missing AL_EXT_BFORMAT\n");
+        return 1;
+    }
+
+    buffers[0] = CreateClick(AL_FALSE);
+    buffers[1] = CreateClick(AL_TRUE);
+
+    /* A click slightly off to the side and a B-Format one, both looping so
+     * there's always input. The second starts half way through, so the two
+     * don't line up.
+     */
+    alGenSources(2, sources);
+    alSourcei(sources[0], AL_BUFFER, (ALint)buffers[0]);
+    alSourcei(sources[0], AL_LOOPING, AL_TRUE);
+    alSource3f(sources[0], AL_POSITION, 0.5f, 0.2f, -1.0f);
+    alSourcei(sources[1], AL_BUFFER, (ALint)buffers[1]);
+    alSourcei(sources[1], AL_LOOPING, AL_TRUE);
+    alSourcei(sources[1], AL_SAMPLE_OFFSET, CLICK_LENGTH/2);
+    alSourcePlayv(2, sources);
+    if(alGetError() != AL_NO_ERROR)
+    {
+        fprintf(stderr, "Failed to set up the sources\n");
+        return 1;
+    }
+
+    snprintf(dumpname, sizeof(dumpname), "alambibench-%s-order%d.raw", path,
+             Orders[idx].order);
+    dump = fopen(dumpname, "wb");
+    if(!dump)
+    {
+        fprintf(stderr, "Failed to write %s\n", dumpname);
+        return 1;
+    }
+    for(b = 0;b < WARMUP_BLOCKS+MEASURED_BLOCKS;b++)
+    {
+        double start, end;
+
+        start = get_nanoseconds();
+        alcRenderSamplesSOFT(device, output, BLOCK_SIZE);
+        end = get_nanoseconds();
+
+        if(b >= WARMUP_BLOCKS)
+            timings[b-WARMUP_BLOCKS] = end - start;
+        hash = HashSamples(hash, output, BLOCK_SIZE*numchans);
+        fwrite(output, sizeof(float), BLOCK_SIZE*numchans, dump);
+    }
+    fclose(dump);
+
+    qsort(timings, MEASURED_BLOCKS, sizeof(timings[0]), compare_doubles);
+    block_ns = timings[MEASURED_BLOCKS/2];
+
+    printf("%s,%d,%s,%d,%.0f,%.0f,%.1f,%08x\n", path, Orders[idx].order, Orders[idx].layout,
+           BLOCK_SIZE, block_ns, timings[MEASURED_BLOCKS*9/10], block_ns / BLOCK_SIZE, hash);
+    fflush(stdout);
+
+    alDeleteSources(2, sources);
+    alDeleteBuffers(2, buffers);
+
+    alcMakeContextCurrent(NULL);
+    alcDestroyContext(context);
+    alcCloseDevice(device);
+    return 0;
+}
+
+static int RunPath(const char *path)
+{
+    const char *disabled_exts = NULL;
+    char confname[64];
+    char decnames[sizeof(Orders)/sizeof(Orders[0])][64];
+    FILE *conf;
+    size_t i;
+    int ret = 0;
+
+    for(i = 0;i < sizeof(Paths)/sizeof(Paths[0]);i++)
+    {
+        if(strcmp(Paths[i].name, path) == 0)
+            disabled_exts = Paths[i].disabled_exts;
+    }
+    if(!disabled_exts)
+    {
+        fprintf(stderr, "Unknown path \"%s\"\n", path);
+        return 1;
+    }
+
+    for(i = 0;i < sizeof(Orders)/sizeof(Orders[0]);i++)
+    {
+        snprintf(decnames[i], sizeof(decnames[i]), "alambibench-%s-order%d.ambdec", path,
+                 Orders[i].order);
+        if(WriteDecoder(decnames[i], i) != 0)
+            return 1;
+    }
+
+    /* The config is read once, on the first call into the library. */
+    snprintf(confname, sizeof(confname), "alambibench-%s.conf", path);
+    conf = fopen(confname, "w");
+    if(!conf)
+    {
+        fprintf(stderr, "Failed to write %s\n", confname);
+        return 1;
+    }
+    fprintf(conf, "disable-cpu-exts = %s\n", disabled_exts);
+    fprintf(conf, "[decoder]\n");
+    fprintf(conf, "hq-mode = true\n");
+    fprintf(conf, "distance-comp = true\n");
+    for(i = 0;i < sizeof(Orders)/sizeof(Orders[0]);i++)
+        fprintf(conf, "%s = %s\n", Orders[i].layout, decnames[i]);
+    fclose(conf);
+
+#ifdef _WIN32
+    {
+        char envvar[96];
+        snprintf(envvar, sizeof(envvar), "ALSOFT_CONF=%s", confname);
+        _putenv(envvar);
+    }
+#else
+    setenv("ALSOFT_CONF", confname, 1);
+#endif
+
+    if(!alcIsExtensionPresent(NULL, "ALC_SOFT_loopback"))
+    {
+        fprintf(stderr, "Missing ALC_SOFT_loopback\n");
+        return 1;
+    }
+    alcLoopbackOpenDeviceSOFT = (LPALCLOOPBACKOPENDEVICESOFT)alcGetProcAddress(NULL, "alcLoopbackOpenDeviceSOFT");
+    alcRenderSamplesSOFT = (LPALCRENDERSAMPLESSOFT)alcGetProcAddress(NULL, "alcRenderSamplesSOFT");
+
+    for(i = 0;i < sizeof(Orders)/sizeof(Orders[0]) && ret == 0;i++)
+        ret = RunCase(path, i);
+
+    remove(confname);
+    for(i = 0;i < sizeof(Orders)/sizeof(Orders[0]);i++)
+        remove(decnames[i]);
+    return ret;
+}
+
+/* Compares the output a path saved against the scalar path's, and prints the
+ * largest difference found. Returns non-zero if it's out of tolerance.
+ */
+static int CheckOutput(const char *path, size_t idx)
+{
+    char refname[64], testname[64];
+    FILE *ref, *test;
+    double maxdiff = 0.0, peak = 0.0;
+    size_t count = 0;
+    int ret = 1;
+
+    snprintf(refname, sizeof(refname), "alambibench-%s-order%d.raw", Paths[0].name,
+             Orders[idx].order);
+    snprintf(testname, sizeof(testname), "alambibench-%s-order%d.raw", path,
+             Orders[idx].order);
+    ref = fopen(refname, "rb");
+    test = fopen(testname, "rb");
+    if(ref && test)
+    {
+        float a[BLOCK_SIZE*MAX_CHANNELS], b[BLOCK_SIZE*MAX_CHANNELS];
+        size_t na, nb, i;
+
+        do {
+            na = fread(a, sizeof(float), BLOCK_SIZE*MAX_CHANNELS, ref);
+            nb = fread(b, sizeof(float), BLOCK_SIZE*MAX_CHANNELS, test);
+            for(i = 0;i < na && i < nb;i++)
+            {
+                double diff = fabs((double)a[i] - (double)b[i]);
+                if(diff > maxdiff) maxdiff = diff;
+                if(fabs(a[i]) > peak) peak = fabs(a[i]);
+            }
+            count += (na < nb) ? na : nb;
+        } while(na == BLOCK_SIZE*MAX_CHANNELS && nb == BLOCK_SIZE*MAX_CHANNELS);
+
+        if(na != nb || count == 0)
+            printf("# %s order %d: output length differs from %s\n", path, Orders[idx].order,
+                   Paths[0].name);
+        else
+        {
+            ret = (maxdiff > TOLERANCE*peak);
+            printf("# %s order %d: max difference from %s is %g (peak %g, %zu samples): %s\n",
+                   path, Orders[idx].order, Paths[0].name, maxdiff, peak, count,
+                   ret ? "FAILED" : "ok");
+        }
+    }
+    else
+        printf("# %s order %d: missing output to compare\n", path, Orders[idx].order);
+    if(ref) fclose(ref);
+    if(test) fclose(test);
+    return ret;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *path = NULL;
+    int failed = 0;
+    size_t i, o;
+
+    for(i = 1;i < (size_t)argc;i++)
+    {
+        if(strcmp(argv[i], "-path") == 0 && i+1 < (size_t)argc)
+            path = argv[++i];
+        else
+        {
+            fprintf(stderr, "Usage: %s [-path c|sse]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if(path)
+        return RunPath(path);
+
+    printf("path,order,layout,block,ns_per_block_p50,ns_per_block_p90,ns_per_frame,checksum\n");
+    fflush(stdout);
+
+    for(i = 0;i < sizeof(Paths)/sizeof(Paths[0]);i++)
+    {
+        char cmd[1024];
+        int ret;
+
+        snprintf(cmd, sizeof(cmd), "\"%s\" -path %s", argv[0], Paths[i].name);
+        ret = system(cmd);
+        if(ret != 0)
+        {
+            fprintf(stderr, "Path %s failed\n", Paths[i].name);
+            return 1;
+        }
+    }
+
+    for(o = 0;o < sizeof(Orders)/sizeof(Orders[0]);o++)
+    {
+        for(i = 1;i < sizeof(Paths)/sizeof(Paths[0]);i++)
+            failed |= CheckOutput(Paths[i].name, o);
+    }
+    for(o = 0;o < sizeof(Orders)/sizeof(Orders[0]);o++)
+    {
+        for(i = 0;i < sizeof(Paths)/sizeof(Paths[0]);i++)
+        {
+            char dumpname[64];
+            snprintf(dumpname, sizeof(dumpname), "alambibench-%s-order%d.raw", Paths[i].name,
+                     Orders[o].order);
+            remove(dumpname);
+        }
+    }
+
+    return failed;
+}
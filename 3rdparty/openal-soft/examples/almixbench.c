@@ -0,0 +1,339 @@
+/*
+ * OpenAL Mixer Benchmark
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* This file contains a benchmark of the mixer for many short, overlapping,
+ * positional voices, rendered through the loopback device.
+ *
+ * The CPU extensions used by the mixer are picked once per process from the
+ * config, so when no mixer is given on the command line, the program runs
+ * itself once for every mixer path.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "AL/al.h"
+#include "AL/alc.h"
+#include "AL/alext.h"
+
+
+#define FREQUENCY       48000
+#define BLOCK_SIZE      1024
+#define WARMUP_BLOCKS   16
+#define MEASURED_BLOCKS 256
+#define CLICK_LENGTH    (FREQUENCY/20)
+
+static LPALCLOOPBACKOPENDEVICESOFT alcLoopbackOpenDeviceSOFT;
+static LPALCRENDERSAMPLESSOFT alcRenderSamplesSOFT;
+
+static const struct {
+    const char *name;
+    const char *disabled_exts;
+} Mixers[] = {
+    { "c",      "all" },
+    { "sse",    "sse2, sse3, sse4.1, avx2" },
+    { "sse2",   "sse3, sse4.1, avx2" },
+    { "sse3",   "sse4.1, avx2" },
+    { "sse4.1", "avx2" },
+    { "avx2",   "" },
+};
+
+static const ALCsizei VoiceCounts[] = { 16, 64, 256 };
+
+
+static double get_nanoseconds(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart * 1000000000.0 / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec*1000000000.0 + (double)ts.tv_nsec;
+#endif
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double da = *(const double*)a;
+    double db = *(const double*)b;
+    return (da > db) - (da < db);
+}
+
+/* Creates a short decaying noise burst that resembles a keystroke. */
+static ALuint CreateClick(void)
+{
+    static ALshort data[CLICK_LENGTH];
+    ALuint seed = 22222;
+    ALuint buffer;
+    ALsizei i;
+
+    for(i = 0;i < CLICK_LENGTH;i++)
+    {
+        float noise;
+        seed = seed*96314165 + 907633515;
+        noise = (float)((ALint)seed) / 2147483648.0f;
+        data[i] = (ALshort)(noise * 32767.0f * expf(-(float)i / (CLICK_LENGTH/6)));
+    }
+
+    buffer = 0;
+    alGenBuffers(1, &buffer);
+    alBufferData(buffer, AL_FORMAT_MONO16, data, sizeof(data), FREQUENCY);
+    return buffer;
+}
+
+/* FNV-1a over the bits of the rendered samples, to compare output between
+ * runs.
+ */
+static unsigned int HashSamples(unsigned int hash, const float *samples, size_t count)
+{
+    const unsigned char *bytes = (const unsigned char*)samples;
+    size_t i;
+
+    for(i = 0;i < count*sizeof(float);i++)
+    {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int RunCase(const char *mixer, unsigned int mixthreads, int hrtfbatch, ALCboolean hrtf, ALCsizei numvoices)
+{
+    ALCint attrs[] = {
+        ALC_FORMAT_CHANNELS_SOFT, ALC_STEREO_SOFT,
+        ALC_FORMAT_TYPE_SOFT, ALC_FLOAT_SOFT,
+        ALC_FREQUENCY, FREQUENCY,
+        ALC_HRTF_SOFT, hrtf,
+        ALC_MONO_SOURCES, numvoices,
+        0
+    };
+    static float output[BLOCK_SIZE*2];
+    static double timings[MEASURED_BLOCKS];
+    ALuint *sources;
+    ALCdevice *device;
+    ALCcontext *context;
+    ALCint hrtf_status = ALC_FALSE;
+    ALuint buffer;
+    unsigned int hash = 2166136261u;
+    ALsizei i, b;
+    double median, p99;
+
+    device = alcLoopbackOpenDeviceSOFT(NULL);
+    if(!device)
+    {
+        fprintf(stderr, "Failed to open loopback device\n");
+        return 1;
+    }
+
+    context = alcCreateContext(device, attrs);
+    if(!context || alcMakeContextCurrent(context) == ALC_FALSE)
+    {
+        fprintf(stderr, "Failed to set up loopback context\n");
+        if(context)
+            alcDestroyContext(context);
+        alcCloseDevice(device);
+        return 1;
+    }
+    alcGetIntegerv(device, ALC_HRTF_SOFT, 1, &hrtf_status);
+
+    buffer = CreateClick();
+    sources = calloc(numvoices, sizeof(sources[0]));
+    alGenSources(numvoices, sources);
+    for(i = 0;i < numvoices;i++)
+    {
+        /* Spread the voices over a keyboard-sized area in front of the
+         * listener, and stagger them so they overlap. */
+        alSourcei(sources[i], AL_BUFFER, buffer);
+        alSource3f(sources[i], AL_POSITION, (float)(i%16)/8.0f - 1.0f, (float)(i/16%4)*0.1f, -1.0f);
+        alSourcePlay(sources[i]);
+        alSourcei(sources[i], AL_SAMPLE_OFFSET, (i*CLICK_LENGTH/numvoices));
+    }
+    if(alGetError() != AL_NO_ERROR)
+    {
+        fprintf(stderr, "Failed to set up %d voices\n", numvoices);
+        return 1;
+    }
+
+    for(b = 0;b < WARMUP_BLOCKS+MEASURED_BLOCKS;b++)
+    {
+        double start, end;
+
+        for(i = 0;i < numvoices;i++)
+        {
+            ALint state;
+            alGetSourcei(sources[i], AL_SOURCE_STATE, &state);
+            if(state != AL_PLAYING)
+                alSourcePlay(sources[i]);
+        }
+
+        start = get_nanoseconds();
+        alcRenderSamplesSOFT(device, output, BLOCK_SIZE);
+        end = get_nanoseconds();
+
+        if(b >= WARMUP_BLOCKS)
+            timings[b-WARMUP_BLOCKS] = end - start;
+        hash = HashSamples(hash, output, BLOCK_SIZE*2);
+    }
+
+    qsort(timings, MEASURED_BLOCKS, sizeof(timings[0]), compare_doubles);
+    median = timings[MEASURED_BLOCKS/2];
+    p99 = timings[MEASURED_BLOCKS*99/100];
+
+    printf("%s,%u,%d,%d,%d,%d,%.0f,%.0f,%.3f,%08x\n", mixer, mixthreads, hrtf_status, hrtfbatch, numvoices,
+           BLOCK_SIZE, median, p99, median / ((double)numvoices*BLOCK_SIZE), hash);
+    fflush(stdout);
+
+    alDeleteSources(numvoices, sources);
+    alDeleteBuffers(1, &buffer);
+    free(sources);
+
+    alcMakeContextCurrent(NULL);
+    alcDestroyContext(context);
+    alcCloseDevice(device);
+    return 0;
+}
+
+static int RunMixer(const char *mixer, unsigned int mixthreads, int hrtfbatch, const char *hrtf_path)
+{
+    const char *disabled_exts = NULL;
+    char confname[64];
+    FILE *conf;
+    size_t m;
+    int h, v;
+
+    for(m = 0;m < sizeof(Mixers)/sizeof(Mixers[0]);m++)
+    {
+        if(strcmp(Mixers[m].name, mixer) == 0)
+            disabled_exts = Mixers[m].disabled_exts;
+    }
+    if(!disabled_exts)
+    {
+        fprintf(stderr, "Unknown mixer \"%s\"\n", mixer);
+        return 1;
+    }
+
+    /* The config is read once, on the first call into the library. */
+    snprintf(confname, sizeof(confname), "almixbench-%s.conf", mixer);
+    conf = fopen(confname, "w");
+    if(!conf)
+    {
+        fprintf(stderr, "Failed to write %s\n", confname);
+        return 1;
+    }
+    fprintf(conf, "disable-cpu-exts = %s\n", disabled_exts);
+    fprintf(conf, "mix-threads = %u\n", mixthreads);
+    fprintf(conf, "hrtf-batch = %s\n", hrtfbatch ? "true" : "false");
+    if(hrtf_path)
+        fprintf(conf, "hrtf-paths = %s\n", hrtf_path);
+    fclose(conf);
+
+#ifdef _WIN32
+    {
+        char envvar[96];
+        snprintf(envvar, sizeof(envvar), "ALSOFT_CONF=%s", confname);
+        _putenv(envvar);
+    }
+#else
+    setenv("ALSOFT_CONF", confname, 1);
+#endif
+
+    if(!alcIsExtensionPresent(NULL, "ALC_SOFT_loopback"))
+    {
+        fprintf(stderr, "Missing ALC_SOFT_loopback\n");
+        return 1;
+    }
+    alcLoopbackOpenDeviceSOFT = (LPALCLOOPBACKOPENDEVICESOFT)alcGetProcAddress(NULL, "alcLoopbackOpenDeviceSOFT");
+    alcRenderSamplesSOFT = (LPALCRENDERSAMPLESSOFT)alcGetProcAddress(NULL, "alcRenderSamplesSOFT");
+
+    for(h = 0;h < 2;h++)
+    {
+        for(v = 0;v < (int)(sizeof(VoiceCounts)/sizeof(VoiceCounts[0]));v++)
+        {
+            if(RunCase(mixer, mixthreads, hrtfbatch, h ? ALC_TRUE : ALC_FALSE, VoiceCounts[v]) != 0)
+                return 1;
+        }
+    }
+
+    remove(confname);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *hrtf_path = NULL;
+    const char *mixer = NULL;
+    unsigned int mixthreads = 1;
+    int hrtfbatch = 1;
+    int i;
+
+    for(i = 1;i < argc;i++)
+    {
+        if(strcmp(argv[i], "-mixer") == 0 && i+1 < argc)
+            mixer = argv[++i];
+        else if(strcmp(argv[i], "-mix-threads") == 0 && i+1 < argc)
+            mixthreads = (unsigned int)strtoul(argv[++i], NULL, 10);
+        else if(strcmp(argv[i], "-hrtf-batch") == 0 && i+1 < argc)
+            hrtfbatch = atoi(argv[++i]) != 0;
+        else if(strcmp(argv[i], "-hrtf-path") == 0 && i+1 < argc)
+            hrtf_path = argv[++i];
+        else
+        {
+            fprintf(stderr, "Usage: %s [-mixer c|sse|sse2|sse3|sse4.1|avx2] [-mix-threads <n>] [-hrtf-batch 0|1] [-hrtf-path <dir>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if(mixer)
+        return RunMixer(mixer, mixthreads, hrtfbatch, hrtf_path);
+
+    printf("mixer,mix_threads,hrtf,hrtf_batch,voices,block,ns_per_block_p50,ns_per_block_p99,ns_per_voice_sample,checksum\n");
+    fflush(stdout);
+
+    for(i = 0;i < (int)(sizeof(Mixers)/sizeof(Mixers[0]));i++)
+    {
+        char cmd[1024];
+        int ret;
+
+        snprintf(cmd, sizeof(cmd), "\"%s\" -mixer %s -mix-threads %u -hrtf-batch %d%s%s%s", argv[0],
+                 Mixers[i].name, mixthreads, hrtfbatch, hrtf_path ? " -hrtf-path \"" : "", hrtf_path ? hrtf_path : "",
+                 hrtf_path ? "\"" : "");
+        ret = system(cmd);
+        if(ret != 0)
+        {
+            fprintf(stderr, "Mixer %s failed\n", Mixers[i].name);
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,266 @@
+/*
+ * OpenAL Shared Memory Ring Consumer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* This file contains a reference consumer for the "shm" backend. It maps the
+ * ring the mixer renders into and takes one update's worth of frames off it
+ * every update period, the way a sound card would, reading them in place.
+ *
+ * The frames are checksummed and can be written out raw. A period where the
+ * mixer had not rendered a whole update yet is counted as an underrun.
+ *
+ * Start it before or after the program using the device, with the same
+ * object name as the [shm] name config option.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "alshm.h"
+
+
+/* Wait this long for the object to show up. */
+#define OPEN_TIMEOUT_MS 10000
+
+typedef struct Totals {
+    unsigned long long frames;
+    unsigned long long updates;
+    unsigned long long underruns;
+    unsigned long long checksum;
+    unsigned int reopens;
+} Totals;
+
+
+static void sleep_ns(long ns)
+{
+    struct timespec ts;
+    ts.tv_sec = ns / 1000000000;
+    ts.tv_nsec = ns % 1000000000;
+    while(nanosleep(&ts, &ts) != 0 && errno == EINTR)
+    {
+    }
+}
+
+static ALshmHeader *OpenRing(const char *name, size_t *mapsize)
+{
+    int waited;
+
+    for(waited = 0;waited < OPEN_TIMEOUT_MS;waited += 10)
+    {
+        const ALshmHeader *header;
+        struct stat st;
+        void *map;
+        int fd;
+
+        fd = shm_open(name, O_RDWR, 0);
+        if(fd < 0)
+        {
+            if(errno != ENOENT)
+            {
+                fprintf(stderr, "Could not open %s: %s\n", name, strerror(errno));
+                return NULL;
+            }
+            sleep_ns(10000000);
+            continue;
+        }
+
+        /* The header says how large the whole thing is, but it may still be
+         * being written; only trust it once the magic value is in place.
+         */
+        if(fstat(fd, &st) != 0 || (size_t)st.st_size < ALSHM_HEADER_SIZE)
+        {
+            close(fd);
+            sleep_ns(10000000);
+            continue;
+        }
+        map = mmap(NULL, (size_t)st.st_size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if(map == MAP_FAILED)
+        {
+            fprintf(stderr, "Could not map %s: %s\n", name, strerror(errno));
+            return NULL;
+        }
+
+        header = map;
+        if(__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) == ALSHM_MAGIC &&
+           header->state != ALSHM_CLOSED && header->map_size == (size_t)st.st_size)
+        {
+            if(header->version != ALSHM_VERSION)
+            {
+                fprintf(stderr, "Unsupported version %u\n", header->version);
+                munmap(map, (size_t)st.st_size);
+                return NULL;
+            }
+            *mapsize = (size_t)st.st_size;
+            return map;
+        }
+
+        munmap(map, (size_t)st.st_size);
+        sleep_ns(10000000);
+    }
+
+    fprintf(stderr, "Timed out waiting for %s\n", name);
+    return NULL;
+}
+
+static void ConsumeFrames(const char *data, size_t frames, size_t frameSize, FILE *out,
+                          Totals *totals)
+{
+    size_t i;
+
+    for(i = 0;i < frames*frameSize;i++)
+        totals->checksum = totals->checksum*31 + (unsigned char)data[i];
+    if(out)
+        fwrite(data, frameSize, frames, out);
+    totals->frames += frames;
+}
+
+/* Takes `count' frames off the ring, in at most two pieces, without copying
+ * them anywhere first. */
+static void ReadUpdate(ALshmRing *ring, size_t count, FILE *out, Totals *totals)
+{
+    size_t r = __atomic_load_n(&ring->read_ptr, __ATOMIC_RELAXED);
+    size_t start = r & ring->size_mask;
+    size_t len1 = ring->size - start;
+
+    if(len1 > count) len1 = count;
+    ConsumeFrames(ALSHM_RING_DATA(ring) + start*ring->elem_size, len1, ring->elem_size,
+                  out, totals);
+    if(count > len1)
+        ConsumeFrames(ALSHM_RING_DATA(ring), count-len1, ring->elem_size, out, totals);
+
+    __atomic_store_n(&ring->read_ptr, r+count, __ATOMIC_RELEASE);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *name = "/alsoft";
+    const char *outname = NULL;
+    double seconds = 5.0;
+    unsigned long long target;
+    struct timespec next;
+    ALshmHeader *header;
+    ALshmRing *ring;
+    size_t mapsize;
+    long period;
+    FILE *out = NULL;
+    Totals totals;
+    int i;
+
+    for(i = 1;i < argc;i++)
+    {
+        if(strcmp(argv[i], "-name") == 0 && i+1 < argc)
+            name = argv[++i];
+        else if(strcmp(argv[i], "-seconds") == 0 && i+1 < argc)
+            seconds = atof(argv[++i]);
+        else if(strcmp(argv[i], "-out") == 0 && i+1 < argc)
+            outname = argv[++i];
+        else
+        {
+            fprintf(stderr, "Usage: %s [-name /alsoft] [-seconds 5] [-out frames.raw]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    memset(&totals, 0, sizeof(totals));
+
+    header = OpenRing(name, &mapsize);
+    if(!header)
+        return 1;
+    printf("%s: %uhz, %u channels, %u-bit %s, %u x %u frames\n", name, header->frequency,
+           header->channels, header->sample_bits, header->is_float ? "float" : "int",
+           header->num_updates, header->update_size);
+    fflush(stdout);
+
+    if(outname)
+    {
+        out = fopen(outname, "wb");
+        if(!out)
+        {
+            fprintf(stderr, "Could not open %s: %s\n", outname, strerror(errno));
+            return 1;
+        }
+    }
+
+    target = (unsigned long long)(seconds * header->frequency);
+    period = (long)((unsigned long long)header->update_size * 1000000000 / header->frequency);
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    while(totals.frames < target)
+    {
+        size_t avail, w;
+
+        if(header->state == ALSHM_CLOSED)
+        {
+            /* Reset or closed; pick up the new object if there is one. */
+            munmap(header, mapsize);
+            header = OpenRing(name, &mapsize);
+            if(!header)
+                break;
+            totals.reopens++;
+            period = (long)((unsigned long long)header->update_size * 1000000000 /
+                            header->frequency);
+            clock_gettime(CLOCK_MONOTONIC, &next);
+        }
+        ring = ALSHM_RING(header);
+
+        next.tv_nsec += period;
+        while(next.tv_nsec >= 1000000000)
+        {
+            next.tv_nsec -= 1000000000;
+            next.tv_sec++;
+        }
+        while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR)
+        {
+        }
+
+        if(header->state != ALSHM_RUNNING)
+            continue;
+
+        w = __atomic_load_n(&ring->write_ptr, __ATOMIC_ACQUIRE);
+        avail = (w - __atomic_load_n(&ring->read_ptr, __ATOMIC_RELAXED)) & ring->size_mask;
+        if(avail < header->update_size)
+        {
+            totals.underruns++;
+            continue;
+        }
+
+        ReadUpdate(ring, header->update_size, out, &totals);
+        totals.updates++;
+    }
+
+    printf("frames,updates,underruns,reopens,checksum\n");
+    printf("%llu,%llu,%llu,%u,%016llx\n", totals.frames, totals.updates, totals.underruns,
+           totals.reopens, totals.checksum);
+
+    if(out)
+        fclose(out);
+    if(header)
+        munmap(header, mapsize);
+    return (totals.frames < target) ? 1 : 0;
+}
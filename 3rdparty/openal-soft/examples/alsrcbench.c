@@ -0,0 +1,335 @@
+/*
+ * OpenAL Source Lifecycle Benchmark
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* This file contains a benchmark of the source lifecycle, as driven by bursts
+ * of keystrokes: sources are generated, set up, played, stopped and deleted
+ * again, by one or more threads at once.
+ *
+ * How sources are stored is picked once per context from the config, so when
+ * no map is given on the command line, the program runs itself once for the
+ * source map and once for the handle table.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#include <pthread.h>
+#endif
+
+#include "AL/al.h"
+#include "AL/alc.h"
+#include "AL/alext.h"
+
+
+#define FREQUENCY   48000
+#define MAX_THREADS 8
+#define ITERATIONS  2000
+#define CLICK_LENGTH (FREQUENCY/20)
+
+static LPALCLOOPBACKOPENDEVICESOFT alcLoopbackOpenDeviceSOFT;
+
+static const struct {
+    const char *name;
+    const char *source_handles;
+} Maps[] = {
+    { "uintmap",     "false" },
+    { "handletable", "true" },
+};
+
+static const int ThreadCounts[] = { 1, 2, 4 };
+static const ALsizei BurstSizes[] = { 1, 8, 32 };
+
+/* Time spent in each stage of the lifecycle, by one thread. */
+typedef struct Stages {
+    ALsizei burst;
+    ALuint buffer;
+    int errors;
+
+    double gen, props, play, del;
+} Stages;
+
+
+static double get_nanoseconds(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart * 1000000000.0 / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec*1000000000.0 + (double)ts.tv_nsec;
+#endif
+}
+
+/* Creates a short decaying sawtooth, standing in for a keystroke. */
+static ALuint CreateClick(void)
+{
+    static ALshort data[CLICK_LENGTH];
+    ALuint buffer;
+    ALsizei i;
+
+    for(i = 0;i < CLICK_LENGTH;i++)
+        data[i] = (ALshort)(((i*97)%512 - 256) * 64 * (CLICK_LENGTH-i) / CLICK_LENGTH);
+
+    buffer = 0;
+    alGenBuffers(1, &buffer);
+    alBufferData(buffer, AL_FORMAT_MONO16, data, sizeof(data), FREQUENCY);
+    return buffer;
+}
+
+#ifdef _WIN32
+static DWORD WINAPI RunLifecycle(LPVOID arg)
+#else
+static void *RunLifecycle(void *arg)
+#endif
+{
+    Stages *stages = arg;
+    ALuint sources[32];
+    ALsizei i;
+    int iter;
+
+    for(iter = 0;iter < ITERATIONS;iter++)
+    {
+        double t0, t1, t2, t3, t4;
+
+        t0 = get_nanoseconds();
+        alGenSources(stages->burst, sources);
+        t1 = get_nanoseconds();
+        for(i = 0;i < stages->burst;i++)
+        {
+            alSourcei(sources[i], AL_BUFFER, stages->buffer);
+            alSource3f(sources[i], AL_POSITION, (float)(i%16)/8.0f - 1.0f, 0.0f, -1.0f);
+            alSourcef(sources[i], AL_GAIN, 0.5f);
+            alSourcef(sources[i], AL_PITCH, 1.0f + (float)(i%5)*0.01f);
+        }
+        t2 = get_nanoseconds();
+        for(i = 0;i < stages->burst;i++)
+            alSourcePlay(sources[i]);
+        t3 = get_nanoseconds();
+        alSourceStopv(stages->burst, sources);
+        alDeleteSources(stages->burst, sources);
+        t4 = get_nanoseconds();
+
+        stages->gen += t1 - t0;
+        stages->props += t2 - t1;
+        stages->play += t3 - t2;
+        stages->del += t4 - t3;
+    }
+    if(alGetError() != AL_NO_ERROR)
+        stages->errors++;
+
+    return 0;
+}
+
+static int RunCase(const char *map, int numthreads, ALsizei burst)
+{
+    ALCint attrs[] = {
+        ALC_FORMAT_CHANNELS_SOFT, ALC_STEREO_SOFT,
+        ALC_FORMAT_TYPE_SOFT, ALC_FLOAT_SOFT,
+        ALC_FREQUENCY, FREQUENCY,
+        ALC_MONO_SOURCES, MAX_THREADS*32,
+        0
+    };
+    Stages stages[MAX_THREADS];
+    ALCdevice *device;
+    ALCcontext *context;
+    ALuint buffer;
+    double gen = 0.0, props = 0.0, play = 0.0, del = 0.0;
+    double count;
+    int errors = 0;
+    int t;
+
+    device = alcLoopbackOpenDeviceSOFT(NULL);
+    if(!device)
+    {
+        fprintf(stderr, "Failed to open loopback device\n");
+        return 1;
+    }
+
+    context = alcCreateContext(device, attrs);
+    if(!context || alcMakeContextCurrent(context) == ALC_FALSE)
+    {
+        fprintf(stderr, "Failed to set up loopback context\n");
+        if(context)
+            alcDestroyContext(context);
+        alcCloseDevice(device);
+        return 1;
+    }
+
+    buffer = CreateClick();
+    for(t = 0;t < numthreads;t++)
+    {
+        memset(&stages[t], 0, sizeof(stages[t]));
+        stages[t].burst = burst;
+        stages[t].buffer = buffer;
+    }
+
+    {
+#ifdef _WIN32
+        HANDLE threads[MAX_THREADS];
+        for(t = 0;t < numthreads;t++)
+            threads[t] = CreateThread(NULL, 0, RunLifecycle, &stages[t], 0, NULL);
+        WaitForMultipleObjects(numthreads, threads, TRUE, INFINITE);
+        for(t = 0;t < numthreads;t++)
+            CloseHandle(threads[t]);
+#else
+        pthread_t threads[MAX_THREADS];
+        for(t = 0;t < numthreads;t++)
+            pthread_create(&threads[t], NULL, RunLifecycle, &stages[t]);
+        for(t = 0;t < numthreads;t++)
+            pthread_join(threads[t], NULL);
+#endif
+    }
+
+    for(t = 0;t < numthreads;t++)
+    {
+        gen += stages[t].gen;
+        props += stages[t].props;
+        play += stages[t].play;
+        del += stages[t].del;
+        errors += stages[t].errors;
+    }
+    if(errors)
+    {
+        fprintf(stderr, "Errors in %d thread%s\n", errors, (errors==1)?"":"s");
+        return 1;
+    }
+
+    /* Per source, and per call for the properties (four calls a source). */
+    count = (double)numthreads * ITERATIONS * burst;
+    printf("%s,%d,%d,%.1f,%.1f,%.1f,%.1f,%.1f\n", map, numthreads, burst, gen/count,
+           props/(count*4.0), play/count, del/count, (gen+props+play+del)/count);
+    fflush(stdout);
+
+    alDeleteBuffers(1, &buffer);
+
+    alcMakeContextCurrent(NULL);
+    alcDestroyContext(context);
+    alcCloseDevice(device);
+    return 0;
+}
+
+static int RunMap(const char *map)
+{
+    const char *source_handles = NULL;
+    char confname[64];
+    FILE *conf;
+    size_t m;
+    int t, b;
+
+    for(m = 0;m < sizeof(Maps)/sizeof(Maps[0]);m++)
+    {
+        if(strcmp(Maps[m].name, map) == 0)
+            source_handles = Maps[m].source_handles;
+    }
+    if(!source_handles)
+    {
+        fprintf(stderr, "Unknown map \"%s\"\n", map);
+        return 1;
+    }
+
+    /* The config is read once, on the first call into the library. */
+    snprintf(confname, sizeof(confname), "alsrcbench-%s.conf", map);
+    conf = fopen(confname, "w");
+    if(!conf)
+    {
+        fprintf(stderr, "Failed to write %s\n", confname);
+        return 1;
+    }
+    fprintf(conf, "source-handles = %s\n", source_handles);
+    fclose(conf);
+
+#ifdef _WIN32
+    {
+        char envvar[96];
+        snprintf(envvar, sizeof(envvar), "ALSOFT_CONF=%s", confname);
+        _putenv(envvar);
+    }
+#else
+    setenv("ALSOFT_CONF", confname, 1);
+#endif
+
+    if(!alcIsExtensionPresent(NULL, "ALC_SOFT_loopback"))
+    {
+        fprintf(stderr, "Missing ALC_SOFT_loopback\n");
+        return 1;
+    }
+    alcLoopbackOpenDeviceSOFT = (LPALCLOOPBACKOPENDEVICESOFT)alcGetProcAddress(NULL, "alcLoopbackOpenDeviceSOFT");
+
+    for(t = 0;t < (int)(sizeof(ThreadCounts)/sizeof(ThreadCounts[0]));t++)
+    {
+        for(b = 0;b < (int)(sizeof(BurstSizes)/sizeof(BurstSizes[0]));b++)
+        {
+            if(RunCase(map, ThreadCounts[t], BurstSizes[b]) != 0)
+                return 1;
+        }
+    }
+
+    remove(confname);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *map = NULL;
+    int i;
+
+    for(i = 1;i < argc;i++)
+    {
+        if(strcmp(argv[i], "-map") == 0 && i+1 < argc)
+            map = argv[++i];
+        else
+        {
+            fprintf(stderr, "Usage: %s [-map uintmap|handletable]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if(map)
+        return RunMap(map);
+
+    printf("map,threads,burst,gen_ns,set_ns_per_call,play_ns,delete_ns,lifecycle_ns\n");
+    fflush(stdout);
+
+    for(i = 0;i < (int)(sizeof(Maps)/sizeof(Maps[0]));i++)
+    {
+        char cmd[1024];
+        int ret;
+
+        snprintf(cmd, sizeof(cmd), "\"%s\" -map %s", argv[0], Maps[i].name);
+        ret = system(cmd);
+        if(ret != 0)
+        {
+            fprintf(stderr, "Map %s failed\n", Maps[i].name);
+            return 1;
+        }
+    }
+
+    return 0;
+}
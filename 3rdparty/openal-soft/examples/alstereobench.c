@@ -0,0 +1,425 @@
+/*
+ * OpenAL Stereo Output Filter Benchmark
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* This file contains a benchmark of the filters run on stereo output without
+ * HRTF: the UHJ encoder used for plain stereo, and the bs2b crossfeed enabled
+ * with the cf_level option. The loopback device never uses the crossfeed, so
+ * both are rendered by the wave file writer instead, mixing as fast as it can
+ * (freewheeling) at 48kHz for a fixed amount of time. The time per block is
+ * the elapsed time over the number of blocks written, so it includes writing
+ * the file out.
+ *
+ * As with alverbbench, the program runs itself once for every CPU extension
+ * path, and for every filter, and the outputs of the vectorized paths are
+ * checked against the scalar one. The device mixes silence until the source
+ * starts, so the outputs are lined up on their first non-zero sample.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "AL/al.h"
+#include "AL/alc.h"
+#include "AL/alext.h"
+
+
+#define FREQUENCY       48000
+#define BLOCK_SIZE      1024
+#define RUN_MILLISECONDS 1000
+#define CLICK_LENGTH    (FREQUENCY/20)
+
+/* The largest difference allowed between the output of a vectorized path and
+ * the scalar one, relative to the peak of the output. The filters themselves
+ * give the same results either way, but the paths also pick different mixers
+ * for the source, which round differently.
+ */
+#define TOLERANCE       1e-5
+
+static const struct {
+    const char *name;
+    const char *disabled_exts;
+} Paths[] = {
+    { "c",   "all" },
+    { "sse", "" },
+};
+
+static const struct {
+    const char *name;
+    const char *config;
+} Filters[] = {
+    { "uhj",  "cf_level = 0\nstereo-panning = uhj\n" },
+    { "bs2b", "cf_level = 5\n" },
+};
+
+
+static double get_nanoseconds(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart * 1000000000.0 / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec*1000000000.0 + (double)ts.tv_nsec;
+#endif
+}
+
+static void sleep_ms(unsigned int ms)
+{
+#ifdef _WIN32
+    Sleep(ms);
+#else
+    struct timespec ts;
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (long)(ms % 1000) * 1000000;
+    while(nanosleep(&ts, &ts) != 0)
+    {
+    }
+#endif
+}
+
+/* Creates a short decaying noise burst that resembles a keystroke. */
+static ALuint CreateClick(void)
+{
+    static ALshort data[CLICK_LENGTH];
+    ALuint seed = 22222;
+    ALuint buffer;
+    ALsizei i;
+
+    for(i = 0;i < CLICK_LENGTH;i++)
+    {
+        float noise;
+        seed = seed*96314165 + 907633515;
+        noise = (float)((ALint)seed) / 2147483648.0f;
+        data[i] = (ALshort)(noise * 32767.0f * expf(-(float)i / (CLICK_LENGTH/6)));
+    }
+
+    buffer = 0;
+    alGenBuffers(1, &buffer);
+    alBufferData(buffer, AL_FORMAT_MONO16, data, sizeof(data), FREQUENCY);
+    return buffer;
+}
+
+/* Opens the wave file and leaves it at the start of the samples. Returns the
+ * size of the samples in bytes, or 0 on failure.
+ */
+static long OpenWave(const char *fname, FILE **file)
+{
+    unsigned char header[12];
+    FILE *f;
+
+    *file = NULL;
+    f = fopen(fname, "rb");
+    if(!f)
+        return 0;
+    if(fread(header, 1, 12, f) != 12 || memcmp(header, "RIFF", 4) != 0 ||
+       memcmp(header+8, "WAVE", 4) != 0)
+    {
+        fclose(f);
+        return 0;
+    }
+    while(fread(header, 1, 8, f) == 8)
+    {
+        long len = (long)(header[4] | (header[5]<<8) | (header[6]<<16) |
+                          ((unsigned long)header[7]<<24));
+        if(memcmp(header, "data", 4) == 0)
+        {
+            *file = f;
+            return len;
+        }
+        if(fseek(f, len, SEEK_CUR) != 0)
+            break;
+    }
+    fclose(f);
+    return 0;
+}
+
+static int RunCase(const char *path, const char *filter)
+{
+    const char *disabled_exts = NULL;
+    const char *filterconf = NULL;
+    char confname[64], wavename[64];
+    ALCdevice *device;
+    ALCcontext *context;
+    ALuint buffer, source;
+    double start, end;
+    long frames;
+    FILE *conf, *wave;
+    size_t i;
+
+    for(i = 0;i < sizeof(Paths)/sizeof(Paths[0]);i++)
+    {
+        if(strcmp(Paths[i].name, path) == 0)
+            disabled_exts = Paths[i].disabled_exts;
+    }
+    for(i = 0;i < sizeof(Filters)/sizeof(Filters[0]);i++)
+    {
+        if(strcmp(Filters[i].name, filter) == 0)
+            filterconf = Filters[i].config;
+    }
+    if(!disabled_exts || !filterconf)
+    {
+        fprintf(stderr, "Unknown path \"%s\" or filter \"%s\"\n", path, filter);
+        return 1;
+    }
+
+    /* The config is read once, on the first call into the library. */
+    snprintf(confname, sizeof(confname), "alstereobench-%s-%s.conf", path, filter);
+    snprintf(wavename, sizeof(wavename), "alstereobench-%s-%s.wav", path, filter);
+    conf = fopen(confname, "w");
+    if(!conf)
+    {
+        fprintf(stderr, "Failed to write %s\n", confname);
+        return 1;
+    }
+    fprintf(conf, "disable-cpu-exts = %s\n", disabled_exts);
+    fprintf(conf, "drivers = wave\n");
+    fprintf(conf, "channels = stereo\n");
+    fprintf(conf, "sample-type = float32\n");
+    fprintf(conf, "frequency = %d\n", FREQUENCY);
+    fprintf(conf, "period_size = %d\n", BLOCK_SIZE);
+    fprintf(conf, "hrtf = false\n");
+    fprintf(conf, "%s", filterconf);
+    fprintf(conf, "[wave]\n");
+    fprintf(conf, "file = %s\n", wavename);
+    fprintf(conf, "freewheel = true\n");
+    fclose(conf);
+
+#ifdef _WIN32
+    {
+        char envvar[96];
+        snprintf(envvar, sizeof(envvar), "ALSOFT_CONF=%s", confname);
+        _putenv(envvar);
+    }
+#else
+    setenv("ALSOFT_CONF", confname, 1);
+#endif
+
+    device = alcOpenDevice(NULL);
+    if(!device)
+    {
+        fprintf(stderr, "Failed to open the wave writer\n");
+        return 1;
+    }
+
+    start = get_nanoseconds();
+    context = alcCreateContext(device, NULL);
+    if(!context || alcMakeContextCurrent(context) == ALC_FALSE)
+    {
+        fprintf(stderr, "Failed to set up the context\n");
+        if(context)
+            alcDestroyContext(context);
+        alcCloseDevice(device);
+        return 1;
+    }
+
+    /* A click slightly off to the side, looping so there's always input. */
+    buffer = CreateClick();
+    source = 0;
+    alGenSources(1, &source);
+    alSourcei(source, AL_BUFFER, (ALint)buffer);
+    alSourcei(source, AL_LOOPING, AL_TRUE);
+    alSource3f(source, AL_POSITION, 0.5f, 0.0f, -1.0f);
+    alSourcePlay(source);
+    if(alGetError() != AL_NO_ERROR)
+    {
+        fprintf(stderr, "Failed to set up the source\n");
+        return 1;
+    }
+
+    sleep_ms(RUN_MILLISECONDS);
+
+    alDeleteSources(1, &source);
+    alDeleteBuffers(1, &buffer);
+    alcMakeContextCurrent(NULL);
+    alcDestroyContext(context);
+    alcCloseDevice(device);
+    end = get_nanoseconds();
+
+    frames = OpenWave(wavename, &wave) / (long)(2*sizeof(float));
+    if(wave)
+        fclose(wave);
+    if(frames < BLOCK_SIZE)
+    {
+        fprintf(stderr, "Nothing was written to %s\n", wavename);
+        return 1;
+    }
+
+    printf("%s,%s,%d,%ld,%.0f,%.1f\n", path, filter, BLOCK_SIZE, frames,
+           (end - start) / ((double)frames / BLOCK_SIZE), (end - start) / (double)frames);
+    fflush(stdout);
+
+    remove(confname);
+    return 0;
+}
+
+/* Skips the silence before the source started. Returns the first sample
+ * pair, or 0 if there's nothing but silence.
+ */
+static int SkipSilence(FILE *f, long *frames, float frame[2])
+{
+    while(*frames > 0)
+    {
+        if(fread(frame, sizeof(float), 2, f) != 2)
+            return 0;
+        (*frames)--;
+        if(frame[0] != 0.0f || frame[1] != 0.0f)
+            return 1;
+    }
+    return 0;
+}
+
+/* Compares the output a path saved against the scalar path's, and prints the
+ * largest difference found. Returns non-zero if it's out of tolerance.
+ */
+static int CheckOutput(const char *path, const char *filter)
+{
+    char refname[64], testname[64];
+    FILE *ref, *test;
+    long nref, ntest;
+    double maxdiff = 0.0, peak = 0.0;
+    size_t count = 0;
+    int ret = 1;
+
+    snprintf(refname, sizeof(refname), "alstereobench-%s-%s.wav", Paths[0].name, filter);
+    snprintf(testname, sizeof(testname), "alstereobench-%s-%s.wav", path, filter);
+    nref = OpenWave(refname, &ref) / (long)(2*sizeof(float));
+    ntest = OpenWave(testname, &test) / (long)(2*sizeof(float));
+    if(ref && test)
+    {
+        float a[2], b[2];
+        int ok;
+
+        ok = SkipSilence(ref, &nref, a) && SkipSilence(test, &ntest, b);
+        while(ok)
+        {
+            size_t i;
+            for(i = 0;i < 2;i++)
+            {
+                double diff = fabs((double)a[i] - (double)b[i]);
+                if(diff > maxdiff) maxdiff = diff;
+                if(fabs(a[i]) > peak) peak = fabs(a[i]);
+            }
+            count += 2;
+
+            if(nref == 0 || ntest == 0)
+                break;
+            nref--;
+            ntest--;
+            ok = fread(a, sizeof(float), 2, ref) == 2 && fread(b, sizeof(float), 2, test) == 2;
+        }
+
+        if(count == 0)
+            printf("# %s %s: no output to compare with %s\n", path, filter, Paths[0].name);
+        else
+        {
+            ret = (maxdiff > TOLERANCE*peak);
+            printf("# %s %s: max difference from %s is %g (peak %g, %zu samples): %s\n", path,
+                   filter, Paths[0].name, maxdiff, peak, count, ret ? "FAILED" : "ok");
+        }
+    }
+    else
+        printf("# %s %s: missing output to compare\n", path, filter);
+    if(ref) fclose(ref);
+    if(test) fclose(test);
+    return ret;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *path = NULL;
+    const char *filter = NULL;
+    int failed = 0;
+    size_t i, f;
+
+    for(i = 1;i < (size_t)argc;i++)
+    {
+        if(strcmp(argv[i], "-path") == 0 && i+1 < (size_t)argc)
+            path = argv[++i];
+        else if(strcmp(argv[i], "-filter") == 0 && i+1 < (size_t)argc)
+            filter = argv[++i];
+        else
+        {
+            fprintf(stderr, "Usage: %s [-path c|sse -filter uhj|bs2b]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if(path || filter)
+    {
+        if(!path || !filter)
+        {
+            fprintf(stderr, "Both -path and -filter are needed\n");
+            return 1;
+        }
+        return RunCase(path, filter);
+    }
+
+    printf("path,filter,block,frames,ns_per_block,ns_per_frame\n");
+    fflush(stdout);
+
+    for(f = 0;f < sizeof(Filters)/sizeof(Filters[0]);f++)
+    {
+        for(i = 0;i < sizeof(Paths)/sizeof(Paths[0]);i++)
+        {
+            char cmd[1024];
+            int ret;
+
+            snprintf(cmd, sizeof(cmd), "\"%s\" -path %s -filter %s", argv[0], Paths[i].name,
+                     Filters[f].name);
+            ret = system(cmd);
+            if(ret != 0)
+            {
+                fprintf(stderr, "Path %s with %s failed\n", Paths[i].name, Filters[f].name);
+                return 1;
+            }
+        }
+    }
+
+    for(f = 0;f < sizeof(Filters)/sizeof(Filters[0]);f++)
+    {
+        for(i = 1;i < sizeof(Paths)/sizeof(Paths[0]);i++)
+            failed |= CheckOutput(Paths[i].name, Filters[f].name);
+    }
+    for(f = 0;f < sizeof(Filters)/sizeof(Filters[0]);f++)
+    {
+        for(i = 0;i < sizeof(Paths)/sizeof(Paths[0]);i++)
+        {
+            char wavename[64];
+            snprintf(wavename, sizeof(wavename), "alstereobench-%s-%s.wav", Paths[i].name,
+                     Filters[f].name);
+            remove(wavename);
+        }
+    }
+
+    return failed;
+}
@@ -0,0 +1,485 @@
+/*
+ * OpenAL Reverb Benchmark
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* This file contains a benchmark of the reverb effect, fed by a stream of
+ * keystroke-like clicks and rendered through the loopback device at 48kHz.
+ * The time of the effect alone is the difference between rendering with the
+ * reverb loaded in the effect slot and with the slot empty.
+ *
+ * The CPU extensions used are picked once per process from the config, so
+ * when no path is given on the command line, the program runs itself once
+ * for every path. Each run also saves its output, and the outputs of the
+ * vectorized paths are then checked against the scalar one.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "AL/al.h"
+#include "AL/alc.h"
+#include "AL/alext.h"
+#include "AL/efx-presets.h"
+
+
+#define FREQUENCY       48000
+/* Not a multiple of the reverb's update size, so partial updates are covered
+ * too. */
+#define BLOCK_SIZE      1000
+#define WARMUP_BLOCKS   16
+#define MEASURED_BLOCKS 256
+#define CLICK_LENGTH    (FREQUENCY/20)
+
+/* The largest difference allowed between the output of a vectorized path and
+ * the scalar one, relative to the peak of the output. The reverb itself gives
+ * the same results either way, but the paths also pick different mixers for
+ * the source, which round differently.
+ */
+#define TOLERANCE       1e-5
+
+static LPALCLOOPBACKOPENDEVICESOFT alcLoopbackOpenDeviceSOFT;
+static LPALCRENDERSAMPLESSOFT alcRenderSamplesSOFT;
+
+static LPALGENEFFECTS alGenEffects;
+static LPALDELETEEFFECTS alDeleteEffects;
+static LPALEFFECTI alEffecti;
+static LPALEFFECTF alEffectf;
+static LPALEFFECTFV alEffectfv;
+static LPALGENAUXILIARYEFFECTSLOTS alGenAuxiliaryEffectSlots;
+static LPALDELETEAUXILIARYEFFECTSLOTS alDeleteAuxiliaryEffectSlots;
+static LPALAUXILIARYEFFECTSLOTI alAuxiliaryEffectSloti;
+
+static const struct {
+    const char *name;
+    const char *disabled_exts;
+} Paths[] = {
+    { "c",   "all" },
+    { "sse", "" },
+};
+
+static const struct {
+    const char *name;
+    ALenum type;
+} Effects[] = {
+    { "reverb",    AL_EFFECT_REVERB },
+    { "eaxreverb", AL_EFFECT_EAXREVERB },
+};
+
+
+static double get_nanoseconds(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart * 1000000000.0 / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec*1000000000.0 + (double)ts.tv_nsec;
+#endif
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double da = *(const double*)a;
+    double db = *(const double*)b;
+    return (da > db) - (da < db);
+}
+
+/* Creates a short decaying noise burst that resembles a keystroke. */
+static ALuint CreateClick(void)
+{
+    static ALshort data[CLICK_LENGTH];
+    ALuint seed = 22222;
+    ALuint buffer;
+    ALsizei i;
+
+    for(i = 0;i < CLICK_LENGTH;i++)
+    {
+        float noise;
+        seed = seed*96314165 + 907633515;
+        noise = (float)((ALint)seed) / 2147483648.0f;
+        data[i] = (ALshort)(noise * 32767.0f * expf(-(float)i / (CLICK_LENGTH/6)));
+    }
+
+    buffer = 0;
+    alGenBuffers(1, &buffer);
+    alBufferData(buffer, AL_FORMAT_MONO16, data, sizeof(data), FREQUENCY);
+    return buffer;
+}
+
+/* Loads a small room, about the size of a desk's surroundings. */
+static ALuint CreateReverb(ALenum type)
+{
+    const EFXEAXREVERBPROPERTIES reverb = EFX_REVERB_PRESET_ROOM;
+    ALuint effect = 0;
+
+    alGenEffects(1, &effect);
+    alEffecti(effect, AL_EFFECT_TYPE, type);
+    if(type == AL_EFFECT_EAXREVERB)
+    {
+        alEffectf(effect, AL_EAXREVERB_DENSITY, reverb.flDensity);
+        alEffectf(effect, AL_EAXREVERB_DIFFUSION, reverb.flDiffusion);
+        alEffectf(effect, AL_EAXREVERB_GAIN, reverb.flGain);
+        alEffectf(effect, AL_EAXREVERB_GAINHF, reverb.flGainHF);
+        alEffectf(effect, AL_EAXREVERB_GAINLF, reverb.flGainLF);
+        alEffectf(effect, AL_EAXREVERB_DECAY_TIME, reverb.flDecayTime);
+        alEffectf(effect, AL_EAXREVERB_DECAY_HFRATIO, reverb.flDecayHFRatio);
+        alEffectf(effect, AL_EAXREVERB_DECAY_LFRATIO, reverb.flDecayLFRatio);
+        alEffectf(effect, AL_EAXREVERB_REFLECTIONS_GAIN, reverb.flReflectionsGain);
+        alEffectf(effect, AL_EAXREVERB_REFLECTIONS_DELAY, reverb.flReflectionsDelay);
+        alEffectfv(effect, AL_EAXREVERB_REFLECTIONS_PAN, reverb.flReflectionsPan);
+        alEffectf(effect, AL_EAXREVERB_LATE_REVERB_GAIN, reverb.flLateReverbGain);
+        alEffectf(effect, AL_EAXREVERB_LATE_REVERB_DELAY, reverb.flLateReverbDelay);
+        alEffectfv(effect, AL_EAXREVERB_LATE_REVERB_PAN, reverb.flLateReverbPan);
+        alEffectf(effect, AL_EAXREVERB_ECHO_TIME, reverb.flEchoTime);
+        alEffectf(effect, AL_EAXREVERB_ECHO_DEPTH, reverb.flEchoDepth);
+        alEffectf(effect, AL_EAXREVERB_MODULATION_TIME, reverb.flModulationTime);
+        alEffectf(effect, AL_EAXREVERB_MODULATION_DEPTH, reverb.flModulationDepth);
+        alEffectf(effect, AL_EAXREVERB_AIR_ABSORPTION_GAINHF, reverb.flAirAbsorptionGainHF);
+        alEffectf(effect, AL_EAXREVERB_HFREFERENCE, reverb.flHFReference);
+        alEffectf(effect, AL_EAXREVERB_LFREFERENCE, reverb.flLFReference);
+        alEffectf(effect, AL_EAXREVERB_ROOM_ROLLOFF_FACTOR, reverb.flRoomRolloffFactor);
+        alEffecti(effect, AL_EAXREVERB_DECAY_HFLIMIT, reverb.iDecayHFLimit);
+    }
+    else
+    {
+        alEffectf(effect, AL_REVERB_DENSITY, reverb.flDensity);
+        alEffectf(effect, AL_REVERB_DIFFUSION, reverb.flDiffusion);
+        alEffectf(effect, AL_REVERB_GAIN, reverb.flGain);
+        alEffectf(effect, AL_REVERB_GAINHF, reverb.flGainHF);
+        alEffectf(effect, AL_REVERB_DECAY_TIME, reverb.flDecayTime);
+        alEffectf(effect, AL_REVERB_DECAY_HFRATIO, reverb.flDecayHFRatio);
+        alEffectf(effect, AL_REVERB_REFLECTIONS_GAIN, reverb.flReflectionsGain);
+        alEffectf(effect, AL_REVERB_REFLECTIONS_DELAY, reverb.flReflectionsDelay);
+        alEffectf(effect, AL_REVERB_LATE_REVERB_GAIN, reverb.flLateReverbGain);
+        alEffectf(effect, AL_REVERB_LATE_REVERB_DELAY, reverb.flLateReverbDelay);
+        alEffectf(effect, AL_REVERB_AIR_ABSORPTION_GAINHF, reverb.flAirAbsorptionGainHF);
+        alEffectf(effect, AL_REVERB_ROOM_ROLLOFF_FACTOR, reverb.flRoomRolloffFactor);
+        alEffecti(effect, AL_REVERB_DECAY_HFLIMIT, reverb.iDecayHFLimit);
+    }
+    return effect;
+}
+
+/* FNV-1a over the bits of the rendered samples, to compare output between
+ * runs.
+ */
+static unsigned int HashSamples(unsigned int hash, const float *samples, size_t count)
+{
+    const unsigned char *bytes = (const unsigned char*)samples;
+    size_t i;
+
+    for(i = 0;i < count*sizeof(float);i++)
+    {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/* Renders the measured blocks, with the effect slot holding the given effect
+ * (or nothing), and returns the median time of a block. The output is saved
+ * to the file, if one is given.
+ */
+static double RenderBlocks(ALCdevice *device, ALuint slot, ALuint effect, FILE *dump, unsigned int *hash)
+{
+    static float output[BLOCK_SIZE*2];
+    static double timings[MEASURED_BLOCKS];
+    ALsizei b;
+
+    alAuxiliaryEffectSloti(slot, AL_EFFECTSLOT_EFFECT, (ALint)effect);
+    for(b = 0;b < WARMUP_BLOCKS+MEASURED_BLOCKS;b++)
+    {
+        double start, end;
+
+        start = get_nanoseconds();
+        alcRenderSamplesSOFT(device, output, BLOCK_SIZE);
+        end = get_nanoseconds();
+
+        if(b >= WARMUP_BLOCKS)
+            timings[b-WARMUP_BLOCKS] = end - start;
+        if(hash)
+            *hash = HashSamples(*hash, output, BLOCK_SIZE*2);
+        if(dump)
+            fwrite(output, sizeof(float), BLOCK_SIZE*2, dump);
+    }
+
+    qsort(timings, MEASURED_BLOCKS, sizeof(timings[0]), compare_doubles);
+    return timings[MEASURED_BLOCKS/2];
+}
+
+static int RunCase(const char *path, const char *effectname, ALenum type)
+{
+    ALCint attrs[] = {
+        ALC_FORMAT_CHANNELS_SOFT, ALC_STEREO_SOFT,
+        ALC_FORMAT_TYPE_SOFT, ALC_FLOAT_SOFT,
+        ALC_FREQUENCY, FREQUENCY,
+        0
+    };
+    ALCdevice *device;
+    ALCcontext *context;
+    ALuint buffer, source, slot, effect;
+    unsigned int hash = 2166136261u;
+    double with_effect, without_effect;
+    char dumpname[64];
+    FILE *dump;
+
+    device = alcLoopbackOpenDeviceSOFT(NULL);
+    if(!device)
+    {
+        fprintf(stderr, "Failed to open loopback device\n");
+        return 1;
+    }
+
+    context = alcCreateContext(device, attrs);
+    if(!context || alcMakeContextCurrent(context) == ALC_FALSE)
+    {
+        fprintf(stderr, "Failed to set up loopback context\n");
+        if(context)
+            alcDestroyContext(context);
+        alcCloseDevice(device);
+        return 1;
+    }
+
+#define LOAD_PROC(x)  ((x) = alGetProcAddress(#x))
+    LOAD_PROC(alGenEffects);
+    LOAD_PROC(alDeleteEffects);
+    LOAD_PROC(alEffecti);
+    LOAD_PROC(alEffectf);
+    LOAD_PROC(alEffectfv);
+    LOAD_PROC(alGenAuxiliaryEffectSlots);
+    LOAD_PROC(alDeleteAuxiliaryEffectSlots);
+    LOAD_PROC(alAuxiliaryEffectSloti);
+#undef LOAD_PROC
+
+    buffer = CreateClick();
+    effect = CreateReverb(type);
+    slot = 0;
+    alGenAuxiliaryEffectSlots(1, &slot);
+
+    /* A click slightly off to the side, looping so there's always input. */
+    source = 0;
+    alGenSources(1, &source);
+    alSourcei(source, AL_BUFFER, buffer);
+    alSourcei(source, AL_LOOPING, AL_TRUE);
+    alSource3f(source, AL_POSITION, 0.5f, 0.0f, -1.0f);
+    alSource3i(source, AL_AUXILIARY_SEND_FILTER, (ALint)slot, 0, AL_FILTER_NULL);
+    alSourcePlay(source);
+    if(alGetError() != AL_NO_ERROR)
+    {
+        fprintf(stderr, "Failed to set up the %s effect\n", effectname);
+        return 1;
+    }
+
+    snprintf(dumpname, sizeof(dumpname), "alverbbench-%s-%s.raw", path, effectname);
+    dump = fopen(dumpname, "wb");
+    if(!dump)
+    {
+        fprintf(stderr, "Failed to write %s\n", dumpname);
+        return 1;
+    }
+    with_effect = RenderBlocks(device, slot, effect, dump, &hash);
+    fclose(dump);
+    without_effect = RenderBlocks(device, slot, 0, NULL, NULL);
+
+    printf("%s,%s,%d,%.0f,%.0f,%.1f,%08x\n", path, effectname, BLOCK_SIZE, with_effect,
+           with_effect - without_effect, (with_effect - without_effect) / BLOCK_SIZE, hash);
+    fflush(stdout);
+
+    alDeleteSources(1, &source);
+    alDeleteAuxiliaryEffectSlots(1, &slot);
+    alDeleteEffects(1, &effect);
+    alDeleteBuffers(1, &buffer);
+
+    alcMakeContextCurrent(NULL);
+    alcDestroyContext(context);
+    alcCloseDevice(device);
+    return 0;
+}
+
+static int RunPath(const char *path)
+{
+    const char *disabled_exts = NULL;
+    char confname[64];
+    FILE *conf;
+    size_t i;
+
+    for(i = 0;i < sizeof(Paths)/sizeof(Paths[0]);i++)
+    {
+        if(strcmp(Paths[i].name, path) == 0)
+            disabled_exts = Paths[i].disabled_exts;
+    }
+    if(!disabled_exts)
+    {
+        fprintf(stderr, "Unknown path \"%s\"\n", path);
+        return 1;
+    }
+
+    /* The config is read once, on the first call into the library. */
+    snprintf(confname, sizeof(confname), "alverbbench-%s.conf", path);
+    conf = fopen(confname, "w");
+    if(!conf)
+    {
+        fprintf(stderr, "Failed to write %s\n", confname);
+        return 1;
+    }
+    fprintf(conf, "disable-cpu-exts = %s\n", disabled_exts);
+    fclose(conf);
+
+#ifdef _WIN32
+    {
+        char envvar[96];
+        snprintf(envvar, sizeof(envvar), "ALSOFT_CONF=%s", confname);
+        _putenv(envvar);
+    }
+#else
+    setenv("ALSOFT_CONF", confname, 1);
+#endif
+
+    if(!alcIsExtensionPresent(NULL, "ALC_SOFT_loopback"))
+    {
+        fprintf(stderr, "Missing ALC_SOFT_loopback\n");
+        return 1;
+    }
+    alcLoopbackOpenDeviceSOFT = (LPALCLOOPBACKOPENDEVICESOFT)alcGetProcAddress(NULL, "alcLoopbackOpenDeviceSOFT");
+    alcRenderSamplesSOFT = (LPALCRENDERSAMPLESSOFT)alcGetProcAddress(NULL, "alcRenderSamplesSOFT");
+
+    for(i = 0;i < sizeof(Effects)/sizeof(Effects[0]);i++)
+    {
+        if(RunCase(path, Effects[i].name, Effects[i].type) != 0)
+            return 1;
+    }
+
+    remove(confname);
+    return 0;
+}
+
+/* Compares the output a path saved against the scalar path's, and prints the
+ * largest difference found. Returns non-zero if it's out of tolerance.
+ */
+static int CheckOutput(const char *path, const char *effectname)
+{
+    char refname[64], testname[64];
+    FILE *ref, *test;
+    double maxdiff = 0.0, peak = 0.0;
+    size_t count = 0;
+    int ret = 1;
+
+    snprintf(refname, sizeof(refname), "alverbbench-%s-%s.raw", Paths[0].name, effectname);
+    snprintf(testname, sizeof(testname), "alverbbench-%s-%s.raw", path, effectname);
+    ref = fopen(refname, "rb");
+    test = fopen(testname, "rb");
+    if(ref && test)
+    {
+        float a[BLOCK_SIZE*2], b[BLOCK_SIZE*2];
+        size_t na, nb, i;
+
+        do {
+            na = fread(a, sizeof(float), BLOCK_SIZE*2, ref);
+            nb = fread(b, sizeof(float), BLOCK_SIZE*2, test);
+            for(i = 0;i < na && i < nb;i++)
+            {
+                double diff = fabs((double)a[i] - (double)b[i]);
+                if(diff > maxdiff) maxdiff = diff;
+                if(fabs(a[i]) > peak) peak = fabs(a[i]);
+            }
+            count += (na < nb) ? na : nb;
+        } while(na == BLOCK_SIZE*2 && nb == BLOCK_SIZE*2);
+
+        if(na != nb || count == 0)
+            printf("# %s %s: output length differs from %s\n", path, effectname, Paths[0].name);
+        else
+        {
+            ret = (maxdiff > TOLERANCE*peak);
+            printf("# %s %s: max difference from %s is %g (peak %g, %zu samples): %s\n", path,
+                   effectname, Paths[0].name, maxdiff, peak, count, ret ? "FAILED" : "ok");
+        }
+    }
+    else
+        printf("# %s %s: missing output to compare\n", path, effectname);
+    if(ref) fclose(ref);
+    if(test) fclose(test);
+    return ret;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *path = NULL;
+    int failed = 0;
+    size_t i, e;
+
+    for(i = 1;i < (size_t)argc;i++)
+    {
+        if(strcmp(argv[i], "-path") == 0 && i+1 < (size_t)argc)
+            path = argv[++i];
+        else
+        {
+            fprintf(stderr, "Usage: %s [-path c|sse]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if(path)
+        return RunPath(path);
+
+    printf("path,effect,block,ns_per_block_p50,effect_ns_per_block_p50,effect_ns_per_frame,checksum\n");
+    fflush(stdout);
+
+    for(i = 0;i < sizeof(Paths)/sizeof(Paths[0]);i++)
+    {
+        char cmd[1024];
+        int ret;
+
+        snprintf(cmd, sizeof(cmd), "\"%s\" -path %s", argv[0], Paths[i].name);
+        ret = system(cmd);
+        if(ret != 0)
+        {
+            fprintf(stderr, "Path %s failed\n", Paths[i].name);
+            return 1;
+        }
+    }
+
+    for(e = 0;e < sizeof(Effects)/sizeof(Effects[0]);e++)
+    {
+        for(i = 1;i < sizeof(Paths)/sizeof(Paths[0]);i++)
+            failed |= CheckOutput(Paths[i].name, Effects[e].name);
+    }
+    for(e = 0;e < sizeof(Effects)/sizeof(Effects[0]);e++)
+    {
+        for(i = 0;i < sizeof(Paths)/sizeof(Paths[0]);i++)
+        {
+            char dumpname[64];
+            snprintf(dumpname, sizeof(dumpname), "alverbbench-%s-%s.raw", Paths[i].name, Effects[e].name);
+            remove(dumpname);
+        }
+    }
+
+    return failed;
+}
@@ -436,6 +436,84 @@ ALC_API ALCboolean ALC_APIENTRY alcResetDeviceSOFT(ALCdevice *device, const ALCi
 #define AL_GAIN_LIMIT_SOFT                       0x200E
 #endif
 
+#ifndef AL_SOFTX_static_emitters
+#define AL_SOFTX_static_emitters 1
+#define AL_EMITTER_SOFTX                         0x1290
+typedef void (AL_APIENTRY*LPALGENEMITTERSSOFTX)(ALsizei n, const ALfloat *positions, ALuint *emitters);
+typedef void (AL_APIENTRY*LPALDELETEEMITTERSSOFTX)(ALsizei n, const ALuint *emitters);
+typedef ALboolean (AL_APIENTRY*LPALISEMITTERSOFTX)(ALuint emitter);
+#ifdef AL_ALEXT_PROTOTYPES
+AL_API void AL_APIENTRY alGenEmittersSOFTX(ALsizei n, const ALfloat *positions, ALuint *emitters);
+AL_API void AL_APIENTRY alDeleteEmittersSOFTX(ALsizei n, const ALuint *emitters);
+AL_API ALboolean AL_APIENTRY alIsEmitterSOFTX(ALuint emitter);
+#endif
+#endif
+
+#ifndef AL_SOFTX_allocation_stats
+#define AL_SOFTX_allocation_stats 1
+#define AL_POOLED_ALLOCATIONS_SOFTX              0x1291
+#define AL_POOL_BLOCKS_SOFTX                     0x1292
+#define AL_SYSTEM_ALLOCATIONS_SOFTX              0x1293
+typedef ALint64SOFT (AL_APIENTRY*LPALGETINTEGER64SOFT)(ALenum pname);
+typedef void (AL_APIENTRY*LPALGETINTEGER64VSOFT)(ALenum pname, ALint64SOFT *values);
+#ifdef AL_ALEXT_PROTOTYPES
+AL_API ALint64SOFT AL_APIENTRY alGetInteger64SOFT(ALenum pname);
+AL_API void AL_APIENTRY alGetInteger64vSOFT(ALenum pname, ALint64SOFT *values);
+#endif
+#endif
+
+#ifndef ALC_SOFTX_periods
+#define ALC_SOFTX_periods 1
+#define ALC_PERIOD_SIZE_SOFTX                    0x1294
+#define ALC_PERIODS_SOFTX                        0x1295
+#define ALC_UNDERRUNS_SOFTX                      0x1296
+#define ALC_OUTPUT_DELAY_SOFTX                   0x1297
+#endif
+
+#ifndef AL_SOFTX_voice_stats
+#define AL_SOFTX_voice_stats 1
+#define AL_VOICES_VISITED_SOFTX                  0x129A
+#define AL_VOICES_SKIPPED_SOFTX                  0x129B
+#define AL_VOICE_UPDATES_SOFTX                   0x129C
+#define AL_VOICE_UPDATES_CULLED_SOFTX            0x129D
+#endif
+
+#ifndef ALC_SOFTX_panning_cache
+#define ALC_SOFTX_panning_cache 1
+#define ALC_PANNING_CACHE_HITS_SOFTX             0x1298
+#define ALC_PANNING_CACHE_MISSES_SOFTX           0x1299
+#endif
+
+#ifndef ALC_SOFTX_thread_sched
+#define ALC_SOFTX_thread_sched 1
+#define ALC_MIXER_THREAD_SCHED_SOFTX             0x129E
+#define ALC_MIXER_THREAD_PRIORITY_SOFTX          0x129F
+#define ALC_SCHED_OTHER_SOFTX                    0x0000
+#define ALC_SCHED_RR_SOFTX                       0x0001
+#define ALC_SCHED_FIFO_SOFTX                     0x0002
+#endif
+
+#ifndef ALC_SOFT_device_clock
+#define ALC_SOFT_device_clock 1
+typedef int64_t ALCint64SOFT;
+typedef uint64_t ALCuint64SOFT;
+#define ALC_DEVICE_CLOCK_SOFT                    0x1600
+#define ALC_DEVICE_LATENCY_SOFT                  0x1601
+#define ALC_DEVICE_CLOCK_LATENCY_SOFT            0x1602
+typedef void (ALC_APIENTRY*LPALCGETINTEGER64VSOFT)(ALCdevice *device, ALCenum pname, ALsizei size, ALCint64SOFT *values);
+#ifdef AL_ALEXT_PROTOTYPES
+ALC_API void ALC_APIENTRY alcGetInteger64vSOFT(ALCdevice *device, ALCenum pname, ALsizei size, ALCint64SOFT *values);
+#endif
+#endif
+
+#ifndef ALC_SOFTX_mix_stamps
+#define ALC_SOFTX_mix_stamps 1
+/* Queried with alcGetInteger64vSOFT. Gives the sequence number of the first
+ * update returned and how many follow, then the time-stamp counter readings
+ * at the start and end of each of the newest updates, oldest first. */
+#define ALC_MIX_STAMPS_SOFTX                     0x12A0
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -3,6 +3,8 @@
 
 #include <stddef.h>
 
+#include "atomic.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -11,6 +13,45 @@ void *al_malloc(size_t alignment, size_t size);
 void *al_calloc(size_t alignment, size_t size);
 void al_free(void *ptr);
 
+/* Number of times al_malloc went to the system allocator. */
+size_t al_malloc_count(void);
+
+
+/* Objects are aligned to, and padded out to, a multiple of this. */
+#define AL_SLAB_ALIGN 64
+
+/* A pool of same-sized objects. Objects are carved out of blocks, and freed
+ * objects are kept for reuse instead of going back to the system, so once the
+ * pool has grown to the peak number of objects in use, allocating and freeing
+ * doesn't touch the system allocator. Blocks are only released by
+ * al_slab_deinit.
+ */
+typedef struct al_slab {
+    size_t ObjSize;
+    size_t ObjCount;
+
+    /* Free objects and allocated blocks, each linked through their first
+     * pointer. Guarded by Lock.
+     */
+    void *FreeList;
+    void *Blocks;
+    ATOMIC_FLAG Lock;
+
+    /* Objects handed out, and blocks allocated. */
+    ATOMIC(size_t) AllocCount;
+    ATOMIC(size_t) BlockCount;
+} al_slab;
+
+/* Sets up a pool of objects of the given size, allocated count at a time. */
+void al_slab_init(al_slab *slab, size_t size, size_t count);
+/* Releases every block, including any objects still in use. */
+void al_slab_deinit(al_slab *slab);
+/* Returns a zeroed object, or NULL if a new block was needed and couldn't be
+ * allocated.
+ */
+void *al_slab_alloc(al_slab *slab);
+void al_slab_free(al_slab *slab, void *ptr);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,76 @@
+#ifndef AL_SHM_H
+#define AL_SHM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Layout of the shared memory object written by the "shm" backend.
+ *
+ * The mapping starts with an ALshmHeader, padded to ALSHM_HEADER_SIZE bytes,
+ * followed by a ring laid out like struct ll_ringbuffer in Alc/alcRing.c. The
+ * mixer renders straight into the ring and the consumer reads straight out of
+ * it, so samples are never copied in between. One ring element is one frame,
+ * with the channels interleaved in the usual WAVEFORMATEXTENSIBLE order.
+ *
+ * There is a single producer (the mixer) and a single consumer. The write and
+ * read positions are not monotonic counters: the ring code reduces them to
+ * the ring size as it goes, so never compare them directly. Mask each with
+ * size_mask to get an element index, and take (write - read) & size_mask as
+ * the number of queued frames, which is why the ring holds at most size-1 of
+ * them. Load the other side's position with acquire semantics, and store your
+ * own with release semantics after being done with the frames.
+ */
+
+#define ALSHM_MAGIC   0x4d534c41u /* "ALSM" */
+#define ALSHM_VERSION 1
+
+#define ALSHM_HEADER_SIZE 64
+
+/* Values of ALshmHeader::state. */
+#define ALSHM_STOPPED 0
+#define ALSHM_RUNNING 1
+/* The device went away, or the object is being replaced for a new format.
+ * Unmap it and open it by name again. */
+#define ALSHM_CLOSED  2
+
+typedef struct ALshmHeader {
+    /* Written last when the object is created, so a consumer that sees the
+     * magic value sees the rest of the header and the ring as well. */
+    uint32_t magic;
+    uint32_t version;
+    /* Size of the whole mapping, in bytes. */
+    uint32_t map_size;
+
+    uint32_t frequency;
+    uint32_t channels;
+    /* 8 for unsigned bytes, 16 or 32 for signed integers or, if is_float is
+     * set, 32 for floats. */
+    uint32_t sample_bits;
+    uint32_t is_float;
+    uint32_t frame_size;
+
+    /* The mixer renders update_size frames at a time and keeps no more than
+     * num_updates of them queued. */
+    uint32_t update_size;
+    uint32_t num_updates;
+
+    volatile uint32_t state;
+} ALshmHeader;
+
+/* Mirrors the start of struct ll_ringbuffer. */
+typedef struct ALshmRing {
+    size_t write_ptr;
+    size_t read_ptr;
+    size_t size;
+    size_t size_mask;
+    size_t elem_size;
+    int mlocked;
+} ALshmRing;
+
+/* Offset of the frames from the start of the ring. */
+#define ALSHM_RING_DATA_OFFSET ((sizeof(ALshmRing)+15) & ~(size_t)15)
+
+#define ALSHM_RING(header) ((ALshmRing*)((char*)(header) + ALSHM_HEADER_SIZE))
+#define ALSHM_RING_DATA(ring) ((char*)(ring) + ALSHM_RING_DATA_OFFSET)
+
+#endif /* AL_SHM_H */
@@ -0,0 +1,110 @@
+#ifndef AL_HANDLETABLE_H
+#define AL_HANDLETABLE_H
+
+#include <stddef.h>
+
+#include "AL/al.h"
+#include "atomic.h"
+#include "rwlock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A handle is a slot index (plus one) in the low bits, and the generation of
+ * the slot in the high bits. The generation changes every time a slot is
+ * reused, so stale handles don't find the new entry. It starts at 1, keeping
+ * handles clear of the small IDs handed out by the thunk.
+ */
+#define HANDLETABLE_INDEX_BITS  20
+#define HANDLETABLE_INDEX_MASK  ((1u<<HANDLETABLE_INDEX_BITS)-1)
+#define HANDLETABLE_GEN_MASK    ((1u<<(32-HANDLETABLE_INDEX_BITS))-1)
+
+/* Slots are allocated in chunks that never move, so lookups can index them
+ * without holding a lock while the table grows.
+ */
+#define HANDLETABLE_CHUNK_BITS  10
+#define HANDLETABLE_CHUNK_SIZE  (1<<HANDLETABLE_CHUNK_BITS)
+#define HANDLETABLE_MAX_CHUNKS  (1<<(HANDLETABLE_INDEX_BITS-HANDLETABLE_CHUNK_BITS))
+
+typedef struct HandleTableSlot {
+    /* Handle of the current entry, or 0 if the slot is free. */
+    ATOMIC(ALuint) handle;
+    ATOMIC(ALvoid*) value;
+
+    /* Only accessed by writers. */
+    ALuint gen;
+    ALuint next_free;
+} HandleTableSlot;
+
+typedef struct HandleTable {
+    ATOMIC(HandleTableSlot*) chunks[HANDLETABLE_MAX_CHUNKS];
+    ATOMIC(ALsizei) capacity;
+
+    ALsizei size;
+    ALsizei limit;
+
+    /* Free slots are reused in the order they were freed (as index+1, 0 when
+     * empty), to go as long as possible before a generation repeats.
+     */
+    ALuint free_head;
+    ALuint free_tail;
+
+    /* Serializes insertions and removals. Lookups don't take it. */
+    RWLock lock;
+} HandleTable;
+
+void InitHandleTable(HandleTable *table, ALsizei limit);
+void ResetHandleTable(HandleTable *table);
+ALenum InsertHandleTableEntry(HandleTable *table, ALvoid *value, ALuint *handle);
+ALvoid *RemoveHandleTableKeyNoLock(HandleTable *table, ALuint handle);
+
+/* Wait-free. The entry is read between two checks of the slot's handle, so a
+ * concurrent removal (and reuse of the slot) returns either the old value or
+ * NULL, never the new one.
+ */
+inline ALvoid *LookupHandleTableKey(HandleTable *table, ALuint handle)
+{
+    ALuint idx = (handle&HANDLETABLE_INDEX_MASK) - 1;
+    HandleTableSlot *slot;
+    ALvoid *value;
+
+    if(idx >= (ALuint)ATOMIC_LOAD(&table->capacity, almemory_order_acquire))
+        return NULL;
+    slot = ATOMIC_LOAD(&table->chunks[idx>>HANDLETABLE_CHUNK_BITS], almemory_order_acquire);
+    slot += idx&(HANDLETABLE_CHUNK_SIZE-1);
+
+    if(ATOMIC_LOAD_SEQ(&slot->handle) != handle)
+        return NULL;
+    value = ATOMIC_LOAD(&slot->value, almemory_order_acquire);
+    if(ATOMIC_LOAD_SEQ(&slot->handle) != handle)
+        return NULL;
+    return value;
+}
+
+/* Returns the value in the given slot, or NULL if it's free. For iterating
+ * over the entries, from 0 up to the capacity.
+ */
+inline ALvoid *GetHandleTableSlotValue(HandleTable *table, ALsizei pos)
+{
+    HandleTableSlot *slot = ATOMIC_LOAD(&table->chunks[pos>>HANDLETABLE_CHUNK_BITS],
+                                        almemory_order_acquire);
+    slot += pos&(HANDLETABLE_CHUNK_SIZE-1);
+    if(ATOMIC_LOAD(&slot->handle, almemory_order_acquire) == 0)
+        return NULL;
+    return ATOMIC_LOAD(&slot->value, almemory_order_acquire);
+}
+
+inline ALsizei GetHandleTableCapacity(HandleTable *table)
+{ return ATOMIC_LOAD(&table->capacity, almemory_order_acquire); }
+
+inline void LockHandleTableWrite(HandleTable *table)
+{ WriteLock(&table->lock); }
+inline void UnlockHandleTableWrite(HandleTable *table)
+{ WriteUnlock(&table->lock); }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AL_HANDLETABLE_H */
@@ -15,6 +15,13 @@ enum {
     althrd_busy
 };
 
+/* Scheduling classes for althrd_setsched. */
+enum {
+    althrd_sched_other = 0,
+    althrd_sched_rr,
+    althrd_sched_fifo
+};
+
 enum {
     almtx_plain = 0,
     almtx_recursive = 1,
@@ -211,6 +218,9 @@ int althrd_create(althrd_t *thr, althrd_start_t func, void *arg);
 int althrd_detach(althrd_t thr);
 int althrd_join(althrd_t thr, int *res);
 void althrd_setname(althrd_t thr, const char *name);
+int althrd_setsched(althrd_t thr, int sched, int priority);
+int althrd_getsched(althrd_t thr, int *sched, int *priority);
+int althrd_setaffinity(althrd_t thr, unsigned long long cpumask);
 
 int almtx_init(almtx_t *mtx, int type);
 void almtx_destroy(almtx_t *mtx);
@@ -69,6 +69,13 @@
 #ifdef HAVE_STRINGS_H
 #include <strings.h>
 #endif
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+#endif
 
 // Rely (if naively) on OpenAL's header for the types used for serialization.
 #include "AL/al.h"
@@ -164,6 +171,13 @@
 // for vectorized convolution.
 #define MOD_TRUNCSIZE                (8)
 
+// The limits to the number of worker threads.
+#define MIN_THREADS                  (1)
+#define MAX_THREADS                  (64)
+
+// The maximum number of stages listed in the timing report.
+#define MAX_STAGES                   (16)
+
 // The defaults for the command line options.
 #define DEFAULT_EQUALIZE             (1)
 #define DEFAULT_SURFACE              (1)
@@ -194,6 +208,22 @@
 // response protocol 01.
 #define MHR_FORMAT                   ("MinPHR01")
 
+// The older MHR format, which can still be converted.
+#define MHR_FORMAT_00                ("MinPHR00")
+
+// The precompiled MHR format.  The marker is followed by nine 32-bit fields
+// (rate, HRIR size, elevation count, HRIR count, the offsets of the azimuth
+// count, elevation offset, coefficient and delay tables, and the file size),
+// and every table starts on a multiple of the alignment.  OpenAL Soft maps
+// these files into memory and uses the tables in place.
+#define MHR_MAPPED_FORMAT            ("MinPHRM1")
+#define MHR_MAPPED_ALIGNMENT         (64)
+
+// The limits for the HRIR size of an MHR data set being converted.
+#define MIN_MHR_IR_SIZE              (8)
+#define MAX_MHR_IR_SIZE              (128)
+#define MOD_MHR_IR_SIZE              (8)
+
 // Byte order for the serialization routines.
 typedef enum ByteOrderT {
     BO_NONE,
@@ -227,7 +257,8 @@ typedef enum HeadModelT {
 // Desired output format from the command line.
 typedef enum OutputFormatT {
     OF_NONE,
-    OF_MHR   // OpenAL Soft MHR data set file.
+    OF_MHR,        // OpenAL Soft MHR data set file.
+    OF_MHR_MAPPED  // Precompiled MHR data set, converted from an MHR file.
 } OutputFormatT;
 
 // Unsigned integer type.
@@ -287,6 +318,28 @@ typedef struct ResamplerT {
     double *mF;
 } ResamplerT;
 
+// A routine run by the worker threads on a range of HRIR indices.
+typedef void (*WorkerProcT)(void *arg, const uint start, const uint end);
+
+// The range of HRIR indices handled by one worker thread.
+typedef struct WorkerT {
+    WorkerProcT mProc;
+    void *mArg;
+    uint mStart, mEnd;
+} WorkerT;
+
+// The wall-clock time spent in each processing stage.
+typedef struct StageTimerT {
+    uint mCount;
+    const char *mNames[MAX_STAGES];
+    double mSeconds[MAX_STAGES];
+    double mMark;
+} StageTimerT;
+
+
+// The number of worker threads used by the per-HRIR processing stages.
+static uint NumThreads = 1;
+
 
 /*****************************
  *** Token reader routines ***
@@ -778,6 +831,143 @@ static int StrSubst(const char *in, const char *pat, const char *rep, const size
 }
 
 
+/*****************************************
+ *** Worker thread and timing routines ***
+ *****************************************/
+
+// Gets the number of processors available, to default the thread count to.
+static uint GetProcessorCount(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (uint)info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (count > 0) ? (uint)count : 1;
+#endif
+}
+
+// Gets a monotonic wall-clock time in seconds.
+static double GetTimeSeconds(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + (ts.tv_nsec / 1000000000.0);
+#endif
+}
+
+#ifdef _WIN32
+static DWORD WINAPI WorkerThread(LPVOID arg)
+#else
+static void *WorkerThread(void *arg)
+#endif
+{
+    WorkerT *worker = (WorkerT*)arg;
+    worker->mProc(worker->mArg, worker->mStart, worker->mEnd);
+    return 0;
+}
+
+/* Splits the given range of HRIR indices into one contiguous range per
+ * worker thread and runs the routine on each.  The calling thread handles
+ * the first range itself, and any range a thread couldn't be started for.
+ * Each HRIR must be independent of the others, and the routine must keep
+ * any scratch memory local to the call.
+ */
+static void RunWorkers(const uint start, const uint end, WorkerProcT proc, void *arg)
+{
+#ifdef _WIN32
+    HANDLE threads[MAX_THREADS];
+#else
+    pthread_t threads[MAX_THREADS];
+#endif
+    int started[MAX_THREADS];
+    WorkerT workers[MAX_THREADS];
+    uint count, i;
+
+    count = NumThreads;
+    if(count > end - start)
+        count = end - start;
+    if(count <= 1)
+    {
+        if(start < end)
+            proc(arg, start, end);
+        return;
+    }
+    for(i = 0;i < count;i++)
+    {
+        workers[i].mProc = proc;
+        workers[i].mArg = arg;
+        workers[i].mStart = start + (uint)((uint64)(end - start) * i / count);
+        workers[i].mEnd = start + (uint)((uint64)(end - start) * (i + 1) / count);
+    }
+    for(i = 1;i < count;i++)
+    {
+#ifdef _WIN32
+        threads[i] = CreateThread(NULL, 0, WorkerThread, &workers[i], 0, NULL);
+        started[i] = (threads[i] != NULL);
+#else
+        started[i] = (pthread_create(&threads[i], NULL, WorkerThread, &workers[i]) == 0);
+#endif
+        if(!started[i])
+            WorkerThread(&workers[i]);
+    }
+    WorkerThread(&workers[0]);
+    for(i = 1;i < count;i++)
+    {
+        if(!started[i])
+            continue;
+#ifdef _WIN32
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+#else
+        pthread_join(threads[i], NULL);
+#endif
+    }
+}
+
+// Starts timing the first processing stage.
+static void StageTimerStart(StageTimerT *timer)
+{
+    timer->mCount = 0;
+    timer->mMark = GetTimeSeconds();
+}
+
+// Records the time spent since the last stage ended as the named stage.
+static void StageTimerMark(StageTimerT *timer, const char *name)
+{
+    double now = GetTimeSeconds();
+    if(timer->mCount < MAX_STAGES)
+    {
+        timer->mNames[timer->mCount] = name;
+        timer->mSeconds[timer->mCount] = now - timer->mMark;
+        timer->mCount++;
+    }
+    timer->mMark = now;
+}
+
+// Prints the time spent in each recorded stage, and in total.
+static void StageTimerReport(const StageTimerT *timer, FILE *ofile)
+{
+    double total = 0.0;
+    uint i;
+
+    fprintf(ofile, "Stage timing (%u thread%s):\n", NumThreads, (NumThreads == 1) ? "" : "s");
+    for(i = 0;i < timer->mCount;i++)
+    {
+        fprintf(ofile, "  %-36s %9.3f s\n", timer->mNames[i], timer->mSeconds[i]);
+        total += timer->mSeconds[i];
+    }
+    fprintf(ofile, "  %-36s %9.3f s\n", "Total", total);
+}
+
+
 /*********************
  *** Math routines ***
  *********************/
@@ -871,10 +1061,46 @@ static void ComplexExp(const double inR, const double inI, double *outR, double
 }
 
 /* Fast Fourier transform routines.  The number of points must be a power of
- * two.  In-place operation is possible only if both the real and imaginary
- * parts are in-place together.
+ * two, no larger than the size the twiddle table was set up for.  In-place
+ * operation is possible only if both the real and imaginary parts are in-place
+ * together.
  */
 
+/* The twiddle factors, cos(2 pi k / n) and -sin(2 pi k / n), for the size
+ * given to FftSetup.  Smaller transforms step through the table.  It's only
+ * written by FftSetup and FftCleanup, so the transforms can run on several
+ * threads at once.
+ */
+static uint FftTableSize = 0;
+static double *FftTableR = NULL;
+static double *FftTableI = NULL;
+
+// Frees the twiddle table.
+static void FftCleanup(void)
+{
+    DestroyArray(FftTableI);
+    DestroyArray(FftTableR);
+    FftTableI = NULL;
+    FftTableR = NULL;
+    FftTableSize = 0;
+}
+
+// Sets up the twiddle table for transforms of up to n points.
+static void FftSetup(const uint n)
+{
+    uint k;
+
+    FftCleanup();
+    FftTableR = CreateArray(n);
+    FftTableI = CreateArray(n);
+    for(k = 0;k < n;k++)
+    {
+        FftTableR[k] = cos(2.0 * M_PI * k / n);
+        FftTableI[k] = -sin(2.0 * M_PI * k / n);
+    }
+    FftTableSize = n;
+}
+
 // Performs bit-reversal ordering.
 static void FftArrange(const uint n, const double *inR, const double *inI, double *outR, double *outI)
 {
@@ -918,46 +1144,84 @@ static void FftArrange(const uint n, const double *inR, const double *inI, doubl
     }
 }
 
-// Performs the summation.
+/* Performs the summation with radix-4 butterflies, which take half the
+ * passes over the data and a quarter fewer complex multiplies than radix-2.
+ * Sizes with an odd power of two start with a single radix-2 pass.  The
+ * input is in bit-reversed order, so of the four sub-transforms combined by
+ * each butterfly, the second and third are swapped compared to the usual
+ * digit-reversed radix-4 arrangement.
+ */
 static void FftSummation(const uint n, const double s, double *re, double *im)
 {
-    double pi;
-    uint m, m2;
-    double vR, vI, wR, wI;
-    uint i, k, mk;
-    double tR, tI;
-
-    pi = s * M_PI;
-    for(m = 1, m2 = 2;m < n; m <<= 1, m2 <<= 1)
-    {
-        // v = Complex (-2.0 * sin (0.5 * pi / m) * sin (0.5 * pi / m), -sin (pi / m))
-        vR = sin(0.5 * pi / m);
-        vR = -2.0 * vR * vR;
-        vI = -sin(pi / m);
-        // w = Complex (1.0, 0.0)
-        wR = 1.0;
-        wI = 0.0;
-        for(i = 0;i < m;i++)
+    uint l, l4, step, i, k, k0, k1, k2, k3;
+    double w1R, w1I, w2R, w2I, w3R, w3I;
+    double a0R, a0I, a1R, a1I, a2R, a2I, a3R, a3I;
+    double t0R, t0I, t1R, t1I, t2R, t2I, t3R, t3I;
+
+    l = 1;
+    if((n&0xAAAAAAAA) != 0)
+    {
+        for(k = 0;k < n;k += 2)
+        {
+            t0R = re[k+1];
+            t0I = im[k+1];
+            re[k+1] = re[k] - t0R;
+            im[k+1] = im[k] - t0I;
+            re[k] += t0R;
+            im[k] += t0I;
+        }
+        l = 2;
+    }
+    for(;l < n;l <<= 2)
+    {
+        l4 = l << 2;
+        step = FftTableSize / l4;
+        for(i = 0;i < n;i += l4)
         {
-            for(k = i;k < n;k += m2)
+            for(k = 0;k < l;k++)
             {
-                mk = k + m;
-                // t = ComplexMul(w, out[km2])
-                tR = (wR * re[mk]) - (wI * im[mk]);
-                tI = (wR * im[mk]) + (wI * re[mk]);
-                // out[mk] = ComplexSub (out [k], t)
-                re[mk] = re[k] - tR;
-                im[mk] = im[k] - tI;
-                // out[k] = ComplexAdd (out [k], t)
-                re[k] += tR;
-                im[k] += tI;
+                k0 = i + k;
+                k1 = k0 + l;
+                k2 = k1 + l;
+                k3 = k2 + l;
+
+                w1R = FftTableR[k*step];
+                w1I = s * FftTableI[k*step];
+                w2R = FftTableR[2*k*step];
+                w2I = s * FftTableI[2*k*step];
+                w3R = FftTableR[3*k*step];
+                w3I = s * FftTableI[3*k*step];
+
+                a0R = re[k0];
+                a0I = im[k0];
+                // a1 = w1 * x[k2], a2 = w2 * x[k1], a3 = w3 * x[k3]
+                a1R = (w1R * re[k2]) - (w1I * im[k2]);
+                a1I = (w1R * im[k2]) + (w1I * re[k2]);
+                a2R = (w2R * re[k1]) - (w2I * im[k1]);
+                a2I = (w2R * im[k1]) + (w2I * re[k1]);
+                a3R = (w3R * re[k3]) - (w3I * im[k3]);
+                a3I = (w3R * im[k3]) + (w3I * re[k3]);
+
+                t0R = a0R + a2R;
+                t0I = a0I + a2I;
+                t1R = a0R - a2R;
+                t1I = a0I - a2I;
+                t2R = a1R + a3R;
+                t2I = a1I + a3I;
+                t3R = a1R - a3R;
+                t3I = a1I - a3I;
+
+                // The quarter-turn rotation is -i for the forward transform
+                // and +i for the inverse.
+                re[k0] = t0R + t2R;
+                im[k0] = t0I + t2I;
+                re[k1] = t1R + (s * t3I);
+                im[k1] = t1I - (s * t3R);
+                re[k2] = t0R - t2R;
+                im[k2] = t0I - t2I;
+                re[k3] = t1R - (s * t3I);
+                im[k3] = t1I + (s * t3R);
             }
-            // t = ComplexMul (v, w)
-            tR = (vR * wR) - (vI * wI);
-            tI = (vR * wI) + (vI * wR);
-            // w = ComplexAdd (w, t)
-            wR += tR;
-            wI += tI;
         }
     }
 }
@@ -1299,7 +1563,7 @@ static void ResamplerClear(ResamplerT *rs)
 
 // Perform the upsample-filter-downsample resampling operation using a
 // polyphase filter implementation.
-static void ResamplerRun(ResamplerT *rs, const uint inN, const double *in, const uint outN, double *out)
+static void ResamplerRun(const ResamplerT *rs, const uint inN, const double *in, const uint outN, double *out)
 {
     const uint p = rs->mP, q = rs->mQ, m = rs->mM, l = rs->mL;
     const double *f = rs->mF;
@@ -1917,6 +2181,221 @@ static int StoreMhr(const HrirDataT *hData, const char *filename)
 }
 
 
+// Write zeros up to the next multiple of the precompiled format's alignment,
+// keeping track of the file offset.
+static int WriteMappedPadding(uint32 *offset, FILE *fp, const char *filename)
+{
+    static const uint8 zeros[MHR_MAPPED_ALIGNMENT] = { 0 };
+    uint32 count = (MHR_MAPPED_ALIGNMENT - (*offset % MHR_MAPPED_ALIGNMENT)) % MHR_MAPPED_ALIGNMENT;
+
+    if(fwrite(zeros, 1, count, fp) != count)
+    {
+        fprintf(stderr, "Error: Bad write to file '%s'.\n", filename);
+        return 0;
+    }
+    *offset += count;
+    return 1;
+}
+
+// Load an MHR data set (either format), and store it in the precompiled
+// format.  The tables are copied as-is, so the result is used exactly like
+// the original.
+static int ConvertMhr(const char *inName, const char *outName)
+{
+    uint32 rate, irSize, evCount, irCount, v;
+    uint32 azCount[MAX_EV_COUNT], evOffset[MAX_EV_COUNT];
+    uint32 offsets[4], total;
+    uint32 *coeffs = NULL;
+    uint32 *delays = NULL;
+    char magic[8];
+    FILE *fp;
+    uint i;
+
+    if(inName == NULL)
+    {
+        fprintf(stderr, "Error: An input MHR file must be given with '-i'.\n");
+        return 0;
+    }
+    if((fp=fopen(inName, "rb")) == NULL)
+    {
+        fprintf(stderr, "Error: Could not open MHR file '%s'.\n", inName);
+        return 0;
+    }
+    if(fread(magic, 1, 8, fp) != 8)
+    {
+        fprintf(stderr, "Error: Bad read from file '%s'.\n", inName);
+        fclose(fp);
+        return 0;
+    }
+    if(!ReadBin4(fp, inName, BO_LITTLE, 4, &rate))
+        goto error;
+    if(memcmp(magic, MHR_FORMAT, 8) == 0)
+    {
+        if(!ReadBin4(fp, inName, BO_LITTLE, 1, &irSize) ||
+           !ReadBin4(fp, inName, BO_LITTLE, 1, &evCount))
+            goto error;
+        if(evCount < MIN_EV_COUNT || evCount > MAX_EV_COUNT)
+        {
+            fprintf(stderr, "Error: Unsupported elevation count %u in '%s'.\n", evCount, inName);
+            goto error;
+        }
+        irCount = 0;
+        for(i = 0;i < evCount;i++)
+        {
+            if(!ReadBin4(fp, inName, BO_LITTLE, 1, &azCount[i]))
+                goto error;
+            evOffset[i] = irCount;
+            irCount += azCount[i];
+        }
+    }
+    else if(memcmp(magic, MHR_FORMAT_00, 8) == 0)
+    {
+        if(!ReadBin4(fp, inName, BO_LITTLE, 2, &irCount) ||
+           !ReadBin4(fp, inName, BO_LITTLE, 2, &irSize) ||
+           !ReadBin4(fp, inName, BO_LITTLE, 1, &evCount))
+            goto error;
+        if(evCount < MIN_EV_COUNT || evCount > MAX_EV_COUNT)
+        {
+            fprintf(stderr, "Error: Unsupported elevation count %u in '%s'.\n", evCount, inName);
+            goto error;
+        }
+        for(i = 0;i < evCount;i++)
+        {
+            if(!ReadBin4(fp, inName, BO_LITTLE, 2, &evOffset[i]))
+                goto error;
+            if(i > 0)
+                azCount[i-1] = evOffset[i] - evOffset[i-1];
+        }
+        azCount[evCount-1] = irCount - evOffset[evCount-1];
+    }
+    else
+    {
+        fprintf(stderr, "Error: '%s' is not an MHR data set.\n", inName);
+        goto error;
+    }
+
+    if(irSize < MIN_MHR_IR_SIZE || irSize > MAX_MHR_IR_SIZE || (irSize%MOD_MHR_IR_SIZE))
+    {
+        fprintf(stderr, "Error: Unsupported HRIR size %u in '%s'.\n", irSize, inName);
+        goto error;
+    }
+    for(i = 0;i < evCount;i++)
+    {
+        if(azCount[i] < MIN_AZ_COUNT || azCount[i] > MAX_AZ_COUNT || evOffset[i] >= irCount)
+        {
+            fprintf(stderr, "Error: Unsupported azimuth count %u for elevation %u in '%s'.\n", azCount[i], i, inName);
+            goto error;
+        }
+    }
+
+    coeffs = calloc(irCount*irSize, sizeof(*coeffs));
+    delays = calloc(irCount, sizeof(*delays));
+    if(coeffs == NULL || delays == NULL)
+    {
+        fprintf(stderr, "Error: Out of memory.\n");
+        goto error;
+    }
+    for(i = 0;i < irCount*irSize;i++)
+    {
+        if(!ReadBin4(fp, inName, BO_LITTLE, 2, &coeffs[i]))
+            goto error;
+    }
+    for(i = 0;i < irCount;i++)
+    {
+        if(!ReadBin4(fp, inName, BO_LITTLE, 1, &delays[i]))
+            goto error;
+        if(delays[i] > MAX_HRTD)
+        {
+            fprintf(stderr, "Error: Invalid delay %u for HRIR %u in '%s'.\n", delays[i], i, inName);
+            goto error;
+        }
+    }
+    fclose(fp);
+
+    // Lay out the tables after the header.
+    total = 8 + 9*4;
+    for(i = 0;i < 4;i++)
+    {
+        total = (total + MHR_MAPPED_ALIGNMENT-1) / MHR_MAPPED_ALIGNMENT * MHR_MAPPED_ALIGNMENT;
+        offsets[i] = total;
+        if(i == 0) total += evCount;
+        else if(i == 1) total += evCount*2;
+        else if(i == 2) total += irCount*irSize*2;
+        else total += irCount;
+    }
+
+    if((fp=fopen(outName, "wb")) == NULL)
+    {
+        fprintf(stderr, "Error: Could not open MHR file '%s'.\n", outName);
+        free(coeffs);
+        free(delays);
+        return 0;
+    }
+    if(!WriteAscii(MHR_MAPPED_FORMAT, fp, outName))
+    {
+        free(coeffs);
+        free(delays);
+        return 0;
+    }
+    if(!WriteBin4(BO_LITTLE, 4, rate, fp, outName) ||
+       !WriteBin4(BO_LITTLE, 4, irSize, fp, outName) ||
+       !WriteBin4(BO_LITTLE, 4, evCount, fp, outName) ||
+       !WriteBin4(BO_LITTLE, 4, irCount, fp, outName))
+        goto error;
+    for(i = 0;i < 4;i++)
+    {
+        if(!WriteBin4(BO_LITTLE, 4, offsets[i], fp, outName))
+            goto error;
+    }
+    if(!WriteBin4(BO_LITTLE, 4, total, fp, outName))
+        goto error;
+
+    v = 8 + 9*4;
+    if(!WriteMappedPadding(&v, fp, outName))
+        goto error;
+    for(i = 0;i < evCount;i++)
+    {
+        if(!WriteBin4(BO_LITTLE, 1, azCount[i], fp, outName))
+            goto error;
+    }
+    v += evCount;
+    if(!WriteMappedPadding(&v, fp, outName))
+        goto error;
+    for(i = 0;i < evCount;i++)
+    {
+        if(!WriteBin4(BO_LITTLE, 2, evOffset[i], fp, outName))
+            goto error;
+    }
+    v += evCount*2;
+    if(!WriteMappedPadding(&v, fp, outName))
+        goto error;
+    for(i = 0;i < irCount*irSize;i++)
+    {
+        if(!WriteBin4(BO_LITTLE, 2, coeffs[i], fp, outName))
+            goto error;
+    }
+    v += irCount*irSize*2;
+    if(!WriteMappedPadding(&v, fp, outName))
+        goto error;
+    for(i = 0;i < irCount;i++)
+    {
+        if(!WriteBin4(BO_LITTLE, 1, delays[i], fp, outName))
+            goto error;
+    }
+    fclose(fp);
+    free(coeffs);
+    free(delays);
+    fprintf(stdout, "Converted %u HRIRs of %u points at %uhz, %u bytes.\n", irCount, irSize, rate, total);
+    return 1;
+
+error:
+    fclose(fp);
+    free(coeffs);
+    free(delays);
+    return 0;
+}
+
+
 /***********************
  *** HRTF processing ***
  ***********************/
@@ -1942,36 +2421,69 @@ static void AverageHrirOnset(const double *hrir, const double f, const uint ei,
     hData->mHrtds[j] = Lerp(hData->mHrtds[j], ((double)i) / hData->mIrRate, f);
 }
 
-// Calculate the magnitude response of an HRIR and average it with any
-// existing responses for its elevation and azimuth.
-static void AverageHrirMagnitude(const double *hrir, const double f, const uint ei, const uint ai, const HrirDataT *hData)
+// The HRIRs loaded from the sources, held until their magnitude responses
+// are calculated and averaged into the data set.
+typedef struct HrirSourcesT {
+    const HrirDataT *mData;
+    uint mCount, mCapacity;
+    uint *mIndices;
+    double *mFactors;
+    double *mResponses;
+} HrirSourcesT;
+
+// Calculate the magnitude responses for a range of loaded HRIRs, in place.
+static void CalcHrirMagnitudesProc(void *arg, const uint start, const uint end)
 {
-    double *re, *im;
-    uint n, m, i, j;
+    HrirSourcesT *srcs = (HrirSourcesT*)arg;
+    const HrirDataT *hData = srcs->mData;
+    double *re, *im, *hrir;
+    uint n, m, i, r;
 
     n = hData->mFftSize;
+    m = 1 + (n / 2);
     re = CreateArray(n);
     im = CreateArray(n);
-    for(i = 0;i < hData->mIrPoints;i++)
-    {
-        re[i] = hrir[i];
-        im[i] = 0.0;
-    }
-    for(;i < n;i++)
+    for(r = start;r < end;r++)
     {
-        re[i] = 0.0;
-        im[i] = 0.0;
+        hrir = &srcs->mResponses[(size_t)r * hData->mIrSize];
+        for(i = 0;i < hData->mIrPoints;i++)
+        {
+            re[i] = hrir[i];
+            im[i] = 0.0;
+        }
+        for(;i < n;i++)
+        {
+            re[i] = 0.0;
+            im[i] = 0.0;
+        }
+        FftForward(n, re, im, re, im);
+        MagnitudeResponse(n, re, im, re);
+        for(i = 0;i < m;i++)
+            hrir[i] = re[i];
     }
-    FftForward(n, re, im, re, im);
-    MagnitudeResponse(n, re, im, re);
-    m = 1 + (n / 2);
-    j = (hData->mEvOffset[ei] + ai) * hData->mIrSize;
-    for(i = 0;i < m;i++)
-        hData->mHrirs[j+i] = Lerp(hData->mHrirs[j+i], re[i], f);
     DestroyArray(im);
     DestroyArray(re);
 }
 
+// Calculate the magnitude responses of the loaded HRIRs and average each
+// with any existing responses for its elevation and azimuth.  The averaging
+// is done in load order, so the results don't depend on the thread count.
+static void AverageHrirMagnitudes(HrirSourcesT *srcs, const HrirDataT *hData)
+{
+    uint m, i, j, r;
+    double *resp;
+
+    RunWorkers(0, srcs->mCount, CalcHrirMagnitudesProc, srcs);
+    m = 1 + (hData->mFftSize / 2);
+    for(r = 0;r < srcs->mCount;r++)
+    {
+        resp = &srcs->mResponses[(size_t)r * hData->mIrSize];
+        j = srcs->mIndices[r] * hData->mIrSize;
+        for(i = 0;i < m;i++)
+            hData->mHrirs[j+i] = Lerp(hData->mHrirs[j+i], resp[i], srcs->mFactors[r]);
+    }
+}
+
 /* Calculate the contribution of each HRIR to the diffuse-field average based
  * on the area of its surface patch.  All patches are centered at the HRIR
  * coordinates on the unit sphere and are measured by solid angle.
@@ -2084,20 +2596,18 @@ static void DiffuseFieldEqualize(const double *dfa, const HrirDataT *hData)
     }
 }
 
-// Perform minimum-phase reconstruction using the magnitude responses of the
-// HRIR set.
-static void ReconstructHrirs(const HrirDataT *hData)
+// Perform minimum-phase reconstruction on a range of HRIRs.
+static void ReconstructHrirsProc(void *arg, const uint start, const uint end)
 {
-    uint step, start, end, n, j, i;
+    const HrirDataT *hData = (const HrirDataT*)arg;
+    uint step, n, j, i;
     double *re, *im;
 
     step = hData->mIrSize;
-    start = hData->mEvOffset[hData->mEvStart] * step;
-    end = hData->mIrCount * step;
     n = hData->mFftSize;
     re = CreateArray(n);
     im = CreateArray(n);
-    for(j = start;j < end;j += step)
+    for(j = start * step;j < end * step;j += step)
     {
         MinimumPhase(n, &hData->mHrirs[j], re, im);
         FftInverse(n, re, im, re, im);
@@ -2108,19 +2618,43 @@ static void ReconstructHrirs(const HrirDataT *hData)
     DestroyArray (re);
 }
 
+// Perform minimum-phase reconstruction using the magnitude responses of the
+// HRIR set.
+static void ReconstructHrirs(const HrirDataT *hData)
+{
+    RunWorkers(hData->mEvOffset[hData->mEvStart], hData->mIrCount, ReconstructHrirsProc, (void*)hData);
+}
+
+// The resampler shared by the worker threads, and the data set to resample.
+typedef struct ResampleJobT {
+    const ResamplerT *mResampler;
+    const HrirDataT *mData;
+} ResampleJobT;
+
+// Resamples a range of HRIRs.  The resampler is only read, so it can be
+// shared between threads.
+static void ResampleHrirsProc(void *arg, const uint start, const uint end)
+{
+    const ResampleJobT *job = (const ResampleJobT*)arg;
+    const HrirDataT *hData = job->mData;
+    uint n, step, j;
+
+    n = hData->mIrPoints;
+    step = hData->mIrSize;
+    for(j = start * step;j < end * step;j += step)
+        ResamplerRun(job->mResampler, n, &hData->mHrirs[j], n, &hData->mHrirs[j]);
+}
+
 // Resamples the HRIRs for use at the given sampling rate.
 static void ResampleHrirs(const uint rate, HrirDataT *hData)
 {
-    uint n, step, start, end, j;
+    ResampleJobT job;
     ResamplerT rs;
 
     ResamplerSetup(&rs, hData->mIrRate, rate);
-    n = hData->mIrPoints;
-    step = hData->mIrSize;
-    start = hData->mEvOffset[hData->mEvStart] * step;
-    end = hData->mIrCount * step;
-    for(j = start;j < end;j += step)
-        ResamplerRun(&rs, n, &hData->mHrirs[j], n, &hData->mHrirs[j]);
+    job.mResampler = &rs;
+    job.mData = hData;
+    RunWorkers(hData->mEvOffset[hData->mEvStart], hData->mIrCount, ResampleHrirsProc, &job);
     ResamplerClear(&rs);
     hData->mIrRate = rate;
 }
@@ -2613,18 +3147,59 @@ static int ReadSourceRef(TokenReaderT *tr, SourceRefT *src)
     return 1;
 }
 
-// Process the list of sources in the data set definition.
-static int ProcessSources(const HeadModelT model, TokenReaderT *tr, HrirDataT *hData)
+// Makes room for another loaded HRIR in the source list.
+static double *AddHrirSource(HrirSourcesT *srcs, const uint index, const double factor)
+{
+    const uint size = srcs->mData->mIrSize;
+    double *responses;
+    double *factors;
+    uint *indices;
+    uint capacity;
+
+    if(srcs->mCount == srcs->mCapacity)
+    {
+        capacity = srcs->mCapacity ? (srcs->mCapacity * 2) : 256;
+        indices = (uint*)realloc(srcs->mIndices, capacity * sizeof(uint));
+        if(indices != NULL)
+            srcs->mIndices = indices;
+        factors = (double*)realloc(srcs->mFactors, capacity * sizeof(double));
+        if(factors != NULL)
+            srcs->mFactors = factors;
+        responses = (double*)realloc(srcs->mResponses, (size_t)capacity * size * sizeof(double));
+        if(responses != NULL)
+            srcs->mResponses = responses;
+        if(indices == NULL || factors == NULL || responses == NULL)
+        {
+            fprintf(stderr, "Error:  Out of memory.\n");
+            exit(-1);
+        }
+        srcs->mCapacity = capacity;
+    }
+    srcs->mIndices[srcs->mCount] = index;
+    srcs->mFactors[srcs->mCount] = factor;
+    return &srcs->mResponses[(size_t)srcs->mCount++ * size];
+}
+
+// Process the list of sources in the data set definition.  The sources are
+// loaded in order, then their magnitude responses are calculated on the
+// worker threads.
+static int ProcessSources(const HeadModelT model, TokenReaderT *tr, HrirDataT *hData, StageTimerT *timer)
 {
     uint *setCount, *setFlag;
     uint line, col, ei, ai;
+    HrirSourcesT srcs;
     SourceRefT src;
     double factor;
     double *hrir;
 
     setCount = (uint*)calloc(hData->mEvCount, sizeof(uint));
     setFlag = (uint*)calloc(hData->mIrCount, sizeof(uint));
-    hrir = CreateArray(hData->mIrPoints);
+    srcs.mData = hData;
+    srcs.mCount = 0;
+    srcs.mCapacity = 0;
+    srcs.mIndices = NULL;
+    srcs.mFactors = NULL;
+    srcs.mResponses = NULL;
     while(TrIsOperator(tr, "["))
     {
         TrIndication(tr, & line, & col);
@@ -2646,12 +3221,12 @@ static int ProcessSources(const HeadModelT model, TokenReaderT *tr, HrirDataT *h
         {
             if(!ReadSourceRef(tr, &src))
                 goto error;
+            hrir = AddHrirSource(&srcs, hData->mEvOffset[ei] + ai, 1.0 / factor);
             if(!LoadSource(&src, hData->mIrRate, hData->mIrPoints, hrir))
                 goto error;
 
             if(model == HM_DATASET)
                 AverageHrirOnset(hrir, 1.0 / factor, ei, ai, hData);
-            AverageHrirMagnitude(hrir, 1.0 / factor, ei, ai, hData);
             factor += 1.0;
             if(!TrIsOperator(tr, "+"))
                 break;
@@ -2673,7 +3248,13 @@ static int ProcessSources(const HeadModelT model, TokenReaderT *tr, HrirDataT *h
         {
             if(!TrLoad(tr))
             {
-                DestroyArray(hrir);
+                StageTimerMark(timer, "Loading sources");
+                fprintf(stdout, "Calculating magnitude responses...\n");
+                AverageHrirMagnitudes(&srcs, hData);
+                StageTimerMark(timer, "Magnitude responses");
+                free(srcs.mResponses);
+                free(srcs.mFactors);
+                free(srcs.mIndices);
                 free(setFlag);
                 free(setCount);
                 return 1;
@@ -2687,7 +3268,9 @@ static int ProcessSources(const HeadModelT model, TokenReaderT *tr, HrirDataT *h
         TrError(tr, "Missing source references.\n");
 
 error:
-    DestroyArray(hrir);
+    free(srcs.mResponses);
+    free(srcs.mFactors);
+    free(srcs.mIndices);
     free(setFlag);
     free(setCount);
     return 0;
@@ -2700,6 +3283,7 @@ error:
 static int ProcessDefinition(const char *inName, const uint outRate, const uint fftSize, const int equalize, const int surface, const double limit, const uint truncSize, const HeadModelT model, const double radius, const OutputFormatT outFormat, const char *outName)
 {
     char rateStr[8+1], expName[MAX_PATH_LEN];
+    StageTimerT timer;
     TokenReaderT tr;
     HrirDataT hData;
     double *dfa;
@@ -2713,6 +3297,7 @@ static int ProcessDefinition(const char *inName, const uint outRate, const uint
     hData.mEvCount = 0;
     hData.mRadius = 0;
     hData.mDistance = 0;
+    StageTimerStart(&timer);
     fprintf(stdout, "Reading HRIR definition...\n");
     if(inName != NULL)
     {
@@ -2737,8 +3322,10 @@ static int ProcessDefinition(const char *inName, const uint outRate, const uint
     }
     hData.mHrirs = CreateArray(hData.mIrCount * hData . mIrSize);
     hData.mHrtds = CreateArray(hData.mIrCount);
-    if(!ProcessSources(model, &tr, &hData))
+    FftSetup(hData.mFftSize);
+    if(!ProcessSources(model, &tr, &hData, &timer))
     {
+        FftCleanup();
         DestroyArray(hData.mHrtds);
         DestroyArray(hData.mHrirs);
         if(inName != NULL)
@@ -2755,13 +3342,17 @@ static int ProcessDefinition(const char *inName, const uint outRate, const uint
         fprintf(stdout, "Performing diffuse-field equalization...\n");
         DiffuseFieldEqualize(dfa, &hData);
         DestroyArray(dfa);
+        StageTimerMark(&timer, "Diffuse-field equalization");
     }
     fprintf(stdout, "Performing minimum phase reconstruction...\n");
     ReconstructHrirs(&hData);
+    FftCleanup();
+    StageTimerMark(&timer, "Minimum phase reconstruction");
     if(outRate != 0 && outRate != hData.mIrRate)
     {
         fprintf(stdout, "Resampling HRIRs...\n");
         ResampleHrirs(outRate, &hData);
+        StageTimerMark(&timer, "Resampling");
     }
     fprintf(stdout, "Truncating minimum-phase HRIRs...\n");
     hData.mIrPoints = truncSize;
@@ -2773,6 +3364,7 @@ static int ProcessDefinition(const char *inName, const uint outRate, const uint
     NormalizeHrirs(&hData);
     fprintf(stdout, "Calculating impulse delays...\n");
     CalculateHrtds(model, (radius > DEFAULT_CUSTOM_RADIUS) ? radius : hData.mRadius, &hData);
+    StageTimerMark(&timer, "Synthesis and normalization");
     snprintf(rateStr, 8, "%u", hData.mIrRate);
     StrSubst(outName, "%r", rateStr, MAX_PATH_LEN, expName);
     switch(outFormat)
@@ -2785,10 +3377,12 @@ static int ProcessDefinition(const char *inName, const uint outRate, const uint
                 DestroyArray(hData.mHrirs);
                 return 0;
             }
+            StageTimerMark(&timer, "Storing data set");
             break;
         default:
             break;
     }
+    StageTimerReport(&timer, stdout);
     DestroyArray(hData.mHrtds);
     DestroyArray(hData.mHrirs);
     return 1;
@@ -2800,6 +3394,11 @@ static void PrintHelp(const char *argv0, FILE *ofile)
     fprintf(ofile, "Commands:\n");
     fprintf(ofile, " -m, --make-mhr  Makes an OpenAL Soft compatible HRTF data set.\n");
     fprintf(ofile, "                 Defaults output to: ./oalsoft_hrtf_%%r.mhr\n");
+    fprintf(ofile, " -p, --precompile-mhr\n");
+    fprintf(ofile, "                 Converts the MHR data set given with '-i' to the precompiled\n");
+    fprintf(ofile, "                 format, which OpenAL Soft maps into memory and uses in place.\n");
+    fprintf(ofile, "                 Only the '-i' and '-o' options apply.\n");
+    fprintf(ofile, "                 Defaults output to: ./oalsoft_hrtf_precompiled.mhr\n");
     fprintf(ofile, " -h, --help      Displays this help information.\n\n");
     fprintf(ofile, "Options:\n");
     fprintf(ofile, " -r=<rate>       Change the data set sample rate to the specified value and\n");
@@ -2815,6 +3414,8 @@ static void PrintHelp(const char *argv0, FILE *ofile)
     fprintf(ofile, " -d={dataset|    Specify the model used for calculating the head-delay timing\n");
     fprintf(ofile, "     sphere}     values (default: %s).\n", ((DEFAULT_HEAD_MODEL == HM_DATASET) ? "dataset" : "sphere"));
     fprintf(ofile, " -c=<size>       Use a customized head radius measured ear-to-ear in meters.\n");
+    fprintf(ofile, " -j=<threads>    Specify the number of threads used to process the HRIRs\n");
+    fprintf(ofile, "                 (defaults to the number of processors).\n");
     fprintf(ofile, " -i=<filename>   Specify an HRIR definition file to use (defaults to stdin).\n");
     fprintf(ofile, " -o=<filename>   Specify an output file.  Overrides command-selected default.\n");
     fprintf(ofile, "                 Use of '%%r' will be substituted with the data set sample rate.\n");
@@ -2846,6 +3447,11 @@ int main(const int argc, const char *argv[])
         outName = "./oalsoft_hrtf_%r.mhr";
         outFormat = OF_MHR;
     }
+    else if(strcmp(argv[1], "--precompile-mhr") == 0 || strcmp(argv[1], "-p") == 0)
+    {
+        outName = "./oalsoft_hrtf_precompiled.mhr";
+        outFormat = OF_MHR_MAPPED;
+    }
     else
     {
         fprintf(stderr, "Error: Invalid command '%s'.\n\n", argv[1]);
@@ -2861,6 +3467,9 @@ int main(const int argc, const char *argv[])
     truncSize = DEFAULT_TRUNCSIZE;
     model = DEFAULT_HEAD_MODEL;
     radius = DEFAULT_CUSTOM_RADIUS;
+    NumThreads = GetProcessorCount();
+    if(NumThreads > MAX_THREADS)
+        NumThreads = MAX_THREADS;
 
     argi = 2;
     while(argi < argc)
@@ -2951,6 +3560,15 @@ int main(const int argc, const char *argv[])
                 return -1;
             }
         }
+        else if(strncmp(argv[argi], "-j=", 3) == 0)
+        {
+            NumThreads = strtoul(&argv[argi][3], &end, 10);
+            if(end[0] != '\0' || NumThreads < MIN_THREADS || NumThreads > MAX_THREADS)
+            {
+                fprintf(stderr, "Error:  Expected a value from %u to %u for '-j'.\n", MIN_THREADS, MAX_THREADS);
+                return -1;
+            }
+        }
         else if(strncmp(argv[argi], "-i=", 3) == 0)
             inName = &argv[argi][3];
         else if(strncmp(argv[argi], "-o=", 3) == 0)
@@ -2962,7 +3580,12 @@ int main(const int argc, const char *argv[])
         }
         argi++;
     }
-    if(!ProcessDefinition(inName, outRate, fftSize, equalize, surface, limit, truncSize, model, radius, outFormat, outName))
+    if(outFormat == OF_MHR_MAPPED)
+    {
+        if(!ConvertMhr(inName, outName))
+            return -1;
+    }
+    else if(!ProcessDefinition(inName, outRate, fftSize, equalize, surface, limit, truncSize, model, radius, outFormat, outName))
         return -1;
     fprintf(stdout, "Operation completed.\n");
     return 0;
@@ -1,5 +1,9 @@
 #include "audio_manager.h"
 
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
 #include <AL/al.h>
 #include <AL/alc.h>
 #include <AL/efx.h>
@@ -29,10 +33,19 @@ static std::string list_audio_devices(const ALCchar * const devices) {
 	return devices_list;
 }
 
+static ALCint get_device_integer(ALCdevice* const device, const ALCenum param) {
+	ALCint value = 0;
+	alcGetIntegerv(device, param, 1, &value);
+	return value;
+}
+
 namespace augs {
 	void audio_manager::generate_alsoft_ini(
 		const bool hrtf_enabled,
-		const unsigned max_number_of_sound_sources
+		const unsigned max_number_of_sound_sources,
+		const output_period_settings periods,
+		const float voice_cull_level_db,
+		const thread_schedule mixer_thread
 	) {
 		std::string alsoft_ini_file;
 		alsoft_ini_file += "# Do not modify.";
@@ -43,10 +56,44 @@ namespace augs {
 		alsoft_ini_file += "\nhrtf-paths = " + augs::get_executable_directory() + "\\hrtf";
 		alsoft_ini_file += typesafe_sprintf("\nsources = %x", max_number_of_sound_sources);
 
+		if (periods.period_size > 0) {
+			alsoft_ini_file += typesafe_sprintf("\nperiod_size = %x", periods.period_size);
+		}
+
+		if (periods.periods > 0) {
+			alsoft_ini_file += typesafe_sprintf("\nperiods = %x", periods.periods);
+		}
+		else if (periods.low_latency) {
+			alsoft_ini_file += "\nperiods = 2";
+		}
+
+		if (voice_cull_level_db < 0.f) {
+			alsoft_ini_file += typesafe_sprintf("\nvoice-cull-level = %x", voice_cull_level_db);
+		}
+
+		/* Written even when 0, since OpenAL raises the mixer by default on Windows. */
+		alsoft_ini_file += typesafe_sprintf("\nrt-prio = %x", mixer_thread.priority);
+
+		if (mixer_thread.priority > 0) {
+			alsoft_ini_file += "\nrt-policy = fifo";
+		}
+
+		if (mixer_thread.cpu_mask != 0) {
+			alsoft_ini_file += typesafe_sprintf("\nrt-cpus = %x", mixer_thread.cpu_mask);
+		}
+
+		if (periods.low_latency) {
+			alsoft_ini_file += "\n[alsa]";
+			alsoft_ini_file += "\nlow-latency = true";
+		}
+
 		augs::create_text_file(std::string("alsoft.ini"), alsoft_ini_file);
 	}
 
-	audio_manager::audio_manager(const std::string output_device_name) {
+	audio_manager::audio_manager(
+		const std::string output_device_name,
+		const output_period_settings periods
+	) {
 		alGetError();
 
 		device = alcOpenDevice(output_device_name.size() > 0 ? output_device_name.c_str() : nullptr);
@@ -64,9 +111,7 @@ namespace augs {
 
 		ensure(alcIsExtensionPresent(device, "ALC_EXT_EFX"));
 
-		AL_CHECK(alSpeedOfSound(100.f));
-		AL_CHECK(alDistanceModel(AL_LINEAR_DISTANCE_CLAMPED));
-		AL_CHECK(alListenerf(AL_METERS_PER_UNIT, 1.3f));
+		set_default_context_parameters();
 
 		const auto devices = list_audio_devices(alcGetString(nullptr, ALC_ALL_DEVICES_SPECIFIER));
 
@@ -79,6 +124,202 @@ namespace augs {
 
 		LOG("Default device: %x", alcGetString(nullptr, ALC_DEFAULT_DEVICE_SPECIFIER));
 		LOG("HRTF status: %x", hrtf_status);
+
+		if (alcIsExtensionPresent(device, "ALC_SOFTX_periods")) {
+			if (periods.low_latency && periods.period_size == 0) {
+				pick_smallest_stable_period();
+			}
+
+			const auto frequency = get_device_integer(device, ALC_FREQUENCY);
+			const auto period_size = get_device_integer(device, ALC_PERIOD_SIZE_SOFTX);
+
+			LOG("Output period: %x frames x %x periods (%x ms per period)",
+				period_size,
+				get_device_integer(device, ALC_PERIODS_SOFTX),
+				period_size * 1000.0 / frequency
+			);
+
+			LOG("Output delay: %x ms", get_output_delay_ms());
+		}
+	}
+
+	void audio_manager::pick_smallest_stable_period() {
+		/*
+			Each candidate is requested through ALC_REFRESH.
+			The backend may round it up, e.g. WASAPI to a multiple of its engine period,
+			so candidates that end up at an already tried size are skipped.
+
+			The first size that plays for probe_duration without an underrun is kept.
+		*/
+
+		const auto probe_duration = std::chrono::milliseconds(250);
+
+		unsigned largest_tried = 0;
+
+		for (const unsigned candidate : { 64u, 128u, 256u, 512u, 1024u }) {
+			const auto period_size = request_period_size(candidate);
+
+			if (period_size <= largest_tried) {
+				continue;
+			}
+
+			largest_tried = period_size;
+
+			const auto underruns_before = get_underruns();
+			std::this_thread::sleep_for(probe_duration);
+
+			if (get_underruns() == underruns_before) {
+				LOG("Low latency: %x frames per period are stable", period_size);
+				return;
+			}
+
+			LOG("Low latency: %x frames per period underran, trying more", period_size);
+		}
+	}
+
+	unsigned audio_manager::request_period_size(const unsigned frames) {
+		if (!alcIsExtensionPresent(device, "ALC_SOFTX_periods")) {
+			return 0u;
+		}
+
+		const auto frequency = get_device_integer(device, ALC_FREQUENCY);
+
+		const ALCint attributes[] = {
+			ALC_REFRESH, frequency / static_cast<ALCint>(frames),
+			0
+		};
+
+		if (alcResetDeviceSOFT(device, attributes) == ALC_FALSE) {
+			return 0u;
+		}
+
+		return static_cast<unsigned>(get_device_integer(device, ALC_PERIOD_SIZE_SOFTX));
+	}
+
+	unsigned audio_manager::get_underruns() const {
+		if (!alcIsExtensionPresent(device, "ALC_SOFTX_periods")) {
+			return 0u;
+		}
+
+		return static_cast<unsigned>(get_device_integer(device, ALC_UNDERRUNS_SOFTX));
+	}
+
+	double audio_manager::get_output_delay_ms() const {
+		if (!alcIsExtensionPresent(device, "ALC_SOFTX_periods")) {
+			return 0.0;
+		}
+
+		const auto frequency = get_device_integer(device, ALC_FREQUENCY);
+
+		if (frequency <= 0) {
+			return 0.0;
+		}
+
+		return get_device_integer(device, ALC_OUTPUT_DELAY_SOFTX) * 1000.0 / frequency;
+	}
+
+	unsigned audio_manager::get_panning_cache_hits() const {
+		if (!alcIsExtensionPresent(device, "ALC_SOFTX_panning_cache")) {
+			return 0u;
+		}
+
+		return static_cast<unsigned>(get_device_integer(device, ALC_PANNING_CACHE_HITS_SOFTX));
+	}
+
+	unsigned audio_manager::get_panning_cache_misses() const {
+		if (!alcIsExtensionPresent(device, "ALC_SOFTX_panning_cache")) {
+			return 0u;
+		}
+
+		return static_cast<unsigned>(get_device_integer(device, ALC_PANNING_CACHE_MISSES_SOFTX));
+	}
+
+	std::string audio_manager::describe_mixer_thread_schedule() const {
+		if (!alcIsExtensionPresent(device, "ALC_SOFTX_thread_sched")) {
+			return "unknown";
+		}
+
+		const auto sched = get_device_integer(device, ALC_MIXER_THREAD_SCHED_SOFTX);
+
+		if (sched < 0) {
+			return "unknown";
+		}
+
+		const auto sched_name =
+			sched == ALC_SCHED_FIFO_SOFTX ? "fifo" :
+			sched == ALC_SCHED_RR_SOFTX ? "round-robin" :
+			"normal"
+		;
+
+		return typesafe_sprintf("%x priority %x", sched_name, get_device_integer(device, ALC_MIXER_THREAD_PRIORITY_SOFTX));
+	}
+
+	std::vector<zone_record> audio_manager::get_mixer_zones(std::uint64_t& next_update) const {
+		std::vector<zone_record> zones;
+
+		if (!alcIsExtensionPresent(device, "ALC_SOFTX_mix_stamps")) {
+			return zones;
+		}
+
+		/* sequence number of the first update and their count, then a begin and end stamp for each */
+		std::vector<ALCint64SOFT> values(2 + 2 * 256);
+		alcGetInteger64vSOFT(device, ALC_MIX_STAMPS_SOFTX, static_cast<ALCsizei>(values.size()), values.data());
+
+		const auto first = static_cast<std::uint64_t>(values[0]);
+		const auto count = static_cast<std::uint64_t>(values[1]);
+
+		for (std::uint64_t i = 0; i < count; ++i) {
+			if (first + i >= next_update) {
+				zones.push_back({
+					"mix",
+					static_cast<std::uint64_t>(values[2 + 2 * i]),
+					static_cast<std::uint64_t>(values[3 + 2 * i])
+				});
+			}
+		}
+
+		next_update = std::max(next_update, first + count);
+		return zones;
+	}
+
+	audio_manager::audio_manager(const loopback_device_settings settings) {
+		alGetError();
+
+		ensure(alcIsExtensionPresent(nullptr, "ALC_SOFT_loopback"));
+
+		device = alcLoopbackOpenDeviceSOFT(nullptr);
+
+		const ALCint attributes[] = {
+			ALC_FORMAT_CHANNELS_SOFT, ALC_STEREO_SOFT,
+			ALC_FORMAT_TYPE_SOFT, ALC_FLOAT_SOFT,
+			ALC_FREQUENCY, settings.frequency,
+			ALC_HRTF_SOFT, settings.hrtf_enabled ? ALC_TRUE : ALC_FALSE,
+			ALC_MONO_SOURCES, settings.max_number_of_sound_sources,
+			0
+		};
+
+		context = alcCreateContext(device, attributes);
+
+		if (!context || !make_current()) {
+			if (context) {
+				alcDestroyContext(context);
+			}
+
+			alcCloseDevice(device);
+			LOG("\n!!! Failed to set a loopback context !!!\n\n");
+		}
+
+		set_default_context_parameters();
+	}
+
+	void audio_manager::set_default_context_parameters() {
+		AL_CHECK(alSpeedOfSound(100.f));
+		AL_CHECK(alDistanceModel(AL_LINEAR_DISTANCE_CLAMPED));
+		AL_CHECK(alListenerf(AL_METERS_PER_UNIT, 1.3f));
+	}
+
+	void audio_manager::render_loopback(float* const interleaved_stereo_output, const int frames) {
+		alcRenderSamplesSOFT(device, interleaved_stereo_output, frames);
 	}
 
 	bool audio_manager::make_current() {
@@ -1,5 +1,9 @@
 #pragma once
 #include <string>
+#include <vector>
+#include <cstdint>
+#include "augs/misc/thread_schedule.h"
+#include "augs/misc/zone_profiler.h"
 
 /** Opaque device handle */
 typedef struct ALCdevice_struct ALCdevice;
@@ -7,9 +11,33 @@ typedef struct ALCdevice_struct ALCdevice;
 typedef struct ALCcontext_struct ALCcontext;
 
 namespace augs {
+	struct loopback_device_settings {
+		int frequency = 48000;
+		int max_number_of_sound_sources = 256;
+		bool hrtf_enabled = false;
+	};
+
+	/*
+		How the output device is fed.
+		Zeros leave the backend's defaults.
+
+		With low_latency set and no explicit period_size, the device is opened with two periods
+		and the period is then lowered step by step until the backend starts to underrun.
+		The ALSA backend additionally mixes straight into the hardware buffer from a real-time thread.
+	*/
+
+	struct output_period_settings {
+		unsigned period_size = 0;
+		unsigned periods = 0;
+		bool low_latency = false;
+	};
+
 	class audio_manager {
 		ALCdevice* device = nullptr;
 		ALCcontext* context = nullptr;
+
+		void set_default_context_parameters();
+		void pick_smallest_stable_period();
 		
 		audio_manager(const audio_manager&) = delete;
 		audio_manager(audio_manager&&) = delete;
@@ -19,12 +47,72 @@ namespace augs {
 	public:
 		static void generate_alsoft_ini(
 			const bool hrtf_enabled,
-			const unsigned max_number_of_sound_sources
+			const unsigned max_number_of_sound_sources,
+			const output_period_settings periods = output_period_settings(),
+			const float voice_cull_level_db = 0.f,
+			const thread_schedule mixer_thread = thread_schedule()
+		);
+
+		audio_manager(
+			const std::string output_device_name = "",
+			const output_period_settings periods = output_period_settings()
 		);
 
-		audio_manager(const std::string output_device_name = "");
+		/* 
+			Opens an ALC_SOFT_loopback device that mixes stereo float frames only when asked to.
+			Used to measure the mixer offline.
+		*/
+
+		audio_manager(const loopback_device_settings);
 		~audio_manager();
 
 		bool make_current();
+
+		/* 
+			Counted by the backend since the device was opened.
+			Always 0 for loopback devices and backends that cannot tell.
+		*/
+
+		unsigned get_underruns() const;
+
+		/*
+			Time between the mixer and the speakers, as the backend last measured it.
+			0 for loopback devices and backends that cannot tell.
+		*/
+
+		double get_output_delay_ms() const;
+
+		/*
+			Directions the mixer looked up in its panning cache since the device was opened,
+			and how many of those it had to calculate anew.
+			Both 0 when the cache is turned off.
+		*/
+
+		unsigned get_panning_cache_hits() const;
+		unsigned get_panning_cache_misses() const;
+
+		/*
+			Scheduling the thread mixing for the device ended up with.
+			Known once it has mixed for the first time.
+		*/
+
+		std::string describe_mixer_thread_schedule() const;
+
+		/*
+			The mixer's updates from the one numbered next_update on, timed with the same counter as tsc_clock.
+			Advances next_update past those returned.
+			The device only keeps the last 256 updates, so poll more often than they take.
+		*/
+
+		std::vector<zone_record> get_mixer_zones(std::uint64_t& next_update) const;
+
+		/*
+			Resets the device to play in periods of about this many frames.
+			Returns the period size the backend settled on, or 0 if it refused.
+		*/
+
+		unsigned request_period_size(const unsigned frames);
+
+		void render_loopback(float* const interleaved_stereo_output, const int frames);
 	};
 }
\ No newline at end of file
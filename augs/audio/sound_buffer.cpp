@@ -1,4 +1,13 @@
 #include <array>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOUND_ENVELOPE_SSE2 1
+#include <emmintrin.h>
+#else
+#define SOUND_ENVELOPE_SSE2 0
+#endif
 
 #include <AL/al.h>
 #include <AL/alc.h>
@@ -12,6 +21,65 @@
 #include "augs/filesystem/file.h"
 #include "augs/audio/sound_buffer.h"
 
+struct block_loudness {
+	int peak = 0;
+	unsigned long long sum_of_squares = 0;
+};
+
+static block_loudness measure_block(const int16_t* const samples, const size_t count) {
+	block_loudness result;
+	int lowest = 0;
+	int highest = 0;
+	size_t i = 0;
+
+#if SOUND_ENVELOPE_SSE2
+	/*
+		Eight samples at a time. A pair of squares can reach 2^31, which only fits unsigned,
+		so the madd results are widened to 64 bits as unsigned before being summed.
+	*/
+
+	const __m128i zero = _mm_setzero_si128();
+	__m128i mins = zero;
+	__m128i maxs = zero;
+	__m128i sums = zero;
+
+	for (; i + 8 <= count; i += 8) {
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + i));
+		const __m128i squares = _mm_madd_epi16(v, v);
+
+		mins = _mm_min_epi16(mins, v);
+		maxs = _mm_max_epi16(maxs, v);
+		sums = _mm_add_epi64(sums, _mm_unpacklo_epi32(squares, zero));
+		sums = _mm_add_epi64(sums, _mm_unpackhi_epi32(squares, zero));
+	}
+
+	alignas(16) int16_t lanes_min[8];
+	alignas(16) int16_t lanes_max[8];
+	alignas(16) unsigned long long lanes_sum[2];
+
+	_mm_store_si128(reinterpret_cast<__m128i*>(lanes_min), mins);
+	_mm_store_si128(reinterpret_cast<__m128i*>(lanes_max), maxs);
+	_mm_store_si128(reinterpret_cast<__m128i*>(lanes_sum), sums);
+
+	for (int l = 0; l < 8; ++l) {
+		lowest = std::min(lowest, static_cast<int>(lanes_min[l]));
+		highest = std::max(highest, static_cast<int>(lanes_max[l]));
+	}
+
+	result.sum_of_squares = lanes_sum[0] + lanes_sum[1];
+#endif
+
+	for (; i < count; ++i) {
+		const int s = samples[i];
+		lowest = std::min(lowest, s);
+		highest = std::max(highest, s);
+		result.sum_of_squares += static_cast<unsigned long long>(s * s);
+	}
+
+	result.peak = std::max(highest, -lowest);
+	return result;
+}
+
 namespace augs {
 	single_sound_buffer::~single_sound_buffer() {
 		if (initialized) {
@@ -24,6 +92,7 @@ namespace augs {
 		std::swap(initialized, b.initialized);
 		std::swap(computed_length_in_seconds, b.computed_length_in_seconds);
 		std::swap(id, b.id);
+		std::swap(envelope, b.envelope);
 		return *this;
 	}
 	
@@ -49,9 +118,11 @@ namespace augs {
 		const auto passed_frequency = new_data.frequency;
 		const auto passed_bytesize = new_data.samples.size() * sizeof(int16_t);
 		computed_length_in_seconds = new_data.compute_length_in_seconds();
+		envelope = compute_sound_envelope(new_data);
 
 #if LOG_AUDIO_BUFFERS
 		LOG("Passed format: %x\nPassed frequency: %x\nPassed bytesize: %x", passed_format, passed_frequency, passed_bytesize);
+		LOG("Peak: %x\nRMS: %x\nEnvelope blocks: %x", envelope.get_peak(), envelope.get_rms(), envelope.peaks.size());
 #endif
 
 		AL_CHECK(alBufferData(id, passed_format, new_data.samples.data(), passed_bytesize, passed_frequency));
@@ -86,6 +157,47 @@ namespace augs {
 		return computed_length_in_seconds;
 	}
 
+	const sound_envelope& single_sound_buffer::get_envelope() const {
+		return envelope;
+	}
+
+	float sound_envelope::get_peak() const {
+		return peaks.empty() ? 0.f : *std::max_element(peaks.begin(), peaks.end());
+	}
+
+	float sound_envelope::get_rms() const {
+		double sum_of_squares = 0.0;
+
+		for (const auto r : rms) {
+			sum_of_squares += static_cast<double>(r) * r;
+		}
+
+		/* Only exact when all blocks are full, which is close enough for a whole-sound figure. */
+		return rms.empty() ? 0.f : static_cast<float>(std::sqrt(sum_of_squares / rms.size()));
+	}
+
+	sound_envelope compute_sound_envelope(const single_sound_buffer::data_type& data, const unsigned frames_per_block) {
+		sound_envelope output;
+		output.frames_per_block = frames_per_block;
+
+		const size_t channels = static_cast<size_t>(std::max(data.channels, 1));
+		const size_t samples_per_block = frames_per_block * channels;
+		const size_t total = data.samples.size();
+
+		output.peaks.reserve((total + samples_per_block - 1) / samples_per_block);
+		output.rms.reserve(output.peaks.capacity());
+
+		for (size_t start = 0; start < total; start += samples_per_block) {
+			const size_t count = std::min(samples_per_block, total - start);
+			const auto block = measure_block(data.samples.data() + start, count);
+
+			output.peaks.push_back(block.peak / 32768.f);
+			output.rms.push_back(static_cast<float>(std::sqrt(static_cast<double>(block.sum_of_squares) / count) / 32768.0));
+		}
+
+		return output;
+	}
+
 	single_sound_buffer& sound_buffer::variation::request_original() {
 		if (original_channels == 1) {
 			return mono;
@@ -6,10 +6,26 @@ typedef unsigned int ALuint;
 class assets_manager;
 
 namespace augs {
+	/*
+		Loudness of a sound over time, for deciding what is quiet enough to cull or steal
+		and how loud a whole pack is. Each block spans frames_per_block frames of all channels;
+		values are relative to full scale, so between 0 and 1.
+	*/
+
+	struct sound_envelope {
+		unsigned frames_per_block = 0;
+		std::vector<float> peaks;
+		std::vector<float> rms;
+
+		float get_peak() const;
+		float get_rms() const;
+	};
+
 	class single_sound_buffer {
 		double computed_length_in_seconds = 0.0;
 		bool initialized = false;
 		ALuint id = 0;
+		sound_envelope envelope;
 
 	public:
 		struct data_type {
@@ -35,6 +51,7 @@ namespace augs {
 		bool is_set() const;
 
 		double get_length_in_seconds() const;
+		const sound_envelope& get_envelope() const;
 
 		ALuint get_id() const;
 		operator ALuint() const;
@@ -79,6 +96,7 @@ namespace augs {
 	};
 
 	single_sound_buffer::data_type get_sound_samples_from_file(const std::string);
+	sound_envelope compute_sound_envelope(const single_sound_buffer::data_type&, const unsigned frames_per_block = 256);
 	std::vector<int16_t> mix_stereo_to_mono(const std::vector<int16_t>&);
 	single_sound_buffer::data_type mix_stereo_to_mono(const single_sound_buffer::data_type& source);
 }
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include <AL/efx.h>
 
 #include "augs/al_log.h"
+#include "augs/misc/instrumentation.h"
 #include "augs/math/vec2.h"
 #include "augs/math/si_scaling.h"
 
@@ -178,10 +179,17 @@ namespace augs {
 
 	bool sound_source::is_playing() const {
 		ALenum state = 0xdeadbeef;
+		INSTRUMENT_COUNT(AL_GET_SOURCEI_CALLS);
 		AL_CHECK(alGetSourcei(id, AL_SOURCE_STATE, &state));
 		return state == AL_PLAYING;
 	}
 
+	std::array<double, 2> sound_source::get_offset_and_latency_in_seconds() const {
+		std::array<double, 2> offset_and_latency = { 0.0, 0.0 };
+		AL_CHECK(alGetSourcedvSOFT(id, AL_SEC_OFFSET_LATENCY_SOFT, offset_and_latency.data()));
+		return offset_and_latency;
+	}
+
 	void sound_source::bind_buffer(const single_sound_buffer& buf) {
 		attached_buffer = &buf;
 		AL_CHECK(alSourcei(id, AL_BUFFER, buf.get_id()));
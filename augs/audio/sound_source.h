@@ -45,6 +45,9 @@ namespace augs {
 		float get_pitch() const;
 		bool is_playing() const;
 
+		/* first value is the playback offset, second is the time until the sample at that offset is heard */
+		std::array<double, 2> get_offset_and_latency_in_seconds() const;
+
 		void bind_buffer(const single_sound_buffer&);
 		void unbind_buffer();
 		const single_sound_buffer* get_bound_buffer() const;
@@ -0,0 +1,2 @@
+#pragma once
+#define ENABLE_INSTRUMENTATION 1
\ No newline at end of file
@@ -0,0 +1,2 @@
+#pragma once
+#define ENABLE_ZONE_PROFILER 1
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include "hdr_histogram.h"
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "augs/misc/typesafe_sprintf.h"
+
+static unsigned most_significant_bit(const std::uint64_t value) {
+#ifdef _MSC_VER
+	unsigned long index = 0;
+	_BitScanReverse64(&index, value);
+	return static_cast<unsigned>(index);
+#else
+	return 63u - static_cast<unsigned>(__builtin_clzll(value));
+#endif
+}
+
+namespace augs {
+	unsigned hdr_histogram::get_bucket_index(const std::uint64_t value) {
+		if (value < sub_bucket_count) {
+			return static_cast<unsigned>(value);
+		}
+
+		const auto msb = most_significant_bit(value);
+		const auto shift = msb - sub_bucket_bits;
+		const auto sub_bucket = static_cast<unsigned>(value >> shift) - sub_bucket_count;
+
+		return (shift + 1) * sub_bucket_count + sub_bucket;
+	}
+
+	std::uint64_t hdr_histogram::get_lowest_equivalent_value(const unsigned bucket_index) {
+		if (bucket_index < sub_bucket_count) {
+			return bucket_index;
+		}
+
+		const auto shift = bucket_index / sub_bucket_count - 1;
+		const auto sub_bucket = bucket_index % sub_bucket_count;
+
+		return static_cast<std::uint64_t>(sub_bucket_count + sub_bucket) << shift;
+	}
+
+	std::uint64_t hdr_histogram::get_highest_equivalent_value(const unsigned bucket_index) {
+		if (bucket_index < sub_bucket_count) {
+			return bucket_index;
+		}
+
+		const auto shift = bucket_index / sub_bucket_count - 1;
+		return get_lowest_equivalent_value(bucket_index) + ((std::uint64_t(1) << shift) - 1);
+	}
+
+	void hdr_histogram::record(const std::uint64_t value) {
+		record(value, 1);
+	}
+
+	void hdr_histogram::record(const std::uint64_t value, const std::uint64_t times) {
+		counts[get_bucket_index(value)] += times;
+
+		total_count += times;
+		total_sum += value * times;
+		min_value = std::min(min_value, value);
+		max_value = std::max(max_value, value);
+	}
+
+	void hdr_histogram::merge(const hdr_histogram& b) {
+		for (unsigned i = 0; i < bucket_count; ++i) {
+			counts[i] += b.counts[i];
+		}
+
+		total_count += b.total_count;
+		total_sum += b.total_sum;
+		min_value = std::min(min_value, b.min_value);
+		max_value = std::max(max_value, b.max_value);
+	}
+
+	hdr_histogram& hdr_histogram::operator+=(const hdr_histogram& b) {
+		merge(b);
+		return *this;
+	}
+
+	hdr_histogram hdr_histogram::snapshot() const {
+		return *this;
+	}
+
+	void hdr_histogram::reset() {
+		*this = hdr_histogram();
+	}
+
+	std::uint64_t hdr_histogram::get_value_at_percentile(const double percentile) const {
+		if (total_count == 0) {
+			return 0;
+		}
+
+		const auto clamped = std::min(std::max(percentile, 0.0), 100.0);
+		const auto wanted_count = std::max(
+			std::uint64_t(1),
+			static_cast<std::uint64_t>(clamped / 100.0 * total_count + 0.5)
+		);
+
+		std::uint64_t accumulated = 0;
+
+		for (unsigned i = 0; i < bucket_count; ++i) {
+			accumulated += counts[i];
+
+			if (accumulated >= wanted_count) {
+				return std::min(get_highest_equivalent_value(i), max_value);
+			}
+		}
+
+		return max_value;
+	}
+
+	std::uint64_t hdr_histogram::get_count() const {
+		return total_count;
+	}
+
+	std::uint64_t hdr_histogram::get_min() const {
+		return total_count == 0 ? 0 : min_value;
+	}
+
+	std::uint64_t hdr_histogram::get_max() const {
+		return max_value;
+	}
+
+	double hdr_histogram::get_mean() const {
+		return total_count == 0 ? 0.0 : static_cast<double>(total_sum) / total_count;
+	}
+
+	std::string hdr_histogram::summary(
+		const std::string& title,
+		const double unit_divisor,
+		const std::string& unit_name
+	) const {
+		const auto in_units = [unit_divisor](const double v) {
+			return v / unit_divisor;
+		};
+
+		return typesafe_sprintf(
+			"%x: count=%x mean=%x%x p50=%x%x p90=%x%x p99=%x%x p99.9=%x%x max=%x%x\n",
+			title,
+			get_count(),
+			in_units(get_mean()), unit_name,
+			in_units(static_cast<double>(get_value_at_percentile(50.0))), unit_name,
+			in_units(static_cast<double>(get_value_at_percentile(90.0))), unit_name,
+			in_units(static_cast<double>(get_value_at_percentile(99.0))), unit_name,
+			in_units(static_cast<double>(get_value_at_percentile(99.9))), unit_name,
+			in_units(static_cast<double>(get_max())), unit_name
+		);
+	}
+}
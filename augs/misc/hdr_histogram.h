@@ -0,0 +1,64 @@
+#pragma once
+#include <array>
+#include <string>
+#include <cstdint>
+
+namespace augs {
+	/*
+		Log-bucketed histogram of unsigned integer values (e.g. nanoseconds).
+
+		Every power of two is split into sub_bucket_count linear sub-buckets,
+		so the relative error of any reported value is at most 1 / sub_bucket_count,
+		while the whole 64-bit range fits in a fixed-size counts array.
+
+		Recording is O(1) and does not allocate.
+		Two histograms can be merged by simply adding their counts.
+	*/
+
+	class hdr_histogram {
+	public:
+		static constexpr unsigned sub_bucket_bits = 5;
+		static constexpr unsigned sub_bucket_count = 1u << sub_bucket_bits;
+		static constexpr unsigned bucket_count = (64 - sub_bucket_bits + 1) * sub_bucket_count;
+
+	private:
+		std::array<std::uint64_t, bucket_count> counts = {};
+
+		std::uint64_t total_count = 0;
+		std::uint64_t total_sum = 0;
+		std::uint64_t min_value = UINT64_MAX;
+		std::uint64_t max_value = 0;
+
+	public:
+		static unsigned get_bucket_index(const std::uint64_t value);
+		static std::uint64_t get_lowest_equivalent_value(const unsigned bucket_index);
+		static std::uint64_t get_highest_equivalent_value(const unsigned bucket_index);
+
+		void record(const std::uint64_t value);
+		void record(const std::uint64_t value, const std::uint64_t times);
+
+		void merge(const hdr_histogram&);
+		hdr_histogram& operator+=(const hdr_histogram&);
+
+		hdr_histogram snapshot() const;
+		void reset();
+
+		std::uint64_t get_value_at_percentile(const double percentile) const;
+
+		std::uint64_t get_count() const;
+		std::uint64_t get_min() const;
+		std::uint64_t get_max() const;
+		double get_mean() const;
+
+		/*
+			Prints count, mean, p50, p90, p99, p99.9 and max,
+			with all values divided by unit_divisor (e.g. 1000 to print microseconds out of nanoseconds).
+		*/
+
+		std::string summary(
+			const std::string& title,
+			const double unit_divisor = 1.0,
+			const std::string& unit_name = ""
+		) const;
+	};
+}
@@ -0,0 +1,125 @@
+#include "instrumentation.h"
+#include "augs/filesystem/file.h"
+#include "augs/misc/typesafe_sprintf.h"
+
+namespace augs {
+	const char* get_metric_name(const instrumented_counter c) {
+		switch (c) {
+		case instrumented_counter::EVENTS_CAPTURED: return "events_captured_total";
+		case instrumented_counter::VOICES_STARTED: return "voices_started_total";
+		case instrumented_counter::AL_GET_SOURCEI_CALLS: return "al_get_sourcei_calls_total";
+		case instrumented_counter::BUFFER_CACHE_HITS: return "buffer_cache_hits_total";
+		case instrumented_counter::BUFFER_CACHE_MISSES: return "buffer_cache_misses_total";
+		case instrumented_counter::MUTED_NANOSECONDS: return "muted_nanoseconds_total";
+		default: return "unknown";
+		}
+	}
+
+	const char* get_metric_name(const instrumented_gauge g) {
+		switch (g) {
+		case instrumented_gauge::SOURCES_LIVE: return "sources_live";
+		case instrumented_gauge::AL_POOLED_ALLOCATIONS: return "al_pooled_allocations";
+		case instrumented_gauge::AL_SYSTEM_ALLOCATIONS: return "al_system_allocations";
+		case instrumented_gauge::AL_VOICES_VISITED: return "al_voices_visited";
+		case instrumented_gauge::AL_VOICES_SKIPPED: return "al_voices_skipped";
+		case instrumented_gauge::AL_VOICE_UPDATES: return "al_voice_updates";
+		case instrumented_gauge::AL_VOICE_UPDATES_CULLED: return "al_voice_updates_culled";
+		case instrumented_gauge::OUTPUT_UNDERRUNS: return "output_underruns";
+		case instrumented_gauge::OUTPUT_DELAY_MICROSECONDS: return "output_delay_us";
+		case instrumented_gauge::PANNING_CACHE_HITS: return "panning_cache_hits";
+		case instrumented_gauge::PANNING_CACHE_MISSES: return "panning_cache_misses";
+		default: return "unknown";
+		}
+	}
+
+	namespace instrumentation {
+		static per_thread_metrics all_threads_metrics[max_threads];
+		static std::atomic<unsigned> claimed_blocks = { 0u };
+
+		per_thread_metrics& get_this_thread_metrics() {
+			thread_local per_thread_metrics* this_thread_metrics = nullptr;
+
+			if (this_thread_metrics == nullptr) {
+				const auto index = claimed_blocks.fetch_add(1u);
+
+				/* 
+					If there ever are more threads than blocks, the surplus ones share the last block.
+					Their increments may then race, but nothing else breaks.
+				*/
+
+				this_thread_metrics = &all_threads_metrics[index < max_threads ? index : max_threads - 1];
+			}
+
+			return *this_thread_metrics;
+		}
+
+		static unsigned get_claimed_count() {
+			const auto claimed = claimed_blocks.load();
+			return claimed < max_threads ? claimed : max_threads;
+		}
+
+		std::uint64_t get_total(const instrumented_counter c) {
+			std::uint64_t total = 0;
+
+			for (unsigned i = 0; i < get_claimed_count(); ++i) {
+				total += all_threads_metrics[i].counters[c].load(std::memory_order_relaxed);
+			}
+
+			return total;
+		}
+
+		std::int64_t get_total(const instrumented_gauge g) {
+			std::int64_t total = 0;
+
+			for (unsigned i = 0; i < get_claimed_count(); ++i) {
+				total += all_threads_metrics[i].gauges[g].load(std::memory_order_relaxed);
+			}
+
+			return total;
+		}
+
+		std::string dump_all() {
+			const auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+				std::chrono::system_clock::now().time_since_epoch()
+			).count();
+
+			std::string output = typesafe_sprintf("timestamp_ms %x\n", now);
+
+			for (std::size_t i = 0; i < static_cast<std::size_t>(instrumented_counter::COUNT); ++i) {
+				const auto c = static_cast<instrumented_counter>(i);
+				output += typesafe_sprintf("%x %x\n", get_metric_name(c), get_total(c));
+			}
+
+			for (std::size_t i = 0; i < static_cast<std::size_t>(instrumented_gauge::COUNT); ++i) {
+				const auto g = static_cast<instrumented_gauge>(i);
+				output += typesafe_sprintf("%x %x\n", get_metric_name(g), get_total(g));
+			}
+
+			return output;
+		}
+	}
+
+	metrics_dump_thread::metrics_dump_thread(
+		const std::string& path,
+		const std::chrono::milliseconds interval
+	) : worker([this, path, interval]() {
+		auto next_dump = std::chrono::steady_clock::now() + interval;
+
+		while (!should_quit.load()) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+			if (std::chrono::steady_clock::now() >= next_dump) {
+				augs::create_text_file(path, instrumentation::dump_all());
+				next_dump += interval;
+			}
+		}
+
+		augs::create_text_file(path, instrumentation::dump_all());
+	}) {
+	}
+
+	metrics_dump_thread::~metrics_dump_thread() {
+		should_quit = true;
+		worker.join();
+	}
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <atomic>
+#include <thread>
+#include <string>
+#include <chrono>
+#include <cstdint>
+
+#include "augs/misc/enum_array.h"
+#include "augs/build_settings/setting_enable_instrumentation.h"
+
+namespace augs {
+	enum class instrumented_counter {
+		EVENTS_CAPTURED,
+		VOICES_STARTED,
+		AL_GET_SOURCEI_CALLS,
+		BUFFER_CACHE_HITS,
+		BUFFER_CACHE_MISSES,
+		MUTED_NANOSECONDS,
+
+		COUNT
+	};
+
+	enum class instrumented_gauge {
+		SOURCES_LIVE,
+		AL_POOLED_ALLOCATIONS,
+		AL_SYSTEM_ALLOCATIONS,
+		AL_VOICES_VISITED,
+		AL_VOICES_SKIPPED,
+		AL_VOICE_UPDATES,
+		AL_VOICE_UPDATES_CULLED,
+		OUTPUT_UNDERRUNS,
+		OUTPUT_DELAY_MICROSECONDS,
+		PANNING_CACHE_HITS,
+		PANNING_CACHE_MISSES,
+
+		COUNT
+	};
+
+	const char* get_metric_name(const instrumented_counter);
+	const char* get_metric_name(const instrumented_gauge);
+
+	namespace instrumentation {
+		/*
+			Every thread that touches a metric claims one of these blocks on first use.
+			Only the owning thread ever writes to its block, so relaxed stores suffice;
+			the dump thread sums all claimed blocks without taking any lock.
+		*/
+
+		struct alignas(64) per_thread_metrics {
+			enum_array<std::atomic<std::uint64_t>, instrumented_counter> counters;
+			enum_array<std::atomic<std::int64_t>, instrumented_gauge> gauges;
+		};
+
+		static constexpr unsigned max_threads = 64;
+
+		per_thread_metrics& get_this_thread_metrics();
+
+		inline void add(const instrumented_counter c, const std::uint64_t amount) {
+			auto& counter = get_this_thread_metrics().counters[c];
+			counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+		}
+
+		inline void set(const instrumented_gauge g, const std::int64_t value) {
+			get_this_thread_metrics().gauges[g].store(value, std::memory_order_relaxed);
+		}
+
+		std::uint64_t get_total(const instrumented_counter);
+		std::int64_t get_total(const instrumented_gauge);
+
+		/* one "name value" pair per line */
+		std::string dump_all();
+	}
+
+	class metrics_dump_thread {
+		std::atomic<bool> should_quit = { false };
+		std::thread worker;
+
+		metrics_dump_thread(const metrics_dump_thread&) = delete;
+		metrics_dump_thread& operator=(const metrics_dump_thread&) = delete;
+
+	public:
+		metrics_dump_thread(
+			const std::string& path,
+			const std::chrono::milliseconds interval
+		);
+
+		~metrics_dump_thread();
+	};
+}
+
+#if ENABLE_INSTRUMENTATION
+#define INSTRUMENT_COUNT(counter) augs::instrumentation::add(augs::instrumented_counter::counter, 1u)
+#define INSTRUMENT_ADD(counter, amount) augs::instrumentation::add(augs::instrumented_counter::counter, amount)
+#define INSTRUMENT_GAUGE(gauge, value) augs::instrumentation::set(augs::instrumented_gauge::gauge, value)
+#else
+#define INSTRUMENT_COUNT(counter)
+#define INSTRUMENT_ADD(counter, amount)
+#define INSTRUMENT_GAUGE(gauge, value)
+#endif
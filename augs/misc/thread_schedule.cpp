@@ -0,0 +1,128 @@
+#include <algorithm>
+#include "thread_schedule.h"
+
+#ifdef PLATFORM_WINDOWS
+#include <Windows.h>
+#elif PLATFORM_LINUX
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "augs/misc/typesafe_sprintf.h"
+
+namespace augs {
+#ifdef PLATFORM_WINDOWS
+	bool apply_to_current_thread(const thread_schedule schedule) {
+		bool applied = true;
+		const auto thread = GetCurrentThread();
+
+		if (schedule.priority > 0) {
+			const int priority =
+				schedule.priority == 1 ? THREAD_PRIORITY_ABOVE_NORMAL :
+				schedule.priority == 2 ? THREAD_PRIORITY_HIGHEST :
+				THREAD_PRIORITY_TIME_CRITICAL
+			;
+
+			applied = SetThreadPriority(thread, priority) != 0 && applied;
+		}
+
+		if (schedule.cpu_mask != 0) {
+			applied = SetThreadAffinityMask(thread, static_cast<DWORD_PTR>(schedule.cpu_mask)) != 0 && applied;
+		}
+
+		return applied;
+	}
+
+	std::string describe_current_thread_schedule() {
+		const auto thread = GetCurrentThread();
+		const auto priority = GetThreadPriority(thread);
+
+		/* There is no getter for a thread's affinity; setting it returns the previous one. */
+		DWORD_PTR process_mask = 0;
+		DWORD_PTR system_mask = 0;
+		DWORD_PTR thread_mask = 0;
+
+		if (GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask)) {
+			thread_mask = SetThreadAffinityMask(thread, process_mask);
+
+			if (thread_mask != 0) {
+				SetThreadAffinityMask(thread, thread_mask);
+			}
+		}
+
+		const auto priority_name =
+			priority == THREAD_PRIORITY_TIME_CRITICAL ? "time-critical" :
+			priority == THREAD_PRIORITY_HIGHEST ? "highest" :
+			priority == THREAD_PRIORITY_ABOVE_NORMAL ? "above normal" :
+			priority == THREAD_PRIORITY_NORMAL ? "normal" :
+			"below normal"
+		;
+
+		return typesafe_sprintf("priority %x (%x), cpu mask %x", priority_name, priority, static_cast<unsigned long long>(thread_mask));
+	}
+#elif PLATFORM_LINUX
+	bool apply_to_current_thread(const thread_schedule schedule) {
+		bool applied = true;
+
+		if (schedule.priority > 0) {
+			sched_param param;
+			param.sched_priority = std::min(
+				sched_get_priority_min(SCHED_FIFO) + static_cast<int>(schedule.priority) - 1,
+				sched_get_priority_max(SCHED_FIFO)
+			);
+
+			applied = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0 && applied;
+		}
+
+		if (schedule.cpu_mask != 0) {
+			cpu_set_t set;
+			CPU_ZERO(&set);
+
+			for (int i = 0; i < 64; ++i) {
+				if ((schedule.cpu_mask >> i) & 1) {
+					CPU_SET(i, &set);
+				}
+			}
+
+			/* 0 stands for the calling thread. */
+			applied = sched_setaffinity(0, sizeof(set), &set) == 0 && applied;
+		}
+
+		return applied;
+	}
+
+	std::string describe_current_thread_schedule() {
+		int policy = SCHED_OTHER;
+		sched_param param;
+		param.sched_priority = 0;
+		pthread_getschedparam(pthread_self(), &policy, &param);
+
+		unsigned long long thread_mask = 0;
+		cpu_set_t set;
+
+		if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+			for (int i = 0; i < 64; ++i) {
+				if (CPU_ISSET(i, &set)) {
+					thread_mask |= 1ull << i;
+				}
+			}
+		}
+
+		const auto policy_name =
+			policy == SCHED_FIFO ? "SCHED_FIFO" :
+			policy == SCHED_RR ? "SCHED_RR" :
+			"SCHED_OTHER"
+		;
+
+		return typesafe_sprintf("%x priority %x, cpu mask %x", policy_name, param.sched_priority, thread_mask);
+	}
+#else
+	bool apply_to_current_thread(const thread_schedule schedule) {
+		return schedule.priority == 0 && schedule.cpu_mask == 0;
+	}
+
+	std::string describe_current_thread_schedule() {
+		return "unknown";
+	}
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#pragma once
+#include <string>
+
+namespace augs {
+	/*
+		Real-time priority and allowed cores for one of the program's threads.
+		Zeros leave the thread as the system made it.
+
+		A priority of 1 and up puts the thread in SCHED_FIFO on Linux, counting up from the lowest
+		real-time priority. Windows has no such class, so 1 maps to above normal, 2 to highest
+		and 3 or more to time-critical.
+
+		Bit n of cpu_mask allows the thread on core n.
+	*/
+
+	struct thread_schedule {
+		unsigned priority = 0;
+		unsigned long long cpu_mask = 0;
+	};
+
+	bool apply_to_current_thread(const thread_schedule);
+	std::string describe_current_thread_schedule();
+}
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include "zone_profiler.h"
+
+#include <mutex>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <fstream>
+#include <iomanip>
+#include <cstring>
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define HAS_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAS_TSC 1
+#else
+#define HAS_TSC 0
+#endif
+
+static std::atomic<double> ticks_per_nanosecond = { 1.0 };
+
+static std::mutex buffers_mutex;
+static std::vector<augs::zone_profiler::thread_buffer*> all_buffers;
+
+namespace augs {
+	std::uint64_t tsc_clock::now() {
+#if HAS_TSC
+		return __rdtsc();
+#else
+		return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()
+		).count());
+#endif
+	}
+
+	void tsc_clock::calibrate() {
+#if HAS_TSC
+		using namespace std::chrono;
+
+		const auto wall_begin = steady_clock::now();
+		const auto ticks_begin = now();
+
+		std::this_thread::sleep_for(milliseconds(20));
+
+		const auto ticks_end = now();
+		const auto wall_end = steady_clock::now();
+
+		const auto elapsed_ns = duration_cast<nanoseconds>(wall_end - wall_begin).count();
+
+		if (elapsed_ns > 0 && ticks_end > ticks_begin) {
+			ticks_per_nanosecond = static_cast<double>(ticks_end - ticks_begin) / elapsed_ns;
+		}
+#endif
+	}
+
+	double tsc_clock::get_ticks_per_nanosecond() {
+		return ticks_per_nanosecond;
+	}
+
+	zone_profiler::thread_buffer& zone_profiler::get_this_thread_buffer() {
+		thread_local thread_buffer* this_thread_buffer = nullptr;
+
+		if (this_thread_buffer == nullptr) {
+			/*
+				Buffers are never freed so that the exporter may still read them after their thread exits.
+				The lock is only ever taken once per thread.
+			*/
+
+			this_thread_buffer = new thread_buffer;
+
+			std::unique_lock<std::mutex> lock(buffers_mutex);
+			this_thread_buffer->thread_index = static_cast<unsigned>(all_buffers.size());
+			all_buffers.push_back(this_thread_buffer);
+		}
+
+		return *this_thread_buffer;
+	}
+
+	zone_profiler::thread_buffer& zone_profiler::get_track_buffer(const char* const track_name) {
+		std::unique_lock<std::mutex> lock(buffers_mutex);
+
+		for (auto* b : all_buffers) {
+			if (b->track_name != nullptr && std::strcmp(b->track_name, track_name) == 0) {
+				return *b;
+			}
+		}
+
+		auto* const new_buffer = new thread_buffer;
+		new_buffer->thread_index = static_cast<unsigned>(all_buffers.size());
+		new_buffer->track_name = track_name;
+		all_buffers.push_back(new_buffer);
+
+		return *new_buffer;
+	}
+
+	void zone_profiler::export_chrome_trace(const std::string& path) {
+		/*
+			The owning thread might be overwriting the oldest entries while we read,
+			so leave a safety margin behind the write cursor.
+		*/
+
+		const std::uint64_t margin = 256;
+		const double ns_per_tick = 1.0 / tsc_clock::get_ticks_per_nanosecond();
+
+		std::uint64_t origin = UINT64_MAX;
+		std::vector<std::pair<const thread_buffer*, std::uint64_t>> exported;
+
+		{
+			std::unique_lock<std::mutex> lock(buffers_mutex);
+
+			for (const auto* b : all_buffers) {
+				exported.push_back({ b, b->written.load(std::memory_order_acquire) });
+			}
+		}
+
+		const auto first_index = [margin](const std::uint64_t written) {
+			return written > records_per_thread - margin ? written - (records_per_thread - margin) : 0u;
+		};
+
+		for (const auto& e : exported) {
+			for (auto i = first_index(e.second); i < e.second; ++i) {
+				origin = std::min(origin, e.first->records[i % records_per_thread].begin_ticks);
+			}
+		}
+
+		std::ofstream out(path, std::ios::out);
+		out << std::fixed << std::setprecision(3);
+		out << "{\"traceEvents\":[\n";
+
+		bool first = true;
+
+		for (const auto& e : exported) {
+			if (e.first->track_name != nullptr) {
+				if (!first) {
+					out << ",\n";
+				}
+
+				first = false;
+
+				out 
+					<< "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << e.first->thread_index
+					<< ",\"args\":{\"name\":\"" << e.first->track_name << "\"}}"
+				;
+			}
+
+			for (auto i = first_index(e.second); i < e.second; ++i) {
+				const auto& r = e.first->records[i % records_per_thread];
+
+				const auto ts_us = (r.begin_ticks - origin) * ns_per_tick / 1000.0;
+				const auto dur_us = (r.end_ticks - r.begin_ticks) * ns_per_tick / 1000.0;
+
+				if (!first) {
+					out << ",\n";
+				}
+
+				first = false;
+
+				out 
+					<< "{\"name\":\"" << r.name 
+					<< "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.first->thread_index
+					<< ",\"ts\":" << ts_us
+					<< ",\"dur\":" << dur_us
+					<< "}"
+				;
+			}
+		}
+
+		out << "\n]}\n";
+	}
+}
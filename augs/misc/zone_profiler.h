@@ -0,0 +1,85 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <cstdint>
+
+#include "augs/build_settings/setting_enable_zone_profiler.h"
+
+namespace augs {
+	/*
+		Reads the time-stamp counter where available,
+		otherwise falls back to steady_clock nanoseconds.
+		calibrate() measures how many ticks there are in a nanosecond.
+	*/
+
+	struct tsc_clock {
+		static std::uint64_t now();
+		static void calibrate();
+		static double get_ticks_per_nanosecond();
+	};
+
+	struct zone_record {
+		const char* name = nullptr;
+		std::uint64_t begin_ticks = 0;
+		std::uint64_t end_ticks = 0;
+	};
+
+	class zone_profiler {
+	public:
+		static constexpr std::size_t records_per_thread = 1 << 14;
+
+		/*
+			Only the owning thread writes to its ring;
+			the exporter reads everything published before the last release-store of "written".
+		*/
+
+		struct thread_buffer {
+			unsigned thread_index = 0;
+			const char* track_name = nullptr;
+			std::atomic<std::uint64_t> written = { 0u };
+			zone_record records[records_per_thread];
+
+			void push(const zone_record& r) {
+				const auto w = written.load(std::memory_order_relaxed);
+				records[w % records_per_thread] = r;
+				written.store(w + 1, std::memory_order_release);
+			}
+		};
+
+		static thread_buffer& get_this_thread_buffer();
+
+		/*
+			A track for zones timed outside of this process' scoped_zones,
+			e.g. by a library that reads the same counter as tsc_clock.
+			Only one thread may push to it.
+		*/
+
+		static thread_buffer& get_track_buffer(const char* const track_name);
+
+		/* writes all recorded zones of all threads in Chrome's Trace Event format */
+		static void export_chrome_trace(const std::string& path);
+	};
+
+	class scoped_zone {
+		const char* name;
+		std::uint64_t begin_ticks;
+
+		scoped_zone(const scoped_zone&) = delete;
+		scoped_zone& operator=(const scoped_zone&) = delete;
+
+	public:
+		scoped_zone(const char* const name) : name(name), begin_ticks(tsc_clock::now()) {}
+
+		~scoped_zone() {
+			zone_profiler::get_this_thread_buffer().push({ name, begin_ticks, tsc_clock::now() });
+		}
+	};
+}
+
+#if ENABLE_ZONE_PROFILER
+#define PROFILE_ZONE_CONCAT_DETAIL(a, b) a##b
+#define PROFILE_ZONE_CONCAT(a, b) PROFILE_ZONE_CONCAT_DETAIL(a, b)
+#define PROFILE_ZONE(name) augs::scoped_zone PROFILE_ZONE_CONCAT(profiled_zone_, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name)
+#endif
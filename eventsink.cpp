@@ -53,6 +53,19 @@ HRESULT EventSink::Indicate(long lObjectCount,
 	HRESULT hr = S_OK;
 	_variant_t vtProp;
 
+	/* WMI calls back on threads of its own choosing, so each one is set up the first time it shows up. */
+	thread_local bool thread_scheduled = false;
+
+	if (!thread_scheduled) {
+		thread_scheduled = true;
+
+		if (!augs::apply_to_current_thread(thread_schedule)) {
+			LOG("Could not apply the WMI thread priority or cpus.");
+		}
+
+		LOG("WMI callback thread: %x", augs::describe_current_thread_schedule());
+	}
+
 	for (int i = 0; i < lObjectCount; i++)
 	{
 		std::wstring procname;
@@ -9,6 +9,8 @@ using namespace std;
 #include <comdef.h>
 #include <Wbemidl.h>
 
+#include "augs/misc/thread_schedule.h"
+
 #pragma comment(lib, "wbemuuid.lib")
 
 class EventSink : public IWbemObjectSink
@@ -28,6 +30,7 @@ public:
 
 
 	std::vector<procentry> process_blacklist;
+	augs::thread_schedule thread_schedule;
 
 	bool is_any_on() const {
 		for(const auto& b : process_blacklist) {
@@ -62,4 +65,4 @@ public:
 
 extern EventSink* pSink;
 
-int makeeventsink(std::vector<std::string> blacklist_processes);
+int makeeventsink(std::vector<std::string> blacklist_processes, const augs::thread_schedule callback_thread = augs::thread_schedule());
@@ -1,7 +1,7 @@
 
 #include "eventsink.h"
 
-int makeeventsink(std::vector<std::string> blacklist_processes)
+int makeeventsink(std::vector<std::string> blacklist_processes, const augs::thread_schedule callback_thread)
 {
 	HRESULT hres;
 
@@ -125,6 +125,7 @@ int makeeventsink(std::vector<std::string> blacklist_processes)
 		(void**)&pUnsecApp);
 
 	pSink = new EventSink;
+	pSink->thread_schedule = callback_thread;
 	
 	for(const auto& p : blacklist_processes) {
 		pSink->process_blacklist.push_back({ p, false });
@@ -0,0 +1,151 @@
+#include <AL/al.h>
+#include <AL/alext.h>
+
+#include "keystroke_dispatch.h"
+
+#include "augs/filesystem/file.h"
+#include "augs/misc/instrumentation.h"
+#include "augs/misc/zone_profiler.h"
+#include "augs/templates/container_templates.h"
+
+void keystroke_latencies::save(const std::string& path) const {
+	augs::create_text_file(
+		path,
+		event_to_play.summary("event_to_play", 1000.0, "us")
+		+ event_to_audible.summary("event_to_audible", 1000.0, "us")
+	);
+}
+
+void register_key_emitter(key_state& subject_key) {
+	if (!alIsExtensionPresent("AL_SOFTX_static_emitters")) {
+		return;
+	}
+
+	const float position[3] = {
+		subject_key.position.x,
+		subject_key.position.y,
+		subject_key.position.z
+	};
+
+	ALuint emitter = 0;
+	alGenEmittersSOFTX(1, position, &emitter);
+
+	if (alGetError() == AL_NO_ERROR) {
+		subject_key.emitter = emitter;
+	}
+}
+
+void dispatch_keystroke(
+	key_state& subject_key,
+	const bool is_keydown,
+	const std::chrono::high_resolution_clock::time_point event_time,
+	sound_buffer_map& sound_buffers,
+	const float volume,
+	std::mt19937& rng,
+	keystroke_latencies& latencies,
+	std::vector<playing_sound>& sound_sources
+) {
+	PROFILE_ZONE("dispatch");
+
+	const auto& pair = subject_key.pairs[subject_key.next_pair_to_be_played];
+
+	augs::sound_source src;
+	src.bind_buffer(sound_buffers[is_keydown ? pair.down_sound_path : pair.up_sound_path]);
+	src.set_gain(volume);
+
+	if (subject_key.emitter != 0u) {
+		alSourcei(src.get_id(), AL_EMITTER_SOFTX, subject_key.emitter);
+	}
+	else {
+		alSource3f(
+			src.get_id(), 
+			AL_POSITION, 
+			subject_key.position.x, 
+			subject_key.position.y, 
+			subject_key.position.z
+		);
+	}
+
+	src.play();
+	INSTRUMENT_COUNT(VOICES_STARTED);
+	latencies.event_to_play.record(keystroke_latencies::nanoseconds_between(event_time, std::chrono::high_resolution_clock::now()));
+
+	sound_sources.push_back({ std::move(src), event_time });
+
+	if (!is_keydown) {
+		++subject_key.next_pair_to_be_played;
+
+		if (subject_key.next_pair_to_be_played == subject_key.pairs.size()) {
+			std::shuffle(subject_key.pairs.begin(), subject_key.pairs.end(), rng);
+			subject_key.next_pair_to_be_played = 0u;
+		}
+	}
+}
+
+void reap_playing_sounds(
+	keystroke_latencies& latencies,
+	std::vector<playing_sound>& sound_sources
+) {
+	PROFILE_ZONE("reap");
+
+	for (auto& s : sound_sources) {
+		if (s.audible_recorded) {
+			continue;
+		}
+
+		const auto offset_and_latency = s.source.get_offset_and_latency_in_seconds();
+
+		if (offset_and_latency[0] > 0.0) {
+			/* the first sample was mixed "offset" seconds ago and will be heard after "latency" seconds */
+			const auto first_sample_audible_after = std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(
+				std::chrono::duration<double>(offset_and_latency[1] - offset_and_latency[0])
+			);
+
+			latencies.event_to_audible.record(keystroke_latencies::nanoseconds_between(
+				s.event_time, 
+				std::chrono::high_resolution_clock::now() + first_sample_audible_after
+			));
+
+			s.audible_recorded = true;
+		}
+	}
+
+	erase_remove(
+		sound_sources,
+		[](const auto& s){
+			return !s.source.is_playing();
+		}
+	);
+
+	INSTRUMENT_GAUGE(SOURCES_LIVE, static_cast<std::int64_t>(sound_sources.size()));
+
+#if ENABLE_INSTRUMENTATION
+	/*
+		OpenAL's own allocation totals.
+		Once typing settles, al_system_allocations should stop growing.
+	*/
+
+	static const bool allocation_stats_present = alIsExtensionPresent("AL_SOFTX_allocation_stats") == AL_TRUE;
+
+	if (allocation_stats_present) {
+		INSTRUMENT_GAUGE(AL_POOLED_ALLOCATIONS, alGetInteger64SOFT(AL_POOLED_ALLOCATIONS_SOFTX));
+		INSTRUMENT_GAUGE(AL_SYSTEM_ALLOCATIONS, alGetInteger64SOFT(AL_SYSTEM_ALLOCATIONS_SOFTX));
+	}
+
+	/*
+		Voice slots the mixer went through and the ones it skipped as unused.
+		Visited per update should follow the number of sounds still playing, not the peak.
+		With cull_silent_voices_below_db set, culled / updates is the fraction of mixing
+		skipped for being inaudible.
+	*/
+
+	static const bool voice_stats_present = alIsExtensionPresent("AL_SOFTX_voice_stats") == AL_TRUE;
+
+	if (voice_stats_present) {
+		INSTRUMENT_GAUGE(AL_VOICES_VISITED, alGetInteger64SOFT(AL_VOICES_VISITED_SOFTX));
+		INSTRUMENT_GAUGE(AL_VOICES_SKIPPED, alGetInteger64SOFT(AL_VOICES_SKIPPED_SOFTX));
+		INSTRUMENT_GAUGE(AL_VOICE_UPDATES, alGetInteger64SOFT(AL_VOICE_UPDATES_SOFTX));
+		INSTRUMENT_GAUGE(AL_VOICE_UPDATES_CULLED, alGetInteger64SOFT(AL_VOICE_UPDATES_CULLED_SOFTX));
+	}
+#endif
+}
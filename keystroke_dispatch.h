@@ -0,0 +1,98 @@
+#pragma once
+#include <array>
+#include <random>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "augs/audio/sound_buffer.h"
+#include "augs/audio/sound_source.h"
+#include "augs/misc/hdr_histogram.h"
+
+struct vec3 {
+	float x = 0.f;
+	float y = 0.f;
+	float z = 0.f;
+
+	vec3 operator+(const vec3 b) const {
+		return { x + b.x, y + b.y, z + b.z };
+	}
+
+	vec3& operator*=(const float s) {
+		*this = vec3{ x * s, y * s, z * s };
+		return *this;
+	}
+};
+
+struct key_state {
+	struct sound_pair {
+		std::string down_sound_path;
+		std::string up_sound_path;
+	};
+
+	vec3 position;
+	/* Static emitter registered at the key's position, or 0 if unavailable. */
+	unsigned int emitter = 0u;
+	std::vector<sound_pair> pairs;
+	std::size_t next_pair_to_be_played = 0u;
+	bool is_pressed = false;
+};
+
+struct playing_sound {
+	augs::sound_source source;
+	std::chrono::high_resolution_clock::time_point event_time;
+	bool audible_recorded = false;
+};
+
+struct keystroke_latencies {
+	augs::hdr_histogram event_to_play;
+	augs::hdr_histogram event_to_audible;
+
+	static std::uint64_t nanoseconds_between(
+		const std::chrono::high_resolution_clock::time_point from,
+		const std::chrono::high_resolution_clock::time_point to
+	) {
+		const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count();
+		return ns > 0 ? static_cast<std::uint64_t>(ns) : 0u;
+	}
+
+	void save(const std::string& path) const;
+};
+
+typedef std::unordered_map<std::string, augs::single_sound_buffer> sound_buffer_map;
+
+/*
+	Registers the final position of a key as a static emitter,
+	so that OpenAL computes the spatialization parameters once per key
+	instead of once per keystroke. Does nothing if the extension is unavailable.
+*/
+
+void register_key_emitter(key_state& subject_key);
+
+/*
+	Starts the sound of a key that has just been pressed or released.
+	This is the only path from a captured keyboard event to alSourcePlay,
+	shared by the daemon and the latency benchmark.
+*/
+
+void dispatch_keystroke(
+	key_state& subject_key,
+	const bool is_keydown,
+	const std::chrono::high_resolution_clock::time_point event_time,
+	sound_buffer_map& sound_buffers,
+	const float volume,
+	std::mt19937& rng,
+	keystroke_latencies& latencies,
+	std::vector<playing_sound>& sound_sources
+);
+
+/* 
+	Records event-to-audible latency of the sounds that have just started mixing
+	and releases the sources that have stopped playing.
+*/
+
+void reap_playing_sounds(
+	keystroke_latencies& latencies,
+	std::vector<playing_sound>& sound_sources
+);
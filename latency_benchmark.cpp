@@ -0,0 +1,397 @@
+#include <array>
+#include <cmath>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <unordered_map>
+
+#include <AL/al.h>
+#include <AL/alc.h>
+
+#include "augs/audio/audio_manager.h"
+#include "augs/audio/sound_buffer.h"
+#include "augs/audio/sound_source.h"
+
+#include "augs/misc/hdr_histogram.h"
+#include "augs/misc/typesafe_sprintf.h"
+#include "augs/filesystem/file.h"
+#include "augs/filesystem/directory.h"
+
+#include "keystroke_dispatch.h"
+
+/*
+	Measures key-to-audible latency offline, on a loopback device.
+
+	Time is counted in rendered frames, so the results do not depend on the machine's load
+	and can be compared between runs:
+
+	- a keystroke happens at a random moment;
+	- the daemon notices it at the next poll, every sleep_every_iteration_for_microseconds;
+	- it is dispatched through the same dispatch_keystroke the daemon uses;
+	- the mixer renders blocks of period_size frames, each one at the moment its first frame would be queued;
+	- a rendered frame is heard (periods - 1) * period_size frames after it was rendered;
+	- the onset is the first rendered frame louder than onset_threshold.
+
+	Wall-clock cost of every rendered block is reported separately.
+	A block that takes longer to render than the (periods - 1) periods still queued would play
+	is counted as an underrun: a real device with the same periods would have crackled there.
+
+	With --device-delay 1, the default output device is also opened at every period size,
+	and the delay its backend measures is reported next to the (periods - 1) * period_size
+	the latencies assume, so the model can be checked against the hardware.
+*/
+
+struct benchmark_case {
+	unsigned period_size = 1024;
+	unsigned periods = 3;
+	unsigned sources = 1024;
+	unsigned long long sleep_every_iteration_for_microseconds = 0u;
+};
+
+struct benchmark_result {
+	benchmark_case setup;
+	unsigned missed_onsets = 0;
+	unsigned underruns = 0;
+	augs::hdr_histogram latency_ns;
+	augs::hdr_histogram render_ns_per_block;
+
+	double queued_ms = 0.0;
+	double device_delay_ms = -1.0;
+
+	static std::string get_csv_header() {
+		return "period_size,periods,sources,sleep_us,trials,missed,p50_ms,p90_ms,p99_ms,p999_ms,max_ms,render_p50_us,render_p99_us,underruns,queued_ms,device_delay_ms\n";
+	}
+
+	std::string to_csv_line() const {
+		const auto ms = [](const std::uint64_t ns) { return ns / 1000000.0; };
+		const auto us = [](const std::uint64_t ns) { return ns / 1000.0; };
+
+		return typesafe_sprintf(
+			"%x,%x,%x,%x,%x,%x,%x,%x,%x,%x,%x,%x,%x,%x,%x,%x\n",
+			setup.period_size,
+			setup.periods,
+			setup.sources,
+			setup.sleep_every_iteration_for_microseconds,
+			latency_ns.get_count(),
+			missed_onsets,
+			ms(latency_ns.get_value_at_percentile(50.0)),
+			ms(latency_ns.get_value_at_percentile(90.0)),
+			ms(latency_ns.get_value_at_percentile(99.0)),
+			ms(latency_ns.get_value_at_percentile(99.9)),
+			ms(latency_ns.get_max()),
+			us(render_ns_per_block.get_value_at_percentile(50.0)),
+			us(render_ns_per_block.get_value_at_percentile(99.0)),
+			underruns,
+			queued_ms,
+			device_delay_ms
+		);
+	}
+};
+
+struct benchmark_settings {
+	int frequency = 48000;
+	bool hrtf_enabled = true;
+	unsigned trials = 500;
+	float onset_threshold = 0.001f;
+	std::string sound_path = "sfx/keydown2.wav";
+	std::string output_path = "generated/logs/latency_benchmark.csv";
+	std::string baseline_path;
+	std::string write_baseline_path;
+	double allowed_regression = 0.05;
+	bool measure_device_delay = false;
+};
+
+/*
+	The device plays for a moment first, so that the backend has a delay to measure.
+	Only the period size can be asked for at runtime; the device keeps its own number of periods.
+*/
+
+static double measure_device_delay_ms(const unsigned period_size) {
+	augs::audio_manager output;
+
+	if (output.request_period_size(period_size) == 0) {
+		return -1.0;
+	}
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(250));
+	return output.get_output_delay_ms();
+}
+
+static benchmark_result run_case(
+	const benchmark_settings& settings,
+	const benchmark_case setup
+) {
+	/*
+		alsoft.ini is only read once per process,
+		so the swept parameters go through context attributes instead.
+	*/
+
+	augs::loopback_device_settings device_settings;
+	device_settings.frequency = settings.frequency;
+	device_settings.hrtf_enabled = settings.hrtf_enabled;
+	device_settings.max_number_of_sound_sources = static_cast<int>(setup.sources);
+
+	augs::audio_manager manager(device_settings);
+
+	const std::array<float, 6> listener_orientation = { 0.f, 0.f, -1.f, 0.f, 1.f, 0.f };
+	augs::set_listener_orientation(listener_orientation);
+	alListener3f(AL_POSITION, 5.f * 0.022f, 3.f * 0.022f, 4.f * 0.022f);
+
+	sound_buffer_map sound_buffers;
+	{
+		const auto samples = augs::get_sound_samples_from_file(settings.sound_path);
+		sound_buffers[settings.sound_path].set_data(samples.channels > 1 ? augs::mix_stereo_to_mono(samples) : samples);
+	}
+
+	key_state key;
+	key.position = { 2.2f * 0.022f, 3.5f * 0.022f, 0.f };
+	key.pairs.push_back({ settings.sound_path, settings.sound_path });
+	register_key_emitter(key);
+
+	std::mt19937 rng(1337u);
+	keystroke_latencies dispatch_latencies;
+	std::vector<playing_sound> sound_sources;
+
+	benchmark_result result;
+	result.setup = setup;
+
+	std::vector<float> block(setup.period_size * 2);
+	double rendered_frames = 0.0;
+
+	const auto frames_to_ns = [&settings](const double frames) {
+		return static_cast<std::uint64_t>(frames * 1e9 / settings.frequency);
+	};
+
+	const auto queued_ns = frames_to_ns(static_cast<double>((setup.periods - 1) * setup.period_size));
+	result.queued_ms = queued_ns / 1000000.0;
+
+	const auto render_block = [&]() {
+		const auto before = std::chrono::high_resolution_clock::now();
+		manager.render_loopback(block.data(), static_cast<int>(setup.period_size));
+		const auto after = std::chrono::high_resolution_clock::now();
+
+		const auto render_ns = keystroke_latencies::nanoseconds_between(before, after);
+
+		result.render_ns_per_block.record(render_ns);
+		rendered_frames += setup.period_size;
+
+		if (render_ns > queued_ns) {
+			++result.underruns;
+		}
+	};
+
+	const auto stop_all = [&]() {
+		for (auto& s : sound_sources) {
+			s.source.stop();
+		}
+
+		reap_playing_sounds(dispatch_latencies, sound_sources);
+		render_block();
+	};
+
+	/*
+		Leave the context in the state right after a typing burst:
+		as many voices as there are sources have been allocated and have finished.
+	*/
+
+	for (unsigned i = 0; i < setup.sources; ++i) {
+		dispatch_keystroke(key, true, std::chrono::high_resolution_clock::now(), sound_buffers, 1.f, rng, dispatch_latencies, sound_sources);
+	}
+
+	render_block();
+	stop_all();
+
+	const double frames_per_poll = std::max(1.0, setup.sleep_every_iteration_for_microseconds * settings.frequency / 1e6);
+	const unsigned max_blocks_until_onset = 1 + static_cast<unsigned>(settings.frequency / setup.period_size);
+
+	std::uniform_real_distribution<double> event_offset(0.0, static_cast<double>(setup.period_size * setup.periods));
+
+	for (unsigned trial = 0; trial < settings.trials; ++trial) {
+		const double event_frame = rendered_frames + event_offset(rng);
+		const double noticed_frame = std::ceil(event_frame / frames_per_poll) * frames_per_poll;
+
+		while (rendered_frames < noticed_frame) {
+			render_block();
+		}
+
+		dispatch_keystroke(key, true, std::chrono::high_resolution_clock::now(), sound_buffers, 1.f, rng, dispatch_latencies, sound_sources);
+
+		double onset_frame = -1.0;
+
+		for (unsigned b = 0; b < max_blocks_until_onset && onset_frame < 0.0; ++b) {
+			const auto block_start = rendered_frames;
+			render_block();
+
+			for (unsigned i = 0; i < setup.period_size; ++i) {
+				if (std::abs(block[i * 2]) > settings.onset_threshold || std::abs(block[i * 2 + 1]) > settings.onset_threshold) {
+					onset_frame = block_start + i;
+					break;
+				}
+			}
+		}
+
+		if (onset_frame < 0.0) {
+			++result.missed_onsets;
+		}
+		else {
+			const double heard_frame = onset_frame + (setup.periods - 1) * setup.period_size;
+			result.latency_ns.record(frames_to_ns(heard_frame - event_frame));
+		}
+
+		stop_all();
+	}
+
+	return result;
+}
+
+static std::unordered_map<std::string, double> read_baseline_p99(const std::string& path) {
+	std::unordered_map<std::string, double> p99_by_case;
+
+	const auto lines = augs::get_file_lines(path);
+
+	for (std::size_t i = 1; i < lines.size(); ++i) {
+		std::istringstream in(lines[i]);
+		std::vector<std::string> cells;
+		std::string cell;
+
+		while (std::getline(in, cell, ',')) {
+			cells.push_back(cell);
+		}
+
+		if (cells.size() >= 9) {
+			p99_by_case[cells[0] + "," + cells[1] + "," + cells[2] + "," + cells[3]] = std::stod(cells[8]);
+		}
+	}
+
+	return p99_by_case;
+}
+
+static std::string get_case_key(const benchmark_case& c) {
+	return typesafe_sprintf("%x,%x,%x,%x", c.period_size, c.periods, c.sources, c.sleep_every_iteration_for_microseconds);
+}
+
+int main(int argc, char** argv) {
+	benchmark_settings settings;
+
+	for (int i = 1; i + 1 < argc; i += 2) {
+		const std::string flag = argv[i];
+		const std::string value = argv[i + 1];
+
+		if (flag == "--trials") {
+			settings.trials = static_cast<unsigned>(std::stoul(value));
+		}
+		else if (flag == "--hrtf") {
+			settings.hrtf_enabled = value != "0";
+		}
+		else if (flag == "--frequency") {
+			settings.frequency = std::stoi(value);
+		}
+		else if (flag == "--sound") {
+			settings.sound_path = value;
+		}
+		else if (flag == "--output") {
+			settings.output_path = value;
+		}
+		else if (flag == "--baseline") {
+			settings.baseline_path = value;
+		}
+		else if (flag == "--write-baseline") {
+			settings.write_baseline_path = value;
+		}
+		else if (flag == "--allowed-regression") {
+			settings.allowed_regression = std::stod(value);
+		}
+		else if (flag == "--device-delay") {
+			settings.measure_device_delay = value != "0";
+		}
+		else {
+			std::cerr << "Unknown argument: " << flag << std::endl;
+			return 2;
+		}
+	}
+
+	augs::create_directories("generated/logs/");
+
+	std::string csv = benchmark_result::get_csv_header();
+	std::cout << csv;
+
+	std::unordered_map<std::string, double> baseline;
+
+	if (settings.baseline_path.size() > 0) {
+		baseline = read_baseline_p99(settings.baseline_path);
+	}
+
+	bool regressed = false;
+
+	/*
+		The periods of the default output next to what the low-latency profile may end up with.
+	*/
+
+	const std::pair<unsigned, unsigned> output_periods[] = {
+		{ 64u, 2u },
+		{ 128u, 2u },
+		{ 256u, 2u },
+		{ 256u, 3u },
+		{ 512u, 3u },
+		{ 1024u, 3u }
+	};
+
+	for (const auto& period : output_periods) {
+		const double device_delay_ms = settings.measure_device_delay ? measure_device_delay_ms(period.first) : -1.0;
+
+		for (const unsigned sources : { 64u, 256u, 1024u }) {
+			for (const unsigned long long sleep_us : { 0ull, 1000ull, 5000ull }) {
+				benchmark_case setup;
+				setup.period_size = period.first;
+				setup.periods = period.second;
+				setup.sources = sources;
+				setup.sleep_every_iteration_for_microseconds = sleep_us;
+
+				auto result = run_case(settings, setup);
+				result.device_delay_ms = device_delay_ms;
+
+				const auto line = result.to_csv_line();
+
+				std::cout << line;
+				csv += line;
+
+				const auto found = baseline.find(get_case_key(setup));
+
+				if (found != baseline.end()) {
+					const auto p99_ms = result.latency_ns.get_value_at_percentile(99.0) / 1000000.0;
+					const auto allowed_ms = found->second * (1.0 + settings.allowed_regression);
+
+					if (p99_ms > allowed_ms) {
+						std::cerr << typesafe_sprintf("REGRESSION %x: p99 %x ms > allowed %x ms\n", get_case_key(setup), p99_ms, allowed_ms);
+						regressed = true;
+					}
+				}
+
+				const auto period_ms = setup.period_size * 1000.0 / settings.frequency;
+
+				if (device_delay_ms >= 0.0 && std::abs(device_delay_ms - result.queued_ms) > period_ms) {
+					std::cerr << typesafe_sprintf("DELAY %x: the device measured %x ms, the model assumes %x ms\n", get_case_key(setup), device_delay_ms, result.queued_ms);
+				}
+
+				if (result.missed_onsets > 0) {
+					std::cerr << typesafe_sprintf("MISSED %x: %x onsets not detected\n", get_case_key(setup), result.missed_onsets);
+					regressed = true;
+				}
+			}
+		}
+	}
+
+	augs::create_text_file(settings.output_path, csv);
+
+	if (settings.write_baseline_path.size() > 0) {
+		augs::create_text_file(settings.write_baseline_path, csv);
+	}
+
+	return regressed ? 1 : 0;
+}
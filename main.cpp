@@ -13,6 +13,10 @@
 #include "augs/audio/sound_source.h"
 
 #include "augs/misc/typesafe_sscanf.h"
+#include "augs/misc/timer.h"
+#include "augs/misc/instrumentation.h"
+#include "augs/misc/zone_profiler.h"
+#include "augs/misc/thread_schedule.h"
 
 #include "augs/filesystem/directory.h"
 #include "augs/filesystem/file.h"
@@ -24,26 +28,12 @@
 
 #include "find_process_id.h"
 #include "eventsink.h"
+#include "keystroke_dispatch.h"
 
 #define LOG_PRESSES 0
 
 using namespace augs::window::event::keys;
 
-struct vec3 {
-	float x = 0.f;
-	float y = 0.f;
-	float z = 0.f;
-
-	vec3 operator+(const vec3 b) const {
-		return { x + b.x, y + b.y, z + b.z };
-	}
-
-	vec3& operator*=(const float s) {
-		*this = vec3{ x * s, y * s, z * s };
-		return *this;
-	}
-};
-
 std::istream& operator>>(std::istream& out, vec3& x) {
 	std::string chunk;
 	out >> chunk;
@@ -56,18 +46,6 @@ std::wostream& operator<<(std::wostream& out, const vec3& x) {
 	return out;
 }
 
-struct key_state {
-	struct sound_pair {
-		std::string down_sound_path;
-		std::string up_sound_path;
-	};
-
-	vec3 position;
-	std::vector<sound_pair> pairs;
-	std::size_t next_pair_to_be_played = 0u;
-	bool is_pressed = false;
-};
-
 struct key_metric {
 	vec3 lt_pos;
 	vec3 center_pos;
@@ -314,6 +292,10 @@ void set_default_keyboard_metrics() {
 int WINAPI WinMain (HINSTANCE, HINSTANCE, LPSTR, int) {
 	augs::create_directories("generated/logs/");
 
+#if ENABLE_ZONE_PROFILER
+	augs::tsc_clock::calibrate();
+#endif
+
 	set_default_keyboard_metrics();
 
 	const auto cfg = augs::get_file_lines("config.cfg");
@@ -332,6 +314,11 @@ int WINAPI WinMain (HINSTANCE, HINSTANCE, LPSTR, int) {
 	unsigned long long sleep_every_iteration_for_microseconds = 0u;
 	std::string default_pairs;
 	std::string mute_when_these_processes_are_on;
+	augs::output_period_settings output_periods;
+	float cull_silent_voices_below_db = 0.f;
+	augs::thread_schedule main_thread_schedule;
+	augs::thread_schedule mixer_thread_schedule;
+	augs::thread_schedule wmi_thread_schedule;
 	/* END OF CONFIG SETTINGS */
 	
 	std::size_t current_line = 0;
@@ -356,6 +343,22 @@ int WINAPI WinMain (HINSTANCE, HINSTANCE, LPSTR, int) {
 	typesafe_sscanf(cfg[current_line++], "default_pairs %x", default_pairs);
 
 	typesafe_sscanf(cfg[current_line++], "mute_when_these_processes_are_on %x", mute_when_these_processes_are_on);
+	typesafe_sscanf(cfg[current_line++], "low_latency_output %x", output_periods.low_latency);
+	typesafe_sscanf(cfg[current_line++], "output_period_size %x", output_periods.period_size);
+	typesafe_sscanf(cfg[current_line++], "output_periods %x", output_periods.periods);
+	typesafe_sscanf(cfg[current_line++], "cull_silent_voices_below_db %x", cull_silent_voices_below_db);
+	typesafe_sscanf(cfg[current_line++], "main_thread_priority %x", main_thread_schedule.priority);
+	typesafe_sscanf(cfg[current_line++], "main_thread_cpus %x", main_thread_schedule.cpu_mask);
+	typesafe_sscanf(cfg[current_line++], "mixer_thread_priority %x", mixer_thread_schedule.priority);
+	typesafe_sscanf(cfg[current_line++], "mixer_thread_cpus %x", mixer_thread_schedule.cpu_mask);
+	typesafe_sscanf(cfg[current_line++], "wmi_thread_priority %x", wmi_thread_schedule.priority);
+	typesafe_sscanf(cfg[current_line++], "wmi_thread_cpus %x", wmi_thread_schedule.cpu_mask);
+
+	if (!augs::apply_to_current_thread(main_thread_schedule)) {
+		LOG("Could not apply the main thread priority or cpus.");
+	}
+
+	LOG("Main thread: %x", augs::describe_current_thread_schedule());
 
 	{
 		std::vector<std::string> process_name_blacklist;
@@ -369,28 +372,34 @@ int WINAPI WinMain (HINSTANCE, HINSTANCE, LPSTR, int) {
 		}
 
 		if(process_name_blacklist.size() > 0) {
-			makeeventsink(process_name_blacklist);
+			makeeventsink(process_name_blacklist, wmi_thread_schedule);
 		}
 	}
 
 	augs::audio_manager::generate_alsoft_ini(
 		enable_hrtf,
-		1024
+		1024,
+		output_periods,
+		cull_silent_voices_below_db,
+		mixer_thread_schedule
 	);
 
-	augs::audio_manager manager(output_device);
+	augs::audio_manager manager(output_device, output_periods);
 
 	augs::set_listener_velocity(si_scaling(), {0.f, 0.f});
 	augs::set_listener_orientation(listener_orientation);
 	alListener3f(AL_POSITION, listener_position.x, listener_position.y, listener_position.z);
 
-	std::unordered_map<std::string, augs::single_sound_buffer> sound_buffers;
+	sound_buffer_map sound_buffers;
 
 	const auto make_buffer = [&sound_buffers, mix_all_sounds_to_mono](const std::string path){
 		if (sound_buffers.find(path) != sound_buffers.end()) {
+			INSTRUMENT_COUNT(BUFFER_CACHE_HITS);
 			return;
 		}
 
+		INSTRUMENT_COUNT(BUFFER_CACHE_MISSES);
+
 		auto& buf = sound_buffers[path];
 
 		const auto samples = augs::get_sound_samples_from_file(path);
@@ -477,6 +486,7 @@ int WINAPI WinMain (HINSTANCE, HINSTANCE, LPSTR, int) {
 
 	for (std::size_t i = 0; i < keys.size(); ++i) {
 		keys[i].position *= scale_key_positions;
+		register_key_emitter(keys[i]);
 	}
 
 	{
@@ -495,7 +505,24 @@ int WINAPI WinMain (HINSTANCE, HINSTANCE, LPSTR, int) {
 	}
 
 
-	std::vector<augs::sound_source> sound_sources;
+	/* By now the mixer has run for a while. */
+	LOG("Mixer thread: %x", manager.describe_mixer_thread_schedule());
+
+	std::vector<playing_sound> sound_sources;
+
+	keystroke_latencies latencies;
+	augs::timer latency_dump_timer;
+
+#if ENABLE_ZONE_PROFILER
+	/* The mixer runs inside OpenAL, which stamps its updates for us to collect. */
+	auto& mixer_track = augs::zone_profiler::get_track_buffer("mixer");
+	std::uint64_t next_mixer_update = 0;
+	augs::timer mixer_zones_timer;
+#endif
+
+#if ENABLE_INSTRUMENTATION
+	augs::metrics_dump_thread metrics_dump("generated/logs/metrics.txt", std::chrono::seconds(5));
+#endif
 
 	while (true) {
 		using namespace std::chrono_literals;
@@ -505,10 +532,18 @@ int WINAPI WinMain (HINSTANCE, HINSTANCE, LPSTR, int) {
 		}
 
 		if (pSink != nullptr && pSink->is_any_on()) {
+#if ENABLE_INSTRUMENTATION
+			const auto mute_start = std::chrono::high_resolution_clock::now();
 			std::this_thread::sleep_for(5ms);
+			INSTRUMENT_ADD(MUTED_NANOSECONDS, keystroke_latencies::nanoseconds_between(mute_start, std::chrono::high_resolution_clock::now()));
+#else
+			std::this_thread::sleep_for(5ms);
+#endif
 			continue;
 		}
 
+		PROFILE_ZONE("poll_iteration");
+
 		for (int i = 0xFF - 1; i >= 0; --i) {
 			const auto id = translate_virtual_key(i);
 			
@@ -530,91 +565,72 @@ int WINAPI WinMain (HINSTANCE, HINSTANCE, LPSTR, int) {
 			}
 
 			const auto async_key_state_result = GetAsyncKeyState(i);
+			const auto event_time = std::chrono::high_resolution_clock::now();
 			
 			auto& subject_key = keys[id];
 
 			if (async_key_state_result == -32767) {
 				if(!subject_key.is_pressed) {
 					subject_key.is_pressed = true;
+					INSTRUMENT_COUNT(EVENTS_CAPTURED);
 					
 					if (subject_key.pairs.empty()) {
 						continue;
 					}
 
-					const auto& pair = subject_key.pairs[subject_key.next_pair_to_be_played];
 #if LOG_PRESSES
 					const auto name = key_to_wstring(id);
 					
 					LOG("DOWN " + std::string(name.begin(), name.end()));
 #endif
-					augs::sound_source src;
-					src.bind_buffer(sound_buffers[pair.down_sound_path]);
-					src.set_gain(volume);
-					
-					alSource3f(
-						src.get_id(), 
-						AL_POSITION, 
-						subject_key.position.x, 
-						subject_key.position.y, 
-						subject_key.position.z
-					);
-
-					src.play();
-
-					sound_sources.emplace_back(std::move(src));
+					dispatch_keystroke(subject_key, true, event_time, sound_buffers, volume, rng, latencies, sound_sources);
 					break;
 				}
 			}
 			else if (async_key_state_result == 0) {
 				if(subject_key.is_pressed) {
 					subject_key.is_pressed = false;
+					INSTRUMENT_COUNT(EVENTS_CAPTURED);
 
 					if (subject_key.pairs.empty()) {
 						continue;
 					}
 
-					const auto& pair = subject_key.pairs[subject_key.next_pair_to_be_played];
-
 #if LOG_PRESSES
 					const auto name = key_to_wstring(id);
 					
 					LOG("UP " + std::string(name.begin(), name.end()));
 #endif
-			
-					augs::sound_source src;
-					src.bind_buffer(sound_buffers[pair.up_sound_path]);
-					src.set_gain(volume);
-
-					alSource3f(
-						src.get_id(), 
-						AL_POSITION, 
-						subject_key.position.x, 
-						subject_key.position.y, 
-						subject_key.position.z
-					);
-
-					src.play();
-
-					sound_sources.emplace_back(std::move(src));
-					
-					++subject_key.next_pair_to_be_played;
-					
-					if(subject_key.next_pair_to_be_played == subject_key.pairs.size()) {
-						std::shuffle(subject_key.pairs.begin(), subject_key.pairs.end(), rng);
-						subject_key.next_pair_to_be_played = 0u;
-					}
+					dispatch_keystroke(subject_key, false, event_time, sound_buffers, volume, rng, latencies, sound_sources);
 
 					break;
 				}
 			}
 		}
 
-		erase_remove(
-			sound_sources,
-			[](const auto& s){
-				return !s.is_playing();
+		reap_playing_sounds(latencies, sound_sources);
+
+#if ENABLE_ZONE_PROFILER
+		if (mixer_zones_timer.get<std::chrono::milliseconds>() > 100.0) {
+			for (const auto& z : manager.get_mixer_zones(next_mixer_update)) {
+				mixer_track.push(z);
 			}
-		);
+
+			mixer_zones_timer.reset();
+		}
+#endif
+
+		if (latency_dump_timer.get<std::chrono::seconds>() > 10.0) {
+			latencies.save("generated/logs/keystroke_latencies.txt");
+			INSTRUMENT_GAUGE(OUTPUT_UNDERRUNS, manager.get_underruns());
+			INSTRUMENT_GAUGE(OUTPUT_DELAY_MICROSECONDS, static_cast<std::int64_t>(manager.get_output_delay_ms() * 1000.0));
+			INSTRUMENT_GAUGE(PANNING_CACHE_HITS, manager.get_panning_cache_hits());
+			INSTRUMENT_GAUGE(PANNING_CACHE_MISSES, manager.get_panning_cache_misses());
+#if ENABLE_ZONE_PROFILER
+			augs::zone_profiler::export_chrome_trace("generated/logs/zone_trace.json");
+#endif
+			latency_dump_timer.reset();
+		}
 	}
 
 	return 0;